@@ -31,6 +31,7 @@
 
 
 #include "FloatInspector.h"
+#include "FloatInspectorPerf.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -59,13 +60,93 @@ const FloatInspectorMetaInformation kFloatInspectorMetaInformationError = {
 };
 
 
+/* Layout of the formats handled by the bit level fast paths.  */
+#define kFloatInspectorFloatMantissaBits	(FLT_MANT_DIG - 1)
+#define kFloatInspectorFloatExponentBits	(sizeof(float) * 8 - FLT_MANT_DIG)
+#define kFloatInspectorDoubleMantissaBits	(DBL_MANT_DIG - 1)
+#define kFloatInspectorDoubleExponentBits	(sizeof(double) * 8 - DBL_MANT_DIG)
+#define kFloatInspectorHalfMantissaBits		10
+#define kFloatInspectorHalfExponentBits		5
+#define kFloatInspectorBFloat16MantissaBits	7
+#define kFloatInspectorBFloat16ExponentBits	8
+
+/* Layout of long double as seen by the generic decoder. x87 extended 
+ * precision stores the integer bit of the significand explicitly, it is 
+ * kept as the top mantissa bit.  */
+#if LDBL_MANT_DIG == 64
+#define kFloatInspectorLongDoubleMantissaBits		64
+#define kFloatInspectorLongDoubleExplicitIntegerBit	1
+#else
+#define kFloatInspectorLongDoubleMantissaBits		(LDBL_MANT_DIG - 1)
+#define kFloatInspectorLongDoubleExplicitIntegerBit	0
+#endif
+#define kFloatInspectorLongDoubleExponentBits \
+	((unsigned int) ceilf(log2f(LDBL_MAX_EXP - LDBL_MIN_EXP)))
+
+/* Values classified by the bulk paths before the sketches are fed, so the 
+ * block is still in cache.  */
+#define kFloatInspectorBulkBlock	1024
+
+/* Heavy hitters listed by FloatInspectorStatisticsPrint.  */
+#define kFloatInspectorHeavyHittersPrinted	10
+
+
 #pragma mark Private Function Prototypes
 
 
 const FloatInspectorMetaInformation 
 FloatInspectorMetaInformationCreateGeneric(void *f, 
 										   unsigned int nExp, 
-										   unsigned int nMant);
+										   unsigned int nMant,
+										   int explicitIntegerBit);
+
+static FloatInspectorMetaInformation 
+FloatInspectorMetaInformationDecodeGeneric(const void *f, 
+										   unsigned int nExp, 
+										   unsigned int nMant,
+										   int explicitIntegerBit,
+										   uint8_t *exponent,
+										   uint8_t *mantissa);
+
+FloatInspectorStatisticsRef 
+FloatInspectorStatisticsCreateGeneric(enum PrecisionType type,
+									  unsigned int nBits,
+									  unsigned int nExp,
+									  unsigned int nMant);
+
+static inline FloatInspectorMetaInformation 
+FloatInspectorMetaInformationClassifyBits(uint64_t bits, 
+										  unsigned int nExp, 
+										  unsigned int nMant);
+
+static inline void 
+FloatInspectorStatisticsAddMetaInformation(FloatInspectorStatisticsRef stats,
+										   FloatInspectorMetaInformation meta);
+
+static inline float 
+FloatInspectorWords16ToFloat(uint16_t bits, enum PrecisionType type);
+
+static inline double 
+FloatInspectorLongDoubleMagnitude(long double f);
+
+static inline void 
+FloatInspectorStatisticsUpdateWithWords16(FloatInspectorStatisticsRef stats,
+										  const uint16_t *restrict values,
+										  size_t n,
+										  unsigned int nExp,
+										  unsigned int nMant);
+
+static void 
+FloatInspectorStatisticsPrintHeavyHitters(const FloatInspectorStatisticsRef stats,
+										  FILE *restrict stream);
+
+static void 
+FloatInspectorStatisticsPrintQuantiles(const FloatInspectorStatisticsRef stats,
+									   FILE *restrict stream);
+
+static void 
+FloatInspectorStatisticsPrintExponents(const FloatInspectorStatisticsRef stats,
+									   FILE *restrict stream);
 
 
 #pragma mark Private Functions Implementations
@@ -73,14 +154,48 @@ FloatInspectorMetaInformationCreateGeneric(void *f,
 const FloatInspectorMetaInformation 
 FloatInspectorMetaInformationCreateGeneric(void *f, 
 										   unsigned int nExp, 
-										   unsigned int nMant) {
+										   unsigned int nMant,
+										   int explicitIntegerBit) {
+	
+	const unsigned int nExpBytes = 
+		nExp % 8 == 0 ? nExp >> 3 : (nExp >> 3) + 1;
+	const unsigned int nMantBytes = 
+		nMant % 8 == 0 ? nMant >> 3 : (nMant >> 3) + 1;
+	
+	/* Allocate memory for exponent an mantissa.  */
+	uint8_t *exponent = (uint8_t *) malloc(nExpBytes);
+	uint8_t *mantissa = (uint8_t *) malloc(nMantBytes);
+	
+	if ((exponent == NULL) || (mantissa == NULL)) {
+		
+		free(exponent);
+		free(mantissa);
+		return kFloatInspectorMetaInformationError;
+	}
+	
+	return FloatInspectorMetaInformationDecodeGeneric(f, nExp, nMant, 
+													  explicitIntegerBit,
+													  exponent, mantissa);
+}
+
+/* Decodes f into the given exponent and mantissa buffers, which have to hold
+ * at least the rounded up number of exponent resp. mantissa bytes. If 
+ * explicitIntegerBit is set, the top mantissa bit is the integer bit of the
+ * significand and does not distinguish infinity from NaN.  */
+static FloatInspectorMetaInformation 
+FloatInspectorMetaInformationDecodeGeneric(const void *f, 
+										   unsigned int nExp, 
+										   unsigned int nMant,
+										   int explicitIntegerBit,
+										   uint8_t *exponent,
+										   uint8_t *mantissa) {
 	
 	const unsigned int overallBytes = (1 + nExp + nMant) >> 3;
 	const unsigned int nExpBytes = 
 		nExp % 8 == 0 ? nExp >> 3 : (nExp >> 3) + 1;
 	const unsigned int nMantBytes = 
 		nMant % 8 == 0 ? nMant >> 3 : (nMant >> 3) + 1;
-	const uint8_t *bytes = (uint8_t *) f;
+	const uint8_t *bytes = (const uint8_t *) f;
 	
 	FloatInspectorMetaInformation meta;
 	
@@ -90,18 +205,12 @@ FloatInspectorMetaInformationCreateGeneric(void *f,
 	meta.nMantissaBits = nMant;
 	meta.nMantissaBytes = nMantBytes;
 	
-	/* Allocate memory for exponent an mantissa.  */
-	meta.exponent = (uint8_t *) malloc(nExpBytes);
-	meta.mantissa = (uint8_t *) malloc(nMantBytes);
+	meta.exponent = exponent;
+	meta.mantissa = mantissa;
 	
 	bzero(meta.exponent, nExpBytes);
 	bzero(meta.mantissa, nMantBytes);
 	
-	if ((meta.exponent == NULL) || (meta.mantissa == NULL)) {
-		
-		return kFloatInspectorMetaInformationError;
-	}
-	
 	/* Extract sign.  */
 	meta.sign = (bytes[overallBytes - 1] & (1 << 7)) != 0;
 	
@@ -135,8 +244,9 @@ FloatInspectorMetaInformationCreateGeneric(void *f,
 	{
 		const unsigned int rest = nMant % 8;
 		memcpy(meta.mantissa, bytes, nMantBytes - 1);
-		/* Clear the upper 8-res' bits.  */
-		uint8_t mask = 0x00;
+		/* Clear the upper 8-res' bits, a whole last byte belongs to the 
+		 * mantissa.  */
+		uint8_t mask = rest == 0 ? 0xff : 0x00;
 		for (unsigned int i = 0; i < rest; i++) {
 			
 			mask = (uint8_t) (mask << 1) | 0x01;
@@ -164,18 +274,11 @@ FloatInspectorMetaInformationCreateGeneric(void *f,
 			}
 		}
 		
-		if ((nZeroBytes << 3) < nExp) {
+		if (nZeroBytes < nExpBytes) {
 			
-			if (nZeroBytes > 0) {
-				
-				meta.nNonZeroExponentBits = (nExp % 8) + 
-					((nZeroBytes - 1) << 3) + nNonZeroBits;
-			}
-			else {
-				
-				meta.nNonZeroExponentBits = 
-					nNonZeroBits + ((nExpBytes - 1) << 3);
-			}
+			/* Every byte below the last non-zero one is a full 8 bits.  */
+			meta.nNonZeroExponentBits = 
+				nNonZeroBits + ((nExpBytes - nZeroBytes - 1) << 3);
 		}
 		else {
 			
@@ -208,7 +311,7 @@ FloatInspectorMetaInformationCreateGeneric(void *f,
 			
 			meta.nNonZeroMantissaBits = nNonZeroBits +
 				((meta.nMantissaBytes - nZeroBytes - 1) << 3) -
-				(8 - (nMant % 8));
+				((8 - (nMant % 8)) % 8);
 		}
 		else {
 			
@@ -248,7 +351,9 @@ FloatInspectorMetaInformationCreateGeneric(void *f,
 		}
 		
 		if (unsetBitsFound == 0) {
-			if (meta.nNonZeroMantissaBits == 0) {
+			/* Only the integer bit set is an x87 infinity.  */
+			if ((meta.nNonZeroMantissaBits == 0) ||
+				(explicitIntegerBit && (meta.nNonZeroMantissaBits == 1))) {
 			
 				meta.type = Infinity;
 			}
@@ -270,292 +375,125 @@ FloatInspectorMetaInformationCreateGeneric(void *f,
 	return meta;
 }
 
-#pragma mark Public Functions Implementations
-
-const FloatInspectorMetaInformation 
-FloatInspectorMetaInformationCreateWithFloat(float f) {
-	
-	const unsigned int nMant = FLT_MANT_DIG - 1;
-	const unsigned int nExp = (unsigned int) (sizeof(f) << 3) - nMant - 1;
-	
-	return FloatInspectorMetaInformationCreateGeneric(&f, nExp, nMant);
-}
-
-const FloatInspectorMetaInformation 
-FloatInspectorMetaInformationCreateWithDouble(double f) {
-	
-	const unsigned int nMant = DBL_MANT_DIG - 1;
-	const unsigned int nExp = (unsigned int) (sizeof(f) << 3) - nMant - 1;
-	
-	return FloatInspectorMetaInformationCreateGeneric(&f, nExp, nMant);
-}
-
-const FloatInspectorMetaInformation 
-FloatInspectorMetaInformationCreateWithLongDouble(long double f) {
-	
-	const unsigned int nMant = LDBL_MANT_DIG;
-	const unsigned int nExp = (unsigned int) ceilf(log2f(LDBL_MAX_EXP - LDBL_MIN_EXP));
-	
-	return FloatInspectorMetaInformationCreateGeneric(&f, nExp, nMant);
-}
-
-void 
-FloatInspectorMetaInformationFree(const FloatInspectorMetaInformation meta) {
-	
-	free(meta.exponent);
-	free(meta.mantissa);
-}
-
-
-const char *
-FloatInspectorMetaInformationDescription(const FloatInspectorMetaInformation meta) {
-	
-	static char buffer[1024];
-	static char expBuffer[128];
-	static char mantBuffer[128];
-	
-	for (unsigned int i = 0; i < meta.nExponentBytes; i++) {
-		sprintf(&expBuffer[2 * i], "%.2x", meta.exponent[meta.nExponentBytes - i - 1]);
-	}
-	
-	for (unsigned int i = 0; i < meta.nMantissaBytes; i++) {
-		sprintf(&mantBuffer[2 * i], "%.2x", meta.mantissa[meta.nMantissaBytes - i - 1]);
-	}
-	
-	const char *typeStr;
-	
-	switch (meta.type) {
-		case Normalized:
-			typeStr = "Normalized";
-			break;
-			
-		case Denormalized:
-			typeStr = "Denormalized";
-			break;
-			
-		case NaN:
-			typeStr = "Not a Number";
-			break;
-			
-		case Infinity:
-			typeStr = "Infinity";
-			break;
-			
-		default:
-			typeStr = "Unknown";
-			break;
-	}
-	
-	sprintf(buffer, 
-			"Sign:\t\t\t\t\t\t\t\t%s\n"
-			"Type:\t\t\t\t\t\t\t\t%s\n"
-			"Exponent length:\t\t\t\t\t%u bits\n"
-			"Number of non zero exponent bits:\t%u\n"
-			"Exponent:\t\t\t\t\t\t\t0x%s\n"
-			"Mantissa length:\t\t\t\t\t%u bits\n"
-			"Number of non zero mantissa bits:\t%u\n"
-			"Mantissa:\t\t\t\t\t\t\t0x%s\n",
-			meta.sign == Positive ? "+" : "-",
-			typeStr,
-			meta.nExponentBits,
-			meta.nNonZeroExponentBits,
-			expBuffer,
-			meta.nMantissaBits,
-			meta.nNonZeroMantissaBits,
-			mantBuffer
-			);
-	
-	return buffer;
-}
-
 FloatInspectorStatisticsRef 
-FloatInspectorStatisticsCreateFloat(void) {
+FloatInspectorStatisticsCreateGeneric(enum PrecisionType type,
+									  unsigned int nBits,
+									  unsigned int nExp,
+									  unsigned int nMant) {
 	
 	FloatInspectorStatisticsRef stats = malloc(sizeof(_FloatInspectorStatistics));
-	_FloatInspectorStatistics _stats = {
 	
-		.nEntries		= 0,
-		.nDenormalized	= 0,
-		.nNormalized	= 0,
-		.nNegative		= 0,
-		.nPositive		= 1,
-		.nNaN			= 0,
-		.nInf			= 0,
+	if (stats == NULL) {
 		
-		.type			= Float,
-		
-		.nBits			= sizeof(float) * 8,
-		.nExponentBits	= sizeof(float) * 8 - FLT_MANT_DIG,
-		.nMantissaBits	= FLT_MANT_DIG - 1,
-		
-		.nNonZeroBitsNormalizedPositive		= NULL,
-		.nNonZeroBitsDenormalizedPositive	= NULL,
-		
-		.nNonZeroBitsNormalizedNegative		= NULL,
-		.nNonZeroBitsDenormalizedNegative	= NULL
-	};
-	
-	*stats = _stats;
-	
-	stats->nNonZeroBitsNormalizedPositive = (unsigned int *)
-		malloc(sizeof(unsigned int) * (_stats.nExponentBits + 1) * 
-			   (_stats.nMantissaBits + 1));
-	
-	stats->nNonZeroBitsDenormalizedPositive = (unsigned int*)
-		malloc(sizeof(unsigned int) * (_stats.nMantissaBits + 1));
-	
-	stats->nNonZeroBitsNormalizedNegative = (unsigned int *)
-		malloc(sizeof(unsigned int) * (_stats.nExponentBits + 1) *
-			   (_stats.nMantissaBits + 1));
-	
-	stats->nNonZeroBitsDenormalizedNegative = (unsigned int*)
-		malloc(sizeof(unsigned int) * (_stats.nMantissaBits + 1));
-	
-	return stats;
-}
-
-FloatInspectorStatisticsRef 
-FloatInspectorStatisticsCreateDouble(void) {
+		return NULL;
+	}
 	
-	FloatInspectorStatisticsRef stats = malloc(sizeof(_FloatInspectorStatistics));
 	_FloatInspectorStatistics _stats = {
 		
 		.nEntries		= 0,
 		.nDenormalized	= 0,
 		.nNormalized	= 0,
 		.nNegative		= 0,
-		.nPositive		= 1,
+		.nPositive		= 0,
 		.nNaN			= 0,
 		.nInf			= 0,
 		
-		.type			= Double,
+		.type			= type,
 		
-		.nBits			= sizeof(double) * 8,
-		.nExponentBits	= sizeof(double) * 8 - DBL_MANT_DIG,
-		.nMantissaBits	= DBL_MANT_DIG - 1,
+		.nBits			= nBits,
+		.nExponentBits	= nExp,
+		.nMantissaBits	= nMant,
 		
 		.nNonZeroBitsNormalizedPositive		= NULL,
 		.nNonZeroBitsDenormalizedPositive	= NULL,
 		
 		.nNonZeroBitsNormalizedNegative		= NULL,
-		.nNonZeroBitsDenormalizedNegative	= NULL
+		.nNonZeroBitsDenormalizedNegative	= NULL,
+		
+		.cardinality	= NULL,
+		.heavyHitters	= NULL,
+		.magnitudes		= NULL,
+		.exponents		= NULL,
+		.moments		= NULL
 	};
 	
 	*stats = _stats;
 	
-	stats->nNonZeroBitsNormalizedPositive = (unsigned int *)
-	malloc(sizeof(unsigned int) * (_stats.nExponentBits + 1) * 
-		   (_stats.nMantissaBits + 1));
+	/* Histograms start out zeroed, so that snapshots, merges and diffs of 
+	 * fresh objects are well defined.  */
+	const size_t nNormalized = FloatInspectorStatisticsNormalizedCells(stats);
+	const size_t nDenormalized = FloatInspectorStatisticsDenormalizedCells(stats);
 	
-	stats->nNonZeroBitsDenormalizedPositive = (unsigned int*)
-	malloc(sizeof(unsigned int) * (_stats.nMantissaBits + 1));
+	stats->nNonZeroBitsNormalizedPositive = (uint64_t *)
+		calloc(nNormalized, sizeof(uint64_t));
 	
-	stats->nNonZeroBitsNormalizedNegative = (unsigned int *)
-	malloc(sizeof(unsigned int) * (_stats.nExponentBits + 1) * 
-		   (_stats.nMantissaBits + 1));
+	stats->nNonZeroBitsDenormalizedPositive = (uint64_t *)
+		calloc(nDenormalized, sizeof(uint64_t));
 	
-	stats->nNonZeroBitsDenormalizedNegative = (unsigned int*)
-	malloc(sizeof(unsigned int) * (_stats.nMantissaBits + 1));
+	stats->nNonZeroBitsNormalizedNegative = (uint64_t *)
+		calloc(nNormalized, sizeof(uint64_t));
 	
-	return stats;
-}
-
-FloatInspectorStatisticsRef 
-FloatInspectorStatisticsCreateLongDouble(void) {
+	stats->nNonZeroBitsDenormalizedNegative = (uint64_t *)
+		calloc(nDenormalized, sizeof(uint64_t));
 	
-	FloatInspectorStatisticsRef stats = malloc(sizeof(_FloatInspectorStatistics));
-	_FloatInspectorStatistics _stats = {
-		
-		.nEntries		= 0,
-		.nDenormalized	= 0,
-		.nNormalized	= 0,
-		.nNegative		= 0,
-		.nPositive		= 0,
-		.nNaN			= 0,
-		.nInf			= 0,
-		
-		.type			= LongDouble,
-		
-		.nBits			= sizeof(long double) * 8,
-		.nExponentBits	= sizeof(long double) * 8 - LDBL_MANT_DIG,
-		.nMantissaBits	= LDBL_MANT_DIG - 1,
+	if ((stats->nNonZeroBitsNormalizedPositive == NULL) ||
+		(stats->nNonZeroBitsDenormalizedPositive == NULL) ||
+		(stats->nNonZeroBitsNormalizedNegative == NULL) ||
+		(stats->nNonZeroBitsDenormalizedNegative == NULL)) {
 		
-		.nNonZeroBitsNormalizedPositive		= NULL,
-		.nNonZeroBitsDenormalizedPositive	= NULL,
-		
-		.nNonZeroBitsNormalizedNegative		= NULL,
-		.nNonZeroBitsDenormalizedNegative	= NULL
-	};
-	
-	*stats = _stats;
-	
-	stats->nNonZeroBitsNormalizedPositive = (unsigned int *)
-	malloc(sizeof(unsigned int) * (_stats.nExponentBits + 1) * 
-		   (_stats.nMantissaBits + 1));
-	
-	stats->nNonZeroBitsDenormalizedPositive = (unsigned int*)
-	malloc(sizeof(unsigned int) * (_stats.nMantissaBits + 1));
-	
-	stats->nNonZeroBitsNormalizedNegative = (unsigned int *)
-	malloc(sizeof(unsigned int) * (_stats.nExponentBits + 1) * 
-		   (_stats.nMantissaBits + 1));
-	
-	stats->nNonZeroBitsDenormalizedNegative = (unsigned int*)
-	malloc(sizeof(unsigned int) * (_stats.nMantissaBits + 1));
+		FloatInspectorStatisticsFree(stats);
+		return NULL;
+	}
 	
 	return stats;
 }
 
-void FloatInspectorStatisticsFree(FloatInspectorStatisticsRef stats) {
-	
-	free(stats->nNonZeroBitsNormalizedPositive);
-	free(stats->nNonZeroBitsDenormalizedPositive);
-	free(stats->nNonZeroBitsNormalizedNegative);
-	free(stats->nNonZeroBitsDenormalizedNegative);
-	
-	free(stats);
-}
-
-void 
-FloatInspectorStatisticsUpdateWithFloat(FloatInspectorStatisticsRef stats, 
-										float f) {
-
-	FloatInspectorMetaInformation meta = 
-		FloatInspectorMetaInformationCreateWithFloat(f);
-	
-	FloatInspectorStatisticsUpdateWithMetaInformation(stats, meta);
-	
-	FloatInspectorMetaInformationFree(meta);
+/* Classifies a float whose bit pattern fits into 64 bits without touching
+ * memory. The result matches FloatInspectorMetaInformationCreateGeneric, 
+ * except that no exponent and mantissa bytes are provided.  */
+static inline FloatInspectorMetaInformation 
+FloatInspectorMetaInformationClassifyBits(uint64_t bits, 
+										  unsigned int nExp, 
+										  unsigned int nMant) {
 	
-}
-
-void 
-FloatInspectorStatisticsUpdateWithDouble(FloatInspectorStatisticsRef stats, 
-										 double f) {
+	const uint64_t exponent = (bits >> nMant) & ((UINT64_C(1) << nExp) - 1);
+	const uint64_t mantissa = bits & ((UINT64_C(1) << nMant) - 1);
 	
-	FloatInspectorMetaInformation meta = 
-	FloatInspectorMetaInformationCreateWithDouble(f);
+	FloatInspectorMetaInformation meta;
 	
-	FloatInspectorStatisticsUpdateWithMetaInformation(stats, meta);
+	meta.exponent = NULL;
+	meta.nExponentBits = nExp;
+	meta.nExponentBytes = (nExp + 7) >> 3;
+	meta.nNonZeroExponentBits = exponent == 0 ? 
+		0 : 64 - (unsigned int) __builtin_clzll(exponent);
 	
-	FloatInspectorMetaInformationFree(meta);
-}
-
-void
-FloatInspectorStatisticsUpdateWithLongDouble(FloatInspectorStatisticsRef stats, 
-											 long double f) {
+	meta.mantissa = NULL;
+	meta.nMantissaBits = nMant;
+	meta.nMantissaBytes = (nMant + 7) >> 3;
+	meta.nNonZeroMantissaBits = mantissa == 0 ?
+		0 : nMant - (unsigned int) __builtin_ctzll(mantissa);
 	
-	FloatInspectorMetaInformation meta = 
-	FloatInspectorMetaInformationCreateWithLongDouble(f);
+	meta.sign = (bits >> (nExp + nMant)) & 1 ? Negative : Positive;
 	
-	FloatInspectorStatisticsUpdateWithMetaInformation(stats, meta);
+	if (exponent == 0) {
+		
+		meta.type = Denormalized;
+	}
+	else if (exponent == (UINT64_C(1) << nExp) - 1) {
+		
+		meta.type = mantissa == 0 ? Infinity : NaN;
+	}
+	else {
+		
+		meta.type = Normalized;
+	}
 	
-	FloatInspectorMetaInformationFree(meta);
+	return meta;
 }
 
-void 
-FloatInspectorStatisticsUpdateWithMetaInformation(FloatInspectorStatisticsRef stats,
-												  FloatInspectorMetaInformation meta) {
+static inline void 
+FloatInspectorStatisticsAddMetaInformation(FloatInspectorStatisticsRef stats,
+										   FloatInspectorMetaInformation meta) {
 	
 	const unsigned int width = stats->nExponentBits + 1;
 	
@@ -614,16 +552,1235 @@ FloatInspectorStatisticsUpdateWithMetaInformation(FloatInspectorStatisticsRef st
 	}
 }
 
-void 
-FloatInspectorStatisticsPrint(const FloatInspectorStatisticsRef stats,
-							  FILE *restrict stream) {
+static inline float 
+FloatInspectorWords16ToFloat(uint16_t bits, enum PrecisionType type) {
 	
-	fprintf(stream, "--- Statistics ---\n\n");
+	uint32_t wide;
+	float f;
 	
-	switch (stats->type) {
-		case Float:
-			fprintf(stream, "Type: float\n");
-			break;
+	if (type == BFloat16) {
+		
+		wide = (uint32_t) bits << 16;
+		memcpy(&f, &wide, sizeof(f));
+		return f;
+	}
+	
+	/* Align the half fields with the float ones and scale by the difference
+	 * of the biases, which is exact for normalized and denormalized halfs.
+	 * Infinities and NaNs get the maximal float exponent instead.  */
+	const uint32_t magnitude = bits & 0x7fffu;
+	
+	wide = magnitude << 13;
+	memcpy(&f, &wide, sizeof(f));
+	f *= 0x1p112f;
+	memcpy(&wide, &f, sizeof(wide));
+	
+	if (magnitude >= 0x7c00u) {
+		
+		wide = (magnitude << 13) | 0x7f800000u;
+	}
+	
+	wide |= (uint32_t) (bits & 0x8000u) << 16;
+	memcpy(&f, &wide, sizeof(f));
+	
+	return f;
+}
+
+/* Magnitude of a finite long double for the quantile sketch. Values beyond
+ * the double range would round to infinity and are clamped to DBL_MAX.  */
+static inline double 
+FloatInspectorLongDoubleMagnitude(long double f) {
+	
+	const long double magnitude = fabsl(f);
+	
+	return magnitude < (long double) DBL_MAX ? (double) magnitude : DBL_MAX;
+}
+
+/* Bulk path shared by the 16 bit formats, inlined with the layout as 
+ * constants.  */
+static inline void 
+FloatInspectorStatisticsUpdateWithWords16(FloatInspectorStatisticsRef stats,
+										  const uint16_t *restrict values,
+										  size_t n,
+										  unsigned int nExp,
+										  unsigned int nMant) {
+	
+	for (size_t block = 0; block < n; block += kFloatInspectorBulkBlock) {
+		
+		const size_t nBlock = n - block < kFloatInspectorBulkBlock ? 
+			n - block : kFloatInspectorBulkBlock;
+		
+		for (size_t i = block; i < block + nBlock; i++) {
+			
+			FloatInspectorStatisticsAddMetaInformation(stats, 
+				FloatInspectorMetaInformationClassifyBits(values[i], nExp, nMant));
+		}
+		
+		/* The sketches take 32 bit words, zero extension keeps patterns 
+		 * distinct.  */
+		if ((stats->cardinality != NULL) || (stats->heavyHitters != NULL)) {
+			
+			uint32_t words[kFloatInspectorBulkBlock];
+			
+			for (size_t i = 0; i < nBlock; i++) {
+				
+				words[i] = values[block + i];
+			}
+			
+			if (stats->cardinality != NULL) {
+				
+				FloatInspectorCardinalityAddWords32(stats->cardinality, words, nBlock);
+			}
+			
+			if (stats->heavyHitters != NULL) {
+				
+				FloatInspectorHeavyHittersAddWords32(stats->heavyHitters, words, nBlock);
+			}
+		}
+		
+		if (stats->exponents != NULL) {
+			
+			FloatInspectorExponentsAddWords16(stats->exponents, &values[block], nBlock);
+		}
+		
+		if ((stats->magnitudes != NULL) || (stats->moments != NULL)) {
+			
+			float floats[kFloatInspectorBulkBlock];
+			
+			for (size_t i = 0; i < nBlock; i++) {
+				
+				floats[i] = FloatInspectorWords16ToFloat(values[block + i], stats->type);
+			}
+			
+			if (stats->magnitudes != NULL) {
+				
+				double magnitudes[kFloatInspectorBulkBlock];
+				size_t nFinite = 0;
+				
+				for (size_t i = 0; i < nBlock; i++) {
+					
+					magnitudes[nFinite] = fabs((double) floats[i]);
+					nFinite += isfinite(floats[i]) != 0;
+				}
+				
+				FloatInspectorQuantilesAdd(stats->magnitudes, magnitudes, nFinite);
+			}
+			
+			if (stats->moments != NULL) {
+				
+				FloatInspectorMomentsAddFloats(stats->moments, floats, nBlock);
+			}
+		}
+	}
+}
+
+static void 
+FloatInspectorStatisticsPrintHeavyHitters(const FloatInspectorStatisticsRef stats,
+										  FILE *restrict stream) {
+	
+	FloatInspectorHeavyHitter hitters[kFloatInspectorHeavyHittersPrinted];
+	const unsigned int n = FloatInspectorHeavyHittersGet(stats->heavyHitters, hitters, 
+														 kFloatInspectorHeavyHittersPrinted);
+	
+	fprintf(stream, 
+			"Most frequent values (%u of %u tracked, count, overestimation, bits):\n",
+			n, 
+			FloatInspectorHeavyHittersCapacity(stats->heavyHitters));
+	
+	for (unsigned int i = 0; i < n; i++) {
+		
+		long double value = 0.l;
+		
+		switch (stats->type) {
+			case Float: {
+				
+				float f;
+				memcpy(&f, hitters[i].bits, sizeof(f));
+				value = f;
+				break;
+			}
+				
+			case Double: {
+				
+				double d;
+				memcpy(&d, hitters[i].bits, sizeof(d));
+				value = d;
+				break;
+			}
+				
+			case LongDouble:
+				
+				memcpy(&value, hitters[i].bits, 
+					   sizeof(value) < sizeof(hitters[i].bits) ? 
+					   sizeof(value) : sizeof(hitters[i].bits));
+				break;
+				
+			case Half:
+			case BFloat16:
+				
+				value = FloatInspectorWords16ToFloat((uint16_t) hitters[i].bits[0], 
+													 stats->type);
+				break;
+		}
+		
+		fprintf(stream, "%Lg\t%" PRIu64 "\t%" PRIu64 "\t0x", 
+				value, 
+				hitters[i].count, 
+				hitters[i].error);
+		
+		if (stats->nBits > 64) {
+			
+			fprintf(stream, "%0*" PRIx64 "%016" PRIx64 "\n", 
+					(int) (stats->nBits - 64 + 3) / 4, hitters[i].bits[1], hitters[i].bits[0]);
+		}
+		else {
+			
+			fprintf(stream, "%0*" PRIx64 "\n", 
+					(int) (stats->nBits + 3) / 4, hitters[i].bits[0]);
+		}
+	}
+	fprintf(stream, "\n");
+}
+
+static void 
+FloatInspectorStatisticsPrintQuantiles(const FloatInspectorStatisticsRef stats,
+									   FILE *restrict stream) {
+	
+	static const double ranks[] = { 0., .5, .9, .99, .999, 1. };
+	
+	fprintf(stream, 
+			"Magnitude quantiles of %" PRIu64 " finite values (KLL, k = %u, rank, magnitude, exponent):\n",
+			FloatInspectorQuantilesCount(stats->magnitudes),
+			FloatInspectorQuantilesK(stats->magnitudes));
+	
+	for (size_t i = 0; i < sizeof(ranks) / sizeof(ranks[0]); i++) {
+		
+		fprintf(stream, "%g\t%g\t%g\n", 
+				ranks[i],
+				FloatInspectorStatisticsMagnitudeQuantile(stats, ranks[i]),
+				FloatInspectorStatisticsExponentQuantile(stats, ranks[i]));
+	}
+	fprintf(stream, "\n");
+}
+
+static void 
+FloatInspectorStatisticsPrintExponents(const FloatInspectorStatisticsRef stats,
+									   FILE *restrict stream) {
+	
+	const FloatInspectorExponentsRef exponents = stats->exponents;
+	
+	for (int negative = 0; negative <= 1; negative++) {
+		
+		fprintf(stream, 
+				"Exponents of %s finite numbers (%" PRIu64 " zeros, exponent, count):\n",
+				negative ? "negative" : "positive",
+				FloatInspectorExponentsZeros(exponents, negative));
+		
+		/* Only the occupied binades, wide formats have thousands.  */
+		for (int exponent = FloatInspectorExponentsMinimum(exponents);
+			 exponent <= FloatInspectorExponentsMaximum(exponents);
+			 exponent++) {
+			
+			const uint64_t count = FloatInspectorExponentsCount(exponents, negative, exponent);
+			
+			if (count != 0) {
+				
+				fprintf(stream, "%d\t%" PRIu64 "%s\n", 
+						exponent, 
+						count,
+						exponent < FloatInspectorExponentsNormalizedMinimum(exponents) ?
+						"\tdenormalized" : "");
+			}
+		}
+		fprintf(stream, "\n");
+	}
+}
+
+#pragma mark Public Functions Implementations
+
+const FloatInspectorMetaInformation 
+FloatInspectorMetaInformationCreateWithFloat(float f) {
+	
+	const unsigned int nMant = FLT_MANT_DIG - 1;
+	const unsigned int nExp = (unsigned int) (sizeof(f) << 3) - nMant - 1;
+	
+	return FloatInspectorMetaInformationCreateGeneric(&f, nExp, nMant, 0);
+}
+
+const FloatInspectorMetaInformation 
+FloatInspectorMetaInformationCreateWithDouble(double f) {
+	
+	const unsigned int nMant = DBL_MANT_DIG - 1;
+	const unsigned int nExp = (unsigned int) (sizeof(f) << 3) - nMant - 1;
+	
+	return FloatInspectorMetaInformationCreateGeneric(&f, nExp, nMant, 0);
+}
+
+const FloatInspectorMetaInformation 
+FloatInspectorMetaInformationCreateWithLongDouble(long double f) {
+	
+	const unsigned int nMant = kFloatInspectorLongDoubleMantissaBits;
+	const unsigned int nExp = kFloatInspectorLongDoubleExponentBits;
+	
+	return FloatInspectorMetaInformationCreateGeneric(&f, nExp, nMant, 
+													  kFloatInspectorLongDoubleExplicitIntegerBit);
+}
+
+FloatInspectorMetaInformation 
+FloatInspectorMetaInformationClassifyFloat(float f) {
+	
+	uint32_t bits;
+	memcpy(&bits, &f, sizeof(bits));
+	
+	return FloatInspectorMetaInformationClassifyBits(bits, 
+													 kFloatInspectorFloatExponentBits, 
+													 kFloatInspectorFloatMantissaBits);
+}
+
+FloatInspectorMetaInformation 
+FloatInspectorMetaInformationClassifyDouble(double f) {
+	
+	uint64_t bits;
+	memcpy(&bits, &f, sizeof(bits));
+	
+	return FloatInspectorMetaInformationClassifyBits(bits, 
+													 kFloatInspectorDoubleExponentBits, 
+													 kFloatInspectorDoubleMantissaBits);
+}
+
+void 
+FloatInspectorMetaInformationFree(const FloatInspectorMetaInformation meta) {
+	
+	free(meta.exponent);
+	free(meta.mantissa);
+}
+
+
+const char *
+FloatInspectorMetaInformationDescription(const FloatInspectorMetaInformation meta) {
+	
+	static char buffer[1024];
+	static char expBuffer[128];
+	static char mantBuffer[128];
+	
+	for (unsigned int i = 0; i < meta.nExponentBytes; i++) {
+		sprintf(&expBuffer[2 * i], "%.2x", meta.exponent[meta.nExponentBytes - i - 1]);
+	}
+	
+	for (unsigned int i = 0; i < meta.nMantissaBytes; i++) {
+		sprintf(&mantBuffer[2 * i], "%.2x", meta.mantissa[meta.nMantissaBytes - i - 1]);
+	}
+	
+	const char *typeStr;
+	
+	switch (meta.type) {
+		case Normalized:
+			typeStr = "Normalized";
+			break;
+			
+		case Denormalized:
+			typeStr = "Denormalized";
+			break;
+			
+		case NaN:
+			typeStr = "Not a Number";
+			break;
+			
+		case Infinity:
+			typeStr = "Infinity";
+			break;
+			
+		default:
+			typeStr = "Unknown";
+			break;
+	}
+	
+	sprintf(buffer, 
+			"Sign:\t\t\t\t\t\t\t\t%s\n"
+			"Type:\t\t\t\t\t\t\t\t%s\n"
+			"Exponent length:\t\t\t\t\t%u bits\n"
+			"Number of non zero exponent bits:\t%u\n"
+			"Exponent:\t\t\t\t\t\t\t0x%s\n"
+			"Mantissa length:\t\t\t\t\t%u bits\n"
+			"Number of non zero mantissa bits:\t%u\n"
+			"Mantissa:\t\t\t\t\t\t\t0x%s\n",
+			meta.sign == Positive ? "+" : "-",
+			typeStr,
+			meta.nExponentBits,
+			meta.nNonZeroExponentBits,
+			expBuffer,
+			meta.nMantissaBits,
+			meta.nNonZeroMantissaBits,
+			mantBuffer
+			);
+	
+	return buffer;
+}
+
+FloatInspectorStatisticsRef 
+FloatInspectorStatisticsCreateFloat(void) {
+	
+	return FloatInspectorStatisticsCreateGeneric(Float, 
+												 sizeof(float) * 8,
+												 sizeof(float) * 8 - FLT_MANT_DIG,
+												 FLT_MANT_DIG - 1);
+}
+
+FloatInspectorStatisticsRef 
+FloatInspectorStatisticsCreateDouble(void) {
+	
+	return FloatInspectorStatisticsCreateGeneric(Double, 
+												 sizeof(double) * 8,
+												 sizeof(double) * 8 - DBL_MANT_DIG,
+												 DBL_MANT_DIG - 1);
+}
+
+FloatInspectorStatisticsRef 
+FloatInspectorStatisticsCreateLongDouble(void) {
+	
+	/* Use the layout the decoder reports, the storage of long double is 
+	 * usually padded.  */
+	return FloatInspectorStatisticsCreateGeneric(LongDouble, 
+												 1 + kFloatInspectorLongDoubleExponentBits +
+												 kFloatInspectorLongDoubleMantissaBits,
+												 kFloatInspectorLongDoubleExponentBits,
+												 kFloatInspectorLongDoubleMantissaBits);
+}
+
+FloatInspectorStatisticsRef 
+FloatInspectorStatisticsCreateHalf(void) {
+	
+	return FloatInspectorStatisticsCreateGeneric(Half, 
+												 16,
+												 kFloatInspectorHalfExponentBits,
+												 kFloatInspectorHalfMantissaBits);
+}
+
+FloatInspectorStatisticsRef 
+FloatInspectorStatisticsCreateBFloat16(void) {
+	
+	return FloatInspectorStatisticsCreateGeneric(BFloat16, 
+												 16,
+												 kFloatInspectorBFloat16ExponentBits,
+												 kFloatInspectorBFloat16MantissaBits);
+}
+
+FloatInspectorStatisticsRef 
+FloatInspectorStatisticsCreate(enum PrecisionType type) {
+	
+	switch (type) {
+		case Float:
+			return FloatInspectorStatisticsCreateFloat();
+			
+		case Double:
+			return FloatInspectorStatisticsCreateDouble();
+			
+		case LongDouble:
+			return FloatInspectorStatisticsCreateLongDouble();
+			
+		case Half:
+			return FloatInspectorStatisticsCreateHalf();
+			
+		case BFloat16:
+			return FloatInspectorStatisticsCreateBFloat16();
+	}
+	
+	return NULL;
+}
+
+FloatInspectorStatisticsRef 
+FloatInspectorStatisticsCopy(const FloatInspectorStatisticsRef stats) {
+	
+	FloatInspectorStatisticsRef copy = 
+		FloatInspectorStatisticsCreateGeneric(stats->type, 
+											  stats->nBits,
+											  stats->nExponentBits,
+											  stats->nMantissaBits);
+	
+	if (copy == NULL) {
+		
+		return NULL;
+	}
+	
+	copy->nEntries		= stats->nEntries;
+	copy->nDenormalized	= stats->nDenormalized;
+	copy->nNormalized	= stats->nNormalized;
+	copy->nNegative		= stats->nNegative;
+	copy->nPositive		= stats->nPositive;
+	copy->nNaN			= stats->nNaN;
+	copy->nInf			= stats->nInf;
+	
+	const size_t nNormalizedBytes = sizeof(uint64_t) * 
+		FloatInspectorStatisticsNormalizedCells(stats);
+	const size_t nDenormalizedBytes = sizeof(uint64_t) * 
+		FloatInspectorStatisticsDenormalizedCells(stats);
+	
+	memcpy(copy->nNonZeroBitsNormalizedPositive, 
+		   stats->nNonZeroBitsNormalizedPositive, nNormalizedBytes);
+	memcpy(copy->nNonZeroBitsDenormalizedPositive, 
+		   stats->nNonZeroBitsDenormalizedPositive, nDenormalizedBytes);
+	memcpy(copy->nNonZeroBitsNormalizedNegative, 
+		   stats->nNonZeroBitsNormalizedNegative, nNormalizedBytes);
+	memcpy(copy->nNonZeroBitsDenormalizedNegative, 
+		   stats->nNonZeroBitsDenormalizedNegative, nDenormalizedBytes);
+	
+	if (stats->cardinality != NULL) {
+		
+		copy->cardinality = FloatInspectorCardinalityCopy(stats->cardinality);
+		
+		if (copy->cardinality == NULL) {
+			
+			FloatInspectorStatisticsFree(copy);
+			return NULL;
+		}
+	}
+	
+	if (stats->heavyHitters != NULL) {
+		
+		copy->heavyHitters = FloatInspectorHeavyHittersCopy(stats->heavyHitters);
+		
+		if (copy->heavyHitters == NULL) {
+			
+			FloatInspectorStatisticsFree(copy);
+			return NULL;
+		}
+	}
+	
+	if (stats->magnitudes != NULL) {
+		
+		copy->magnitudes = FloatInspectorQuantilesCopy(stats->magnitudes);
+		
+		if (copy->magnitudes == NULL) {
+			
+			FloatInspectorStatisticsFree(copy);
+			return NULL;
+		}
+	}
+	
+	if (stats->exponents != NULL) {
+		
+		copy->exponents = FloatInspectorExponentsCopy(stats->exponents);
+		
+		if (copy->exponents == NULL) {
+			
+			FloatInspectorStatisticsFree(copy);
+			return NULL;
+		}
+	}
+	
+	if (stats->moments != NULL) {
+		
+		copy->moments = FloatInspectorMomentsCopy(stats->moments);
+		
+		if (copy->moments == NULL) {
+			
+			FloatInspectorStatisticsFree(copy);
+			return NULL;
+		}
+	}
+	
+	return copy;
+}
+
+void 
+FloatInspectorStatisticsReset(FloatInspectorStatisticsRef stats) {
+	
+	stats->nEntries			= 0;
+	stats->nDenormalized	= 0;
+	stats->nNormalized		= 0;
+	stats->nNegative		= 0;
+	stats->nPositive		= 0;
+	stats->nNaN				= 0;
+	stats->nInf				= 0;
+	
+	const size_t nNormalizedBytes = sizeof(uint64_t) * 
+		FloatInspectorStatisticsNormalizedCells(stats);
+	const size_t nDenormalizedBytes = sizeof(uint64_t) * 
+		FloatInspectorStatisticsDenormalizedCells(stats);
+	
+	memset(stats->nNonZeroBitsNormalizedPositive, 0, nNormalizedBytes);
+	memset(stats->nNonZeroBitsDenormalizedPositive, 0, nDenormalizedBytes);
+	memset(stats->nNonZeroBitsNormalizedNegative, 0, nNormalizedBytes);
+	memset(stats->nNonZeroBitsDenormalizedNegative, 0, nDenormalizedBytes);
+	
+	if (stats->cardinality != NULL) {
+		
+		FloatInspectorCardinalityReset(stats->cardinality);
+	}
+	
+	if (stats->heavyHitters != NULL) {
+		
+		FloatInspectorHeavyHittersReset(stats->heavyHitters);
+	}
+	
+	if (stats->magnitudes != NULL) {
+		
+		FloatInspectorQuantilesReset(stats->magnitudes);
+	}
+	
+	if (stats->exponents != NULL) {
+		
+		FloatInspectorExponentsReset(stats->exponents);
+	}
+	
+	if (stats->moments != NULL) {
+		
+		FloatInspectorMomentsReset(stats->moments);
+	}
+}
+
+int 
+FloatInspectorStatisticsMerge(FloatInspectorStatisticsRef dst,
+							  const FloatInspectorStatisticsRef src) {
+	
+	uint64_t nEntries;
+	
+	/* Everything that can fail for another reason than memory is checked 
+	 * before dst is touched. No counter or cell exceeds nEntries, so its 
+	 * sum is the only one that can overflow.  */
+	if ((dst->type != src->type) ||
+		(dst->nExponentBits != src->nExponentBits) ||
+		(dst->nMantissaBits != src->nMantissaBits) ||
+		__builtin_add_overflow(dst->nEntries, src->nEntries, &nEntries)) {
+		
+		return -1;
+	}
+	
+	if (((dst->cardinality != NULL) && (src->cardinality != NULL) &&
+		 (dst->cardinality->precision != src->cardinality->precision)) ||
+		((dst->magnitudes != NULL) && (src->magnitudes != NULL) &&
+		 (FloatInspectorQuantilesK(dst->magnitudes) != 
+		  FloatInspectorQuantilesK(src->magnitudes)))) {
+		
+		return -1;
+	}
+	
+	/* A sketch has to cover all values of its object. One that only src 
+	 * has is taken over while dst is empty, one that only dst has is 
+	 * dropped unless src is empty, and one whose merge ran out of memory 
+	 * is dropped as well.  */
+	const int dstEmpty = dst->nEntries == 0;
+	const int srcEmpty = src->nEntries == 0;
+	
+	if ((dst->cardinality != NULL) && (src->cardinality != NULL)) {
+		
+		FloatInspectorCardinalityMerge(dst->cardinality, src->cardinality);
+	}
+	else if ((dst->cardinality != NULL) && !srcEmpty) {
+		
+		FloatInspectorCardinalityFree(dst->cardinality);
+		dst->cardinality = NULL;
+	}
+	else if ((src->cardinality != NULL) && dstEmpty) {
+		
+		dst->cardinality = FloatInspectorCardinalityCopy(src->cardinality);
+	}
+	
+	if ((dst->heavyHitters != NULL) && (src->heavyHitters != NULL)) {
+		
+		FloatInspectorHeavyHittersMerge(dst->heavyHitters, src->heavyHitters);
+	}
+	else if ((dst->heavyHitters != NULL) && !srcEmpty) {
+		
+		FloatInspectorHeavyHittersFree(dst->heavyHitters);
+		dst->heavyHitters = NULL;
+	}
+	else if ((src->heavyHitters != NULL) && dstEmpty) {
+		
+		dst->heavyHitters = FloatInspectorHeavyHittersCopy(src->heavyHitters);
+	}
+	
+	if ((dst->magnitudes != NULL) && (src->magnitudes != NULL)) {
+		
+		if (FloatInspectorQuantilesMerge(dst->magnitudes, src->magnitudes) != 0) {
+			
+			FloatInspectorQuantilesFree(dst->magnitudes);
+			dst->magnitudes = NULL;
+		}
+	}
+	else if ((dst->magnitudes != NULL) && !srcEmpty) {
+		
+		FloatInspectorQuantilesFree(dst->magnitudes);
+		dst->magnitudes = NULL;
+	}
+	else if ((src->magnitudes != NULL) && dstEmpty) {
+		
+		dst->magnitudes = FloatInspectorQuantilesCopy(src->magnitudes);
+	}
+	
+	if ((dst->exponents != NULL) && (src->exponents != NULL)) {
+		
+		if (FloatInspectorExponentsMerge(dst->exponents, src->exponents) != 0) {
+			
+			FloatInspectorExponentsFree(dst->exponents);
+			dst->exponents = NULL;
+		}
+	}
+	else if ((dst->exponents != NULL) && !srcEmpty) {
+		
+		FloatInspectorExponentsFree(dst->exponents);
+		dst->exponents = NULL;
+	}
+	else if ((src->exponents != NULL) && dstEmpty) {
+		
+		dst->exponents = FloatInspectorExponentsCopy(src->exponents);
+	}
+	
+	if ((dst->moments != NULL) && (src->moments != NULL)) {
+		
+		FloatInspectorMomentsMerge(dst->moments, src->moments);
+	}
+	else if ((dst->moments != NULL) && !srcEmpty) {
+		
+		FloatInspectorMomentsFree(dst->moments);
+		dst->moments = NULL;
+	}
+	else if ((src->moments != NULL) && dstEmpty) {
+		
+		dst->moments = FloatInspectorMomentsCopy(src->moments);
+	}
+	
+	dst->nEntries		= nEntries;
+	dst->nDenormalized	+= src->nDenormalized;
+	dst->nNormalized	+= src->nNormalized;
+	dst->nNegative		+= src->nNegative;
+	dst->nPositive		+= src->nPositive;
+	dst->nNaN			+= src->nNaN;
+	dst->nInf			+= src->nInf;
+	
+	const size_t nNormalized = FloatInspectorStatisticsNormalizedCells(src);
+	const size_t nDenormalized = FloatInspectorStatisticsDenormalizedCells(src);
+	
+	for (size_t i = 0; i < nNormalized; i++) {
+		
+		dst->nNonZeroBitsNormalizedPositive[i] += 
+			src->nNonZeroBitsNormalizedPositive[i];
+		dst->nNonZeroBitsNormalizedNegative[i] += 
+			src->nNonZeroBitsNormalizedNegative[i];
+	}
+	
+	for (size_t i = 0; i < nDenormalized; i++) {
+		
+		dst->nNonZeroBitsDenormalizedPositive[i] += 
+			src->nNonZeroBitsDenormalizedPositive[i];
+		dst->nNonZeroBitsDenormalizedNegative[i] += 
+			src->nNonZeroBitsDenormalizedNegative[i];
+	}
+	
+	return 0;
+}
+
+size_t 
+FloatInspectorStatisticsNormalizedCells(const FloatInspectorStatisticsRef stats) {
+	
+	return (size_t) (stats->nExponentBits + 1) * (stats->nMantissaBits + 1);
+}
+
+size_t 
+FloatInspectorStatisticsDenormalizedCells(const FloatInspectorStatisticsRef stats) {
+	
+	return (size_t) stats->nMantissaBits + 1;
+}
+
+void FloatInspectorStatisticsFree(FloatInspectorStatisticsRef stats) {
+	
+	free(stats->nNonZeroBitsNormalizedPositive);
+	free(stats->nNonZeroBitsDenormalizedPositive);
+	free(stats->nNonZeroBitsNormalizedNegative);
+	free(stats->nNonZeroBitsDenormalizedNegative);
+	
+	FloatInspectorCardinalityFree(stats->cardinality);
+	FloatInspectorHeavyHittersFree(stats->heavyHitters);
+	FloatInspectorQuantilesFree(stats->magnitudes);
+	FloatInspectorExponentsFree(stats->exponents);
+	FloatInspectorMomentsFree(stats->moments);
+	
+	free(stats);
+}
+
+int 
+FloatInspectorStatisticsEnableCardinality(FloatInspectorStatisticsRef stats,
+										  unsigned int precision) {
+	
+	if (stats->cardinality != NULL) {
+		
+		return stats->cardinality->precision == precision ? 0 : -1;
+	}
+	
+	stats->cardinality = FloatInspectorCardinalityCreate(precision);
+	
+	return stats->cardinality != NULL ? 0 : -1;
+}
+
+double 
+FloatInspectorStatisticsCardinality(const FloatInspectorStatisticsRef stats) {
+	
+	if (stats->cardinality == NULL) {
+		
+		return -1.;
+	}
+	
+	return FloatInspectorCardinalityEstimate(stats->cardinality);
+}
+
+int 
+FloatInspectorStatisticsEnableHeavyHitters(FloatInspectorStatisticsRef stats,
+										   unsigned int capacity) {
+	
+	if (stats->heavyHitters != NULL) {
+		
+		return FloatInspectorHeavyHittersCapacity(stats->heavyHitters) == capacity ? 0 : -1;
+	}
+	
+	stats->heavyHitters = FloatInspectorHeavyHittersCreate(capacity);
+	
+	return stats->heavyHitters != NULL ? 0 : -1;
+}
+
+int 
+FloatInspectorStatisticsEnableQuantiles(FloatInspectorStatisticsRef stats,
+										unsigned int k) {
+	
+	if (stats->magnitudes != NULL) {
+		
+		return FloatInspectorQuantilesK(stats->magnitudes) == k ? 0 : -1;
+	}
+	
+	stats->magnitudes = FloatInspectorQuantilesCreate(k);
+	
+	return stats->magnitudes != NULL ? 0 : -1;
+}
+
+int 
+FloatInspectorStatisticsEnableExponents(FloatInspectorStatisticsRef stats) {
+	
+	if (stats->exponents == NULL) {
+		
+		stats->exponents = FloatInspectorExponentsCreate(stats->nExponentBits,
+														 stats->nMantissaBits);
+	}
+	
+	return stats->exponents != NULL ? 0 : -1;
+}
+
+int 
+FloatInspectorStatisticsEnableMoments(FloatInspectorStatisticsRef stats) {
+	
+	if (stats->moments == NULL) {
+		
+		stats->moments = FloatInspectorMomentsCreate();
+	}
+	
+	return stats->moments != NULL ? 0 : -1;
+}
+
+double 
+FloatInspectorStatisticsMagnitudeQuantile(const FloatInspectorStatisticsRef stats,
+										  double rank) {
+	
+	if (stats->magnitudes == NULL) {
+		
+		return NAN;
+	}
+	
+	return FloatInspectorQuantilesGet(stats->magnitudes, rank);
+}
+
+double 
+FloatInspectorStatisticsExponentQuantile(const FloatInspectorStatisticsRef stats,
+										 double rank) {
+	
+	if (stats->exponents != NULL) {
+		
+		return FloatInspectorExponentsQuantile(stats->exponents, rank);
+	}
+	
+	/* The exponent grows monotonically with the magnitude, so the quantiles
+	 * of both coincide.  */
+	const double magnitude = FloatInspectorStatisticsMagnitudeQuantile(stats, rank);
+	
+	if (isnan(magnitude) || (magnitude == 0.)) {
+		
+		return magnitude == 0. ? -INFINITY : NAN;
+	}
+	
+	return (double) ilogb(magnitude);
+}
+
+void 
+FloatInspectorStatisticsUpdateWithFloat(FloatInspectorStatisticsRef stats, 
+										float f) {
+	
+	if (__builtin_expect(__atomic_load_n(&FloatInspectorPerfEnabled, __ATOMIC_RELAXED), 0)) {
+		
+		FloatInspectorPerfCountScalar(stats->type);
+	}
+	
+	FloatInspectorStatisticsAddMetaInformation(stats, 
+		FloatInspectorMetaInformationClassifyFloat(f));
+	
+	if (stats->cardinality != NULL) {
+		
+		FloatInspectorCardinalityAddWords32(stats->cardinality, &f, 1);
+	}
+	
+	if (stats->heavyHitters != NULL) {
+		
+		FloatInspectorHeavyHittersAddBytes(stats->heavyHitters, &f, sizeof(f));
+	}
+	
+	if ((stats->magnitudes != NULL) && isfinite(f)) {
+		
+		const double magnitude = fabs((double) f);
+		FloatInspectorQuantilesAdd(stats->magnitudes, &magnitude, 1);
+	}
+	
+	if (stats->exponents != NULL) {
+		
+		FloatInspectorExponentsAddWords32(stats->exponents, &f, 1);
+	}
+	
+	if (stats->moments != NULL) {
+		
+		FloatInspectorMomentsAddFloats(stats->moments, &f, 1);
+	}
+}
+
+void 
+FloatInspectorStatisticsUpdateWithDouble(FloatInspectorStatisticsRef stats, 
+										 double f) {
+	
+	if (__builtin_expect(__atomic_load_n(&FloatInspectorPerfEnabled, __ATOMIC_RELAXED), 0)) {
+		
+		FloatInspectorPerfCountScalar(stats->type);
+	}
+	
+	FloatInspectorStatisticsAddMetaInformation(stats, 
+		FloatInspectorMetaInformationClassifyDouble(f));
+	
+	if (stats->cardinality != NULL) {
+		
+		FloatInspectorCardinalityAddWords64(stats->cardinality, &f, 1);
+	}
+	
+	if (stats->heavyHitters != NULL) {
+		
+		FloatInspectorHeavyHittersAddBytes(stats->heavyHitters, &f, sizeof(f));
+	}
+	
+	if ((stats->magnitudes != NULL) && isfinite(f)) {
+		
+		const double magnitude = fabs(f);
+		FloatInspectorQuantilesAdd(stats->magnitudes, &magnitude, 1);
+	}
+	
+	if (stats->exponents != NULL) {
+		
+		FloatInspectorExponentsAddWords64(stats->exponents, &f, 1);
+	}
+	
+	if (stats->moments != NULL) {
+		
+		FloatInspectorMomentsAddDoubles(stats->moments, &f, 1);
+	}
+}
+
+void
+FloatInspectorStatisticsUpdateWithLongDouble(FloatInspectorStatisticsRef stats, 
+											 long double f) {
+	
+	if (__builtin_expect(__atomic_load_n(&FloatInspectorPerfEnabled, __ATOMIC_RELAXED), 0)) {
+		
+		FloatInspectorPerfCountScalar(stats->type);
+	}
+	
+	FloatInspectorMetaInformation meta = 
+	FloatInspectorMetaInformationCreateWithLongDouble(f);
+	
+	FloatInspectorStatisticsUpdateWithMetaInformation(stats, meta);
+	
+	FloatInspectorMetaInformationFree(meta);
+	
+	if (stats->cardinality != NULL) {
+		
+		FloatInspectorCardinalityAddBytes(stats->cardinality, &f, (stats->nBits + 7) / 8);
+	}
+	
+	if (stats->heavyHitters != NULL) {
+		
+		FloatInspectorHeavyHittersAddBytes(stats->heavyHitters, &f, (stats->nBits + 7) / 8);
+	}
+	
+	if ((stats->magnitudes != NULL) && isfinite(f)) {
+		
+		const double magnitude = FloatInspectorLongDoubleMagnitude(f);
+		FloatInspectorQuantilesAdd(stats->magnitudes, &magnitude, 1);
+	}
+	
+	if ((stats->exponents != NULL) && isfinite(f)) {
+		
+		FloatInspectorExponentsAdd(stats->exponents, signbit(f) != 0, 
+								   f != 0.L ? ilogbl(f) : 0, f == 0.L);
+	}
+	
+	if (stats->moments != NULL) {
+		
+		FloatInspectorMomentsAddLongDouble(stats->moments, f);
+	}
+}
+
+void 
+FloatInspectorStatisticsUpdateWithMetaInformation(FloatInspectorStatisticsRef stats,
+												  FloatInspectorMetaInformation meta) {
+	
+	FloatInspectorStatisticsAddMetaInformation(stats, meta);
+}
+
+void 
+FloatInspectorStatisticsUpdateWithFloats(FloatInspectorStatisticsRef stats,
+										 const float *restrict values,
+										 size_t n) {
+	
+	assert(stats->type == Float);
+	
+	FloatInspectorPerfPhase phase;
+	
+	FloatInspectorPerfBegin(&phase, Float, BulkPath);
+	
+	for (size_t block = 0; block < n; block += kFloatInspectorBulkBlock) {
+		
+		const size_t nBlock = n - block < kFloatInspectorBulkBlock ? 
+			n - block : kFloatInspectorBulkBlock;
+		
+		for (size_t i = block; i < block + nBlock; i++) {
+			
+			uint32_t bits;
+			memcpy(&bits, &values[i], sizeof(bits));
+			
+			FloatInspectorStatisticsAddMetaInformation(stats, 
+				FloatInspectorMetaInformationClassifyBits(bits, 
+														  kFloatInspectorFloatExponentBits, 
+														  kFloatInspectorFloatMantissaBits));
+		}
+		
+		if (stats->cardinality != NULL) {
+			
+			FloatInspectorCardinalityAddWords32(stats->cardinality, &values[block], nBlock);
+		}
+		
+		if (stats->heavyHitters != NULL) {
+			
+			FloatInspectorHeavyHittersAddWords32(stats->heavyHitters, &values[block], nBlock);
+		}
+		
+		if (stats->exponents != NULL) {
+			
+			FloatInspectorExponentsAddWords32(stats->exponents, &values[block], nBlock);
+		}
+		
+		if (stats->moments != NULL) {
+			
+			FloatInspectorMomentsAddFloats(stats->moments, &values[block], nBlock);
+		}
+		
+		if (stats->magnitudes != NULL) {
+			
+			double magnitudes[kFloatInspectorBulkBlock];
+			size_t nFinite = 0;
+			
+			for (size_t i = block; i < block + nBlock; i++) {
+				
+				magnitudes[nFinite] = fabs((double) values[i]);
+				nFinite += isfinite(values[i]) != 0;
+			}
+			
+			FloatInspectorQuantilesAdd(stats->magnitudes, magnitudes, nFinite);
+		}
+	}
+	
+	FloatInspectorPerfEnd(&phase, n);
+}
+
+void 
+FloatInspectorStatisticsUpdateWithDoubles(FloatInspectorStatisticsRef stats,
+										  const double *restrict values,
+										  size_t n) {
+	
+	assert(stats->type == Double);
+	
+	FloatInspectorPerfPhase phase;
+	
+	FloatInspectorPerfBegin(&phase, Double, BulkPath);
+	
+	for (size_t block = 0; block < n; block += kFloatInspectorBulkBlock) {
+		
+		const size_t nBlock = n - block < kFloatInspectorBulkBlock ? 
+			n - block : kFloatInspectorBulkBlock;
+		
+		for (size_t i = block; i < block + nBlock; i++) {
+			
+			uint64_t bits;
+			memcpy(&bits, &values[i], sizeof(bits));
+			
+			FloatInspectorStatisticsAddMetaInformation(stats, 
+				FloatInspectorMetaInformationClassifyBits(bits, 
+														  kFloatInspectorDoubleExponentBits, 
+														  kFloatInspectorDoubleMantissaBits));
+		}
+		
+		if (stats->cardinality != NULL) {
+			
+			FloatInspectorCardinalityAddWords64(stats->cardinality, &values[block], nBlock);
+		}
+		
+		if (stats->heavyHitters != NULL) {
+			
+			FloatInspectorHeavyHittersAddWords64(stats->heavyHitters, &values[block], nBlock);
+		}
+		
+		if (stats->exponents != NULL) {
+			
+			FloatInspectorExponentsAddWords64(stats->exponents, &values[block], nBlock);
+		}
+		
+		if (stats->moments != NULL) {
+			
+			FloatInspectorMomentsAddDoubles(stats->moments, &values[block], nBlock);
+		}
+		
+		if (stats->magnitudes != NULL) {
+			
+			double magnitudes[kFloatInspectorBulkBlock];
+			size_t nFinite = 0;
+			
+			for (size_t i = block; i < block + nBlock; i++) {
+				
+				magnitudes[nFinite] = fabs(values[i]);
+				nFinite += isfinite(values[i]) != 0;
+			}
+			
+			FloatInspectorQuantilesAdd(stats->magnitudes, magnitudes, nFinite);
+		}
+	}
+	
+	FloatInspectorPerfEnd(&phase, n);
+}
+
+void 
+FloatInspectorStatisticsUpdateWithLongDoubles(FloatInspectorStatisticsRef stats,
+											  const long double *restrict values,
+											  size_t n) {
+	
+	assert(stats->type == LongDouble);
+	
+	FloatInspectorPerfPhase phase;
+	
+	FloatInspectorPerfBegin(&phase, LongDouble, BulkPath);
+	
+	const unsigned int nMant = kFloatInspectorLongDoubleMantissaBits;
+	const unsigned int nExp = kFloatInspectorLongDoubleExponentBits;
+	
+	/* The generic decoder is the slow path, but at least decode into stack 
+	 * buffers instead of allocating them per value.  */
+	uint8_t exponent[sizeof(long double)];
+	uint8_t mantissa[sizeof(long double)];
+	
+	for (size_t i = 0; i < n; i++) {
+		
+		FloatInspectorStatisticsAddMetaInformation(stats, 
+			FloatInspectorMetaInformationDecodeGeneric(&values[i], nExp, nMant, 
+													   kFloatInspectorLongDoubleExplicitIntegerBit,
+													   exponent, mantissa));
+		
+		/* Only the significant bytes, the padding is undefined.  */
+		if (stats->cardinality != NULL) {
+			
+			FloatInspectorCardinalityAddBytes(stats->cardinality, &values[i], 
+											  (stats->nBits + 7) / 8);
+		}
+		
+		if (stats->heavyHitters != NULL) {
+			
+			FloatInspectorHeavyHittersAddBytes(stats->heavyHitters, &values[i], 
+											   (stats->nBits + 7) / 8);
+		}
+		
+		if ((stats->magnitudes != NULL) && isfinite(values[i])) {
+			
+			const double magnitude = FloatInspectorLongDoubleMagnitude(values[i]);
+			FloatInspectorQuantilesAdd(stats->magnitudes, &magnitude, 1);
+		}
+		
+		if ((stats->exponents != NULL) && isfinite(values[i])) {
+			
+			FloatInspectorExponentsAdd(stats->exponents, signbit(values[i]) != 0, 
+									   values[i] != 0.L ? ilogbl(values[i]) : 0, 
+									   values[i] == 0.L);
+		}
+		
+		if (stats->moments != NULL) {
+			
+			FloatInspectorMomentsAddLongDouble(stats->moments, values[i]);
+		}
+	}
+	
+	FloatInspectorPerfEnd(&phase, n);
+}
+
+void 
+FloatInspectorStatisticsUpdateWithHalfs(FloatInspectorStatisticsRef stats,
+										const uint16_t *restrict values,
+										size_t n) {
+	
+	assert(stats->type == Half);
+	
+	FloatInspectorPerfPhase phase;
+	
+	FloatInspectorPerfBegin(&phase, Half, BulkPath);
+	FloatInspectorStatisticsUpdateWithWords16(stats, values, n, 
+											  kFloatInspectorHalfExponentBits, 
+											  kFloatInspectorHalfMantissaBits);
+	FloatInspectorPerfEnd(&phase, n);
+}
+
+void 
+FloatInspectorStatisticsUpdateWithBFloat16s(FloatInspectorStatisticsRef stats,
+											const uint16_t *restrict values,
+											size_t n) {
+	
+	assert(stats->type == BFloat16);
+	
+	FloatInspectorPerfPhase phase;
+	
+	FloatInspectorPerfBegin(&phase, BFloat16, BulkPath);
+	FloatInspectorStatisticsUpdateWithWords16(stats, values, n, 
+											  kFloatInspectorBFloat16ExponentBits, 
+											  kFloatInspectorBFloat16MantissaBits);
+	FloatInspectorPerfEnd(&phase, n);
+}
+
+float 
+FloatInspectorHalfToFloat(uint16_t bits) {
+	
+	return FloatInspectorWords16ToFloat(bits, Half);
+}
+
+float 
+FloatInspectorBFloat16ToFloat(uint16_t bits) {
+	
+	return FloatInspectorWords16ToFloat(bits, BFloat16);
+}
+
+void 
+FloatInspectorStatisticsPrint(const FloatInspectorStatisticsRef stats,
+							  FILE *restrict stream) {
+	
+	fprintf(stream, "--- Statistics ---\n\n");
+	
+	switch (stats->type) {
+		case Float:
+			fprintf(stream, "Type: float\n");
+			break;
 			
 		case Double:
 			fprintf(stream, "Type: double\n");
@@ -632,17 +1789,25 @@ FloatInspectorStatisticsPrint(const FloatInspectorStatisticsRef stats,
 		case LongDouble:
 			fprintf(stream, "Type: long double\n");
 			break;
+			
+		case Half:
+			fprintf(stream, "Type: half\n");
+			break;
+			
+		case BFloat16:
+			fprintf(stream, "Type: bfloat16\n");
+			break;
 	}
 	
 	/* Coarse grained statistics.  */
 	fprintf(stream,
-			"%u entries overall,\n\n"
-			"%u normalized numbers,\n"
-			"%u denormalized numbers,\n"
-			"%u positive numbers,\n"
-			"%u negatvie numbers,\n"
-			"%u NaNs,\n"
-			"%u times infinity.\n",
+			"%" PRIu64 " entries overall,\n\n"
+			"%" PRIu64 " normalized numbers,\n"
+			"%" PRIu64 " denormalized numbers,\n"
+			"%" PRIu64 " positive numbers,\n"
+			"%" PRIu64 " negatvie numbers,\n"
+			"%" PRIu64 " NaNs,\n"
+			"%" PRIu64 " times infinity.\n",
 			stats->nEntries,
 			stats->nNormalized,
 			stats->nDenormalized,
@@ -658,6 +1823,52 @@ FloatInspectorStatisticsPrint(const FloatInspectorStatisticsRef stats,
 			stats->nExponentBits,
 			stats->nMantissaBits);
 	
+	if (stats->moments != NULL) {
+		
+		fprintf(stream, 
+				"%" PRIu64 " finite values, minimum %g, maximum %g,\n"
+				"sum %.17g, mean %.17g, variance %.17g.\n",
+				stats->moments->n,
+				stats->moments->minimum,
+				stats->moments->maximum,
+				FloatInspectorMomentsSum(stats->moments),
+				FloatInspectorMomentsMean(stats->moments),
+				FloatInspectorMomentsVariance(stats->moments));
+		
+		if (stats->moments->nOutOfRange != 0) {
+			
+			fprintf(stream, 
+					"%" PRIu64 " finite values beyond the double range are not included.\n",
+					stats->moments->nOutOfRange);
+		}
+		
+		fprintf(stream, "\n");
+	}
+	
+	if (stats->cardinality != NULL) {
+		
+		fprintf(stream, 
+				"About %.0f distinct values (HyperLogLog, %u registers, %.1f%% error).\n\n",
+				FloatInspectorCardinalityEstimate(stats->cardinality),
+				1u << stats->cardinality->precision,
+				104. / sqrt((double) (1u << stats->cardinality->precision)));
+	}
+	
+	if (stats->heavyHitters != NULL) {
+		
+		FloatInspectorStatisticsPrintHeavyHitters(stats, stream);
+	}
+	
+	if (stats->magnitudes != NULL) {
+		
+		FloatInspectorStatisticsPrintQuantiles(stats, stream);
+	}
+	
+	if (stats->exponents != NULL) {
+		
+		FloatInspectorStatisticsPrintExponents(stats, stream);
+	}
+	
 	fprintf(stream, "Non-zero bits of positive normalized numbers:\n");
 	
 	for (unsigned int row = 0; row < stats->nMantissaBits + 1; row++) {
@@ -665,7 +1876,7 @@ FloatInspectorStatisticsPrint(const FloatInspectorStatisticsRef stats,
 			
 			const unsigned int idx = row * (stats->nExponentBits + 1) + col;
 			fprintf(stream, 
-					"%u\t", 
+					"%" PRIu64 "\t", 
 					stats->nNonZeroBitsNormalizedPositive[idx]);
 		}
 		fprintf(stream, "\n");
@@ -679,7 +1890,7 @@ FloatInspectorStatisticsPrint(const FloatInspectorStatisticsRef stats,
 			
 			const unsigned int idx = row * (stats->nExponentBits + 1) + col;
 			fprintf(stream, 
-					"%u\t", 
+					"%" PRIu64 "\t", 
 					stats->nNonZeroBitsNormalizedNegative[idx]);
 		}
 		fprintf(stream, "\n");
@@ -691,7 +1902,7 @@ FloatInspectorStatisticsPrint(const FloatInspectorStatisticsRef stats,
 	for (unsigned int row = 0; row < stats->nMantissaBits + 1; row++) {
 	
 		fprintf(stream, 
-				"%u\n", 
+				"%" PRIu64 "\n", 
 				stats->nNonZeroBitsDenormalizedPositive[row]);
 	}
 	fprintf(stream, "\n\n");
@@ -701,10 +1912,14 @@ FloatInspectorStatisticsPrint(const FloatInspectorStatisticsRef stats,
 	for (unsigned int row = 0; row < stats->nMantissaBits + 1; row++) {
 		
 		fprintf(stream, 
-				"%u\n", 
+				"%" PRIu64 "\n", 
 				stats->nNonZeroBitsDenormalizedNegative[row]);
 	}
 	fprintf(stream, "\n\n");
 	
+	if (FloatInspectorPerfIsEnabled()) {
+		
+		FloatInspectorPerfPrintType(stats->type, stream);
+	}
 }
 
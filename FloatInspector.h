@@ -33,8 +33,15 @@
 #define FloatInspector_FloatInspector_h
 
 #include <inttypes.h>
+#include <stddef.h>
 #include <stdio.h>
 
+#include "FloatInspectorCardinality.h"
+#include "FloatInspectorExponents.h"
+#include "FloatInspectorHeavyHitters.h"
+#include "FloatInspectorMoments.h"
+#include "FloatInspectorQuantiles.h"
+
 #pragma mark Data Types
 
 /* Datatype that contains some meta information about a given floating
@@ -82,19 +89,24 @@ typedef struct {
 /* Datatype to store statistical information about the usage of flaots.  */
 typedef struct {
 	
-	/* Coarse grained statistics.  */
-	unsigned int nEntries;
-	unsigned int nDenormalized;
-	unsigned int nNormalized;
-	unsigned int nNegative;
-	unsigned int nPositive;
-	unsigned int nNaN;
-	unsigned int nInf;
+	/* Coarse grained statistics. All counters are 64 bit, so aggregates of
+	 * long running inspections do not wrap.  */
+	uint64_t nEntries;
+	uint64_t nDenormalized;
+	uint64_t nNormalized;
+	uint64_t nNegative;
+	uint64_t nPositive;
+	uint64_t nNaN;
+	uint64_t nInf;
 	
 	enum PrecisionType {
 		Float,
 		Double,
-		LongDouble
+		LongDouble,
+		/* IEEE 754 binary16.  */
+		Half,
+		/* Upper half of a float, as used for machine learning weights.  */
+		BFloat16
 	} type;
 	
 	/* Fine grained statistics.  */
@@ -102,12 +114,18 @@ typedef struct {
 	unsigned int nExponentBits;
 	unsigned int nMantissaBits;
 	
-	unsigned int * restrict nNonZeroBitsNormalizedPositive;
-	unsigned int * restrict nNonZeroBitsDenormalizedPositive;
+	uint64_t * restrict nNonZeroBitsNormalizedPositive;
+	uint64_t * restrict nNonZeroBitsDenormalizedPositive;
 	
-	unsigned int * restrict nNonZeroBitsNormalizedNegative;
-	unsigned int * restrict nNonZeroBitsDenormalizedNegative;
+	uint64_t * restrict nNonZeroBitsNormalizedNegative;
+	uint64_t * restrict nNonZeroBitsDenormalizedNegative;
 	
+	/* Optional sketches, NULL unless enabled.  */
+	FloatInspectorCardinalityRef cardinality;
+	FloatInspectorHeavyHittersRef heavyHitters;
+	FloatInspectorQuantilesRef magnitudes;
+	FloatInspectorExponentsRef exponents;
+	FloatInspectorMomentsRef moments;
 	
 } _FloatInspectorStatistics;
 typedef _FloatInspectorStatistics* FloatInspectorStatisticsRef;
@@ -128,6 +146,14 @@ FloatInspectorMetaInformationCreateWithDouble(double f);
 const FloatInspectorMetaInformation 
 FloatInspectorMetaInformationCreateWithLongDouble(long double f);
 
+/* Same as the Create functions above, but without exponent and mantissa 
+ * bytes (both NULL). These never allocate and need not be freed.  */
+FloatInspectorMetaInformation 
+FloatInspectorMetaInformationClassifyFloat(float f);
+
+FloatInspectorMetaInformation 
+FloatInspectorMetaInformationClassifyDouble(double f);
+
 void 
 FloatInspectorMetaInformationFree(const FloatInspectorMetaInformation meta);
 
@@ -137,9 +163,87 @@ FloatInspectorMetaInformationDescription(const FloatInspectorMetaInformation met
 FloatInspectorStatisticsRef FloatInspectorStatisticsCreateFloat(void);
 FloatInspectorStatisticsRef FloatInspectorStatisticsCreateDouble(void);
 FloatInspectorStatisticsRef FloatInspectorStatisticsCreateLongDouble(void);
+FloatInspectorStatisticsRef FloatInspectorStatisticsCreateHalf(void);
+FloatInspectorStatisticsRef FloatInspectorStatisticsCreateBFloat16(void);
+FloatInspectorStatisticsRef FloatInspectorStatisticsCreate(enum PrecisionType type);
+
+/* Returns a deep copy of the given statistics or NULL if out of memory.  */
+FloatInspectorStatisticsRef 
+FloatInspectorStatisticsCopy(const FloatInspectorStatisticsRef stats);
+
+/* Clears all counters and histograms.  */
+void FloatInspectorStatisticsReset(FloatInspectorStatisticsRef stats);
+
+/* Adds the counters, histograms and sketches of src to dst. Returns 0 on 
+ * success and -1, leaving dst unchanged, if both objects do not describe the
+ * same floating point format, sketches attached to both have different 
+ * parameters or the counters would overflow. Sketches only stay attached if
+ * they cover all values: one only src has is copied if dst is empty, one 
+ * only dst has is dropped unless src is empty. A sketch whose merge runs out
+ * of memory is dropped as well.  */
+int FloatInspectorStatisticsMerge(FloatInspectorStatisticsRef dst,
+								  const FloatInspectorStatisticsRef src);
+
+/* Number of cells of a normalized resp. denormalized histogram.  */
+size_t 
+FloatInspectorStatisticsNormalizedCells(const FloatInspectorStatisticsRef stats);
+size_t 
+FloatInspectorStatisticsDenormalizedCells(const FloatInspectorStatisticsRef stats);
 
 void FloatInspectorStatisticsFree(FloatInspectorStatisticsRef stats);
 
+/* Attaches a HyperLogLog sketch of distinct bit patterns with 2^precision 
+ * registers, fed by the float, double, long double and 16 bit update paths (not by
+ * FloatInspectorStatisticsUpdateWithMetaInformation). Enable it before the
+ * first update. Returns 0 on success and -1 on failure or if a sketch of 
+ * another precision is attached already. The sketch is off by default: 
+ * on a 2.1 GHz Xeon hashing every value costs about 2.3 ns per double, a 
+ * third on top of the 7 ns the histograms take, and 1.2 ns per float once 
+ * the stream is long next to 2^precision (2 ns before that).  */
+int FloatInspectorStatisticsEnableCardinality(FloatInspectorStatisticsRef stats,
+											  unsigned int precision);
+
+/* Estimated number of distinct values or -1 if no sketch is attached.  */
+double FloatInspectorStatisticsCardinality(const FloatInspectorStatisticsRef stats);
+
+/* Attaches a summary of the capacity most frequent bit patterns, fed by the
+ * same paths as the cardinality sketch. Returns 0 on success and -1 on 
+ * failure or if a summary of another capacity is attached already.  */
+int FloatInspectorStatisticsEnableHeavyHitters(FloatInspectorStatisticsRef stats,
+											   unsigned int capacity);
+
+/* Attaches a quantile sketch of the magnitudes of all finite values, fed by
+ * the same paths as the cardinality sketch. Long double magnitudes are 
+ * rounded to double, the ones beyond its range count as DBL_MAX. Returns 0
+ * on success and -1 on failure or if a sketch of another k is attached 
+ * already.  */
+int FloatInspectorStatisticsEnableQuantiles(FloatInspectorStatisticsRef stats,
+											unsigned int k);
+
+/* Magnitude of the given rank in [0, 1], NAN if no sketch is attached or no
+ * finite value was seen.  */
+double FloatInspectorStatisticsMagnitudeQuantile(const FloatInspectorStatisticsRef stats,
+												 double rank);
+
+/* Attaches a histogram of the unbiased exponents of all finite values, fed 
+ * by the same paths as the cardinality sketch. Returns 0 on success and -1
+ * on failure.  */
+int FloatInspectorStatisticsEnableExponents(FloatInspectorStatisticsRef stats);
+
+/* Attaches running moments (extrema, compensated sum, mean and variance) of
+ * all finite values, fed by the same paths as the cardinality sketch. Long 
+ * doubles are rounded to double, those beyond its range are only counted in
+ * nOutOfRange and reported by FloatInspectorStatisticsPrint. Returns 0 on 
+ * success and -1 on failure.  */
+int FloatInspectorStatisticsEnableMoments(FloatInspectorStatisticsRef stats);
+
+/* Unbiased exponent of the magnitude of the given rank. Exact if the 
+ * exponent histogram is attached, otherwise derived from the magnitude 
+ * quantile. Zero has exponent -INFINITY, NAN is returned if neither is 
+ * attached or no finite value was seen.  */
+double FloatInspectorStatisticsExponentQuantile(const FloatInspectorStatisticsRef stats,
+												double rank);
+
 void FloatInspectorStatisticsUpdateWithFloat(FloatInspectorStatisticsRef stats, 
 									float f);
 
@@ -152,6 +256,35 @@ void FloatInspectorStatisticsUpdateWithLongDouble(FloatInspectorStatisticsRef st
 void FloatInspectorStatisticsUpdateWithMetaInformation(FloatInspectorStatisticsRef stats,
 													   FloatInspectorMetaInformation meta);
 
+/* Bulk classification paths. Float and double values are classified on the
+ * bit level without allocating, long doubles go through the generic 
+ * decoder.  */
+void FloatInspectorStatisticsUpdateWithFloats(FloatInspectorStatisticsRef stats,
+											  const float *restrict values,
+											  size_t n);
+
+void FloatInspectorStatisticsUpdateWithDoubles(FloatInspectorStatisticsRef stats,
+											   const double *restrict values,
+											   size_t n);
+
+void FloatInspectorStatisticsUpdateWithLongDoubles(FloatInspectorStatisticsRef stats,
+												   const long double *restrict values,
+												   size_t n);
+
+/* Bulk paths of the 16 bit formats, which have no C type. Values are bit
+ * patterns in native byte order.  */
+void FloatInspectorStatisticsUpdateWithHalfs(FloatInspectorStatisticsRef stats,
+											 const uint16_t *restrict values,
+											 size_t n);
+
+void FloatInspectorStatisticsUpdateWithBFloat16s(FloatInspectorStatisticsRef stats,
+												 const uint16_t *restrict values,
+												 size_t n);
+
+/* Exact conversions of 16 bit patterns, NaN payloads are kept.  */
+float FloatInspectorHalfToFloat(uint16_t bits);
+float FloatInspectorBFloat16ToFloat(uint16_t bits);
+
 void FloatInspectorStatisticsPrint(const FloatInspectorStatisticsRef stats,
 								   FILE *restrict stream);
 
@@ -0,0 +1,1708 @@
+//
+//  FloatInspectorAggregator.c
+//  FloatInspector
+//  
+//  Copyright 2011 Stefan Reinhold <stefan@sreinhold.com>. All rights reserved.
+//  
+//  Redistribution and use in source and binary forms, with or without modification, are
+//  permitted provided that the following conditions are met:
+//  
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//  
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list
+//  of conditions and the following disclaimer in the documentation and/or other materials
+//  provided with the distribution.
+//  
+//  THIS SOFTWARE IS PROVIDED BY STEFAN REINHOLD ``AS IS'' AND ANY EXPRESS OR IMPLIED
+//  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STEFAN REINHOLD OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+//  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+//  ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//  
+//  The views and conclusions contained in the software and documentation are those of the
+//  authors and should not be interpreted as representing official policies, either expressed
+//  or implied, of Stefan Reinhold.
+//  
+
+
+
+#define _GNU_SOURCE
+
+#include "FloatInspectorAggregator.h"
+#include "FloatInspectorSnapshot.h"
+#include "FloatInspectorTable.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#endif
+
+#pragma mark Data Types
+
+typedef enum {
+	DeltaFrame = 1,
+	QueryFrame = 2,
+	StatisticsFrame = 3,
+	UnknownFrame = 4
+} FloatInspectorAggregatorFrame;
+
+typedef struct {
+	
+	char *name;
+	size_t length;
+	uint64_t hash;
+	FloatInspectorStatisticsRef stats;
+	unsigned long long nDeltas;
+	
+} FloatInspectorAggregate;
+
+/* Index entry, the upper half of the hash saves most name comparisons.  */
+typedef struct {
+	
+	uint32_t tag;
+	/* Aggregate plus one, 0 marks an empty slot.  */
+	uint32_t aggregate;
+	
+} FloatInspectorAggregatorSlot;
+
+typedef struct {
+	
+	/* -1 if the slot is free.  */
+	int fd;
+	/* Registered for writability.  */
+	int writing;
+	unsigned int nextFree;
+	
+	/* Start of a frame that has not arrived completely.  */
+	uint8_t *pending;
+	size_t nPending;
+	size_t pendingCapacity;
+	
+	/* Replies the socket did not take yet.  */
+	uint8_t *out;
+	size_t nOut;
+	size_t nSent;
+	size_t outCapacity;
+	
+} FloatInspectorAggregatorConnection;
+
+/* Something to handle, the token is the wake pipe, the listening socket 
+ * or a connection slot.  */
+typedef struct {
+	
+	unsigned int token;
+	int readable;
+	int writable;
+	
+} FloatInspectorAggregatorEvent;
+
+struct _FloatInspectorAggregator {
+	
+	FloatInspectorAggregatorOptions options;
+	char *path;
+	int listenFd;
+	/* Accepting, off while all connection slots are taken.  */
+	int listening;
+	int wake[2];
+	
+#if defined(__linux__)
+	int epollFd;
+	struct epoll_event *epollEvents;
+#else
+	struct pollfd *pollFds;
+	unsigned int *pollTokens;
+#endif
+	FloatInspectorAggregatorEvent *events;
+	
+	FloatInspectorAggregatorConnection *connections;
+	unsigned int nOpen;
+	unsigned int freeSlot;
+	
+	/* Reads of connections without pending bytes land here, so a client 
+	 * that sends whole frames and leaves never costs an allocation.  */
+	uint8_t *buffer;
+	
+	/* Guards the aggregates and counters against copies and prints.  */
+	pthread_mutex_t lock;
+	FloatInspectorAggregate *aggregates;
+	size_t nAggregates;
+	size_t capacity;
+	/* Power of two, at most half full.  */
+	FloatInspectorAggregatorSlot *slots;
+	size_t nSlots;
+	unsigned long long nAccepted;
+	unsigned long long nFrames;
+	unsigned long long nQueries;
+	unsigned long long nRejected;
+};
+
+typedef struct {
+	
+	char *name;
+	size_t length;
+	/* What the daemon has been sent.  */
+	FloatInspectorStatisticsRef sent;
+	
+} FloatInspectorClientSeries;
+
+struct _FloatInspectorClient {
+	
+	FloatInspectorClientOptions options;
+	struct sockaddr_un address;
+	/* -1 while disconnected.  */
+	int fd;
+	
+	uint8_t *buffer;
+	size_t nBuffered;
+	size_t nSent;
+	
+	FloatInspectorClientSeries *series;
+	size_t nSeries;
+	size_t capacity;
+	
+	/* Replies still to come for queries that were given up on.  */
+	unsigned int nUnanswered;
+	uint8_t *reply;
+	size_t nReply;
+	size_t replyCapacity;
+};
+
+#pragma mark Constants
+
+const FloatInspectorAggregatorOptions kFloatInspectorAggregatorDefaultOptions = {
+	.backlog		= 1024,
+	.maxConnections	= 4096,
+	.maxFrameSize	= (size_t) 1 << 20
+};
+
+const FloatInspectorClientOptions kFloatInspectorClientDefaultOptions = {
+	.bufferSize		= (size_t) 256 << 10,
+	.batchSize		= (size_t) 4 << 10
+};
+
+/* Length, kind and name length bytes.  */
+#define kFloatInspectorAggregatorFrameHeader	6
+#define kFloatInspectorAggregatorMaxName		255
+#define kFloatInspectorAggregatorBufferSize		((size_t) 64 << 10)
+#define kFloatInspectorAggregatorMaxEvents		256
+/* Reads of one connection per event, the rest waits for the next round.  */
+#define kFloatInspectorAggregatorMaxReads		16
+#define kFloatInspectorAggregatorNoSlot			UINT_MAX
+#define kFloatInspectorAggregatorWakeToken		0
+#define kFloatInspectorAggregatorListenToken	1
+#define kFloatInspectorAggregatorFirstSlot		2
+
+#if defined(MSG_NOSIGNAL)
+#define kFloatInspectorAggregatorSendFlags		MSG_NOSIGNAL
+#else
+#define kFloatInspectorAggregatorSendFlags		0
+#endif
+
+#pragma mark Private Function Prototypes
+
+static void FloatInspectorAggregatorPut32(uint8_t *p, uint32_t value);
+static uint32_t FloatInspectorAggregatorGet32(const uint8_t *p);
+
+static int FloatInspectorAggregatorConfigure(int fd);
+
+static int FloatInspectorAggregatorWatch(FloatInspectorAggregatorRef aggregator,
+										 int fd,
+										 unsigned int token,
+										 int writable,
+										 int add);
+
+static int FloatInspectorAggregatorWait(FloatInspectorAggregatorRef aggregator);
+
+static FloatInspectorAggregate *
+FloatInspectorAggregatorFind(FloatInspectorAggregatorRef aggregator,
+							 const uint8_t *name,
+							 size_t length);
+
+static void FloatInspectorAggregatorIndex(FloatInspectorAggregatorSlot *slots,
+										  size_t nSlots,
+										  uint64_t hash,
+										  size_t aggregate);
+
+static int FloatInspectorAggregatorGrowIndex(FloatInspectorAggregatorRef aggregator);
+
+static void FloatInspectorAggregatorDeliver(FloatInspectorAggregatorRef aggregator,
+											const uint8_t *name,
+											size_t length,
+											const uint8_t *diff,
+											size_t size);
+
+static int FloatInspectorAggregatorReply(FloatInspectorAggregatorRef aggregator,
+										 FloatInspectorAggregatorConnection *connection,
+										 const uint8_t *name,
+										 size_t length);
+
+static long FloatInspectorAggregatorProcess(FloatInspectorAggregatorRef aggregator,
+											FloatInspectorAggregatorConnection *connection,
+											const uint8_t *data,
+											size_t size);
+
+static void FloatInspectorAggregatorAccept(FloatInspectorAggregatorRef aggregator);
+
+static void FloatInspectorAggregatorClose(FloatInspectorAggregatorRef aggregator,
+										  unsigned int slot);
+
+static void FloatInspectorAggregatorRead(FloatInspectorAggregatorRef aggregator,
+										 unsigned int slot);
+
+static void FloatInspectorAggregatorWrite(FloatInspectorAggregatorRef aggregator,
+										  unsigned int slot);
+
+static int FloatInspectorClientConnect(FloatInspectorClientRef client);
+
+static size_t FloatInspectorClientFrameStart(FloatInspectorClientRef client);
+
+static void FloatInspectorClientDisconnect(FloatInspectorClientRef client);
+
+static void FloatInspectorClientCompact(FloatInspectorClientRef client);
+
+static FloatInspectorClientSeries *
+FloatInspectorClientFindSeries(FloatInspectorClientRef client,
+							   const char *name,
+							   size_t length,
+							   enum PrecisionType type);
+
+static double FloatInspectorClientNow(void);
+
+#pragma mark Private Functions Implementations
+
+static void 
+FloatInspectorAggregatorPut32(uint8_t *p, uint32_t value) {
+	
+	for (unsigned int i = 0; i < 4; i++) {
+		
+		p[i] = (uint8_t) (value >> (8 * i));
+	}
+}
+
+static uint32_t 
+FloatInspectorAggregatorGet32(const uint8_t *p) {
+	
+	return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | 
+		((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+/* Non-blocking, closed on exec and, where sends cannot ask for it, without
+ * SIGPIPE.  */
+static int 
+FloatInspectorAggregatorConfigure(int fd) {
+	
+	const int flags = fcntl(fd, F_GETFL);
+	
+	if ((flags == -1) || 
+		(fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1) ||
+		(fcntl(fd, F_SETFD, FD_CLOEXEC) == -1)) {
+		
+		return -1;
+	}
+	
+#if defined(SO_NOSIGPIPE)
+	const int on = 1;
+	
+	setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+	
+	return 0;
+}
+
+/* Adds fd or changes what it is watched for. Without epoll the set is 
+ * rebuilt from the connections on every wait, so there is nothing to do.  */
+static int 
+FloatInspectorAggregatorWatch(FloatInspectorAggregatorRef aggregator,
+							  int fd,
+							  unsigned int token,
+							  int writable,
+							  int add) {
+	
+#if defined(__linux__)
+	struct epoll_event event;
+	
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN | (writable ? EPOLLOUT : 0);
+	event.data.u32 = token;
+	
+	return epoll_ctl(aggregator->epollFd, add ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, fd, &event);
+#else
+	(void) aggregator;
+	(void) fd;
+	(void) token;
+	(void) writable;
+	(void) add;
+	
+	return 0;
+#endif
+}
+
+/* Fills the event list, returns the number of events or -1.  */
+static int 
+FloatInspectorAggregatorWait(FloatInspectorAggregatorRef aggregator) {
+	
+#if defined(__linux__)
+	const int n = epoll_wait(aggregator->epollFd, aggregator->epollEvents, 
+							 kFloatInspectorAggregatorMaxEvents, -1);
+	
+	for (int i = 0; i < n; i++) {
+		
+		const uint32_t events = aggregator->epollEvents[i].events;
+		
+		aggregator->events[i].token = aggregator->epollEvents[i].data.u32;
+		aggregator->events[i].readable = (events & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0;
+		aggregator->events[i].writable = (events & EPOLLOUT) != 0;
+	}
+	
+	return n;
+#else
+	struct pollfd *fds = aggregator->pollFds;
+	unsigned int nFds = 0;
+	
+	fds[nFds].fd = aggregator->wake[0];
+	fds[nFds].events = POLLIN;
+	aggregator->pollTokens[nFds++] = kFloatInspectorAggregatorWakeToken;
+	
+	if (aggregator->listening) {
+		
+		fds[nFds].fd = aggregator->listenFd;
+		fds[nFds].events = POLLIN;
+		aggregator->pollTokens[nFds++] = kFloatInspectorAggregatorListenToken;
+	}
+	
+	for (unsigned int s = 0; s < aggregator->options.maxConnections; s++) {
+		
+		const FloatInspectorAggregatorConnection *connection = &aggregator->connections[s];
+		
+		if (connection->fd != -1) {
+			
+			fds[nFds].fd = connection->fd;
+			fds[nFds].events = POLLIN | (connection->writing ? POLLOUT : 0);
+			aggregator->pollTokens[nFds++] = kFloatInspectorAggregatorFirstSlot + s;
+		}
+	}
+	
+	if (poll(fds, nFds, -1) < 0) {
+		
+		return -1;
+	}
+	
+	int n = 0;
+	
+	for (unsigned int i = 0; (i < nFds) && (n < kFloatInspectorAggregatorMaxEvents); i++) {
+		
+		if (fds[i].revents != 0) {
+			
+			aggregator->events[n].token = aggregator->pollTokens[i];
+			aggregator->events[n].readable = 
+				(fds[i].revents & (POLLIN | POLLHUP | POLLERR)) != 0;
+			aggregator->events[n].writable = (fds[i].revents & POLLOUT) != 0;
+			n++;
+		}
+	}
+	
+	return n;
+#endif
+}
+
+/* Called with the lock held. Linear probing from the hash of the name.  */
+static FloatInspectorAggregate *
+FloatInspectorAggregatorFind(FloatInspectorAggregatorRef aggregator,
+							 const uint8_t *name,
+							 size_t length) {
+	
+	if (aggregator->nSlots == 0) {
+		
+		return NULL;
+	}
+	
+	const uint64_t hash = FloatInspectorTableHash(name, length);
+	const size_t mask = aggregator->nSlots - 1;
+	const uint32_t tag = (uint32_t) (hash >> 32);
+	
+	for (size_t i = (size_t) hash & mask;; i = (i + 1) & mask) {
+		
+		const FloatInspectorAggregatorSlot slot = aggregator->slots[i];
+		
+		if (slot.aggregate == 0) {
+			
+			return NULL;
+		}
+		
+		FloatInspectorAggregate *aggregate = &aggregator->aggregates[slot.aggregate - 1];
+		
+		if ((slot.tag == tag) && (aggregate->length == length) && 
+			(memcmp(aggregate->name, name, length) == 0)) {
+			
+			return aggregate;
+		}
+	}
+}
+
+static void 
+FloatInspectorAggregatorIndex(FloatInspectorAggregatorSlot *slots,
+							  size_t nSlots,
+							  uint64_t hash,
+							  size_t aggregate) {
+	
+	size_t i = (size_t) hash & (nSlots - 1);
+	
+	while (slots[i].aggregate != 0) {
+		
+		i = (i + 1) & (nSlots - 1);
+	}
+	
+	slots[i].tag = (uint32_t) (hash >> 32);
+	slots[i].aggregate = (uint32_t) aggregate + 1;
+}
+
+/* Called with the lock held. Rehashes from the stored hashes.  */
+static int 
+FloatInspectorAggregatorGrowIndex(FloatInspectorAggregatorRef aggregator) {
+	
+	const size_t nSlots = aggregator->nSlots == 0 ? 64 : 2 * aggregator->nSlots;
+	FloatInspectorAggregatorSlot *slots = calloc(nSlots, sizeof(FloatInspectorAggregatorSlot));
+	
+	if (slots == NULL) {
+		
+		return -1;
+	}
+	
+	for (size_t a = 0; a < aggregator->nAggregates; a++) {
+		
+		FloatInspectorAggregatorIndex(slots, nSlots, aggregator->aggregates[a].hash, a);
+	}
+	
+	free(aggregator->slots);
+	aggregator->slots = slots;
+	aggregator->nSlots = nSlots;
+	
+	return 0;
+}
+
+/* Called with the lock held. Diffs that do not parse or do not match the
+ * format of their aggregate are counted and dropped.  */
+static void 
+FloatInspectorAggregatorDeliver(FloatInspectorAggregatorRef aggregator,
+								const uint8_t *name,
+								size_t length,
+								const uint8_t *diff,
+								size_t size) {
+	
+	FloatInspectorStatisticsDiffRef decoded = FloatInspectorStatisticsDiffDecode(diff, size);
+	
+	if (decoded == NULL) {
+		
+		aggregator->nRejected++;
+		return;
+	}
+	
+	FloatInspectorAggregate *aggregate = FloatInspectorAggregatorFind(aggregator, name, length);
+	
+	if (aggregate != NULL) {
+		
+		if (FloatInspectorStatisticsDiffApply(aggregate->stats, decoded) == 0) {
+			
+			aggregate->nDeltas++;
+		}
+		else {
+			
+			aggregator->nRejected++;
+		}
+		
+		FloatInspectorStatisticsDiffFree(decoded);
+		return;
+	}
+	
+	FloatInspectorStatisticsRef stats = FloatInspectorStatisticsCreate(decoded->type);
+	char *copy = malloc(length + 1);
+	
+	if (aggregator->nAggregates == aggregator->capacity) {
+		
+		const size_t capacity = aggregator->capacity == 0 ? 16 : 2 * aggregator->capacity;
+		FloatInspectorAggregate *aggregates = realloc(aggregator->aggregates, 
+													  capacity * sizeof(FloatInspectorAggregate));
+		
+		if (aggregates != NULL) {
+			
+			aggregator->aggregates = aggregates;
+			aggregator->capacity = capacity;
+		}
+	}
+	
+	if ((2 * (aggregator->nAggregates + 1) > aggregator->nSlots) && 
+		(aggregator->nAggregates < UINT32_MAX - 1)) {
+		
+		FloatInspectorAggregatorGrowIndex(aggregator);
+	}
+	
+	if ((stats == NULL) || (copy == NULL) || 
+		(aggregator->nAggregates == aggregator->capacity) ||
+		(2 * (aggregator->nAggregates + 1) > aggregator->nSlots) ||
+		(FloatInspectorStatisticsDiffApply(stats, decoded) != 0)) {
+		
+		if (stats != NULL) FloatInspectorStatisticsFree(stats);
+		free(copy);
+		FloatInspectorStatisticsDiffFree(decoded);
+		aggregator->nRejected++;
+		return;
+	}
+	
+	memcpy(copy, name, length);
+	copy[length] = '\0';
+	
+	aggregate = &aggregator->aggregates[aggregator->nAggregates];
+	aggregate->name = copy;
+	aggregate->length = length;
+	aggregate->hash = FloatInspectorTableHash(name, length);
+	aggregate->stats = stats;
+	aggregate->nDeltas = 1;
+	FloatInspectorAggregatorIndex(aggregator->slots, aggregator->nSlots, aggregate->hash, 
+								  aggregator->nAggregates++);
+	
+	FloatInspectorStatisticsDiffFree(decoded);
+}
+
+/* Called with the lock held. Appends the aggregate of name, encoded as 
+ * the diff from an empty object, or an unknown frame to the replies.  */
+static int 
+FloatInspectorAggregatorReply(FloatInspectorAggregatorRef aggregator,
+							  FloatInspectorAggregatorConnection *connection,
+							  const uint8_t *name,
+							  size_t length) {
+	
+	FloatInspectorAggregate *aggregate = FloatInspectorAggregatorFind(aggregator, name, length);
+	FloatInspectorStatisticsRef empty = NULL;
+	FloatInspectorStatisticsDiffRef diff = NULL;
+	
+	aggregator->nQueries++;
+	
+	if (aggregate != NULL) {
+		
+		empty = FloatInspectorStatisticsCreate(aggregate->stats->type);
+		diff = empty != NULL ? 
+			FloatInspectorStatisticsDiffCreate(empty, aggregate->stats) : NULL;
+		
+		if (empty != NULL) FloatInspectorStatisticsFree(empty);
+		
+		if (diff == NULL) {
+			
+			return -1;
+		}
+	}
+	
+	const size_t size = kFloatInspectorAggregatorFrameHeader + length + 
+		(diff != NULL ? FloatInspectorStatisticsDiffEncodedSize(diff) : 0);
+	
+	if (connection->outCapacity - connection->nOut < size) {
+		
+		const size_t capacity = connection->nOut + size;
+		uint8_t *out = realloc(connection->out, capacity);
+		
+		if (out == NULL) {
+			
+			if (diff != NULL) FloatInspectorStatisticsDiffFree(diff);
+			return -1;
+		}
+		
+		connection->out = out;
+		connection->outCapacity = capacity;
+	}
+	
+	uint8_t *frame = connection->out + connection->nOut;
+	size_t n = kFloatInspectorAggregatorFrameHeader + length;
+	
+	frame[4] = diff != NULL ? StatisticsFrame : UnknownFrame;
+	frame[5] = (uint8_t) length;
+	memcpy(frame + kFloatInspectorAggregatorFrameHeader, name, length);
+	
+	if (diff != NULL) {
+		
+		n += FloatInspectorStatisticsDiffEncode(diff, frame + n, size - n);
+		FloatInspectorStatisticsDiffFree(diff);
+	}
+	
+	FloatInspectorAggregatorPut32(frame, (uint32_t) (n - 4));
+	connection->nOut += n;
+	
+	return 0;
+}
+
+/* Handles the complete frames in data. Returns the number of bytes used
+ * or -1 if the connection broke the protocol.  */
+static long 
+FloatInspectorAggregatorProcess(FloatInspectorAggregatorRef aggregator,
+								FloatInspectorAggregatorConnection *connection,
+								const uint8_t *data,
+								size_t size) {
+	
+	size_t offset = 0;
+	int failed = 0;
+	
+	pthread_mutex_lock(&aggregator->lock);
+	
+	while (!failed && (size - offset >= 4)) {
+		
+		const uint32_t length = FloatInspectorAggregatorGet32(data + offset);
+		
+		if ((length < 2) || (length > aggregator->options.maxFrameSize)) {
+			
+			failed = 1;
+			break;
+		}
+		
+		if (size - offset - 4 < length) {
+			
+			break;
+		}
+		
+		const uint8_t *frame = data + offset + 4;
+		const size_t nameLength = frame[1];
+		
+		if (2 + nameLength > length) {
+			
+			failed = 1;
+			break;
+		}
+		
+		switch (frame[0]) {
+				
+			case DeltaFrame:
+				FloatInspectorAggregatorDeliver(aggregator, frame + 2, nameLength, 
+												frame + 2 + nameLength, 
+												length - 2 - nameLength);
+				break;
+				
+			case QueryFrame:
+				failed = FloatInspectorAggregatorReply(aggregator, connection, 
+													   frame + 2, nameLength) != 0;
+				break;
+				
+			default:
+				failed = 1;
+				break;
+		}
+		
+		aggregator->nFrames++;
+		offset += 4 + (size_t) length;
+	}
+	
+	aggregator->nRejected += failed;
+	
+	pthread_mutex_unlock(&aggregator->lock);
+	
+	return failed ? -1 : (long) offset;
+}
+
+/* Takes connections until the backlog is empty or all slots are in use. 
+ * Short-lived clients have usually sent everything and left by now, so a
+ * new connection is read before it is watched and is often closed right
+ * away.  */
+static void 
+FloatInspectorAggregatorAccept(FloatInspectorAggregatorRef aggregator) {
+	
+	while (aggregator->freeSlot != kFloatInspectorAggregatorNoSlot) {
+		
+#if defined(__linux__)
+		const int fd = accept4(aggregator->listenFd, NULL, NULL, 
+							   SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
+		const int fd = accept(aggregator->listenFd, NULL, NULL);
+#endif
+		
+		if (fd == -1) {
+			
+			if (errno == EINTR) {
+				
+				continue;
+			}
+			
+			return;
+		}
+		
+#if !defined(__linux__)
+		if (FloatInspectorAggregatorConfigure(fd) != 0) {
+			
+			close(fd);
+			continue;
+		}
+#endif
+		
+		const unsigned int slot = aggregator->freeSlot;
+		FloatInspectorAggregatorConnection *connection = &aggregator->connections[slot];
+		
+		aggregator->freeSlot = connection->nextFree;
+		aggregator->nOpen++;
+		connection->fd = fd;
+		connection->writing = -1;
+		
+		pthread_mutex_lock(&aggregator->lock);
+		aggregator->nAccepted++;
+		pthread_mutex_unlock(&aggregator->lock);
+		
+		FloatInspectorAggregatorRead(aggregator, slot);
+	}
+	
+	/* Out of slots, the listening socket is watched again once one is 
+	 * closed.  */
+	if (aggregator->listening) {
+		
+#if defined(__linux__)
+		epoll_ctl(aggregator->epollFd, EPOLL_CTL_DEL, aggregator->listenFd, NULL);
+#endif
+		aggregator->listening = 0;
+	}
+}
+
+static void 
+FloatInspectorAggregatorClose(FloatInspectorAggregatorRef aggregator, unsigned int slot) {
+	
+	FloatInspectorAggregatorConnection *connection = &aggregator->connections[slot];
+	
+	if (connection->nPending != 0) {
+		
+		pthread_mutex_lock(&aggregator->lock);
+		aggregator->nRejected++;
+		pthread_mutex_unlock(&aggregator->lock);
+	}
+	
+	close(connection->fd);
+	free(connection->pending);
+	free(connection->out);
+	memset(connection, 0, sizeof(FloatInspectorAggregatorConnection));
+	connection->fd = -1;
+	connection->nextFree = aggregator->freeSlot;
+	aggregator->freeSlot = slot;
+	aggregator->nOpen--;
+	
+	if (!aggregator->listening && 
+		(FloatInspectorAggregatorWatch(aggregator, aggregator->listenFd, 
+									   kFloatInspectorAggregatorListenToken, 0, 1) == 0)) {
+		
+		aggregator->listening = 1;
+	}
+}
+
+static void 
+FloatInspectorAggregatorRead(FloatInspectorAggregatorRef aggregator, unsigned int slot) {
+	
+	FloatInspectorAggregatorConnection *connection = &aggregator->connections[slot];
+	
+	for (unsigned int r = 0; r < kFloatInspectorAggregatorMaxReads; r++) {
+		
+		uint8_t *data;
+		size_t size;
+		ssize_t n;
+		
+		if (connection->nPending == 0) {
+			
+			data = aggregator->buffer;
+			size = kFloatInspectorAggregatorBufferSize;
+			n = read(connection->fd, data, size);
+		}
+		else {
+			
+			data = connection->pending;
+			size = connection->pendingCapacity - connection->nPending;
+			n = read(connection->fd, data + connection->nPending, size);
+			size = connection->nPending;
+		}
+		
+		if (n == 0) {
+			
+			FloatInspectorAggregatorClose(aggregator, slot);
+			return;
+		}
+		
+		if (n < 0) {
+			
+			if (errno == EINTR) {
+				
+				continue;
+			}
+			
+			if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+				
+				FloatInspectorAggregatorClose(aggregator, slot);
+				return;
+			}
+			
+			break;
+		}
+		
+		size = data == aggregator->buffer ? (size_t) n : size + (size_t) n;
+		
+		const long used = FloatInspectorAggregatorProcess(aggregator, connection, data, size);
+		
+		if (used < 0) {
+			
+			FloatInspectorAggregatorClose(aggregator, slot);
+			return;
+		}
+		
+		/* Keep the incomplete frame, with room for all of it.  */
+		const size_t left = size - (size_t) used;
+		size_t needed = kFloatInspectorAggregatorBufferSize;
+		
+		if (left >= 4) {
+			
+			const size_t frame = 4 + (size_t) FloatInspectorAggregatorGet32(data + used);
+			
+			needed = frame > needed ? frame : needed;
+		}
+		
+		if ((left != 0) && (connection->pendingCapacity < needed)) {
+			
+			uint8_t *pending = malloc(needed);
+			
+			if (pending == NULL) {
+				
+				FloatInspectorAggregatorClose(aggregator, slot);
+				return;
+			}
+			
+			memcpy(pending, data + used, left);
+			free(connection->pending);
+			connection->pending = pending;
+			connection->pendingCapacity = needed;
+		}
+		else if (left != 0) {
+			
+			memmove(connection->pending, data + used, left);
+		}
+		
+		connection->nPending = left;
+	}
+	
+	if (connection->nOut != 0) {
+		
+		FloatInspectorAggregatorWrite(aggregator, slot);
+	}
+	else if ((connection->writing == -1) && 
+			 (FloatInspectorAggregatorWatch(aggregator, connection->fd, 
+											kFloatInspectorAggregatorFirstSlot + slot, 0, 1) == 0)) {
+		
+		connection->writing = 0;
+	}
+	else if (connection->writing == -1) {
+		
+		FloatInspectorAggregatorClose(aggregator, slot);
+	}
+}
+
+/* Sends replies until the socket is full, then waits for writability. A
+ * client that stops reading is closed once its replies exceed a few 
+ * frames.  */
+static void 
+FloatInspectorAggregatorWrite(FloatInspectorAggregatorRef aggregator, unsigned int slot) {
+	
+	FloatInspectorAggregatorConnection *connection = &aggregator->connections[slot];
+	
+	while (connection->nSent < connection->nOut) {
+		
+		const ssize_t n = send(connection->fd, connection->out + connection->nSent,
+							   connection->nOut - connection->nSent, 
+							   kFloatInspectorAggregatorSendFlags);
+		
+		if (n < 0) {
+			
+			if (errno == EINTR) {
+				
+				continue;
+			}
+			
+			if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+				
+				FloatInspectorAggregatorClose(aggregator, slot);
+				return;
+			}
+			
+			break;
+		}
+		
+		connection->nSent += (size_t) n;
+	}
+	
+	if (connection->nSent == connection->nOut) {
+		
+		connection->nOut = connection->nSent = 0;
+	}
+	else if (connection->nOut - connection->nSent > 4 * aggregator->options.maxFrameSize) {
+		
+		FloatInspectorAggregatorClose(aggregator, slot);
+		return;
+	}
+	
+	const int writing = connection->nOut != 0;
+	
+	if (connection->writing != writing) {
+		
+		if (FloatInspectorAggregatorWatch(aggregator, connection->fd, 
+										  kFloatInspectorAggregatorFirstSlot + slot, 
+										  writing, connection->writing == -1) != 0) {
+			
+			FloatInspectorAggregatorClose(aggregator, slot);
+			return;
+		}
+		
+		connection->writing = writing;
+	}
+}
+
+static int 
+FloatInspectorClientConnect(FloatInspectorClientRef client) {
+	
+	const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	
+	if (fd == -1) {
+		
+		return -1;
+	}
+	
+	if ((FloatInspectorAggregatorConfigure(fd) != 0) ||
+		((connect(fd, (const struct sockaddr *) &client->address, 
+				  sizeof(client->address)) != 0) && (errno != EINPROGRESS))) {
+		
+		close(fd);
+		return -1;
+	}
+	
+	client->fd = fd;
+	
+	return 0;
+}
+
+/* Start of the frame being sent, the buffer always starts with a frame.  */
+static size_t 
+FloatInspectorClientFrameStart(FloatInspectorClientRef client) {
+	
+	size_t start = 0;
+	
+	while ((start < client->nSent) &&
+		   (start + 4 + FloatInspectorAggregatorGet32(client->buffer + start) <= client->nSent)) {
+		
+		start += 4 + FloatInspectorAggregatorGet32(client->buffer + start);
+	}
+	
+	return start;
+}
+
+/* Frames sent completely are gone with the connection, a partly sent one
+ * is sent again in full over the next. Queries are dropped, their replies
+ * will not come.  */
+static void 
+FloatInspectorClientDisconnect(FloatInspectorClientRef client) {
+	
+	const size_t start = FloatInspectorClientFrameStart(client);
+	size_t n = start;
+	
+	for (size_t i = start; i < client->nBuffered;) {
+		
+		const size_t size = 4 + FloatInspectorAggregatorGet32(client->buffer + i);
+		
+		if (client->buffer[i + 4] != QueryFrame) {
+			
+			memmove(client->buffer + n, client->buffer + i, size);
+			n += size;
+		}
+		
+		i += size;
+	}
+	
+	close(client->fd);
+	client->fd = -1;
+	client->nSent = start;
+	client->nBuffered = n;
+	client->nUnanswered = 0;
+	client->nReply = 0;
+}
+
+/* Drops the frames sent, keeping a partly sent one.  */
+static void 
+FloatInspectorClientCompact(FloatInspectorClientRef client) {
+	
+	const size_t start = FloatInspectorClientFrameStart(client);
+	
+	memmove(client->buffer, client->buffer + start, client->nBuffered - start);
+	client->nBuffered -= start;
+	client->nSent -= start;
+}
+
+static FloatInspectorClientSeries *
+FloatInspectorClientFindSeries(FloatInspectorClientRef client,
+							   const char *name,
+							   size_t length,
+							   enum PrecisionType type) {
+	
+	for (size_t i = 0; i < client->nSeries; i++) {
+		
+		if ((client->series[i].length == length) && 
+			(memcmp(client->series[i].name, name, length) == 0)) {
+			
+			return &client->series[i];
+		}
+	}
+	
+	if (client->nSeries == client->capacity) {
+		
+		const size_t capacity = client->capacity == 0 ? 4 : 2 * client->capacity;
+		FloatInspectorClientSeries *series = realloc(client->series, 
+													 capacity * sizeof(FloatInspectorClientSeries));
+		
+		if (series == NULL) {
+			
+			return NULL;
+		}
+		
+		client->series = series;
+		client->capacity = capacity;
+	}
+	
+	FloatInspectorClientSeries *series = &client->series[client->nSeries];
+	
+	series->name = strdup(name);
+	series->length = length;
+	series->sent = FloatInspectorStatisticsCreate(type);
+	
+	if ((series->name == NULL) || (series->sent == NULL)) {
+		
+		free(series->name);
+		if (series->sent != NULL) FloatInspectorStatisticsFree(series->sent);
+		
+		return NULL;
+	}
+	
+	client->nSeries++;
+	
+	return series;
+}
+
+static double 
+FloatInspectorClientNow(void) {
+	
+	struct timespec now;
+	
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	
+	return (double) now.tv_sec + 1e-9 * (double) now.tv_nsec;
+}
+
+#pragma mark Public Functions Implementations
+
+FloatInspectorAggregatorRef 
+FloatInspectorAggregatorCreate(const char *path,
+							   FloatInspectorAggregatorOptions options) {
+	
+	struct sockaddr_un address;
+	struct stat st;
+	
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	
+	if (strlen(path) >= sizeof(address.sun_path)) {
+		
+		errno = ENAMETOOLONG;
+		return NULL;
+	}
+	
+	strcpy(address.sun_path, path);
+	
+	if (options.maxConnections == 0) {
+		
+		options.maxConnections = 1;
+	}
+	
+	FloatInspectorAggregatorRef aggregator = calloc(1, sizeof(struct _FloatInspectorAggregator));
+	
+	if (aggregator == NULL) {
+		
+		return NULL;
+	}
+	
+	pthread_mutex_init(&aggregator->lock, NULL);
+	aggregator->options = options;
+	aggregator->listenFd = aggregator->wake[0] = aggregator->wake[1] = -1;
+#if defined(__linux__)
+	aggregator->epollFd = -1;
+#endif
+	aggregator->path = strdup(path);
+	aggregator->buffer = malloc(kFloatInspectorAggregatorBufferSize);
+	aggregator->events = malloc(kFloatInspectorAggregatorMaxEvents * 
+								sizeof(FloatInspectorAggregatorEvent));
+	aggregator->connections = malloc(options.maxConnections * 
+									 sizeof(FloatInspectorAggregatorConnection));
+#if defined(__linux__)
+	aggregator->epollEvents = malloc(kFloatInspectorAggregatorMaxEvents * 
+									 sizeof(struct epoll_event));
+	int failed = aggregator->epollEvents == NULL;
+#else
+	aggregator->pollFds = malloc((options.maxConnections + 2) * sizeof(struct pollfd));
+	aggregator->pollTokens = malloc((options.maxConnections + 2) * sizeof(unsigned int));
+	int failed = (aggregator->pollFds == NULL) || (aggregator->pollTokens == NULL);
+#endif
+	
+	failed = failed || (aggregator->path == NULL) || (aggregator->buffer == NULL) || 
+		(aggregator->events == NULL) || (aggregator->connections == NULL);
+	
+	if (failed) {
+		
+		free(aggregator->connections);
+		aggregator->connections = NULL;
+		FloatInspectorAggregatorFree(aggregator);
+		errno = ENOMEM;
+		
+		return NULL;
+	}
+	
+	for (unsigned int s = 0; s < options.maxConnections; s++) {
+		
+		memset(&aggregator->connections[s], 0, sizeof(FloatInspectorAggregatorConnection));
+		aggregator->connections[s].fd = -1;
+		aggregator->connections[s].nextFree = 
+			s + 1 < options.maxConnections ? s + 1 : kFloatInspectorAggregatorNoSlot;
+	}
+	
+	/* A socket nobody accepts on is left over from an earlier daemon.  */
+	if ((lstat(path, &st) == 0) && S_ISSOCK(st.st_mode)) {
+		
+		const int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+		
+		if ((probe != -1) && 
+			(connect(probe, (const struct sockaddr *) &address, sizeof(address)) == 0)) {
+			
+			errno = EADDRINUSE;
+			failed = 1;
+		}
+		else {
+			
+			unlink(path);
+		}
+		
+		if (probe != -1) close(probe);
+	}
+	
+	if (!failed) {
+		
+		aggregator->listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+		failed = (aggregator->listenFd == -1) ||
+			(FloatInspectorAggregatorConfigure(aggregator->listenFd) != 0) ||
+			(bind(aggregator->listenFd, (const struct sockaddr *) &address, 
+				  sizeof(address)) != 0);
+		
+		if (failed && (aggregator->listenFd != -1)) {
+			
+			/* Not ours to remove.  */
+			free(aggregator->path);
+			aggregator->path = NULL;
+		}
+	}
+	
+	failed = failed || (listen(aggregator->listenFd, options.backlog) != 0) ||
+		(pipe(aggregator->wake) != 0) ||
+		(FloatInspectorAggregatorConfigure(aggregator->wake[0]) != 0) ||
+		(FloatInspectorAggregatorConfigure(aggregator->wake[1]) != 0);
+	
+#if defined(__linux__)
+	failed = failed || ((aggregator->epollFd = epoll_create1(EPOLL_CLOEXEC)) == -1) ||
+		(FloatInspectorAggregatorWatch(aggregator, aggregator->wake[0], 
+									   kFloatInspectorAggregatorWakeToken, 0, 1) != 0) ||
+		(FloatInspectorAggregatorWatch(aggregator, aggregator->listenFd, 
+									   kFloatInspectorAggregatorListenToken, 0, 1) != 0);
+#endif
+	
+	if (failed) {
+		
+		const int error = errno;
+		
+		FloatInspectorAggregatorFree(aggregator);
+		errno = error;
+		
+		return NULL;
+	}
+	
+	aggregator->listening = 1;
+	
+	return aggregator;
+}
+
+void 
+FloatInspectorAggregatorFree(FloatInspectorAggregatorRef aggregator) {
+	
+	for (unsigned int s = 0; 
+		 (aggregator->connections != NULL) && (s < aggregator->options.maxConnections); 
+		 s++) {
+		
+		FloatInspectorAggregatorConnection *connection = &aggregator->connections[s];
+		
+		if (connection->fd != -1) {
+			
+			close(connection->fd);
+		}
+		
+		free(connection->pending);
+		free(connection->out);
+	}
+	
+	if (aggregator->listenFd != -1) {
+		
+		close(aggregator->listenFd);
+		
+		if (aggregator->path != NULL) {
+			
+			unlink(aggregator->path);
+		}
+	}
+	
+	if (aggregator->wake[0] != -1) close(aggregator->wake[0]);
+	if (aggregator->wake[1] != -1) close(aggregator->wake[1]);
+	
+#if defined(__linux__)
+	if (aggregator->epollFd != -1) close(aggregator->epollFd);
+	free(aggregator->epollEvents);
+#else
+	free(aggregator->pollFds);
+	free(aggregator->pollTokens);
+#endif
+	
+	for (size_t i = 0; i < aggregator->nAggregates; i++) {
+		
+		free(aggregator->aggregates[i].name);
+		FloatInspectorStatisticsFree(aggregator->aggregates[i].stats);
+	}
+	
+	pthread_mutex_destroy(&aggregator->lock);
+	free(aggregator->aggregates);
+	free(aggregator->slots);
+	free(aggregator->connections);
+	free(aggregator->events);
+	free(aggregator->buffer);
+	free(aggregator->path);
+	free(aggregator);
+}
+
+int 
+FloatInspectorAggregatorRun(FloatInspectorAggregatorRef aggregator) {
+	
+	for (;;) {
+		
+		const int n = FloatInspectorAggregatorWait(aggregator);
+		int stop = 0;
+		
+		if (n < 0) {
+			
+			if (errno == EINTR) {
+				
+				continue;
+			}
+			
+			return -1;
+		}
+		
+		for (int i = 0; i < n; i++) {
+			
+			const FloatInspectorAggregatorEvent event = aggregator->events[i];
+			
+			if (event.token == kFloatInspectorAggregatorWakeToken) {
+				
+				uint8_t drain[64];
+				
+				while (read(aggregator->wake[0], drain, sizeof(drain)) > 0);
+				stop = 1;
+			}
+			else if (event.token == kFloatInspectorAggregatorListenToken) {
+				
+				FloatInspectorAggregatorAccept(aggregator);
+			}
+			else {
+				
+				/* Events of a slot closed earlier in this round are stale.  */
+				const unsigned int slot = event.token - kFloatInspectorAggregatorFirstSlot;
+				
+				if (event.readable && (aggregator->connections[slot].fd != -1)) {
+					
+					FloatInspectorAggregatorRead(aggregator, slot);
+				}
+				
+				if (event.writable && (aggregator->connections[slot].fd != -1)) {
+					
+					FloatInspectorAggregatorWrite(aggregator, slot);
+				}
+			}
+		}
+		
+		if (stop) {
+			
+			return 0;
+		}
+	}
+}
+
+void 
+FloatInspectorAggregatorStop(FloatInspectorAggregatorRef aggregator) {
+	
+	const uint8_t byte = 0;
+	
+	if (write(aggregator->wake[1], &byte, 1) < 0) {
+		
+		/* Full, a wake up is pending anyway.  */
+	}
+}
+
+FloatInspectorStatisticsRef 
+FloatInspectorAggregatorCopyStatistics(FloatInspectorAggregatorRef aggregator,
+									   const char *name) {
+	
+	pthread_mutex_lock(&aggregator->lock);
+	
+	FloatInspectorAggregate *aggregate = 
+		FloatInspectorAggregatorFind(aggregator, (const uint8_t *) name, strlen(name));
+	FloatInspectorStatisticsRef copy = aggregate != NULL ? 
+		FloatInspectorStatisticsCopy(aggregate->stats) : NULL;
+	
+	pthread_mutex_unlock(&aggregator->lock);
+	
+	return copy;
+}
+
+void 
+FloatInspectorAggregatorPrint(FloatInspectorAggregatorRef aggregator,
+							  FILE *restrict stream) {
+	
+	pthread_mutex_lock(&aggregator->lock);
+	
+	fprintf(stream, 
+			"=== Aggregator %s: %llu connections, %llu frames, %llu queries, "
+			"%llu rejected ===\n\n",
+			aggregator->path,
+			aggregator->nAccepted,
+			aggregator->nFrames,
+			aggregator->nQueries,
+			aggregator->nRejected);
+	
+	for (size_t i = 0; i < aggregator->nAggregates; i++) {
+		
+		fprintf(stream, "=== %s: %llu deltas ===\n\n",
+				aggregator->aggregates[i].name,
+				aggregator->aggregates[i].nDeltas);
+		FloatInspectorStatisticsPrint(aggregator->aggregates[i].stats, stream);
+	}
+	
+	pthread_mutex_unlock(&aggregator->lock);
+}
+
+FloatInspectorClientRef 
+FloatInspectorClientCreate(const char *path, FloatInspectorClientOptions options) {
+	
+	FloatInspectorClientRef client = calloc(1, sizeof(struct _FloatInspectorClient));
+	
+	if ((client == NULL) || (strlen(path) >= sizeof(client->address.sun_path))) {
+		
+		free(client);
+		return NULL;
+	}
+	
+	client->options = options;
+	client->address.sun_family = AF_UNIX;
+	strcpy(client->address.sun_path, path);
+	client->fd = -1;
+	client->buffer = malloc(options.bufferSize);
+	
+	if (client->buffer == NULL) {
+		
+		free(client);
+		return NULL;
+	}
+	
+	return client;
+}
+
+void 
+FloatInspectorClientFree(FloatInspectorClientRef client) {
+	
+	FloatInspectorClientFlush(client);
+	
+	if (client->fd != -1) {
+		
+		close(client->fd);
+	}
+	
+	for (size_t i = 0; i < client->nSeries; i++) {
+		
+		free(client->series[i].name);
+		FloatInspectorStatisticsFree(client->series[i].sent);
+	}
+	
+	free(client->series);
+	free(client->reply);
+	free(client->buffer);
+	free(client);
+}
+
+int 
+FloatInspectorClientSubmit(FloatInspectorClientRef client,
+						   const char *name,
+						   const FloatInspectorStatisticsRef stats) {
+	
+	const size_t length = strlen(name);
+	FloatInspectorClientSeries *series = length <= kFloatInspectorAggregatorMaxName ? 
+		FloatInspectorClientFindSeries(client, name, length, stats->type) : NULL;
+	FloatInspectorStatisticsDiffRef diff = series != NULL ? 
+		FloatInspectorStatisticsDiffCreate(series->sent, stats) : NULL;
+	
+	if (diff == NULL) {
+		
+		return -1;
+	}
+	
+	if ((diff->nChanges == 0) && (diff->nEntries == 0) && (diff->nNaN == 0) && 
+		(diff->nInf == 0) && (diff->nNegative == 0) && (diff->nPositive == 0) &&
+		(diff->nNormalized == 0) && (diff->nDenormalized == 0)) {
+		
+		FloatInspectorStatisticsDiffFree(diff);
+		return 0;
+	}
+	
+	const size_t size = kFloatInspectorAggregatorFrameHeader + length + 
+		FloatInspectorStatisticsDiffEncodedSize(diff);
+	
+	if (client->options.bufferSize - client->nBuffered < size) {
+		
+		FloatInspectorClientFlush(client);
+		FloatInspectorClientCompact(client);
+		
+		if (client->options.bufferSize - client->nBuffered < size) {
+			
+			FloatInspectorStatisticsDiffFree(diff);
+			return 1;
+		}
+	}
+	
+	uint8_t *frame = client->buffer + client->nBuffered;
+	size_t n = kFloatInspectorAggregatorFrameHeader + length;
+	
+	frame[4] = DeltaFrame;
+	frame[5] = (uint8_t) length;
+	memcpy(frame + kFloatInspectorAggregatorFrameHeader, name, length);
+	n += FloatInspectorStatisticsDiffEncode(diff, frame + n, size - n);
+	FloatInspectorAggregatorPut32(frame, (uint32_t) (n - 4));
+	client->nBuffered += n;
+	
+	FloatInspectorStatisticsDiffApply(series->sent, diff);
+	FloatInspectorStatisticsDiffFree(diff);
+	
+	if (client->nBuffered - client->nSent >= client->options.batchSize) {
+		
+		FloatInspectorClientFlush(client);
+	}
+	
+	return 0;
+}
+
+int 
+FloatInspectorClientFlush(FloatInspectorClientRef client) {
+	
+	if ((client->nSent < client->nBuffered) && (client->fd == -1)) {
+		
+		FloatInspectorClientConnect(client);
+	}
+	
+	while ((client->nSent < client->nBuffered) && (client->fd != -1)) {
+		
+		const ssize_t n = send(client->fd, client->buffer + client->nSent,
+							   client->nBuffered - client->nSent,
+							   kFloatInspectorAggregatorSendFlags);
+		
+		if (n >= 0) {
+			
+			client->nSent += (size_t) n;
+		}
+		else if ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == ENOTCONN)) {
+			
+			/* Full or still connecting.  */
+			break;
+		}
+		else if (errno != EINTR) {
+			
+			FloatInspectorClientDisconnect(client);
+		}
+	}
+	
+	if (client->nSent == client->nBuffered) {
+		
+		client->nSent = client->nBuffered = 0;
+		
+		return 0;
+	}
+	
+	return 1;
+}
+
+FloatInspectorStatisticsRef 
+FloatInspectorClientQuery(FloatInspectorClientRef client,
+						  const char *name,
+						  double timeout) {
+	
+	const size_t length = strlen(name);
+	const double deadline = FloatInspectorClientNow() + timeout;
+	
+	FloatInspectorClientCompact(client);
+	
+	if ((client->fd == -1) && (FloatInspectorClientConnect(client) != 0)) {
+		
+		return NULL;
+	}
+	
+	if ((length > kFloatInspectorAggregatorMaxName) || 
+		(client->options.bufferSize - client->nBuffered < 
+		 kFloatInspectorAggregatorFrameHeader + length)) {
+		
+		return NULL;
+	}
+	
+	uint8_t *frame = client->buffer + client->nBuffered;
+	
+	FloatInspectorAggregatorPut32(frame, (uint32_t) (2 + length));
+	frame[4] = QueryFrame;
+	frame[5] = (uint8_t) length;
+	memcpy(frame + kFloatInspectorAggregatorFrameHeader, name, length);
+	client->nBuffered += kFloatInspectorAggregatorFrameHeader + length;
+	
+	/* Replies come in order, ours is the one after those of abandoned 
+	 * queries.  */
+	const unsigned int nSkip = client->nUnanswered++;
+	unsigned int nReplies = 0;
+	
+	for (;;) {
+		
+		const int pending = FloatInspectorClientFlush(client);
+		const double left = deadline - FloatInspectorClientNow();
+		
+		if (client->fd == -1) {
+			
+			/* Connection lost, which dropped the query.  */
+			return NULL;
+		}
+		
+		/* Complete replies in the buffer.  */
+		size_t offset = 0;
+		
+		while (client->nReply - offset >= 4) {
+			
+			const size_t size = 4 + (size_t) FloatInspectorAggregatorGet32(client->reply + offset);
+			
+			if (client->nReply - offset < size) {
+				
+				break;
+			}
+			
+			const uint8_t *reply = client->reply + offset;
+			
+			offset += size;
+			client->nUnanswered--;
+			
+			if (nReplies++ < nSkip) {
+				
+				continue;
+			}
+			
+			FloatInspectorStatisticsRef stats = NULL;
+			const size_t nameLength = size >= kFloatInspectorAggregatorFrameHeader ? 
+				reply[5] : SIZE_MAX;
+			
+			if ((reply[4] == StatisticsFrame) && 
+				(kFloatInspectorAggregatorFrameHeader + nameLength <= size)) {
+				
+				const size_t headerSize = kFloatInspectorAggregatorFrameHeader + nameLength;
+				FloatInspectorStatisticsDiffRef diff = 
+					FloatInspectorStatisticsDiffDecode(reply + headerSize, size - headerSize);
+				
+				stats = diff != NULL ? FloatInspectorStatisticsCreate(diff->type) : NULL;
+				
+				if ((stats != NULL) && (FloatInspectorStatisticsDiffApply(stats, diff) != 0)) {
+					
+					FloatInspectorStatisticsFree(stats);
+					stats = NULL;
+				}
+				
+				if (diff != NULL) FloatInspectorStatisticsDiffFree(diff);
+			}
+			
+			memmove(client->reply, client->reply + offset, client->nReply - offset);
+			client->nReply -= offset;
+			
+			return stats;
+		}
+		
+		if (offset != 0) {
+			
+			memmove(client->reply, client->reply + offset, client->nReply - offset);
+			client->nReply -= offset;
+		}
+		
+		if (left <= 0) {
+			
+			return NULL;
+		}
+		
+		struct pollfd fd = {client->fd, POLLIN | (pending ? POLLOUT : 0), 0};
+		const int wait = left > 1e6 ? 1000000000 : (int) (1000. * left) + 1;
+		
+		if ((poll(&fd, 1, wait) <= 0) || !(fd.revents & (POLLIN | POLLHUP | POLLERR))) {
+			
+			continue;
+		}
+		
+		/* Room for at least the reply that is arriving.  */
+		size_t needed = client->nReply + 4096;
+		
+		if (client->nReply >= 4) {
+			
+			const size_t size = 4 + (size_t) FloatInspectorAggregatorGet32(client->reply);
+			
+			needed = size > needed ? size : needed;
+		}
+		
+		if (client->replyCapacity < needed) {
+			
+			uint8_t *reply = realloc(client->reply, needed);
+			
+			if (reply == NULL) {
+				
+				return NULL;
+			}
+			
+			client->reply = reply;
+			client->replyCapacity = needed;
+		}
+		
+		const ssize_t n = read(client->fd, client->reply + client->nReply, 
+							   client->replyCapacity - client->nReply);
+		
+		if (n > 0) {
+			
+			client->nReply += (size_t) n;
+		}
+		else if ((n == 0) || ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR))) {
+			
+			FloatInspectorClientDisconnect(client);
+			return NULL;
+		}
+	}
+}
@@ -0,0 +1,154 @@
+//
+//  FloatInspectorAggregator.h
+//  FloatInspector
+//  
+//  Copyright 2011 Stefan Reinhold <stefan@sreinhold.com>. All rights reserved.
+//  
+//  Redistribution and use in source and binary forms, with or without modification, are
+//  permitted provided that the following conditions are met:
+//  
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//  
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list
+//  of conditions and the following disclaimer in the documentation and/or other materials
+//  provided with the distribution.
+//  
+//  THIS SOFTWARE IS PROVIDED BY STEFAN REINHOLD ``AS IS'' AND ANY EXPRESS OR IMPLIED
+//  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STEFAN REINHOLD OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+//  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+//  ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//  
+//  The views and conclusions contained in the software and documentation are those of the
+//  authors and should not be interpreted as representing official policies, either expressed
+//  or implied, of Stefan Reinhold.
+//  
+
+
+
+#ifndef FloatInspector_FloatInspectorAggregator_h
+#define FloatInspector_FloatInspectorAggregator_h
+
+#include "FloatInspector.h"
+
+#pragma mark Data Types
+
+/* Long-lived named aggregates fed by many processes over a Unix domain 
+ * stream socket. A single thread multiplexes all connections (epoll on 
+ * Linux, poll elsewhere) and merges every statistics diff it receives into
+ * the aggregate of its name, created by the first diff. Aggregates are 
+ * kept in memory only and cover counters and histograms, not sketches.
+ *
+ * Every message is a frame: a 4 byte little endian length of the rest, a
+ * kind byte, a name length byte and the name, followed by the encoded diff
+ * (FloatInspectorStatisticsDiffEncode) for deltas and statistics replies.  */
+typedef struct _FloatInspectorAggregator *FloatInspectorAggregatorRef;
+
+/* Producer side of the protocol. Submitted statistics are turned into 
+ * diffs against what was sent before, framed into a buffer and written 
+ * without ever blocking: while the daemon is slow or absent frames wait in
+ * the buffer and, once it is full, further changes stay in the statistics
+ * until a later submit. Delivery is at most once. Frames the socket took 
+ * are lost if the daemon goes away before reading them, and frames still 
+ * buffered when the client is freed are dropped. A client is not thread 
+ * safe, use one per thread or serialize them externally.  */
+typedef struct _FloatInspectorClient *FloatInspectorClientRef;
+
+typedef struct {
+	
+	/* Connections the kernel queues while the daemon is busy.  */
+	int backlog;
+	/* Open connections, further ones wait in the backlog.  */
+	unsigned int maxConnections;
+	/* Largest frame accepted, larger ones close the connection.  */
+	size_t maxFrameSize;
+	
+} FloatInspectorAggregatorOptions;
+
+typedef struct {
+	
+	/* Bytes of frames held while the daemon is slow or absent.  */
+	size_t bufferSize;
+	/* Pending bytes from which a submit writes the buffer out.  */
+	size_t batchSize;
+	
+} FloatInspectorClientOptions;
+
+#pragma mark Constants
+
+/* Backlog of 1024, 4096 connections, frames of up to 1 MiB.  */
+extern const FloatInspectorAggregatorOptions kFloatInspectorAggregatorDefaultOptions;
+
+/* Buffer of 256 KiB, written out from 4 KiB.  */
+extern const FloatInspectorClientOptions kFloatInspectorClientDefaultOptions;
+
+#pragma mark Public Functions
+
+/* Binds and listens on path, replacing a stale socket. Returns NULL with 
+ * errno set on failure.  */
+FloatInspectorAggregatorRef 
+FloatInspectorAggregatorCreate(const char *path,
+							   FloatInspectorAggregatorOptions options);
+
+/* Closes all connections and removes the socket. The aggregator must not 
+ * be running.  */
+void FloatInspectorAggregatorFree(FloatInspectorAggregatorRef aggregator);
+
+/* Serves connections on the calling thread until stopped. Returns 0 once 
+ * stopped and -1 with errno set if waiting for events failed. May be 
+ * called again after it returned.  */
+int FloatInspectorAggregatorRun(FloatInspectorAggregatorRef aggregator);
+
+/* Makes Run return after the current events. Safe from any thread and 
+ * from signal handlers.  */
+void FloatInspectorAggregatorStop(FloatInspectorAggregatorRef aggregator);
+
+/* Returns a copy of the aggregate of name, owned by the caller, or NULL if
+ * there is none. May be called while running.  */
+FloatInspectorStatisticsRef 
+FloatInspectorAggregatorCopyStatistics(FloatInspectorAggregatorRef aggregator,
+									   const char *name);
+
+/* Prints the traffic counters and every aggregate. May be called while 
+ * running.  */
+void FloatInspectorAggregatorPrint(FloatInspectorAggregatorRef aggregator,
+								   FILE *restrict stream);
+
+/* Does not connect yet, that happens on the first write. Returns NULL if 
+ * out of memory or the path is too long.  */
+FloatInspectorClientRef 
+FloatInspectorClientCreate(const char *path, FloatInspectorClientOptions options);
+
+/* Writes what the socket takes without waiting and disconnects, frames 
+ * left in the buffer are lost.  */
+void FloatInspectorClientFree(FloatInspectorClientRef client);
+
+/* Queues the changes of stats since its last submit under name (at most 
+ * 255 bytes). Returns 0 if queued or unchanged, 1 if the buffer is full 
+ * and the changes are deferred to a later submit and -1 if the format 
+ * differs from earlier submits of the name.  */
+int FloatInspectorClientSubmit(FloatInspectorClientRef client,
+							   const char *name,
+							   const FloatInspectorStatisticsRef stats);
+
+/* Writes as much of the buffer as the socket takes without waiting, 
+ * connecting first if needed. Returns 0 if the buffer is empty, 1 if 
+ * frames are left.  */
+int FloatInspectorClientFlush(FloatInspectorClientRef client);
+
+/* Returns the aggregate of name as known to the daemon, owned by the 
+ * caller, or NULL if it has none or did not answer within timeout 
+ * seconds. Frames queued before are written first, frames of other 
+ * connections are covered as far as the daemon has read them. Unlike 
+ * everything else here this waits.  */
+FloatInspectorStatisticsRef 
+FloatInspectorClientQuery(FloatInspectorClientRef client,
+						  const char *name,
+						  double timeout);
+
+#endif
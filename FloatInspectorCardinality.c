@@ -0,0 +1,560 @@
+//
+//  FloatInspectorCardinality.c
+//  FloatInspector
+//  
+//  Copyright 2011 Stefan Reinhold <stefan@sreinhold.com>. All rights reserved.
+//  
+//  Redistribution and use in source and binary forms, with or without modification, are
+//  permitted provided that the following conditions are met:
+//  
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//  
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list
+//  of conditions and the following disclaimer in the documentation and/or other materials
+//  provided with the distribution.
+//  
+//  THIS SOFTWARE IS PROVIDED BY STEFAN REINHOLD ``AS IS'' AND ANY EXPRESS OR IMPLIED
+//  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STEFAN REINHOLD OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+//  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+//  ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//  
+//  The views and conclusions contained in the software and documentation are those of the
+//  authors and should not be interpreted as representing official policies, either expressed
+//  or implied, of Stefan Reinhold.
+//  
+
+
+
+
+#include "FloatInspectorCardinality.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#pragma mark Data Types
+
+#define kFloatInspectorCardinalityVectorSize	16
+
+/* Generic vectors, lowered to SSE2, NEON or plain scalar code.  */
+typedef uint8_t FloatInspectorCardinalityBytes 
+	__attribute__((vector_size(kFloatInspectorCardinalityVectorSize)));
+typedef uint32_t FloatInspectorCardinalityWords32 
+	__attribute__((vector_size(kFloatInspectorCardinalityVectorSize)));
+typedef uint64_t FloatInspectorCardinalityWords64 
+	__attribute__((vector_size(kFloatInspectorCardinalityVectorSize)));
+typedef int32_t FloatInspectorCardinalityInts 
+	__attribute__((vector_size(kFloatInspectorCardinalityVectorSize)));
+typedef float FloatInspectorCardinalityFloats 
+	__attribute__((vector_size(kFloatInspectorCardinalityVectorSize)));
+
+#pragma mark Constants
+
+#define kFloatInspectorCardinalityLanes32	\
+	(kFloatInspectorCardinalityVectorSize / sizeof(uint32_t))
+
+/* Values hashed at once before the registers are updated, a multiple of 
+ * the lanes. Keeps the hash loops free of dependencies, so the 
+ * multiplications of consecutive values overlap.  */
+#define kFloatInspectorCardinalityChunk	256
+
+/* Lowest floor at which the values are hashed in vectors and tested before
+ * their codes are taken. A vector of four is then skipped more than two 
+ * times in three; below it the test would mostly mispredict, and the lane
+ * multiplies cost more than scalar ones.  */
+#define kFloatInspectorCardinalitySkipFloor	3
+
+static const uint8_t kFloatInspectorCardinalityMagic[4] = { 'F', 'I', 'H', 1 };
+
+#pragma mark Private Functions Implementations
+
+/* splitmix64 finalizer. The additive constant keeps the all zero pattern 
+ * from hashing to zero.  */
+static inline uint64_t 
+FloatInspectorCardinalityHash(uint64_t x) {
+	
+	x += 0x9e3779b97f4a7c15ULL;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	
+	return x ^ (x >> 31);
+}
+
+/* fmix32 per 32 bit lane with the lowbias32 constants, offset like the 
+ * above; the murmur3 ones overestimate runs of consecutive floats. A 
+ * bijection, so distinct 32 bit patterns never collide.  */
+static inline FloatInspectorCardinalityWords32 
+FloatInspectorCardinalityHash32(FloatInspectorCardinalityWords32 x) {
+	
+	x += 0x9e3779b9u;
+	x = (x ^ (x >> 16)) * 0x7feb352du;
+	x = (x ^ (x >> 15)) * 0x846ca68bu;
+	
+	return x ^ (x >> 16);
+}
+
+/* The same per word, for the scalar path.  */
+static inline uint32_t 
+FloatInspectorCardinalityWordHash32(uint32_t x) {
+	
+	x += 0x9e3779b9u;
+	x = (x ^ (x >> 16)) * 0x7feb352du;
+	x = (x ^ (x >> 15)) * 0x846ca68bu;
+	
+	return x ^ (x >> 16);
+}
+
+/* Register index and rank of 32 bit hashes, packed as index << 8 | rank. 
+ * The first p bits select the register, the number of trailing zeros of
+ * the other 32 - p bits is the rank minus one, bounded by a sentinel bit.
+ * The lowest set bit is a power of two, which a float holds exactly, so 
+ * the count is read from its exponent.  */
+static inline FloatInspectorCardinalityWords32 
+FloatInspectorCardinalityCodes(FloatInspectorCardinalityWords32 hashes, unsigned int p) {
+	
+	const FloatInspectorCardinalityWords32 rest = 
+		(hashes & ((1u << (32 - p)) - 1)) | (1u << (32 - p));
+	const FloatInspectorCardinalityFloats lowest = 
+		__builtin_convertvector((FloatInspectorCardinalityInts) (rest & -rest), 
+								FloatInspectorCardinalityFloats);
+	
+	/* The biased exponent is 127 plus the trailing zeros.  */
+	const FloatInspectorCardinalityWords32 rank = 
+		((FloatInspectorCardinalityWords32) lowest >> 23) - 126;
+	
+	return ((hashes >> (32 - p)) << 8) | rank;
+}
+
+/* Raises the floor to the smallest register once enough values were added
+ * since the last scan for it to have moved.  */
+static inline void 
+FloatInspectorCardinalityRaiseFloor(FloatInspectorCardinalityRef sketch, size_t n) {
+	
+	if (sketch->nUntilScan > n) {
+		
+		sketch->nUntilScan -= n;
+		return;
+	}
+	
+	const size_t m = (size_t) 1 << sketch->precision;
+	FloatInspectorCardinalityBytes minimum;
+	
+	memcpy(&minimum, sketch->registers, sizeof(minimum));
+	
+	for (size_t i = sizeof(minimum); i < m; i += sizeof(minimum)) {
+		
+		FloatInspectorCardinalityBytes registers;
+		memcpy(&registers, sketch->registers + i, sizeof(registers));
+		
+		const FloatInspectorCardinalityBytes lower = 
+			(FloatInspectorCardinalityBytes) (registers < minimum);
+		
+		minimum = (registers & lower) | (minimum & ~lower);
+	}
+	
+	unsigned int floor = minimum[0];
+	
+	for (size_t i = 1; i < sizeof(minimum); i++) {
+		
+		floor = minimum[i] < floor ? minimum[i] : floor;
+	}
+	
+	sketch->floor = floor;
+	sketch->nUntilScan = m;
+}
+
+/* Bits of a hash that are all zero if its rank is above the floor. Ranks 
+ * are bounded to 32 - p + 1, a floor there keeps every value out.  */
+static inline uint32_t 
+FloatInspectorCardinalityFloorMask(const FloatInspectorCardinalityRef sketch) {
+	
+	const unsigned int p = sketch->precision;
+	
+	return sketch->floor > 32 - p ? UINT32_MAX : (uint32_t) ((1ull << sketch->floor) - 1);
+}
+
+/* Appends the codes of the first n lanes of hashes if one of them may raise
+ * a register, returns the new number of codes.  */
+static inline size_t 
+FloatInspectorCardinalityKeepCodes(uint32_t *restrict codes,
+								   size_t nCodes,
+								   FloatInspectorCardinalityWords32 hashes,
+								   size_t n,
+								   unsigned int p,
+								   uint32_t mask) {
+	
+	const FloatInspectorCardinalityWords64 raise = 
+		(FloatInspectorCardinalityWords64) ((hashes & mask) == 0);
+	
+	if (__builtin_expect((raise[0] | raise[1]) == 0, 1)) {
+		
+		return nCodes;
+	}
+	
+	const FloatInspectorCardinalityWords32 x = FloatInspectorCardinalityCodes(hashes, p);
+	
+	memcpy(&codes[nCodes], &x, n * sizeof(uint32_t));
+	
+	return nCodes + n;
+}
+
+static inline void 
+FloatInspectorCardinalityAddCodes(FloatInspectorCardinalityRef sketch,
+								  const uint32_t *restrict codes,
+								  size_t n) {
+	
+	uint8_t * restrict registers = sketch->registers;
+	
+	for (size_t i = 0; i < n; i++) {
+		
+		const uint8_t rank = (uint8_t) codes[i];
+		
+		/* Once a few values per register were seen, a new maximum is rare
+		 * and the branch predictable. Skipping the store keeps the loop 
+		 * free of store to load dependencies between repeated indices.  */
+		if (rank > registers[codes[i] >> 8]) {
+			
+			registers[codes[i] >> 8] = rank;
+		}
+	}
+}
+
+/* The code of a single 32 bit hash, as in FloatInspectorCardinalityCodes.  */
+static inline void 
+FloatInspectorCardinalityAddWord(uint8_t *restrict registers, uint32_t hash, unsigned int p) {
+	
+	const uint32_t index = hash >> (32 - p);
+	const uint8_t rank = (uint8_t) (__builtin_ctz(hash | (1u << (32 - p))) + 1);
+	
+	if (rank > registers[index]) {
+		
+		registers[index] = rank;
+	}
+}
+
+static inline void 
+FloatInspectorCardinalityAddHashes(FloatInspectorCardinalityRef sketch,
+								   const uint64_t *restrict hashes,
+								   size_t n) {
+	
+	const unsigned int p = sketch->precision;
+	uint8_t * restrict registers = sketch->registers;
+	
+	for (size_t i = 0; i < n; i++) {
+		
+		/* The first p bits select the register, the position of the first 
+		 * set bit of the rest is the rank. The sentinel bit bounds the rank 
+		 * to 64 - p + 1.  */
+		const uint64_t index = hashes[i] >> (64 - p);
+		const uint64_t rest = (hashes[i] << p) | ((uint64_t) 1 << (p - 1));
+		const uint8_t rank = (uint8_t) (__builtin_clzll(rest) + 1);
+		
+		/* Once a few values per register were seen, a new maximum is rare
+		 * and the branch predictable. Skipping the store keeps the loop 
+		 * free of store to load dependencies between repeated indices.  */
+		if (rank > registers[index]) {
+			
+			registers[index] = rank;
+		}
+	}
+}
+
+#pragma mark Public Functions Implementations
+
+FloatInspectorCardinalityRef 
+FloatInspectorCardinalityCreate(unsigned int precision) {
+	
+	if ((precision < kFloatInspectorCardinalityMinPrecision) ||
+		(precision > kFloatInspectorCardinalityMaxPrecision)) {
+		
+		return NULL;
+	}
+	
+	FloatInspectorCardinalityRef sketch = malloc(sizeof(_FloatInspectorCardinality));
+	
+	if (sketch == NULL) {
+		
+		return NULL;
+	}
+	
+	sketch->precision = precision;
+	sketch->floor = 0;
+	sketch->nUntilScan = (size_t) 1 << precision;
+	sketch->registers = calloc((size_t) 1 << precision, sizeof(uint8_t));
+	
+	if (sketch->registers == NULL) {
+		
+		free(sketch);
+		return NULL;
+	}
+	
+	return sketch;
+}
+
+FloatInspectorCardinalityRef 
+FloatInspectorCardinalityCopy(const FloatInspectorCardinalityRef sketch) {
+	
+	FloatInspectorCardinalityRef copy = FloatInspectorCardinalityCreate(sketch->precision);
+	
+	if (copy == NULL) {
+		
+		return NULL;
+	}
+	
+	memcpy(copy->registers, sketch->registers, (size_t) 1 << sketch->precision);
+	
+	return copy;
+}
+
+void 
+FloatInspectorCardinalityReset(FloatInspectorCardinalityRef sketch) {
+	
+	memset(sketch->registers, 0, (size_t) 1 << sketch->precision);
+	sketch->floor = 0;
+	sketch->nUntilScan = (size_t) 1 << sketch->precision;
+}
+
+int 
+FloatInspectorCardinalityMerge(FloatInspectorCardinalityRef dst,
+							   const FloatInspectorCardinalityRef src) {
+	
+	if (dst->precision != src->precision) {
+		
+		return -1;
+	}
+	
+	const size_t m = (size_t) 1 << dst->precision;
+	
+	for (size_t i = 0; i < m; i++) {
+		
+		dst->registers[i] = dst->registers[i] > src->registers[i] ? 
+			dst->registers[i] : src->registers[i];
+	}
+	
+	return 0;
+}
+
+void 
+FloatInspectorCardinalityFree(FloatInspectorCardinalityRef sketch) {
+	
+	if (sketch == NULL) {
+		
+		return;
+	}
+	
+	free(sketch->registers);
+	free(sketch);
+}
+
+void 
+FloatInspectorCardinalityAddWords32(FloatInspectorCardinalityRef sketch,
+									const void *restrict words,
+									size_t n) {
+	
+	const uint8_t *bytes = words;
+	const unsigned int p = sketch->precision;
+	uint8_t *restrict registers = sketch->registers;
+	uint32_t codes[kFloatInspectorCardinalityChunk];
+	
+	for (size_t i = 0; i < n; i += kFloatInspectorCardinalityChunk) {
+		
+		const size_t nChunk = n - i < kFloatInspectorCardinalityChunk ? 
+			n - i : kFloatInspectorCardinalityChunk;
+		
+		if (sketch->floor < kFloatInspectorCardinalitySkipFloor) {
+			
+			for (size_t j = 0; j < nChunk; j++) {
+				
+				uint32_t x;
+				memcpy(&x, bytes + (i + j) * sizeof(x), sizeof(x));
+				FloatInspectorCardinalityAddWord(registers, FloatInspectorCardinalityWordHash32(x), p);
+			}
+			
+			FloatInspectorCardinalityRaiseFloor(sketch, nChunk);
+			continue;
+		}
+		
+		const uint32_t mask = FloatInspectorCardinalityFloorMask(sketch);
+		size_t j = 0, nCodes = 0;
+		
+		for (; j + kFloatInspectorCardinalityLanes32 <= nChunk; 
+			 j += kFloatInspectorCardinalityLanes32) {
+			
+			FloatInspectorCardinalityWords32 x;
+			memcpy(&x, bytes + (i + j) * sizeof(uint32_t), sizeof(x));
+			nCodes = FloatInspectorCardinalityKeepCodes(codes, nCodes, 
+														FloatInspectorCardinalityHash32(x),
+														kFloatInspectorCardinalityLanes32, p, mask);
+		}
+		
+		/* The tail is padded, only its own codes are kept.  */
+		if (j < nChunk) {
+			
+			FloatInspectorCardinalityWords32 x = { 0 };
+			memcpy(&x, bytes + (i + j) * sizeof(uint32_t), (nChunk - j) * sizeof(uint32_t));
+			nCodes = FloatInspectorCardinalityKeepCodes(codes, nCodes, 
+														FloatInspectorCardinalityHash32(x),
+														nChunk - j, p, mask);
+		}
+		
+		FloatInspectorCardinalityAddCodes(sketch, codes, nCodes);
+		FloatInspectorCardinalityRaiseFloor(sketch, nChunk);
+	}
+}
+
+void 
+FloatInspectorCardinalityAddWords64(FloatInspectorCardinalityRef sketch,
+									const void *restrict words,
+									size_t n) {
+	
+	const uint8_t *bytes = words;
+	uint64_t hashes[kFloatInspectorCardinalityChunk];
+	
+	for (size_t i = 0; i < n; i += kFloatInspectorCardinalityChunk) {
+		
+		const size_t nChunk = n - i < kFloatInspectorCardinalityChunk ? 
+			n - i : kFloatInspectorCardinalityChunk;
+		
+		for (size_t j = 0; j < nChunk; j++) {
+			
+			uint64_t word;
+			memcpy(&word, bytes + (i + j) * sizeof(word), sizeof(word));
+			hashes[j] = FloatInspectorCardinalityHash(word);
+		}
+		
+		FloatInspectorCardinalityAddHashes(sketch, hashes, nChunk);
+	}
+}
+
+void 
+FloatInspectorCardinalityAddBytes(FloatInspectorCardinalityRef sketch,
+								  const void *restrict bytes,
+								  size_t nBytes) {
+	
+	uint64_t words[2] = { 0, 0 };
+	memcpy(words, bytes, nBytes < sizeof(words) ? nBytes : sizeof(words));
+	
+	const uint64_t hash = 
+		FloatInspectorCardinalityHash(words[0] ^ FloatInspectorCardinalityHash(words[1]));
+	
+	FloatInspectorCardinalityAddHashes(sketch, &hash, 1);
+}
+
+double 
+FloatInspectorCardinalityEstimate(const FloatInspectorCardinalityRef sketch) {
+	
+	const size_t m = (size_t) 1 << sketch->precision;
+	double sum = 0.;
+	size_t nZero = 0;
+	
+	for (size_t i = 0; i < m; i++) {
+		
+		sum += ldexp(1., -(int) sketch->registers[i]);
+		nZero += sketch->registers[i] == 0;
+	}
+	
+	double alpha;
+	
+	switch (m) {
+		case 16:
+			alpha = .673;
+			break;
+			
+		case 32:
+			alpha = .697;
+			break;
+			
+		case 64:
+			alpha = .709;
+			break;
+			
+		default:
+			alpha = .7213 / (1. + 1.079 / (double) m);
+			break;
+	}
+	
+	const double estimate = alpha * (double) m * (double) m / sum;
+	
+	/* Small range correction, 64 bit hashes need no large range one.  */
+	if ((estimate <= 2.5 * (double) m) && (nZero != 0)) {
+		
+		return (double) m * log((double) m / (double) nZero);
+	}
+	
+	return estimate;
+}
+
+size_t 
+FloatInspectorCardinalityEncodedSize(const FloatInspectorCardinalityRef sketch) {
+	
+	return sizeof(kFloatInspectorCardinalityMagic) + 1 + ((size_t) 1 << sketch->precision);
+}
+
+size_t 
+FloatInspectorCardinalityEncode(const FloatInspectorCardinalityRef sketch,
+								uint8_t *buffer,
+								size_t size) {
+	
+	const size_t nBytes = FloatInspectorCardinalityEncodedSize(sketch);
+	
+	if (size < nBytes) {
+		
+		return 0;
+	}
+	
+	memcpy(buffer, kFloatInspectorCardinalityMagic, sizeof(kFloatInspectorCardinalityMagic));
+	buffer[sizeof(kFloatInspectorCardinalityMagic)] = (uint8_t) sketch->precision;
+	memcpy(buffer + sizeof(kFloatInspectorCardinalityMagic) + 1, 
+		   sketch->registers, (size_t) 1 << sketch->precision);
+	
+	return nBytes;
+}
+
+FloatInspectorCardinalityRef 
+FloatInspectorCardinalityDecode(const uint8_t *buffer, size_t size) {
+	
+	const size_t nHeader = sizeof(kFloatInspectorCardinalityMagic) + 1;
+	
+	if ((size < nHeader) ||
+		(memcmp(buffer, kFloatInspectorCardinalityMagic, 
+				sizeof(kFloatInspectorCardinalityMagic)) != 0)) {
+		
+		return NULL;
+	}
+	
+	const unsigned int precision = buffer[sizeof(kFloatInspectorCardinalityMagic)];
+	
+	if ((precision < kFloatInspectorCardinalityMinPrecision) ||
+		(precision > kFloatInspectorCardinalityMaxPrecision) ||
+		(size != nHeader + ((size_t) 1 << precision))) {
+		
+		return NULL;
+	}
+	
+	const size_t m = (size_t) 1 << precision;
+	
+	for (size_t i = 0; i < m; i++) {
+		
+		if (buffer[nHeader + i] > 64 - precision + 1) {
+			
+			return NULL;
+		}
+	}
+	
+	FloatInspectorCardinalityRef sketch = FloatInspectorCardinalityCreate(precision);
+	
+	if (sketch == NULL) {
+		
+		return NULL;
+	}
+	
+	memcpy(sketch->registers, buffer + nHeader, m);
+	
+	return sketch;
+}
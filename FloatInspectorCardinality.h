@@ -0,0 +1,122 @@
+//
+//  FloatInspectorCardinality.h
+//  FloatInspector
+//  
+//  Copyright 2011 Stefan Reinhold <stefan@sreinhold.com>. All rights reserved.
+//  
+//  Redistribution and use in source and binary forms, with or without modification, are
+//  permitted provided that the following conditions are met:
+//  
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//  
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list
+//  of conditions and the following disclaimer in the documentation and/or other materials
+//  provided with the distribution.
+//  
+//  THIS SOFTWARE IS PROVIDED BY STEFAN REINHOLD ``AS IS'' AND ANY EXPRESS OR IMPLIED
+//  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STEFAN REINHOLD OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+//  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+//  ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//  
+//  The views and conclusions contained in the software and documentation are those of the
+//  authors and should not be interpreted as representing official policies, either expressed
+//  or implied, of Stefan Reinhold.
+//  
+
+
+
+#ifndef FloatInspector_FloatInspectorCardinality_h
+#define FloatInspector_FloatInspectorCardinality_h
+
+#include <inttypes.h>
+#include <stddef.h>
+
+#pragma mark Data Types
+
+/* HyperLogLog sketch of distinct bit patterns. Uses 2^precision one byte 
+ * registers, the standard error of the estimate is about 
+ * 1.04 / sqrt(2^precision). Sketches of the same precision can be merged 
+ * losslessly, so per thread or per node sketches can be combined later.  */
+typedef struct {
+	
+	unsigned int precision;
+	uint8_t * restrict registers;
+	
+	/* No register is below floor, 32 bit words of a rank up to it are 
+	 * skipped. Raised from the registers every 2^precision such words.  */
+	unsigned int floor;
+	size_t nUntilScan;
+	
+} _FloatInspectorCardinality;
+typedef _FloatInspectorCardinality* FloatInspectorCardinalityRef;
+
+#pragma mark Constants
+
+/* 4 KiB of registers, about 1.6% standard error.  */
+#define kFloatInspectorCardinalityDefaultPrecision	12
+#define kFloatInspectorCardinalityMinPrecision		4
+#define kFloatInspectorCardinalityMaxPrecision		18
+
+#pragma mark Public Functions
+
+/* Returns an empty sketch or NULL if the precision is out of range or memory
+ * is exhausted.  */
+FloatInspectorCardinalityRef 
+FloatInspectorCardinalityCreate(unsigned int precision);
+
+FloatInspectorCardinalityRef 
+FloatInspectorCardinalityCopy(const FloatInspectorCardinalityRef sketch);
+
+void FloatInspectorCardinalityReset(FloatInspectorCardinalityRef sketch);
+
+/* Folds src into dst. Returns 0 on success and -1 if the precisions 
+ * differ.  */
+int FloatInspectorCardinalityMerge(FloatInspectorCardinalityRef dst,
+								   const FloatInspectorCardinalityRef src);
+
+void FloatInspectorCardinalityFree(FloatInspectorCardinalityRef sketch);
+
+/* Adds n 32 resp. 64 bit patterns. Values are read with memcpy, so float 
+ * and double arrays can be passed directly. 32 bit words are hashed four at
+ * a time to 32 bits, which runs the estimate low by some 0.2% at 4 * 10^8 
+ * distinct words and 1% at 10^9. 64 bit words are hashed one at a time to 
+ * 64 bits: the lanes would need a 64 bit multiply, which SSE2 and NEON 
+ * lack.  */
+void FloatInspectorCardinalityAddWords32(FloatInspectorCardinalityRef sketch,
+										 const void *restrict words,
+										 size_t n);
+
+void FloatInspectorCardinalityAddWords64(FloatInspectorCardinalityRef sketch,
+										 const void *restrict words,
+										 size_t n);
+
+/* Adds a single bit pattern of up to 16 bytes, e.g. the significant bytes of
+ * a long double.  */
+void FloatInspectorCardinalityAddBytes(FloatInspectorCardinalityRef sketch,
+									   const void *restrict bytes,
+									   size_t nBytes);
+
+/* Estimated number of distinct patterns added so far.  */
+double FloatInspectorCardinalityEstimate(const FloatInspectorCardinalityRef sketch);
+
+/* Size of the serialized sketch in bytes.  */
+size_t 
+FloatInspectorCardinalityEncodedSize(const FloatInspectorCardinalityRef sketch);
+
+/* Writes the sketch to buffer, so sketches can be shipped between nodes. 
+ * Returns the number of bytes written or 0 if the buffer is too small.  */
+size_t FloatInspectorCardinalityEncode(const FloatInspectorCardinalityRef sketch,
+									   uint8_t *buffer,
+									   size_t size);
+
+/* Parses an encoded sketch. Returns NULL if the buffer is malformed.  */
+FloatInspectorCardinalityRef 
+FloatInspectorCardinalityDecode(const uint8_t *buffer, size_t size);
+
+#endif
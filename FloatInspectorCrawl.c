@@ -0,0 +1,1544 @@
+//
+//  FloatInspectorCrawl.c
+//  FloatInspector
+//  
+//  Copyright 2011 Stefan Reinhold <stefan@sreinhold.com>. All rights reserved.
+//  
+//  Redistribution and use in source and binary forms, with or without modification, are
+//  permitted provided that the following conditions are met:
+//  
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//  
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list
+//  of conditions and the following disclaimer in the documentation and/or other materials
+//  provided with the distribution.
+//  
+//  THIS SOFTWARE IS PROVIDED BY STEFAN REINHOLD ``AS IS'' AND ANY EXPRESS OR IMPLIED
+//  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STEFAN REINHOLD OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+//  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+//  ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//  
+//  The views and conclusions contained in the software and documentation are those of the
+//  authors and should not be interpreted as representing official policies, either expressed
+//  or implied, of Stefan Reinhold.
+//  
+
+
+
+
+#define _GNU_SOURCE
+
+#include "FloatInspectorCrawl.h"
+#include "FloatInspectorPerf.h"
+#include "FloatInspectorSnapshot.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <fts.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+#if defined(__linux__)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+#pragma mark Data Types
+
+typedef struct {
+	
+	char *path;
+	unsigned long long size;
+	/* Modification time in nanoseconds, part of the checkpoint key.  */
+	long long mtime;
+	
+	int fd;
+	/* Next byte to read and end of the last whole value.  */
+	unsigned long long next;
+	unsigned long long end;
+	/* Buffers handed out and not yet classified.  */
+	unsigned int nPending;
+	/* All buffers have been handed out.  */
+	int issued;
+	/* Completed, by this run or an earlier one.  */
+	int completed;
+	int error;
+	
+	/* Updated by the workers under lock.  */
+	FloatInspectorStatisticsRef stats;
+	pthread_mutex_t lock;
+	
+} FloatInspectorCrawlEntry;
+
+typedef struct _FloatInspectorCrawlBuffer {
+	
+	uint8_t *data;
+	FloatInspectorCrawlEntry *entry;
+	unsigned long long offset;
+	size_t length;
+	size_t filled;
+	int error;
+	/* Remaining part of a short read, resubmitted to the ring.  */
+	struct iovec iov;
+	
+	struct _FloatInspectorCrawlBuffer *next;
+	
+} FloatInspectorCrawlBuffer;
+
+#if defined(__linux__)
+
+/* The parts of an io_uring instance a single submitter needs.  */
+typedef struct {
+	
+	int fd;
+	unsigned int nEntries;
+	
+	unsigned int *sqHead;
+	unsigned int *sqTail;
+	unsigned int *sqMask;
+	unsigned int *sqArray;
+	struct io_uring_sqe *sqes;
+	
+	unsigned int *cqHead;
+	unsigned int *cqTail;
+	unsigned int *cqMask;
+	struct io_uring_cqe *cqes;
+	
+	void *sqMap;
+	size_t sqMapSize;
+	void *cqMap;
+	size_t cqMapSize;
+	size_t sqesSize;
+	
+} FloatInspectorCrawlRing;
+
+#endif
+
+struct _FloatInspectorCrawl {
+	
+	FloatInspectorCrawlOptions options;
+	FloatInspectorStatisticsRef prototype;
+	size_t elementSize;
+	
+	FloatInspectorCrawlEntry *entries;
+	size_t nEntries;
+	size_t capacity;
+	char *checkpointPath;
+	
+	/* Guards everything below up to the finish lock.  */
+	pthread_mutex_t lock;
+	pthread_cond_t bufferFree;
+	pthread_cond_t bufferReady;
+	
+	FloatInspectorCrawlBuffer *buffers;
+	FloatInspectorCrawlBuffer *freeBuffers;
+	FloatInspectorCrawlBuffer *readyHead;
+	FloatInspectorCrawlBuffer *readyTail;
+	/* No buffer will become ready any more.  */
+	int readingDone;
+	unsigned int nReadersRunning;
+	
+	/* Files being handed out, interleaved buffer by buffer.  */
+	FloatInspectorCrawlEntry **active;
+	unsigned int nActive;
+	unsigned int cursor;
+	size_t nextEntry;
+	unsigned long long nBytes;
+	
+	/* Serializes aggregate, checkpoint and callback.  */
+	pthread_mutex_t finishLock;
+	FloatInspectorStatisticsRef stats;
+	FloatInspectorStatisticsRef empty;
+	FloatInspectorCrawlCallback callback;
+	void *context;
+	int checkpoint;
+	unsigned int nUnsynced;
+	int failed;
+	int asynchronous;
+};
+
+#pragma mark Constants
+
+const FloatInspectorCrawlOptions kFloatInspectorCrawlDefaultOptions = {
+	.offset			= 0,
+	.bufferSize		= (size_t) 1 << 20,
+	.nBuffers		= 64,
+	.nWorkers		= 0,
+	.nReaders		= 16,
+	.nOpenFiles		= 16,
+	.asynchronous	= 1
+};
+
+/* Checkpoint header: magic, version, type, padding and the offset option.  */
+static const uint8_t kFloatInspectorCrawlMagic[4] = {'F', 'I', 'C', 'K'};
+#define kFloatInspectorCrawlVersion		2
+#define kFloatInspectorCrawlHeaderSize	16
+/* Completed files between two syncs of the checkpoint.  */
+#define kFloatInspectorCrawlSyncInterval	64
+
+#pragma mark Private Function Prototypes
+
+static size_t FloatInspectorCrawlElementSize(enum PrecisionType type);
+
+static int FloatInspectorCrawlAddEntry(FloatInspectorCrawlRef crawl,
+									   const char *path,
+									   const struct stat *st,
+									   int error);
+
+static int FloatInspectorCrawlCompareEntries(const void *a, const void *b);
+
+static FloatInspectorCrawlEntry *
+FloatInspectorCrawlFindEntry(FloatInspectorCrawlRef crawl, const char *path);
+
+static void FloatInspectorCrawlPut32(uint8_t *p, uint32_t value);
+static void FloatInspectorCrawlPut64(uint8_t *p, uint64_t value);
+static uint32_t FloatInspectorCrawlGet32(const uint8_t *p);
+static uint64_t FloatInspectorCrawlGet64(const uint8_t *p);
+static uint32_t FloatInspectorCrawlChecksum(const uint8_t *data, size_t size);
+
+static int FloatInspectorCrawlLoadCheckpoint(FloatInspectorCrawlRef crawl);
+
+static void FloatInspectorCrawlResume(FloatInspectorCrawlRef crawl,
+									  FloatInspectorCrawlEntry *entry,
+									  const uint8_t *diff,
+									  size_t size);
+
+static int FloatInspectorCrawlAppendCheckpoint(FloatInspectorCrawlRef crawl,
+											   const FloatInspectorCrawlEntry *entry);
+
+static int FloatInspectorCrawlAssign(FloatInspectorCrawlRef crawl,
+									 FloatInspectorCrawlBuffer *buffer);
+
+static void FloatInspectorCrawlPushReady(FloatInspectorCrawlRef crawl,
+										 FloatInspectorCrawlBuffer *buffer);
+
+static void FloatInspectorCrawlClassify(FloatInspectorCrawlEntry *entry,
+										const FloatInspectorCrawlBuffer *buffer,
+										size_t elementSize);
+
+static void FloatInspectorCrawlFinish(FloatInspectorCrawlRef crawl,
+									  FloatInspectorCrawlEntry *entry);
+
+static void *FloatInspectorCrawlWorker(void *context);
+
+static void *FloatInspectorCrawlReader(void *context);
+
+#if defined(__linux__)
+
+static int FloatInspectorCrawlRingCreate(FloatInspectorCrawlRing *ring,
+										 unsigned int nEntries);
+
+static void FloatInspectorCrawlRingFree(FloatInspectorCrawlRing *ring);
+
+static void FloatInspectorCrawlRingPrepare(FloatInspectorCrawlRing *ring,
+										   FloatInspectorCrawlBuffer *buffer);
+
+static int FloatInspectorCrawlRingEnter(FloatInspectorCrawlRing *ring,
+										unsigned int nSubmit,
+										unsigned int nWait);
+
+static void FloatInspectorCrawlRingRead(FloatInspectorCrawlRef crawl,
+										FloatInspectorCrawlRing *ring);
+
+#endif
+
+#pragma mark Private Functions Implementations
+
+static size_t 
+FloatInspectorCrawlElementSize(enum PrecisionType type) {
+	
+	switch (type) {
+		case Float:
+			return sizeof(float);
+			
+		case Double:
+			return sizeof(double);
+			
+		case LongDouble:
+			return sizeof(long double);
+			
+		case Half:
+		case BFloat16:
+			return sizeof(uint16_t);
+	}
+	
+	return 0;
+}
+
+static int 
+FloatInspectorCrawlAddEntry(FloatInspectorCrawlRef crawl,
+							const char *path,
+							const struct stat *st,
+							int error) {
+	
+	if (crawl->nEntries == crawl->capacity) {
+		
+		const size_t capacity = crawl->capacity == 0 ? 256 : 2 * crawl->capacity;
+		FloatInspectorCrawlEntry *entries = realloc(crawl->entries, 
+													capacity * sizeof(FloatInspectorCrawlEntry));
+		
+		if (entries == NULL) {
+			
+			return -1;
+		}
+		
+		crawl->entries = entries;
+		crawl->capacity = capacity;
+	}
+	
+	FloatInspectorCrawlEntry *entry = &crawl->entries[crawl->nEntries];
+	
+	memset(entry, 0, sizeof(FloatInspectorCrawlEntry));
+	entry->path = strdup(path);
+	entry->fd = -1;
+	entry->error = error;
+	
+	if (entry->path == NULL) {
+		
+		return -1;
+	}
+	
+	if (st != NULL) {
+		
+#if defined(__APPLE__)
+		const struct timespec mtime = st->st_mtimespec;
+#else
+		const struct timespec mtime = st->st_mtim;
+#endif
+		
+		entry->size = (unsigned long long) st->st_size;
+		entry->mtime = 1000000000LL * (long long) mtime.tv_sec + mtime.tv_nsec;
+	}
+	
+	crawl->nEntries++;
+	
+	return 0;
+}
+
+static int 
+FloatInspectorCrawlCompareEntries(const void *a, const void *b) {
+	
+	return strcmp(((const FloatInspectorCrawlEntry *) a)->path, 
+				  ((const FloatInspectorCrawlEntry *) b)->path);
+}
+
+/* Entries are sorted by path when a run starts.  */
+static FloatInspectorCrawlEntry *
+FloatInspectorCrawlFindEntry(FloatInspectorCrawlRef crawl, const char *path) {
+	
+	size_t low = 0, high = crawl->nEntries;
+	
+	while (low < high) {
+		
+		const size_t middle = low + (high - low) / 2;
+		const int order = strcmp(crawl->entries[middle].path, path);
+		
+		if (order == 0) {
+			
+			return &crawl->entries[middle];
+		}
+		
+		if (order < 0) {
+			
+			low = middle + 1;
+		}
+		else {
+			
+			high = middle;
+		}
+	}
+	
+	return NULL;
+}
+
+static void 
+FloatInspectorCrawlPut32(uint8_t *p, uint32_t value) {
+	
+	for (unsigned int i = 0; i < 4; i++) {
+		
+		p[i] = (uint8_t) (value >> (8 * i));
+	}
+}
+
+static void 
+FloatInspectorCrawlPut64(uint8_t *p, uint64_t value) {
+	
+	FloatInspectorCrawlPut32(p, (uint32_t) value);
+	FloatInspectorCrawlPut32(p + 4, (uint32_t) (value >> 32));
+}
+
+static uint32_t 
+FloatInspectorCrawlGet32(const uint8_t *p) {
+	
+	return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | 
+		((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static uint64_t 
+FloatInspectorCrawlGet64(const uint8_t *p) {
+	
+	return (uint64_t) FloatInspectorCrawlGet32(p) | 
+		((uint64_t) FloatInspectorCrawlGet32(p + 4) << 32);
+}
+
+/* FNV-1a, detects records torn by a crash.  */
+static uint32_t 
+FloatInspectorCrawlChecksum(const uint8_t *data, size_t size) {
+	
+	uint32_t hash = 2166136261u;
+	
+	for (size_t i = 0; i < size; i++) {
+		
+		hash = (hash ^ data[i]) * 16777619u;
+	}
+	
+	return hash;
+}
+
+/* The checkpoint is a header followed by one record per completed file:
+ * 
+ *   u32 payload size, payload, u32 checksum of the payload
+ *   payload: u32 path length, path, u64 size, u64 mtime, encoded diff
+ * 
+ * The diff is taken against empty statistics and carries the full 64 bit 
+ * counters, version 1 checkpoints held 32 bit ones and are refused. 
+ * Everything after the first damaged record is cut off, the file is 
+ * reopened for appending.  */
+static int 
+FloatInspectorCrawlLoadCheckpoint(FloatInspectorCrawlRef crawl) {
+	
+	const int fd = open(crawl->checkpointPath, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	struct stat st;
+	
+	if ((fd < 0) || (fstat(fd, &st) != 0)) {
+		
+		if (fd >= 0) close(fd);
+		return -1;
+	}
+	
+	const size_t size = (size_t) st.st_size;
+	uint8_t *data = malloc(size + 1);
+	size_t nRead = 0;
+	
+	if (data == NULL) {
+		
+		close(fd);
+		errno = ENOMEM;
+		return -1;
+	}
+	
+	while (nRead < size) {
+		
+		const ssize_t n = pread(fd, data + nRead, size - nRead, (off_t) nRead);
+		
+		if ((n < 0) && (errno == EINTR)) continue;
+		
+		if (n <= 0) break;
+		
+		nRead += (size_t) n;
+	}
+	
+	size_t valid = 0;
+	uint8_t header[kFloatInspectorCrawlHeaderSize] = {0};
+	
+	memcpy(header, kFloatInspectorCrawlMagic, sizeof(kFloatInspectorCrawlMagic));
+	header[4] = kFloatInspectorCrawlVersion;
+	header[5] = (uint8_t) crawl->prototype->type;
+	FloatInspectorCrawlPut64(header + 8, crawl->options.offset);
+	
+	if (nRead >= kFloatInspectorCrawlHeaderSize) {
+		
+		/* Counters of another format or offset cannot be reused.  */
+		if (memcmp(data, header, kFloatInspectorCrawlHeaderSize) != 0) {
+			
+			free(data);
+			close(fd);
+			errno = EINVAL;
+			return -1;
+		}
+		
+		valid = kFloatInspectorCrawlHeaderSize;
+		
+		while (nRead - valid >= 8) {
+			
+			const size_t length = FloatInspectorCrawlGet32(data + valid);
+			const uint8_t *payload = data + valid + 4;
+			
+			if ((length < 20) || (length > nRead - valid - 8) ||
+				(FloatInspectorCrawlGet32(payload + length) != 
+				 FloatInspectorCrawlChecksum(payload, length))) {
+				
+				break;
+			}
+			
+			const size_t pathLength = FloatInspectorCrawlGet32(payload);
+			
+			if (pathLength > length - 20) {
+				
+				break;
+			}
+			
+			char *path = malloc(pathLength + 1);
+			
+			if (path == NULL) {
+				
+				break;
+			}
+			
+			memcpy(path, payload + 4, pathLength);
+			path[pathLength] = '\0';
+			
+			FloatInspectorCrawlEntry *entry = FloatInspectorCrawlFindEntry(crawl, path);
+			const uint8_t *key = payload + 4 + pathLength;
+			
+			/* Files that changed since are read again.  */
+			if ((entry != NULL) && !entry->completed && (entry->error == 0) &&
+				(FloatInspectorCrawlGet64(key) == entry->size) &&
+				(FloatInspectorCrawlGet64(key + 8) == (uint64_t) entry->mtime)) {
+				
+				FloatInspectorCrawlResume(crawl, entry, key + 16, 
+										  length - 20 - pathLength);
+			}
+			
+			free(path);
+			valid += length + 8;
+		}
+	}
+	
+	free(data);
+	
+	if ((valid < (size_t) st.st_size) && (ftruncate(fd, (off_t) valid) != 0)) {
+		
+		close(fd);
+		return -1;
+	}
+	
+	if ((valid == 0) && 
+		(pwrite(fd, header, kFloatInspectorCrawlHeaderSize, 0) != kFloatInspectorCrawlHeaderSize)) {
+		
+		close(fd);
+		return -1;
+	}
+	
+	if (lseek(fd, 0, SEEK_END) < 0) {
+		
+		close(fd);
+		return -1;
+	}
+	
+	crawl->checkpoint = fd;
+	
+	return 0;
+}
+
+static void 
+FloatInspectorCrawlResume(FloatInspectorCrawlRef crawl,
+						  FloatInspectorCrawlEntry *entry,
+						  const uint8_t *diff,
+						  size_t size) {
+	
+	FloatInspectorStatisticsDiffRef decoded = FloatInspectorStatisticsDiffDecode(diff, size);
+	FloatInspectorStatisticsRef stats = FloatInspectorStatisticsCreate(crawl->prototype->type);
+	
+	/* A record that does not fit the aggregate is dropped and the file is
+	 * read again.  */
+	if ((decoded != NULL) && (stats != NULL) && 
+		(FloatInspectorStatisticsDiffApply(stats, decoded) == 0) &&
+		(FloatInspectorStatisticsDiffApply(crawl->stats, decoded) == 0)) {
+		
+		const FloatInspectorCrawlFile file = {
+			.path = entry->path,
+			.size = entry->size,
+			.stats = stats,
+			.error = 0,
+			.resumed = 1
+		};
+		
+		entry->completed = 1;
+		
+		if (crawl->callback != NULL) {
+			
+			crawl->callback(&file, crawl->context);
+		}
+	}
+	
+	if (decoded != NULL) FloatInspectorStatisticsDiffFree(decoded);
+	if (stats != NULL) FloatInspectorStatisticsFree(stats);
+}
+
+/* Called under the finish lock. A record is written at once, so a crash
+ * leaves at most one torn record at the end.  */
+static int 
+FloatInspectorCrawlAppendCheckpoint(FloatInspectorCrawlRef crawl,
+									const FloatInspectorCrawlEntry *entry) {
+	
+	FloatInspectorStatisticsDiffRef diff = FloatInspectorStatisticsDiffCreate(crawl->empty, 
+																			  entry->stats);
+	
+	if (diff == NULL) {
+		
+		errno = ENOMEM;
+		return -1;
+	}
+	
+	const size_t pathLength = strlen(entry->path);
+	const size_t capacity = 4 + 4 + pathLength + 16 + 
+		FloatInspectorStatisticsDiffEncodedSize(diff) + 4;
+	uint8_t *record = malloc(capacity);
+	
+	if (record == NULL) {
+		
+		FloatInspectorStatisticsDiffFree(diff);
+		errno = ENOMEM;
+		return -1;
+	}
+	
+	uint8_t *payload = record + 4;
+	
+	FloatInspectorCrawlPut32(payload, (uint32_t) pathLength);
+	memcpy(payload + 4, entry->path, pathLength);
+	FloatInspectorCrawlPut64(payload + 4 + pathLength, entry->size);
+	FloatInspectorCrawlPut64(payload + 12 + pathLength, (uint64_t) entry->mtime);
+	
+	const size_t length = 20 + pathLength + 
+		FloatInspectorStatisticsDiffEncode(diff, payload + 20 + pathLength, 
+										   capacity - 28 - pathLength);
+	
+	FloatInspectorStatisticsDiffFree(diff);
+	FloatInspectorCrawlPut32(record, (uint32_t) length);
+	FloatInspectorCrawlPut32(payload + length, FloatInspectorCrawlChecksum(payload, length));
+	
+	ssize_t n;
+	
+	while (((n = write(crawl->checkpoint, record, length + 8)) < 0) && (errno == EINTR));
+	
+	free(record);
+	
+	if (n != (ssize_t) (length + 8)) {
+		
+		if (n >= 0) errno = EIO;
+		return -1;
+	}
+	
+	if (++crawl->nUnsynced == kFloatInspectorCrawlSyncInterval) {
+		
+		crawl->nUnsynced = 0;
+		fsync(crawl->checkpoint);
+	}
+	
+	return 0;
+}
+
+/* Called under the lock. Hands out the next part of one of the active 
+ * files, opening files as the window has room. Files that cannot be opened
+ * or hold no value get a single empty buffer, so every file completes 
+ * through the workers. Returns 0 if no file is left.  */
+static int 
+FloatInspectorCrawlAssign(FloatInspectorCrawlRef crawl,
+						  FloatInspectorCrawlBuffer *buffer) {
+	
+	while ((crawl->nActive < crawl->options.nOpenFiles) && 
+		   (crawl->nextEntry < crawl->nEntries)) {
+		
+		FloatInspectorCrawlEntry *entry = &crawl->entries[crawl->nextEntry++];
+		
+		if (entry->completed) {
+			
+			continue;
+		}
+		
+		entry->next = crawl->options.offset;
+		entry->end = crawl->options.offset;
+		
+		if (entry->error == 0) {
+			
+			entry->fd = open(entry->path, O_RDONLY | O_CLOEXEC);
+			
+			if (entry->fd < 0) {
+				
+				entry->error = errno;
+			}
+			else if (entry->size > crawl->options.offset) {
+				
+				entry->end += (entry->size - crawl->options.offset) / crawl->elementSize * 
+					crawl->elementSize;
+			}
+		}
+		
+		if (entry->error == 0) {
+			
+			entry->stats = FloatInspectorStatisticsCopy(crawl->prototype);
+			
+			if (entry->stats == NULL) {
+				
+				entry->error = ENOMEM;
+			}
+			else {
+				
+				FloatInspectorStatisticsReset(entry->stats);
+				pthread_mutex_init(&entry->lock, NULL);
+			}
+		}
+		
+		if (entry->error != 0) {
+			
+			entry->end = entry->next;
+		}
+		
+		crawl->active[crawl->nActive++] = entry;
+	}
+	
+	if (crawl->nActive == 0) {
+		
+		return 0;
+	}
+	
+	const unsigned int i = crawl->cursor % crawl->nActive;
+	FloatInspectorCrawlEntry *entry = crawl->active[i];
+	const unsigned long long remaining = entry->end - entry->next;
+	
+	buffer->entry = entry;
+	buffer->offset = entry->next;
+	buffer->length = remaining < crawl->options.bufferSize ? 
+		(size_t) remaining : crawl->options.bufferSize;
+	buffer->filled = 0;
+	buffer->error = 0;
+	
+	entry->next += buffer->length;
+	entry->nPending++;
+	
+	if (entry->next == entry->end) {
+		
+		entry->issued = 1;
+		crawl->active[i] = crawl->active[--crawl->nActive];
+	}
+	else {
+		
+		crawl->cursor++;
+	}
+	
+	return 1;
+}
+
+/* Called under the lock. A failed read stops the rest of its file.  */
+static void 
+FloatInspectorCrawlPushReady(FloatInspectorCrawlRef crawl,
+							 FloatInspectorCrawlBuffer *buffer) {
+	
+	FloatInspectorCrawlEntry *entry = buffer->entry;
+	
+	if ((buffer->error != 0) && (entry->error == 0)) {
+		
+		entry->error = buffer->error;
+		entry->end = entry->next;
+	}
+	
+	buffer->next = NULL;
+	
+	if (crawl->readyTail == NULL) {
+		
+		crawl->readyHead = buffer;
+	}
+	else {
+		
+		crawl->readyTail->next = buffer;
+	}
+	
+	crawl->readyTail = buffer;
+	pthread_cond_signal(&crawl->bufferReady);
+}
+
+static void 
+FloatInspectorCrawlClassify(FloatInspectorCrawlEntry *entry,
+							const FloatInspectorCrawlBuffer *buffer,
+							size_t elementSize) {
+	
+	const size_t n = buffer->filled / elementSize;
+	FloatInspectorStatisticsRef stats = entry->stats;
+	
+	pthread_mutex_lock(&entry->lock);
+	
+	switch (stats->type) {
+		case Float:
+			FloatInspectorStatisticsUpdateWithFloats(stats, (const float *) buffer->data, n);
+			break;
+			
+		case Double:
+			FloatInspectorStatisticsUpdateWithDoubles(stats, (const double *) buffer->data, n);
+			break;
+			
+		case LongDouble:
+			FloatInspectorStatisticsUpdateWithLongDoubles(stats, 
+														  (const long double *) buffer->data, 
+														  n);
+			break;
+			
+		case Half:
+			FloatInspectorStatisticsUpdateWithHalfs(stats, (const uint16_t *) buffer->data, n);
+			break;
+			
+		case BFloat16:
+			FloatInspectorStatisticsUpdateWithBFloat16s(stats, 
+														(const uint16_t *) buffer->data, 
+														n);
+			break;
+	}
+	
+	pthread_mutex_unlock(&entry->lock);
+}
+
+static void 
+FloatInspectorCrawlFinish(FloatInspectorCrawlRef crawl,
+						  FloatInspectorCrawlEntry *entry) {
+	
+	if (entry->fd >= 0) {
+		
+		close(entry->fd);
+		entry->fd = -1;
+	}
+	
+	pthread_mutex_lock(&crawl->finishLock);
+	
+	if ((entry->error == 0) && 
+		(FloatInspectorStatisticsMerge(crawl->stats, entry->stats) != 0)) {
+		
+		entry->error = EOVERFLOW;
+	}
+	
+	if (entry->error == 0) {
+		
+		if ((crawl->checkpoint >= 0) && 
+			(FloatInspectorCrawlAppendCheckpoint(crawl, entry) != 0)) {
+			
+			/* The scan goes on, only the resume point is lost.  */
+			close(crawl->checkpoint);
+			crawl->checkpoint = -1;
+			crawl->failed = errno;
+		}
+	}
+	else if (crawl->failed == 0) {
+		
+		crawl->failed = entry->error;
+	}
+	
+	const FloatInspectorCrawlFile file = {
+		.path = entry->path,
+		.size = entry->size,
+		.stats = entry->error == 0 ? entry->stats : NULL,
+		.error = entry->error,
+		.resumed = 0
+	};
+	
+	entry->completed = 1;
+	
+	if (crawl->callback != NULL) {
+		
+		crawl->callback(&file, crawl->context);
+	}
+	
+	pthread_mutex_unlock(&crawl->finishLock);
+	
+	if (entry->stats != NULL) {
+		
+		FloatInspectorStatisticsFree(entry->stats);
+		pthread_mutex_destroy(&entry->lock);
+		entry->stats = NULL;
+	}
+}
+
+static void *
+FloatInspectorCrawlWorker(void *context) {
+	
+	FloatInspectorCrawlRef crawl = context;
+	
+	FloatInspectorPerfMarkWorkerThread();
+	pthread_mutex_lock(&crawl->lock);
+	
+	for (;;) {
+		
+		while ((crawl->readyHead == NULL) && !crawl->readingDone) {
+			
+			pthread_cond_wait(&crawl->bufferReady, &crawl->lock);
+		}
+		
+		FloatInspectorCrawlBuffer *buffer = crawl->readyHead;
+		
+		if (buffer == NULL) {
+			
+			break;
+		}
+		
+		crawl->readyHead = buffer->next;
+		
+		if (crawl->readyHead == NULL) {
+			
+			crawl->readyTail = NULL;
+		}
+		
+		pthread_mutex_unlock(&crawl->lock);
+		
+		FloatInspectorCrawlEntry *entry = buffer->entry;
+		
+		if ((buffer->error == 0) && (buffer->filled != 0)) {
+			
+			FloatInspectorCrawlClassify(entry, buffer, crawl->elementSize);
+		}
+		
+		pthread_mutex_lock(&crawl->lock);
+		
+		crawl->nBytes += buffer->filled;
+		buffer->next = crawl->freeBuffers;
+		crawl->freeBuffers = buffer;
+		pthread_cond_signal(&crawl->bufferFree);
+		
+		if ((--entry->nPending == 0) && entry->issued) {
+			
+			pthread_mutex_unlock(&crawl->lock);
+			FloatInspectorCrawlFinish(crawl, entry);
+			pthread_mutex_lock(&crawl->lock);
+		}
+	}
+	
+	pthread_mutex_unlock(&crawl->lock);
+	
+	return NULL;
+}
+
+/* Blocking reader, several of them keep the device busy.  */
+static void *
+FloatInspectorCrawlReader(void *context) {
+	
+	FloatInspectorCrawlRef crawl = context;
+	
+	pthread_mutex_lock(&crawl->lock);
+	
+	for (;;) {
+		
+		while (crawl->freeBuffers == NULL) {
+			
+			pthread_cond_wait(&crawl->bufferFree, &crawl->lock);
+		}
+		
+		FloatInspectorCrawlBuffer *buffer = crawl->freeBuffers;
+		
+		if (!FloatInspectorCrawlAssign(crawl, buffer)) {
+			
+			break;
+		}
+		
+		crawl->freeBuffers = buffer->next;
+		pthread_mutex_unlock(&crawl->lock);
+		
+		while ((buffer->filled < buffer->length) && (buffer->error == 0)) {
+			
+			const ssize_t n = pread(buffer->entry->fd, buffer->data + buffer->filled,
+									buffer->length - buffer->filled,
+									(off_t) (buffer->offset + buffer->filled));
+			
+			if (n < 0) {
+				
+				if (errno != EINTR) buffer->error = errno;
+			}
+			else if (n == 0) {
+				
+				/* Truncated since it was listed.  */
+				buffer->filled -= buffer->filled % crawl->elementSize;
+				break;
+			}
+			else {
+				
+				buffer->filled += (size_t) n;
+			}
+		}
+		
+		pthread_mutex_lock(&crawl->lock);
+		FloatInspectorCrawlPushReady(crawl, buffer);
+	}
+	
+	/* Wake the other readers, no file is left for them either.  */
+	pthread_cond_broadcast(&crawl->bufferFree);
+	
+	if (--crawl->nReadersRunning == 0) {
+		
+		crawl->readingDone = 1;
+		pthread_cond_broadcast(&crawl->bufferReady);
+	}
+	
+	pthread_mutex_unlock(&crawl->lock);
+	
+	return NULL;
+}
+
+#if defined(__linux__)
+
+/* Maps the rings of a new io_uring instance, see io_uring_setup(2).  */
+static int 
+FloatInspectorCrawlRingCreate(FloatInspectorCrawlRing *ring,
+							  unsigned int nEntries) {
+	
+	struct io_uring_params params;
+	
+	memset(ring, 0, sizeof(FloatInspectorCrawlRing));
+	memset(&params, 0, sizeof(params));
+	
+	ring->fd = (int) syscall(__NR_io_uring_setup, nEntries, &params);
+	
+	if (ring->fd < 0) {
+		
+		return -1;
+	}
+	
+	ring->nEntries = params.sq_entries;
+	ring->sqMapSize = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+	ring->cqMapSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+	ring->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+	
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		
+		if (ring->cqMapSize > ring->sqMapSize) {
+			
+			ring->sqMapSize = ring->cqMapSize;
+		}
+		
+		ring->cqMapSize = 0;
+	}
+	
+	ring->sqMap = mmap(NULL, ring->sqMapSize, PROT_READ | PROT_WRITE, 
+					   MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+	ring->cqMap = ring->cqMapSize == 0 ? ring->sqMap :
+		mmap(NULL, ring->cqMapSize, PROT_READ | PROT_WRITE, 
+			 MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+	ring->sqes = mmap(NULL, ring->sqesSize, PROT_READ | PROT_WRITE, 
+					  MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+	
+	if ((ring->sqMap == MAP_FAILED) || (ring->cqMap == MAP_FAILED) || 
+		(ring->sqes == MAP_FAILED)) {
+		
+		FloatInspectorCrawlRingFree(ring);
+		return -1;
+	}
+	
+	uint8_t *sq = ring->sqMap, *cq = ring->cqMap;
+	
+	ring->sqHead = (unsigned int *) (sq + params.sq_off.head);
+	ring->sqTail = (unsigned int *) (sq + params.sq_off.tail);
+	ring->sqMask = (unsigned int *) (sq + params.sq_off.ring_mask);
+	ring->sqArray = (unsigned int *) (sq + params.sq_off.array);
+	ring->cqHead = (unsigned int *) (cq + params.cq_off.head);
+	ring->cqTail = (unsigned int *) (cq + params.cq_off.tail);
+	ring->cqMask = (unsigned int *) (cq + params.cq_off.ring_mask);
+	ring->cqes = (struct io_uring_cqe *) (cq + params.cq_off.cqes);
+	
+	return 0;
+}
+
+static void 
+FloatInspectorCrawlRingFree(FloatInspectorCrawlRing *ring) {
+	
+	if ((ring->sqes != NULL) && (ring->sqes != MAP_FAILED)) {
+		
+		munmap(ring->sqes, ring->sqesSize);
+	}
+	
+	if ((ring->cqMapSize != 0) && (ring->cqMap != NULL) && (ring->cqMap != MAP_FAILED)) {
+		
+		munmap(ring->cqMap, ring->cqMapSize);
+	}
+	
+	if ((ring->sqMap != NULL) && (ring->sqMap != MAP_FAILED)) {
+		
+		munmap(ring->sqMap, ring->sqMapSize);
+	}
+	
+	close(ring->fd);
+}
+
+/* Queues a read of the unfilled part of buffer. There is always room, no
+ * more reads are in flight than the ring has entries.  */
+static void 
+FloatInspectorCrawlRingPrepare(FloatInspectorCrawlRing *ring,
+							   FloatInspectorCrawlBuffer *buffer) {
+	
+	const unsigned int tail = *ring->sqTail;
+	const unsigned int index = tail & *ring->sqMask;
+	struct io_uring_sqe *sqe = &ring->sqes[index];
+	
+	buffer->iov.iov_base = buffer->data + buffer->filled;
+	buffer->iov.iov_len = buffer->length - buffer->filled;
+	
+	memset(sqe, 0, sizeof(struct io_uring_sqe));
+	sqe->opcode = IORING_OP_READV;
+	sqe->fd = buffer->entry->fd;
+	sqe->off = buffer->offset + buffer->filled;
+	sqe->addr = (unsigned long long) (uintptr_t) &buffer->iov;
+	sqe->len = 1;
+	sqe->user_data = (unsigned long long) (uintptr_t) buffer;
+	
+	ring->sqArray[index] = index;
+	__atomic_store_n(ring->sqTail, tail + 1, __ATOMIC_RELEASE);
+}
+
+static int 
+FloatInspectorCrawlRingEnter(FloatInspectorCrawlRing *ring,
+							 unsigned int nSubmit,
+							 unsigned int nWait) {
+	
+	for (;;) {
+		
+		const long n = syscall(__NR_io_uring_enter, ring->fd, nSubmit, nWait, 
+							   nWait != 0 ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+		
+		if (n >= 0) {
+			
+			return 0;
+		}
+		
+		if (errno != EINTR) {
+			
+			return -1;
+		}
+		
+		/* Submitted entries are consumed even if the wait was interrupted.  */
+		nSubmit = 0;
+	}
+}
+
+/* Single submitter keeping every free buffer in flight. The reader only 
+ * sleeps in the kernel while reads are pending, otherwise it waits for the
+ * workers to return a buffer.  */
+static void 
+FloatInspectorCrawlRingRead(FloatInspectorCrawlRef crawl,
+							FloatInspectorCrawlRing *ring) {
+	
+	/* Reads in the kernel and reads queued but not submitted yet.  */
+	unsigned int nInFlight = 0;
+	unsigned int nSubmit = 0;
+	int exhausted = 0;
+	
+	for (;;) {
+		
+		pthread_mutex_lock(&crawl->lock);
+		
+		while (!exhausted && (crawl->freeBuffers != NULL)) {
+			
+			FloatInspectorCrawlBuffer *buffer = crawl->freeBuffers;
+			
+			if (!FloatInspectorCrawlAssign(crawl, buffer)) {
+				
+				exhausted = 1;
+				break;
+			}
+			
+			crawl->freeBuffers = buffer->next;
+			
+			if (buffer->length == 0) {
+				
+				FloatInspectorCrawlPushReady(crawl, buffer);
+			}
+			else {
+				
+				FloatInspectorCrawlRingPrepare(ring, buffer);
+				nInFlight++;
+				nSubmit++;
+			}
+		}
+		
+		if (nInFlight == 0) {
+			
+			if (exhausted) {
+				
+				pthread_mutex_unlock(&crawl->lock);
+				break;
+			}
+			
+			while (crawl->freeBuffers == NULL) {
+				
+				pthread_cond_wait(&crawl->bufferFree, &crawl->lock);
+			}
+			
+			pthread_mutex_unlock(&crawl->lock);
+			continue;
+		}
+		
+		pthread_mutex_unlock(&crawl->lock);
+		
+		const int entered = FloatInspectorCrawlRingEnter(ring, nSubmit, 1);
+		
+		nSubmit = 0;
+		
+		if (entered != 0) {
+			
+			/* Nothing can be reaped, fail the pending reads.  */
+			const int error = errno;
+			
+			pthread_mutex_lock(&crawl->lock);
+			
+			for (unsigned int i = 0; i < crawl->options.nBuffers; i++) {
+				
+				FloatInspectorCrawlBuffer *buffer = &crawl->buffers[i];
+				
+				if (buffer->iov.iov_base != NULL) {
+					
+					buffer->iov.iov_base = NULL;
+					buffer->error = error;
+					FloatInspectorCrawlPushReady(crawl, buffer);
+				}
+			}
+			
+			pthread_mutex_unlock(&crawl->lock);
+			nInFlight = 0;
+			continue;
+		}
+		
+		unsigned int head = *ring->cqHead;
+		const unsigned int tail = __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE);
+		
+		for (; head != tail; head++) {
+			
+			const struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cqMask];
+			FloatInspectorCrawlBuffer *buffer = (FloatInspectorCrawlBuffer *) (uintptr_t) 
+				cqe->user_data;
+			
+			if (cqe->res > 0) {
+				
+				buffer->filled += (size_t) cqe->res;
+			}
+			else if (cqe->res == 0) {
+				
+				buffer->filled -= buffer->filled % crawl->elementSize;
+				buffer->length = buffer->filled;
+			}
+			else if (cqe->res != -EINTR) {
+				
+				buffer->error = -cqe->res;
+			}
+			
+			if ((buffer->filled < buffer->length) && (buffer->error == 0)) {
+				
+				FloatInspectorCrawlRingPrepare(ring, buffer);
+				nSubmit++;
+				continue;
+			}
+			
+			buffer->iov.iov_base = NULL;
+			nInFlight--;
+			
+			pthread_mutex_lock(&crawl->lock);
+			FloatInspectorCrawlPushReady(crawl, buffer);
+			pthread_mutex_unlock(&crawl->lock);
+		}
+		
+		__atomic_store_n(ring->cqHead, head, __ATOMIC_RELEASE);
+	}
+	
+	pthread_mutex_lock(&crawl->lock);
+	crawl->readingDone = 1;
+	pthread_cond_broadcast(&crawl->bufferReady);
+	pthread_mutex_unlock(&crawl->lock);
+}
+
+#endif
+
+#pragma mark Public Functions Implementations
+
+FloatInspectorCrawlRef 
+FloatInspectorCrawlCreate(const FloatInspectorStatisticsRef prototype,
+						  FloatInspectorCrawlOptions options) {
+	
+	FloatInspectorCrawlRef crawl = calloc(1, sizeof(struct _FloatInspectorCrawl));
+	
+	if (crawl == NULL) {
+		
+		return NULL;
+	}
+	
+	pthread_mutex_init(&crawl->lock, NULL);
+	pthread_mutex_init(&crawl->finishLock, NULL);
+	pthread_cond_init(&crawl->bufferFree, NULL);
+	pthread_cond_init(&crawl->bufferReady, NULL);
+	
+	options.bufferSize &= ~(size_t) 4095;
+	
+	if (options.bufferSize == 0) options.bufferSize = 4096;
+	if (options.nBuffers == 0) options.nBuffers = 1;
+	if (options.nReaders == 0) options.nReaders = 1;
+	if (options.nOpenFiles == 0) options.nOpenFiles = 1;
+	
+	if (options.nWorkers == 0) {
+		
+		const long nCores = sysconf(_SC_NPROCESSORS_ONLN);
+		options.nWorkers = nCores > 0 ? (unsigned int) nCores : 1;
+	}
+	
+	crawl->options = options;
+	crawl->elementSize = FloatInspectorCrawlElementSize(prototype->type);
+	crawl->prototype = FloatInspectorStatisticsCopy(prototype);
+	crawl->stats = FloatInspectorStatisticsCopy(prototype);
+	crawl->empty = FloatInspectorStatisticsCreate(prototype->type);
+	crawl->checkpoint = -1;
+	
+	if ((crawl->prototype == NULL) || (crawl->stats == NULL) || (crawl->empty == NULL)) {
+		
+		FloatInspectorCrawlFree(crawl);
+		return NULL;
+	}
+	
+	FloatInspectorStatisticsReset(crawl->prototype);
+	FloatInspectorStatisticsReset(crawl->stats);
+	
+	return crawl;
+}
+
+void 
+FloatInspectorCrawlFree(FloatInspectorCrawlRef crawl) {
+	
+	pthread_mutex_destroy(&crawl->lock);
+	pthread_mutex_destroy(&crawl->finishLock);
+	pthread_cond_destroy(&crawl->bufferFree);
+	pthread_cond_destroy(&crawl->bufferReady);
+	
+	for (size_t i = 0; i < crawl->nEntries; i++) {
+		
+		free(crawl->entries[i].path);
+	}
+	
+	if (crawl->prototype != NULL) FloatInspectorStatisticsFree(crawl->prototype);
+	if (crawl->stats != NULL) FloatInspectorStatisticsFree(crawl->stats);
+	if (crawl->empty != NULL) FloatInspectorStatisticsFree(crawl->empty);
+	
+	free(crawl->entries);
+	free(crawl->checkpointPath);
+	free(crawl);
+}
+
+int 
+FloatInspectorCrawlAddPath(FloatInspectorCrawlRef crawl, const char *path) {
+	
+	char *paths[2] = {(char *) path, NULL};
+	FTS *fts = fts_open(paths, FTS_PHYSICAL | FTS_NOCHDIR, NULL);
+	FTSENT *node;
+	
+	if (fts == NULL) {
+		
+		return -1;
+	}
+	
+	while ((node = fts_read(fts)) != NULL) {
+		
+		int result = 0;
+		
+		switch (node->fts_info) {
+			case FTS_F:
+				result = FloatInspectorCrawlAddEntry(crawl, node->fts_path, node->fts_statp, 0);
+				break;
+				
+			case FTS_DNR:
+			case FTS_ERR:
+			case FTS_NS:
+				/* Reported as a failed file by the run.  */
+				result = FloatInspectorCrawlAddEntry(crawl, node->fts_path, NULL, 
+													 node->fts_errno);
+				break;
+				
+			default:
+				break;
+		}
+		
+		if (result != 0) {
+			
+			fts_close(fts);
+			errno = ENOMEM;
+			return -1;
+		}
+	}
+	
+	const int error = errno;
+	
+	fts_close(fts);
+	errno = error;
+	
+	return error == 0 ? 0 : -1;
+}
+
+void 
+FloatInspectorCrawlSetCheckpoint(FloatInspectorCrawlRef crawl, const char *path) {
+	
+	free(crawl->checkpointPath);
+	crawl->checkpointPath = path != NULL ? strdup(path) : NULL;
+}
+
+int 
+FloatInspectorCrawlRun(FloatInspectorCrawlRef crawl,
+					   FloatInspectorCrawlCallback callback,
+					   void *context) {
+	
+	const FloatInspectorCrawlOptions options = crawl->options;
+	
+	crawl->callback = callback;
+	crawl->context = context;
+	crawl->failed = 0;
+	crawl->nBytes = 0;
+	crawl->nextEntry = 0;
+	crawl->nActive = 0;
+	crawl->readingDone = 0;
+	
+	/* Sorted and unique, for lookups from the checkpoint. A path added again
+	 * after a run stays completed.  */
+	qsort(crawl->entries, crawl->nEntries, sizeof(FloatInspectorCrawlEntry), 
+		  FloatInspectorCrawlCompareEntries);
+	
+	size_t nUnique = 0;
+	
+	for (size_t i = 0; i < crawl->nEntries; i++) {
+		
+		if ((nUnique > 0) && 
+			(strcmp(crawl->entries[nUnique - 1].path, crawl->entries[i].path) == 0)) {
+			
+			crawl->entries[nUnique - 1].completed |= crawl->entries[i].completed;
+			free(crawl->entries[i].path);
+			continue;
+		}
+		
+		crawl->entries[nUnique++] = crawl->entries[i];
+	}
+	
+	crawl->nEntries = nUnique;
+	
+	if ((crawl->checkpointPath != NULL) && (FloatInspectorCrawlLoadCheckpoint(crawl) != 0)) {
+		
+		return -1;
+	}
+	
+	crawl->buffers = calloc(options.nBuffers, sizeof(FloatInspectorCrawlBuffer));
+	crawl->active = calloc(options.nOpenFiles, sizeof(FloatInspectorCrawlEntry *));
+	crawl->freeBuffers = NULL;
+	
+	for (unsigned int i = 0; (crawl->buffers != NULL) && (i < options.nBuffers); i++) {
+		
+		void *data = NULL;
+		
+		if (posix_memalign(&data, 4096, options.bufferSize) != 0) {
+			
+			break;
+		}
+		
+		crawl->buffers[i].data = data;
+		crawl->buffers[i].next = crawl->freeBuffers;
+		crawl->freeBuffers = &crawl->buffers[i];
+	}
+	
+	pthread_t *workers = malloc(options.nWorkers * sizeof(pthread_t));
+	pthread_t *readers = malloc(options.nReaders * sizeof(pthread_t));
+	int result = 0;
+	
+	if ((crawl->freeBuffers == NULL) || (crawl->active == NULL) || 
+		(workers == NULL) || (readers == NULL)) {
+		
+		errno = ENOMEM;
+		result = -1;
+	}
+	
+	for (unsigned int i = 0; (result == 0) && (i < options.nWorkers); i++) {
+		
+		pthread_create(&workers[i], NULL, FloatInspectorCrawlWorker, crawl);
+	}
+	
+	crawl->asynchronous = 0;
+	
+#if defined(__linux__)
+	
+	FloatInspectorCrawlRing ring;
+	
+	if ((result == 0) && options.asynchronous && 
+		(FloatInspectorCrawlRingCreate(&ring, options.nBuffers) == 0)) {
+		
+		crawl->asynchronous = 1;
+		FloatInspectorCrawlRingRead(crawl, &ring);
+		FloatInspectorCrawlRingFree(&ring);
+	}
+	
+#endif
+	
+	if ((result == 0) && !crawl->asynchronous) {
+		
+		crawl->nReadersRunning = options.nReaders;
+		
+		for (unsigned int i = 0; i < options.nReaders; i++) {
+			
+			pthread_create(&readers[i], NULL, FloatInspectorCrawlReader, crawl);
+		}
+		
+		for (unsigned int i = 0; i < options.nReaders; i++) {
+			
+			pthread_join(readers[i], NULL);
+		}
+	}
+	
+	for (unsigned int i = 0; (result == 0) && (i < options.nWorkers); i++) {
+		
+		pthread_join(workers[i], NULL);
+	}
+	
+	for (unsigned int i = 0; (crawl->buffers != NULL) && (i < options.nBuffers); i++) {
+		
+		free(crawl->buffers[i].data);
+	}
+	
+	free(crawl->buffers);
+	free(crawl->active);
+	free(workers);
+	free(readers);
+	crawl->buffers = NULL;
+	crawl->active = NULL;
+	crawl->freeBuffers = NULL;
+	
+	if (crawl->checkpoint >= 0) {
+		
+		fsync(crawl->checkpoint);
+		close(crawl->checkpoint);
+		crawl->checkpoint = -1;
+	}
+	
+	if ((result == 0) && (crawl->failed != 0)) {
+		
+		errno = crawl->failed;
+		result = -1;
+	}
+	
+	return result;
+}
+
+FloatInspectorStatisticsRef 
+FloatInspectorCrawlStatistics(FloatInspectorCrawlRef crawl) {
+	
+	return crawl->stats;
+}
+
+size_t 
+FloatInspectorCrawlNumberOfFiles(FloatInspectorCrawlRef crawl) {
+	
+	return crawl->nEntries;
+}
+
+unsigned long long 
+FloatInspectorCrawlNumberOfBytes(FloatInspectorCrawlRef crawl) {
+	
+	return crawl->nBytes;
+}
+
+int 
+FloatInspectorCrawlIsAsynchronous(FloatInspectorCrawlRef crawl) {
+	
+	return crawl->asynchronous;
+}
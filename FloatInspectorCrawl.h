@@ -0,0 +1,136 @@
+//
+//  FloatInspectorCrawl.h
+//  FloatInspector
+//  
+//  Copyright 2011 Stefan Reinhold <stefan@sreinhold.com>. All rights reserved.
+//  
+//  Redistribution and use in source and binary forms, with or without modification, are
+//  permitted provided that the following conditions are met:
+//  
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//  
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list
+//  of conditions and the following disclaimer in the documentation and/or other materials
+//  provided with the distribution.
+//  
+//  THIS SOFTWARE IS PROVIDED BY STEFAN REINHOLD ``AS IS'' AND ANY EXPRESS OR IMPLIED
+//  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STEFAN REINHOLD OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+//  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+//  ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//  
+//  The views and conclusions contained in the software and documentation are those of the
+//  authors and should not be interpreted as representing official policies, either expressed
+//  or implied, of Stefan Reinhold.
+//  
+
+
+
+#ifndef FloatInspector_FloatInspectorCrawl_h
+#define FloatInspector_FloatInspectorCrawl_h
+
+#include "FloatInspector.h"
+
+#pragma mark Data Types
+
+/* Statistics of every file below a set of directories. Files are raw arrays
+ * of one format in native byte order (shards), read in fixed size buffers
+ * by a reader stage and classified by a pool of worker threads. On Linux
+ * the reader keeps all buffers in flight through io_uring, elsewhere or if
+ * the kernel refuses a ring a pool of threads issues blocking preads. The
+ * buffers are the only large allocation, readers wait for a free one, so 
+ * memory stays bounded however many files there are.  */
+typedef struct _FloatInspectorCrawl *FloatInspectorCrawlRef;
+
+typedef struct {
+	
+	/* Bytes skipped at the start of every file, e.g. a fixed size header.  */
+	size_t offset;
+	/* Bytes per read, rounded down to a multiple of 4096.  */
+	size_t bufferSize;
+	/* Number of buffers, bounds memory and the number of reads in flight.  */
+	unsigned int nBuffers;
+	/* Threads classifying filled buffers, 0 for one per online core.  */
+	unsigned int nWorkers;
+	/* Threads issuing reads without io_uring.  */
+	unsigned int nReaders;
+	/* Files read at the same time, their buffers are interleaved so the 
+	 * workers rarely wait for each other on one file's statistics.  */
+	unsigned int nOpenFiles;
+	/* Use io_uring where available.  */
+	int asynchronous;
+	
+} FloatInspectorCrawlOptions;
+
+/* A file that has been completed.  */
+typedef struct {
+	
+	const char *path;
+	/* Size in bytes, values are read from offset to the last whole one.  */
+	unsigned long long size;
+	/* Statistics of the file, NULL if it could not be read.  */
+	FloatInspectorStatisticsRef stats;
+	/* errno of the failure, 0 on success.  */
+	int error;
+	/* The file was completed by an earlier run and its counters and 
+	 * histograms are restored from the checkpoint, without sketches.  */
+	int resumed;
+	
+} FloatInspectorCrawlFile;
+
+/* Called once per file, by one thread at a time. The file and its 
+ * statistics are only valid during the call.  */
+typedef void (*FloatInspectorCrawlCallback)(const FloatInspectorCrawlFile *file,
+											void *context);
+
+#pragma mark Constants
+
+/* No header, 64 buffers of 1 MiB, a worker per core, 16 readers, 16 open 
+ * files, io_uring enabled.  */
+extern const FloatInspectorCrawlOptions kFloatInspectorCrawlDefaultOptions;
+
+#pragma mark Public Functions
+
+/* Every file gets a reset copy of prototype, which defines the format and
+ * the attached sketches. Returns NULL if out of memory.  */
+FloatInspectorCrawlRef 
+FloatInspectorCrawlCreate(const FloatInspectorStatisticsRef prototype,
+						  FloatInspectorCrawlOptions options);
+
+void FloatInspectorCrawlFree(FloatInspectorCrawlRef crawl);
+
+/* Adds a file or all regular files below a directory, symbolic links are
+ * not followed. Returns 0 on success and -1 with errno set otherwise.  */
+int FloatInspectorCrawlAddPath(FloatInspectorCrawlRef crawl, const char *path);
+
+/* Journal of completed files, created if it does not exist. Files recorded
+ * with their current size and modification time are not read again, every
+ * file completed by FloatInspectorCrawlRun is appended. Call before the 
+ * run.  */
+void FloatInspectorCrawlSetCheckpoint(FloatInspectorCrawlRef crawl, const char *path);
+
+/* Reads all files added so far and calls callback (if not NULL) for each,
+ * in order of completion. Returns 0 if all files were read and -1 if any 
+ * failed or the checkpoint could not be used (errno set).  */
+int FloatInspectorCrawlRun(FloatInspectorCrawlRef crawl,
+						   FloatInspectorCrawlCallback callback,
+						   void *context);
+
+/* Statistics of all completed files, owned by the crawl. Sketches do not
+ * cover files restored from the checkpoint.  */
+FloatInspectorStatisticsRef FloatInspectorCrawlStatistics(FloatInspectorCrawlRef crawl);
+
+size_t FloatInspectorCrawlNumberOfFiles(FloatInspectorCrawlRef crawl);
+
+/* Bytes read by the last run, files restored from the checkpoint excluded.  */
+unsigned long long FloatInspectorCrawlNumberOfBytes(FloatInspectorCrawlRef crawl);
+
+/* Nonzero if the last run read through io_uring.  */
+int FloatInspectorCrawlIsAsynchronous(FloatInspectorCrawlRef crawl);
+
+#endif
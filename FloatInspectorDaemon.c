@@ -0,0 +1,203 @@
+//
+//  FloatInspectorDaemon.c
+//  FloatInspector
+//  
+//  Copyright 2011 Stefan Reinhold <stefan@sreinhold.com>. All rights reserved.
+//  
+//  Redistribution and use in source and binary forms, with or without modification, are
+//  permitted provided that the following conditions are met:
+//  
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//  
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list
+//  of conditions and the following disclaimer in the documentation and/or other materials
+//  provided with the distribution.
+//  
+//  THIS SOFTWARE IS PROVIDED BY STEFAN REINHOLD ``AS IS'' AND ANY EXPRESS OR IMPLIED
+//  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STEFAN REINHOLD OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+//  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+//  ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//  
+//  The views and conclusions contained in the software and documentation are those of the
+//  authors and should not be interpreted as representing official policies, either expressed
+//  or implied, of Stefan Reinhold.
+//  
+
+
+
+//  Per host aggregation daemon, see FloatInspectorAggregator.h. Serves the
+//  socket until SIGINT or SIGTERM and then prints every aggregate, SIGUSR1
+//  prints them while it keeps running. With -q it is a client instead and
+//  prints the aggregate of one name as known to the running daemon.
+//  
+//  Usage: FloatInspectorDaemon [-c connections] [-b backlog] socket
+//         FloatInspectorDaemon -q name [-w seconds] socket
+//  
+//    -c  connections served at the same time
+//    -b  connections the kernel queues while the daemon is busy
+//    -q  print the aggregate of name and exit
+//    -w  seconds to wait for the answer, default 5
+//  
+
+
+#include "FloatInspector.h"
+#include "FloatInspectorAggregator.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#pragma mark Private Variables
+
+static FloatInspectorAggregatorRef FloatInspectorDaemonAggregator = NULL;
+static volatile sig_atomic_t FloatInspectorDaemonTerminate = 0;
+
+#pragma mark Private Function Prototypes
+
+static void FloatInspectorDaemonSignal(int number);
+
+static int FloatInspectorDaemonQuery(const char *path, const char *name, double timeout);
+
+static int FloatInspectorDaemonServe(const char *path, FloatInspectorAggregatorOptions options);
+
+#pragma mark Private Functions Implementations
+
+static void 
+FloatInspectorDaemonSignal(int number) {
+	
+	if (number != SIGUSR1) {
+		
+		FloatInspectorDaemonTerminate = 1;
+	}
+	
+	FloatInspectorAggregatorStop(FloatInspectorDaemonAggregator);
+}
+
+static int 
+FloatInspectorDaemonQuery(const char *path, const char *name, double timeout) {
+	
+	FloatInspectorClientRef client = 
+		FloatInspectorClientCreate(path, kFloatInspectorClientDefaultOptions);
+	
+	if (client == NULL) {
+		
+		fprintf(stderr, "%s: invalid socket path\n", path);
+		return EXIT_FAILURE;
+	}
+	
+	FloatInspectorStatisticsRef stats = FloatInspectorClientQuery(client, name, timeout);
+	
+	FloatInspectorClientFree(client);
+	
+	if (stats == NULL) {
+		
+		fprintf(stderr, "%s: no aggregate or no answer from %s\n", name, path);
+		return EXIT_FAILURE;
+	}
+	
+	FloatInspectorStatisticsPrint(stats, stdout);
+	FloatInspectorStatisticsFree(stats);
+	
+	return EXIT_SUCCESS;
+}
+
+static int 
+FloatInspectorDaemonServe(const char *path, FloatInspectorAggregatorOptions options) {
+	
+	struct sigaction action;
+	int status = EXIT_SUCCESS;
+	
+	FloatInspectorDaemonAggregator = FloatInspectorAggregatorCreate(path, options);
+	
+	if (FloatInspectorDaemonAggregator == NULL) {
+		
+		perror(path);
+		return EXIT_FAILURE;
+	}
+	
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = FloatInspectorDaemonSignal;
+	sigemptyset(&action.sa_mask);
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
+	sigaction(SIGUSR1, &action, NULL);
+	signal(SIGPIPE, SIG_IGN);
+	
+	while (!FloatInspectorDaemonTerminate) {
+		
+		if (FloatInspectorAggregatorRun(FloatInspectorDaemonAggregator) != 0) {
+			
+			perror(path);
+			status = EXIT_FAILURE;
+			break;
+		}
+		
+		FloatInspectorAggregatorPrint(FloatInspectorDaemonAggregator, stdout);
+		fflush(stdout);
+	}
+	
+	FloatInspectorAggregatorFree(FloatInspectorDaemonAggregator);
+	
+	return status;
+}
+
+#pragma mark Main
+
+int
+main(int argc, char **argv) {
+	
+	static const char usage[] = 
+		"usage: %s [-c connections] [-b backlog] socket\n"
+		"       %s -q name [-w seconds] socket\n";
+	
+	FloatInspectorAggregatorOptions options = kFloatInspectorAggregatorDefaultOptions;
+	const char *name = NULL;
+	double timeout = 5.;
+	int opt;
+	
+	while ((opt = getopt(argc, argv, "c:b:q:w:")) != -1) {
+		
+		switch (opt) {
+			case 'c':
+				options.maxConnections = (unsigned int) strtoul(optarg, NULL, 0);
+				break;
+				
+			case 'b':
+				options.backlog = atoi(optarg);
+				break;
+				
+			case 'q':
+				name = optarg;
+				break;
+				
+			case 'w':
+				timeout = atof(optarg);
+				break;
+				
+			default:
+				fprintf(stderr, usage, argv[0], argv[0]);
+				return EXIT_FAILURE;
+		}
+	}
+	
+	if (optind + 1 != argc) {
+		
+		fprintf(stderr, usage, argv[0], argv[0]);
+		return EXIT_FAILURE;
+	}
+	
+	if (name != NULL) {
+		
+		return FloatInspectorDaemonQuery(argv[optind], name, timeout);
+	}
+	
+	return FloatInspectorDaemonServe(argv[optind], options);
+}
@@ -0,0 +1,584 @@
+//
+//  FloatInspectorExponents.c
+//  FloatInspector
+//  
+//  Copyright 2011 Stefan Reinhold <stefan@sreinhold.com>. All rights reserved.
+//  
+//  Redistribution and use in source and binary forms, with or without modification, are
+//  permitted provided that the following conditions are met:
+//  
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//  
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list
+//  of conditions and the following disclaimer in the documentation and/or other materials
+//  provided with the distribution.
+//  
+//  THIS SOFTWARE IS PROVIDED BY STEFAN REINHOLD ``AS IS'' AND ANY EXPRESS OR IMPLIED
+//  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STEFAN REINHOLD OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+//  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+//  ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//  
+//  The views and conclusions contained in the software and documentation are those of the
+//  authors and should not be interpreted as representing official policies, either expressed
+//  or implied, of Stefan Reinhold.
+//  
+
+
+
+
+
+#include "FloatInspectorExponents.h"
+
+#include <assert.h>
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#pragma mark Constants
+
+/* Cells per block.  */
+#define kFloatInspectorExponentsBlockCells	256
+/* Interleaved sub-histograms. Consecutive values go to different lanes, so
+ * runs of equal exponents do not serialize on a single counter.  */
+#define kFloatInspectorExponentsLanes	4
+/* Cells extracted before they are counted.  */
+#define kFloatInspectorExponentsBatch	1024
+/* Bytes per vector of the extraction pass, 128 bit vectors are available on
+ * every SIMD target.  */
+#define kFloatInspectorExponentsVectorSize	16
+
+#pragma mark Data Types
+
+struct _FloatInspectorExponents {
+	
+	unsigned int nExponentBits;
+	unsigned int nMantissaBits;
+	
+	/* Exponent of cell 1, cell 0 counts zeros.  */
+	int minimum;
+	
+	/* Cells per sign, negative values follow the positive ones. The cell
+	 * after both signs collects NaNs and infinities, so the counting loop 
+	 * does not need to branch on them.  */
+	uint32_t nCells;
+	
+	/* Lanes of 64 bit counters, so no cell wraps.  */
+	uint32_t nBlocks;
+	uint64_t **blocks;
+};
+
+/* Generic vectors, lowered to SSE2, NEON or plain scalar code.  */
+typedef uint32_t FloatInspectorExponentsWords32 
+	__attribute__((vector_size(kFloatInspectorExponentsVectorSize)));
+typedef uint64_t FloatInspectorExponentsWords64 
+	__attribute__((vector_size(kFloatInspectorExponentsVectorSize)));
+typedef float FloatInspectorExponentsFloats 
+	__attribute__((vector_size(kFloatInspectorExponentsVectorSize)));
+typedef double FloatInspectorExponentsDoubles 
+	__attribute__((vector_size(kFloatInspectorExponentsVectorSize)));
+
+#define kFloatInspectorExponentsLanes32	\
+	(kFloatInspectorExponentsVectorSize / sizeof(uint32_t))
+/* 32 bit lane holding the upper half of a 64 bit lane.  */
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define kFloatInspectorExponentsHighHalf	0
+#else
+#define kFloatInspectorExponentsHighHalf	1
+#endif
+
+#pragma mark Private Functions Implementations
+
+static inline uint32_t 
+FloatInspectorExponentsDiscardCell(const FloatInspectorExponentsRef histogram) {
+	
+	return 2 * histogram->nCells;
+}
+
+static uint64_t *
+FloatInspectorExponentsBlock(FloatInspectorExponentsRef histogram,
+							 uint32_t block) {
+	
+	if (histogram->blocks[block] == NULL) {
+		
+		histogram->blocks[block] = calloc(kFloatInspectorExponentsBlockCells * 
+										  kFloatInspectorExponentsLanes, 
+										  sizeof(uint64_t));
+	}
+	
+	return histogram->blocks[block];
+}
+
+static uint64_t 
+FloatInspectorExponentsCell(const FloatInspectorExponentsRef histogram,
+							uint32_t cell) {
+	
+	const uint64_t *block = histogram->blocks[cell / kFloatInspectorExponentsBlockCells];
+	
+	if (block == NULL) {
+		
+		return 0;
+	}
+	
+	const uint64_t *lanes = block + 
+		(cell % kFloatInspectorExponentsBlockCells) * kFloatInspectorExponentsLanes;
+	uint64_t count = 0;
+	
+	for (unsigned int lane = 0; lane < kFloatInspectorExponentsLanes; lane++) {
+		
+		count += lanes[lane];
+	}
+	
+	return count;
+}
+
+/* Second pass of the bulk paths.  */
+static void 
+FloatInspectorExponentsIncrement(FloatInspectorExponentsRef histogram,
+								 const uint32_t *restrict cells,
+								 size_t n) {
+	
+	for (size_t i = 0; i < n; i++) {
+		
+		uint64_t *block = histogram->blocks[cells[i] / kFloatInspectorExponentsBlockCells];
+		
+		if (__builtin_expect(block == NULL, 0)) {
+			
+			block = FloatInspectorExponentsBlock(histogram, 
+												 cells[i] / kFloatInspectorExponentsBlockCells);
+			
+			if (block == NULL) {
+				
+				continue;
+			}
+		}
+		
+		block[(cells[i] % kFloatInspectorExponentsBlockCells) * kFloatInspectorExponentsLanes + 
+			  (i % kFloatInspectorExponentsLanes)]++;
+	}
+}
+
+/* Cells of up to 32 bit patterns (1 sign bit, no explicit integer bit) 
+ * with masks instead of selects, so all lanes run the same instructions.
+ * The leading bit of a denormalized mantissa m < 2^23 comes from the float
+ * 1 + m * 2^-23 - 1, which is exact: its exponent field is 104 plus the 
+ * position of that bit, or 0 for m = 0.  */
+static inline FloatInspectorExponentsWords32 
+FloatInspectorExponentsCells32(const FloatInspectorExponentsRef histogram,
+							   FloatInspectorExponentsWords32 bits,
+							   uint32_t nBits) {
+	
+	const uint32_t nMant = histogram->nMantissaBits;
+	const uint32_t exponentMask = (UINT32_C(1) << histogram->nExponentBits) - 1;
+	const uint32_t mantissaMask = (UINT32_C(1) << nMant) - 1;
+	
+	const FloatInspectorExponentsWords32 exponent = (bits >> nMant) & exponentMask;
+	const FloatInspectorExponentsFloats leading = 
+		(FloatInspectorExponentsFloats) ((bits & mantissaMask) | 0x3f800000u) - 1.f;
+	const FloatInspectorExponentsWords32 field = (FloatInspectorExponentsWords32) leading >> 23;
+	
+	const FloatInspectorExponentsWords32 denormalized = 
+		(field - 103) & (FloatInspectorExponentsWords32) (field != 0);
+	const FloatInspectorExponentsWords32 normalized = 
+		(FloatInspectorExponentsWords32) (exponent != 0);
+	const FloatInspectorExponentsWords32 cell = 
+		(((exponent + nMant) & normalized) | (denormalized & ~normalized)) + 
+		(-(bits >> (nBits - 1)) & histogram->nCells);
+	const FloatInspectorExponentsWords32 finite = 
+		(FloatInspectorExponentsWords32) (exponent != exponentMask);
+	
+	return (cell & finite) | (FloatInspectorExponentsDiscardCell(histogram) & ~finite);
+}
+
+/* Cells of four 64 bit patterns. Only the mantissa is handled in 64 bit 
+ * lanes, the leading bit of m < 2^52 comes from the double 1 + m * 2^-52 - 1
+ * with an exponent field of 971 plus its position. Sign and exponent are in
+ * the upper halves, as at least 43 mantissa bits are left by 20 exponent 
+ * bits, and everything else runs in 32 bit lanes that SSE2 can compare.  */
+static inline FloatInspectorExponentsWords32 
+FloatInspectorExponentsCells64(const FloatInspectorExponentsRef histogram,
+							   FloatInspectorExponentsWords64 first,
+							   FloatInspectorExponentsWords64 second) {
+	
+	const uint32_t nMant = histogram->nMantissaBits;
+	const uint32_t exponentMask = (UINT32_C(1) << histogram->nExponentBits) - 1;
+	const uint64_t mantissaMask = (UINT64_C(1) << nMant) - 1;
+	const uint64_t one = UINT64_C(0x3ff0000000000000);
+	
+	const FloatInspectorExponentsWords64 leadingFirst = (FloatInspectorExponentsWords64) 
+		((FloatInspectorExponentsDoubles) ((first & mantissaMask) | one) - 1.);
+	const FloatInspectorExponentsWords64 leadingSecond = (FloatInspectorExponentsWords64) 
+		((FloatInspectorExponentsDoubles) ((second & mantissaMask) | one) - 1.);
+	
+	/* Gathering 32 bit lanes stays a single shuffle.  */
+	const FloatInspectorExponentsWords32 a = (FloatInspectorExponentsWords32) first;
+	const FloatInspectorExponentsWords32 b = (FloatInspectorExponentsWords32) second;
+	const FloatInspectorExponentsWords32 c = (FloatInspectorExponentsWords32) leadingFirst;
+	const FloatInspectorExponentsWords32 d = (FloatInspectorExponentsWords32) leadingSecond;
+	const unsigned int h = kFloatInspectorExponentsHighHalf;
+	
+	const FloatInspectorExponentsWords32 high = { a[h], a[h + 2], b[h], b[h + 2] };
+	const FloatInspectorExponentsWords32 field = 
+		(FloatInspectorExponentsWords32) { c[h], c[h + 2], d[h], d[h + 2] } >> 20;
+	
+	const FloatInspectorExponentsWords32 exponent = (high >> (nMant - 32)) & exponentMask;
+	const FloatInspectorExponentsWords32 denormalized = 
+		(field - 970) & (FloatInspectorExponentsWords32) (field != 0);
+	const FloatInspectorExponentsWords32 normalized = 
+		(FloatInspectorExponentsWords32) (exponent != 0);
+	const FloatInspectorExponentsWords32 cell = 
+		(((exponent + nMant) & normalized) | (denormalized & ~normalized)) + 
+		(-(high >> 31) & histogram->nCells);
+	const FloatInspectorExponentsWords32 finite = 
+		(FloatInspectorExponentsWords32) (exponent != exponentMask);
+	
+	return (cell & finite) | (FloatInspectorExponentsDiscardCell(histogram) & ~finite);
+}
+
+#pragma mark Public Functions Implementations
+
+FloatInspectorExponentsRef 
+FloatInspectorExponentsCreate(unsigned int nExponentBits,
+							  unsigned int nMantissaBits) {
+	
+	if ((nExponentBits < 2) || (nExponentBits > 20)) {
+		
+		return NULL;
+	}
+	
+	FloatInspectorExponentsRef histogram = malloc(sizeof(struct _FloatInspectorExponents));
+	
+	if (histogram == NULL) {
+		
+		return NULL;
+	}
+	
+	const int bias = (1 << (nExponentBits - 1)) - 1;
+	
+	histogram->nExponentBits = nExponentBits;
+	histogram->nMantissaBits = nMantissaBits;
+	histogram->minimum = 1 - bias - (int) nMantissaBits;
+	
+	/* Zero, one cell per denormalized leading bit and one per exponent of
+	 * normalized numbers.  */
+	histogram->nCells = 1 + nMantissaBits + ((1u << nExponentBits) - 2);
+	histogram->nBlocks = (2 * histogram->nCells + 1 + kFloatInspectorExponentsBlockCells - 1) /
+		kFloatInspectorExponentsBlockCells;
+	histogram->blocks = calloc(histogram->nBlocks, sizeof(uint64_t *));
+	
+	if (histogram->blocks == NULL) {
+		
+		free(histogram);
+		return NULL;
+	}
+	
+	return histogram;
+}
+
+FloatInspectorExponentsRef 
+FloatInspectorExponentsCopy(const FloatInspectorExponentsRef histogram) {
+	
+	FloatInspectorExponentsRef copy = 
+		FloatInspectorExponentsCreate(histogram->nExponentBits, histogram->nMantissaBits);
+	
+	if ((copy == NULL) || (FloatInspectorExponentsMerge(copy, histogram) != 0)) {
+		
+		FloatInspectorExponentsFree(copy);
+		return NULL;
+	}
+	
+	return copy;
+}
+
+void 
+FloatInspectorExponentsReset(FloatInspectorExponentsRef histogram) {
+	
+	for (uint32_t block = 0; block < histogram->nBlocks; block++) {
+		
+		free(histogram->blocks[block]);
+		histogram->blocks[block] = NULL;
+	}
+}
+
+int 
+FloatInspectorExponentsMerge(FloatInspectorExponentsRef dst,
+							 const FloatInspectorExponentsRef src) {
+	
+	if ((dst->nExponentBits != src->nExponentBits) ||
+		(dst->nMantissaBits != src->nMantissaBits)) {
+		
+		return -1;
+	}
+	
+	for (uint32_t block = 0; block < src->nBlocks; block++) {
+		
+		if (src->blocks[block] == NULL) {
+			
+			continue;
+		}
+		
+		uint64_t *counts = FloatInspectorExponentsBlock(dst, block);
+		
+		if (counts == NULL) {
+			
+			return -1;
+		}
+		
+		for (size_t i = 0; i < kFloatInspectorExponentsBlockCells * kFloatInspectorExponentsLanes; i++) {
+			
+			counts[i] += src->blocks[block][i];
+		}
+	}
+	
+	return 0;
+}
+
+void 
+FloatInspectorExponentsFree(FloatInspectorExponentsRef histogram) {
+	
+	if (histogram == NULL) {
+		
+		return;
+	}
+	
+	FloatInspectorExponentsReset(histogram);
+	free(histogram->blocks);
+	free(histogram);
+}
+
+void 
+FloatInspectorExponentsAddWords16(FloatInspectorExponentsRef histogram,
+								  const void *restrict words,
+								  size_t n) {
+	
+	assert(histogram->nExponentBits + histogram->nMantissaBits == 15);
+	
+	const size_t nLanes = kFloatInspectorExponentsLanes32;
+	uint32_t cells[kFloatInspectorExponentsBatch];
+	
+	for (size_t batch = 0; batch < n; batch += kFloatInspectorExponentsBatch) {
+		
+		const size_t nBatch = n - batch < kFloatInspectorExponentsBatch ?
+			n - batch : kFloatInspectorExponentsBatch;
+		
+		/* The tail is padded with zeros whose cells are not kept.  */
+		for (size_t i = 0; i < nBatch; i += nLanes) {
+			
+			uint16_t halfs[kFloatInspectorExponentsLanes32] = { 0 };
+			memcpy(halfs, (const uint8_t *) words + (batch + i) * sizeof(uint16_t), 
+				   (nBatch - i < nLanes ? nBatch - i : nLanes) * sizeof(uint16_t));
+			
+			FloatInspectorExponentsWords32 bits;
+			
+			for (size_t lane = 0; lane < nLanes; lane++) {
+				
+				bits[lane] = halfs[lane];
+			}
+			
+			bits = FloatInspectorExponentsCells32(histogram, bits, 16);
+			memcpy(&cells[i], &bits, (nBatch - i < nLanes ? nBatch - i : nLanes) * sizeof(uint32_t));
+		}
+		
+		FloatInspectorExponentsIncrement(histogram, cells, nBatch);
+	}
+}
+
+void 
+FloatInspectorExponentsAddWords32(FloatInspectorExponentsRef histogram,
+								  const void *restrict words,
+								  size_t n) {
+	
+	assert((histogram->nExponentBits + histogram->nMantissaBits == 31) && 
+		   (histogram->nMantissaBits < FLT_MANT_DIG));
+	
+	const size_t nLanes = kFloatInspectorExponentsLanes32;
+	uint32_t cells[kFloatInspectorExponentsBatch];
+	
+	for (size_t batch = 0; batch < n; batch += kFloatInspectorExponentsBatch) {
+		
+		const size_t nBatch = n - batch < kFloatInspectorExponentsBatch ?
+			n - batch : kFloatInspectorExponentsBatch;
+		const size_t nVectors = nBatch / nLanes;
+		const uint8_t *bytes = (const uint8_t *) words + batch * sizeof(uint32_t);
+		FloatInspectorExponentsWords32 bits;
+		
+		for (size_t i = 0; i < nVectors * nLanes; i += nLanes) {
+			
+			memcpy(&bits, bytes + i * sizeof(uint32_t), sizeof(bits));
+			bits = FloatInspectorExponentsCells32(histogram, bits, 32);
+			memcpy(&cells[i], &bits, sizeof(bits));
+		}
+		
+		/* The tail is padded with zeros whose cells are not kept.  */
+		if (nBatch > nVectors * nLanes) {
+			
+			const size_t nTail = nBatch - nVectors * nLanes;
+			
+			memset(&bits, 0, sizeof(bits));
+			memcpy(&bits, bytes + nVectors * nLanes * sizeof(uint32_t), nTail * sizeof(uint32_t));
+			bits = FloatInspectorExponentsCells32(histogram, bits, 32);
+			memcpy(&cells[nVectors * nLanes], &bits, nTail * sizeof(uint32_t));
+		}
+		
+		FloatInspectorExponentsIncrement(histogram, cells, nBatch);
+	}
+}
+
+void 
+FloatInspectorExponentsAddWords64(FloatInspectorExponentsRef histogram,
+								  const void *restrict words,
+								  size_t n) {
+	
+	assert((histogram->nExponentBits + histogram->nMantissaBits == 63) && 
+		   (histogram->nMantissaBits < DBL_MANT_DIG));
+	
+	/* Two 64 bit vectors per 32 bit vector of cells.  */
+	const size_t nLanes = kFloatInspectorExponentsLanes32;
+	uint32_t cells[kFloatInspectorExponentsBatch];
+	
+	for (size_t batch = 0; batch < n; batch += kFloatInspectorExponentsBatch) {
+		
+		const size_t nBatch = n - batch < kFloatInspectorExponentsBatch ?
+			n - batch : kFloatInspectorExponentsBatch;
+		const size_t nVectors = nBatch / nLanes;
+		const uint8_t *bytes = (const uint8_t *) words + batch * sizeof(uint64_t);
+		FloatInspectorExponentsWords64 bits[2];
+		FloatInspectorExponentsWords32 cell;
+		
+		for (size_t i = 0; i < nVectors * nLanes; i += nLanes) {
+			
+			memcpy(bits, bytes + i * sizeof(uint64_t), sizeof(bits));
+			cell = FloatInspectorExponentsCells64(histogram, bits[0], bits[1]);
+			memcpy(&cells[i], &cell, sizeof(cell));
+		}
+		
+		/* The tail is padded with zeros whose cells are not kept.  */
+		if (nBatch > nVectors * nLanes) {
+			
+			const size_t nTail = nBatch - nVectors * nLanes;
+			
+			memset(bits, 0, sizeof(bits));
+			memcpy(bits, bytes + nVectors * nLanes * sizeof(uint64_t), nTail * sizeof(uint64_t));
+			cell = FloatInspectorExponentsCells64(histogram, bits[0], bits[1]);
+			memcpy(&cells[nVectors * nLanes], &cell, nTail * sizeof(uint32_t));
+		}
+		
+		FloatInspectorExponentsIncrement(histogram, cells, nBatch);
+	}
+}
+
+void 
+FloatInspectorExponentsAdd(FloatInspectorExponentsRef histogram,
+						   int negative,
+						   int exponent,
+						   int zero) {
+	
+	if (!zero && ((exponent < histogram->minimum) || 
+				  (exponent > FloatInspectorExponentsMaximum(histogram)))) {
+		
+		return;
+	}
+	
+	const uint32_t cell = (zero ? 0 : (uint32_t) (exponent - histogram->minimum) + 1) + 
+		(negative ? histogram->nCells : 0);
+	
+	FloatInspectorExponentsIncrement(histogram, &cell, 1);
+}
+
+int 
+FloatInspectorExponentsMinimum(const FloatInspectorExponentsRef histogram) {
+	
+	return histogram->minimum;
+}
+
+int 
+FloatInspectorExponentsMaximum(const FloatInspectorExponentsRef histogram) {
+	
+	return histogram->minimum + (int) histogram->nCells - 2;
+}
+
+int 
+FloatInspectorExponentsNormalizedMinimum(const FloatInspectorExponentsRef histogram) {
+	
+	return histogram->minimum + (int) histogram->nMantissaBits;
+}
+
+uint64_t 
+FloatInspectorExponentsCount(const FloatInspectorExponentsRef histogram,
+							 int negative,
+							 int exponent) {
+	
+	if ((exponent < histogram->minimum) || 
+		(exponent > FloatInspectorExponentsMaximum(histogram))) {
+		
+		return 0;
+	}
+	
+	return FloatInspectorExponentsCell(histogram, 
+									   (uint32_t) (exponent - histogram->minimum) + 1 + 
+									   (negative ? histogram->nCells : 0));
+}
+
+uint64_t 
+FloatInspectorExponentsZeros(const FloatInspectorExponentsRef histogram,
+							 int negative) {
+	
+	return FloatInspectorExponentsCell(histogram, negative ? histogram->nCells : 0);
+}
+
+uint64_t 
+FloatInspectorExponentsTotal(const FloatInspectorExponentsRef histogram) {
+	
+	uint64_t total = 0;
+	
+	for (uint32_t cell = 0; cell < 2 * histogram->nCells; cell++) {
+		
+		total += FloatInspectorExponentsCell(histogram, cell);
+	}
+	
+	return total;
+}
+
+double 
+FloatInspectorExponentsQuantile(const FloatInspectorExponentsRef histogram,
+								double rank) {
+	
+	const uint64_t total = FloatInspectorExponentsTotal(histogram);
+	
+	if (total == 0) {
+		
+		return NAN;
+	}
+	
+	const double target = rank * (double) total;
+	uint64_t cumulative = 0;
+	double exponent = NAN;
+	
+	/* Cells grow with the magnitude, so both signs are walked in step.  */
+	for (uint32_t cell = 0; cell < histogram->nCells; cell++) {
+		
+		const uint64_t count = FloatInspectorExponentsCell(histogram, cell) + 
+			FloatInspectorExponentsCell(histogram, cell + histogram->nCells);
+		
+		if (count == 0) {
+			
+			continue;
+		}
+		
+		cumulative += count;
+		exponent = cell == 0 ? -INFINITY : (double) (histogram->minimum + (int) cell - 1);
+		
+		if ((double) cumulative >= target) {
+			
+			break;
+		}
+	}
+	
+	return exponent;
+}
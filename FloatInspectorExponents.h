@@ -0,0 +1,122 @@
+//
+//  FloatInspectorExponents.h
+//  FloatInspector
+//  
+//  Copyright 2011 Stefan Reinhold <stefan@sreinhold.com>. All rights reserved.
+//  
+//  Redistribution and use in source and binary forms, with or without modification, are
+//  permitted provided that the following conditions are met:
+//  
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//  
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list
+//  of conditions and the following disclaimer in the documentation and/or other materials
+//  provided with the distribution.
+//  
+//  THIS SOFTWARE IS PROVIDED BY STEFAN REINHOLD ``AS IS'' AND ANY EXPRESS OR IMPLIED
+//  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STEFAN REINHOLD OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+//  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+//  ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//  
+//  The views and conclusions contained in the software and documentation are those of the
+//  authors and should not be interpreted as representing official policies, either expressed
+//  or implied, of Stefan Reinhold.
+//  
+
+
+
+
+#ifndef FloatInspector_FloatInspectorExponents_h
+#define FloatInspector_FloatInspectorExponents_h
+
+#include <inttypes.h>
+#include <stddef.h>
+
+#pragma mark Data Types
+
+/* Histogram over the unbiased exponents of finite values, split by sign. 
+ * Normalized numbers are binned by their exponent field and denormalized 
+ * ones by the position of their leading mantissa bit, so every cell covers
+ * one binade [2^e, 2^(e + 1)) and denormalized numbers occupy the exponents
+ * below the smallest normalized one. Zeros are counted separately, NaNs and
+ * infinities are ignored.
+ * Cells are stored in blocks of 256 that are allocated on first use, so 
+ * wide formats only pay for the range that actually occurs. Values whose
+ * block cannot be allocated are dropped.  */
+typedef struct _FloatInspectorExponents *FloatInspectorExponentsRef;
+
+#pragma mark Public Functions
+
+/* Returns an empty histogram of the given format or NULL if memory is 
+ * exhausted. nMantissaBits includes an explicit integer bit, if any.  */
+FloatInspectorExponentsRef 
+FloatInspectorExponentsCreate(unsigned int nExponentBits,
+							  unsigned int nMantissaBits);
+
+FloatInspectorExponentsRef 
+FloatInspectorExponentsCopy(const FloatInspectorExponentsRef histogram);
+
+void FloatInspectorExponentsReset(FloatInspectorExponentsRef histogram);
+
+/* Adds the counts of src to dst. Returns 0 on success and -1 if the formats
+ * differ or memory is exhausted.  */
+int FloatInspectorExponentsMerge(FloatInspectorExponentsRef dst,
+								 const FloatInspectorExponentsRef src);
+
+void FloatInspectorExponentsFree(FloatInspectorExponentsRef histogram);
+
+/* Adds n 16, 32 resp. 64 bit patterns (1 sign bit, no explicit integer 
+ * bit), e.g. binary16 or bfloat16, float and double. Values are read with 
+ * memcpy, so float and double arrays can be passed directly.  */
+void FloatInspectorExponentsAddWords16(FloatInspectorExponentsRef histogram,
+									   const void *restrict words,
+									   size_t n);
+
+void FloatInspectorExponentsAddWords32(FloatInspectorExponentsRef histogram,
+									   const void *restrict words,
+									   size_t n);
+
+void FloatInspectorExponentsAddWords64(FloatInspectorExponentsRef histogram,
+									   const void *restrict words,
+									   size_t n);
+
+/* Adds a single finite value given by its sign (0 or 1) and unbiased 
+ * exponent as returned by ilogb, e.g. of a long double. zero is non-zero 
+ * for zeros, the exponent is ignored then.  */
+void FloatInspectorExponentsAdd(FloatInspectorExponentsRef histogram,
+								int negative,
+								int exponent,
+								int zero);
+
+/* Smallest resp. largest exponent that may occur in the format.  */
+int FloatInspectorExponentsMinimum(const FloatInspectorExponentsRef histogram);
+int FloatInspectorExponentsMaximum(const FloatInspectorExponentsRef histogram);
+
+/* Smallest exponent of a normalized number, all exponents below are 
+ * reached only by denormalized numbers.  */
+int FloatInspectorExponentsNormalizedMinimum(const FloatInspectorExponentsRef histogram);
+
+/* Number of values of the given sign in [2^exponent, 2^(exponent + 1)).  */
+uint64_t FloatInspectorExponentsCount(const FloatInspectorExponentsRef histogram,
+									  int negative,
+									  int exponent);
+
+/* Number of zeros of the given sign.  */
+uint64_t FloatInspectorExponentsZeros(const FloatInspectorExponentsRef histogram,
+									  int negative);
+
+/* Number of values added so far.  */
+uint64_t FloatInspectorExponentsTotal(const FloatInspectorExponentsRef histogram);
+
+/* Exact exponent of the magnitude of the given rank in [0, 1], -INFINITY for
+ * zero and NAN if the histogram is empty.  */
+double FloatInspectorExponentsQuantile(const FloatInspectorExponentsRef histogram,
+									   double rank);
+
+#endif
@@ -0,0 +1,441 @@
+//
+//  FloatInspectorHeavyHitters.c
+//  FloatInspector
+//  
+//  Copyright 2011 Stefan Reinhold <stefan@sreinhold.com>. All rights reserved.
+//  
+//  Redistribution and use in source and binary forms, with or without modification, are
+//  permitted provided that the following conditions are met:
+//  
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//  
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list
+//  of conditions and the following disclaimer in the documentation and/or other materials
+//  provided with the distribution.
+//  
+//  THIS SOFTWARE IS PROVIDED BY STEFAN REINHOLD ``AS IS'' AND ANY EXPRESS OR IMPLIED
+//  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STEFAN REINHOLD OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+//  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+//  ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//  
+//  The views and conclusions contained in the software and documentation are those of the
+//  authors and should not be interpreted as representing official policies, either expressed
+//  or implied, of Stefan Reinhold.
+//  
+
+
+
+
+#include "FloatInspectorHeavyHitters.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#pragma mark Data Types
+
+typedef struct {
+	
+	uint64_t bits[2];
+	uint64_t count;
+	
+} FloatInspectorHeavyHittersCounter;
+
+struct _FloatInspectorHeavyHitters {
+	
+	unsigned int capacity;
+	unsigned int nCounters;
+	uint64_t nTotal;
+	
+	/* Sum of all counts subtracted by purges, bounds the amount by which a
+	 * tracked pattern can be underestimated.  */
+	uint64_t offset;
+	
+	/* Dense array of the tracked patterns, so purges only touch live 
+	 * counters.  */
+	FloatInspectorHeavyHittersCounter *counters;
+	
+	/* Open addressing index with linear probing, at most half full. Maps 
+	 * patterns to counter positions + 1, 0 marks an empty slot.  */
+	uint32_t *slots;
+	uint32_t slotMask;
+	
+	/* Scratch space of the median selection.  */
+	uint64_t *counts;
+};
+
+#pragma mark Private Functions Implementations
+
+static inline uint64_t 
+FloatInspectorHeavyHittersHash(const uint64_t bits[2]) {
+	
+	uint64_t x = bits[0] ^ (bits[1] * 0xc2b2ae3d27d4eb4fULL);
+	
+	x += 0x9e3779b97f4a7c15ULL;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	
+	return x ^ (x >> 31);
+}
+
+/* Returns the index slot of bits, or the empty slot it would go to.  */
+static inline uint32_t *
+FloatInspectorHeavyHittersFind(const FloatInspectorHeavyHittersRef summary,
+							   const uint64_t bits[2]) {
+	
+	uint32_t slot = (uint32_t) FloatInspectorHeavyHittersHash(bits) & summary->slotMask;
+	
+	for (;;) {
+		
+		const uint32_t position = summary->slots[slot];
+		
+		if ((position == 0) ||
+			((summary->counters[position - 1].bits[0] == bits[0]) && 
+			 (summary->counters[position - 1].bits[1] == bits[1]))) {
+			
+			return &summary->slots[slot];
+		}
+		
+		slot = (slot + 1) & summary->slotMask;
+	}
+}
+
+/* Returns the k-th smallest of the n counts, reordering them.  */
+static uint64_t 
+FloatInspectorHeavyHittersSelect(uint64_t *counts, size_t n, size_t k) {
+	
+	size_t left = 0;
+	size_t right = n - 1;
+	
+	while (left < right) {
+		
+		const uint64_t pivot = counts[left + (right - left) / 2];
+		size_t i = left;
+		size_t j = right;
+		
+		while (i <= j) {
+			
+			while (counts[i] < pivot) i++;
+			while (counts[j] > pivot) j--;
+			
+			if (i <= j) {
+				
+				const uint64_t count = counts[i];
+				counts[i] = counts[j];
+				counts[j] = count;
+				i++;
+				
+				if (j == 0) {
+					
+					break;
+				}
+				j--;
+			}
+		}
+		
+		if (k <= j) {
+			
+			right = j;
+		}
+		else if (k >= i) {
+			
+			left = i;
+		}
+		else {
+			
+			break;
+		}
+	}
+	
+	return counts[k];
+}
+
+/* Rebuilds the index after the counters were rewritten.  */
+static void 
+FloatInspectorHeavyHittersReindex(FloatInspectorHeavyHittersRef summary) {
+	
+	memset(summary->slots, 0, (summary->slotMask + 1) * sizeof(uint32_t));
+	
+	for (unsigned int i = 0; i < summary->nCounters; i++) {
+		
+		*FloatInspectorHeavyHittersFind(summary, summary->counters[i].bits) = i + 1;
+	}
+}
+
+/* Subtracts the median count from all counters and evicts the ones that 
+ * drop to zero, which frees at least half of the counters.  */
+static void 
+FloatInspectorHeavyHittersPurge(FloatInspectorHeavyHittersRef summary) {
+	
+	const unsigned int n = summary->nCounters;
+	
+	for (unsigned int i = 0; i < n; i++) {
+		
+		summary->counts[i] = summary->counters[i].count;
+	}
+	
+	const uint64_t median = FloatInspectorHeavyHittersSelect(summary->counts, n, n / 2);
+	unsigned int nSurvivors = 0;
+	
+	for (unsigned int i = 0; i < n; i++) {
+		
+		if (summary->counters[i].count > median) {
+			
+			summary->counters[nSurvivors] = summary->counters[i];
+			summary->counters[nSurvivors].count -= median;
+			nSurvivors++;
+		}
+	}
+	
+	summary->nCounters = nSurvivors;
+	summary->offset += median;
+	
+	/* Linear probing has no cheap deletion, rebuild the index instead.  */
+	FloatInspectorHeavyHittersReindex(summary);
+}
+
+static inline void 
+FloatInspectorHeavyHittersUpdate(FloatInspectorHeavyHittersRef summary,
+								 const uint64_t bits[2],
+								 uint64_t weight) {
+	
+	uint32_t *slot = FloatInspectorHeavyHittersFind(summary, bits);
+	
+	if (*slot != 0) {
+		
+		summary->counters[*slot - 1].count += weight;
+		return;
+	}
+	
+	FloatInspectorHeavyHittersCounter *counter = &summary->counters[summary->nCounters++];
+	
+	counter->bits[0] = bits[0];
+	counter->bits[1] = bits[1];
+	counter->count = weight;
+	*slot = summary->nCounters;
+	
+	if (summary->nCounters == summary->capacity) {
+		
+		FloatInspectorHeavyHittersPurge(summary);
+	}
+}
+
+static int 
+FloatInspectorHeavyHittersCompare(const void *a, const void *b) {
+	
+	const FloatInspectorHeavyHitter *x = a;
+	const FloatInspectorHeavyHitter *y = b;
+	
+	if (x->count != y->count) {
+		
+		return x->count > y->count ? -1 : 1;
+	}
+	
+	if (x->bits[1] != y->bits[1]) {
+		
+		return x->bits[1] < y->bits[1] ? -1 : 1;
+	}
+	
+	return x->bits[0] < y->bits[0] ? -1 : (x->bits[0] > y->bits[0]);
+}
+
+#pragma mark Public Functions Implementations
+
+FloatInspectorHeavyHittersRef 
+FloatInspectorHeavyHittersCreate(unsigned int capacity) {
+	
+	if ((capacity < 2) || (capacity > (1u << 24))) {
+		
+		return NULL;
+	}
+	
+	FloatInspectorHeavyHittersRef summary = calloc(1, sizeof(struct _FloatInspectorHeavyHitters));
+	
+	if (summary == NULL) {
+		
+		return NULL;
+	}
+	
+	uint32_t nSlots = 1;
+	
+	while (nSlots < 2 * capacity) {
+		
+		nSlots <<= 1;
+	}
+	
+	summary->capacity = capacity;
+	summary->slotMask = nSlots - 1;
+	
+	summary->counters = malloc(capacity * sizeof(FloatInspectorHeavyHittersCounter));
+	summary->slots = calloc(nSlots, sizeof(uint32_t));
+	summary->counts = malloc(capacity * sizeof(uint64_t));
+	
+	if ((summary->counters == NULL) ||
+		(summary->slots == NULL) ||
+		(summary->counts == NULL)) {
+		
+		FloatInspectorHeavyHittersFree(summary);
+		return NULL;
+	}
+	
+	return summary;
+}
+
+FloatInspectorHeavyHittersRef 
+FloatInspectorHeavyHittersCopy(const FloatInspectorHeavyHittersRef summary) {
+	
+	FloatInspectorHeavyHittersRef copy = FloatInspectorHeavyHittersCreate(summary->capacity);
+	
+	if (copy == NULL) {
+		
+		return NULL;
+	}
+	
+	copy->nCounters = summary->nCounters;
+	copy->nTotal = summary->nTotal;
+	copy->offset = summary->offset;
+	
+	memcpy(copy->counters, summary->counters, 
+		   summary->nCounters * sizeof(FloatInspectorHeavyHittersCounter));
+	memcpy(copy->slots, summary->slots, (summary->slotMask + 1) * sizeof(uint32_t));
+	
+	return copy;
+}
+
+void 
+FloatInspectorHeavyHittersReset(FloatInspectorHeavyHittersRef summary) {
+	
+	summary->nCounters = 0;
+	summary->nTotal = 0;
+	summary->offset = 0;
+	
+	memset(summary->slots, 0, (summary->slotMask + 1) * sizeof(uint32_t));
+}
+
+int 
+FloatInspectorHeavyHittersMerge(FloatInspectorHeavyHittersRef dst,
+								const FloatInspectorHeavyHittersRef src) {
+	
+	for (unsigned int i = 0; i < src->nCounters; i++) {
+		
+		FloatInspectorHeavyHittersUpdate(dst, src->counters[i].bits, src->counters[i].count);
+	}
+	
+	dst->nTotal += src->nTotal;
+	dst->offset += src->offset;
+	
+	return 0;
+}
+
+void 
+FloatInspectorHeavyHittersFree(FloatInspectorHeavyHittersRef summary) {
+	
+	if (summary == NULL) {
+		
+		return;
+	}
+	
+	free(summary->counters);
+	free(summary->slots);
+	free(summary->counts);
+	free(summary);
+}
+
+void 
+FloatInspectorHeavyHittersAddWords32(FloatInspectorHeavyHittersRef summary,
+									 const void *restrict words,
+									 size_t n) {
+	
+	const uint8_t *bytes = words;
+	
+	for (size_t i = 0; i < n; i++) {
+		
+		uint32_t word;
+		memcpy(&word, bytes + i * sizeof(word), sizeof(word));
+		
+		const uint64_t bits[2] = { word, 0 };
+		FloatInspectorHeavyHittersUpdate(summary, bits, 1);
+	}
+	
+	summary->nTotal += n;
+}
+
+void 
+FloatInspectorHeavyHittersAddWords64(FloatInspectorHeavyHittersRef summary,
+									 const void *restrict words,
+									 size_t n) {
+	
+	const uint8_t *bytes = words;
+	
+	for (size_t i = 0; i < n; i++) {
+		
+		uint64_t bits[2] = { 0, 0 };
+		memcpy(&bits[0], bytes + i * sizeof(uint64_t), sizeof(uint64_t));
+		
+		FloatInspectorHeavyHittersUpdate(summary, bits, 1);
+	}
+	
+	summary->nTotal += n;
+}
+
+void 
+FloatInspectorHeavyHittersAddBytes(FloatInspectorHeavyHittersRef summary,
+								   const void *restrict bytes,
+								   size_t nBytes) {
+	
+	uint64_t bits[2] = { 0, 0 };
+	memcpy(bits, bytes, nBytes < sizeof(bits) ? nBytes : sizeof(bits));
+	
+	FloatInspectorHeavyHittersUpdate(summary, bits, 1);
+	summary->nTotal++;
+}
+
+uint64_t 
+FloatInspectorHeavyHittersTotal(const FloatInspectorHeavyHittersRef summary) {
+	
+	return summary->nTotal;
+}
+
+unsigned int 
+FloatInspectorHeavyHittersCapacity(const FloatInspectorHeavyHittersRef summary) {
+	
+	return summary->capacity;
+}
+
+unsigned int 
+FloatInspectorHeavyHittersGet(const FloatInspectorHeavyHittersRef summary,
+							  FloatInspectorHeavyHitter *hitters,
+							  unsigned int max) {
+	
+	FloatInspectorHeavyHitter *sorted = 
+		malloc(summary->nCounters * sizeof(FloatInspectorHeavyHitter) + 1);
+	
+	if (sorted == NULL) {
+		
+		return 0;
+	}
+	
+	for (unsigned int i = 0; i < summary->nCounters; i++) {
+		
+		/* A counter may have lost up to offset occurrences in purges.  */
+		sorted[i].bits[0] = summary->counters[i].bits[0];
+		sorted[i].bits[1] = summary->counters[i].bits[1];
+		sorted[i].count = summary->counters[i].count + summary->offset;
+		sorted[i].error = summary->offset;
+	}
+	
+	qsort(sorted, summary->nCounters, sizeof(FloatInspectorHeavyHitter), 
+		  FloatInspectorHeavyHittersCompare);
+	
+	const unsigned int n = max < summary->nCounters ? max : summary->nCounters;
+	memcpy(hitters, sorted, n * sizeof(FloatInspectorHeavyHitter));
+	
+	free(sorted);
+	
+	return n;
+}
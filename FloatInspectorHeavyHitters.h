@@ -0,0 +1,113 @@
+//
+//  FloatInspectorHeavyHitters.h
+//  FloatInspector
+//  
+//  Copyright 2011 Stefan Reinhold <stefan@sreinhold.com>. All rights reserved.
+//  
+//  Redistribution and use in source and binary forms, with or without modification, are
+//  permitted provided that the following conditions are met:
+//  
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//  
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list
+//  of conditions and the following disclaimer in the documentation and/or other materials
+//  provided with the distribution.
+//  
+//  THIS SOFTWARE IS PROVIDED BY STEFAN REINHOLD ``AS IS'' AND ANY EXPRESS OR IMPLIED
+//  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STEFAN REINHOLD OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+//  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+//  ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//  
+//  The views and conclusions contained in the software and documentation are those of the
+//  authors and should not be interpreted as representing official policies, either expressed
+//  or implied, of Stefan Reinhold.
+//  
+
+
+
+#ifndef FloatInspector_FloatInspectorHeavyHitters_h
+#define FloatInspector_FloatInspectorHeavyHitters_h
+
+#include <inttypes.h>
+#include <stddef.h>
+
+#pragma mark Data Types
+
+/* Misra-Gries summary of the most frequent bit patterns. Tracks at most 
+ * capacity patterns in a hash table. When it is full, the median count is
+ * subtracted from all counters and the ones that drop to zero are evicted,
+ * so the cost per value is constant on average. Every pattern that occurs
+ * more than 2 * total / capacity times is guaranteed to be tracked.  */
+typedef struct _FloatInspectorHeavyHitters *FloatInspectorHeavyHittersRef;
+
+/* A tracked bit pattern.  */
+typedef struct {
+	
+	/* Raw pattern as little endian words, bits beyond the format are 0.  */
+	uint64_t bits[2];
+	/* Upper bound of the number of occurrences.  */
+	uint64_t count;
+	/* Maximal overestimation, count - error is a lower bound.  */
+	uint64_t error;
+	
+} FloatInspectorHeavyHitter;
+
+#pragma mark Constants
+
+#define kFloatInspectorHeavyHittersDefaultCapacity	64
+
+#pragma mark Public Functions
+
+/* Returns an empty summary or NULL if capacity is less than 2 or memory is
+ * exhausted.  */
+FloatInspectorHeavyHittersRef 
+FloatInspectorHeavyHittersCreate(unsigned int capacity);
+
+FloatInspectorHeavyHittersRef 
+FloatInspectorHeavyHittersCopy(const FloatInspectorHeavyHittersRef summary);
+
+void FloatInspectorHeavyHittersReset(FloatInspectorHeavyHittersRef summary);
+
+/* Folds src into dst, keeping the capacity of dst. The error bounds of the 
+ * result cover both inputs. Returns 0 on success.  */
+int FloatInspectorHeavyHittersMerge(FloatInspectorHeavyHittersRef dst,
+									const FloatInspectorHeavyHittersRef src);
+
+void FloatInspectorHeavyHittersFree(FloatInspectorHeavyHittersRef summary);
+
+/* Adds n 32 resp. 64 bit patterns. Values are read with memcpy, so float 
+ * and double arrays can be passed directly.  */
+void FloatInspectorHeavyHittersAddWords32(FloatInspectorHeavyHittersRef summary,
+										  const void *restrict words,
+										  size_t n);
+
+void FloatInspectorHeavyHittersAddWords64(FloatInspectorHeavyHittersRef summary,
+										  const void *restrict words,
+										  size_t n);
+
+/* Adds a single bit pattern of up to 16 bytes, e.g. the significant bytes of
+ * a long double.  */
+void FloatInspectorHeavyHittersAddBytes(FloatInspectorHeavyHittersRef summary,
+										const void *restrict bytes,
+										size_t nBytes);
+
+/* Number of patterns added so far.  */
+uint64_t FloatInspectorHeavyHittersTotal(const FloatInspectorHeavyHittersRef summary);
+
+unsigned int 
+FloatInspectorHeavyHittersCapacity(const FloatInspectorHeavyHittersRef summary);
+
+/* Copies up to max tracked patterns to hitters, most frequent first. Returns
+ * the number of patterns copied.  */
+unsigned int 
+FloatInspectorHeavyHittersGet(const FloatInspectorHeavyHittersRef summary,
+							  FloatInspectorHeavyHitter *hitters,
+							  unsigned int max);
+
+#endif
@@ -0,0 +1,585 @@
+//
+//  FloatInspectorInterposer.c
+//  FloatInspector
+//  
+//  Copyright 2011 Stefan Reinhold <stefan@sreinhold.com>. All rights reserved.
+//  
+//  Redistribution and use in source and binary forms, with or without modification, are
+//  permitted provided that the following conditions are met:
+//  
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//  
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list
+//  of conditions and the following disclaimer in the documentation and/or other materials
+//  provided with the distribution.
+//  
+//  THIS SOFTWARE IS PROVIDED BY STEFAN REINHOLD ``AS IS'' AND ANY EXPRESS OR IMPLIED
+//  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STEFAN REINHOLD OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+//  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+//  ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//  
+//  The views and conclusions contained in the software and documentation are those of the
+//  authors and should not be interpreted as representing official policies, either expressed
+//  or implied, of Stefan Reinhold.
+//  
+
+
+//  Preloadable library that wraps common libm entry points and records
+//  statistics of their arguments and results, e.g.
+//  
+//      LD_PRELOAD=libFloatInspectorLibm.so ./solver
+//      DYLD_INSERT_LIBRARIES=libFloatInspectorLibm.dylib DYLD_FORCE_FLAT_NAMESPACE=1 ./solver
+//  
+//  Values are appended to per thread buffers and only classified, in bulk,
+//  when a buffer is full, when the thread exits and at process exit. The 
+//  report is written to $FLOATINSPECTOR_LIBM_REPORT or stderr at exit.
+//  
+
+
+#define _GNU_SOURCE
+
+#include "FloatInspector.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <sched.h>
+#include <dlfcn.h>
+#include <pthread.h>
+
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/membarrier.h>
+#endif
+
+#pragma mark Data Types
+
+typedef enum {
+	DoubleFunction,
+	FloatFunction
+} FloatInspectorInterposerPrecision;
+
+/* Statistics of one wrapped function, protected by the global lock.  */
+typedef struct {
+	
+	const char *name;
+	FloatInspectorInterposerPrecision precision;
+	unsigned int nArguments;
+	
+	unsigned long long nCalls;
+	/* Calls only counted because the statistics could not be allocated.  */
+	unsigned long long nDropped;
+	FloatInspectorStatisticsRef arguments[2];
+	FloatInspectorStatisticsRef result;
+	
+} FloatInspectorInterposerFunction;
+
+#define kFloatInspectorInterposerBufferLength 256
+
+/* Unclassified values of one function recorded by one thread.  */
+typedef struct {
+	
+	unsigned int n;
+	double arguments[2][kFloatInspectorInterposerBufferLength];
+	double result[kFloatInspectorInterposerBufferLength];
+	
+} FloatInspectorInterposerBuffer;
+
+typedef struct _FloatInspectorInterposerThread {
+	
+	struct _FloatInspectorInterposerThread *next;
+	/* Set by the owning thread while it appends to its buffers, the report
+	 * waits for it before flushing them. Plain stores, see 
+	 * FloatInspectorInterposerEnter.  */
+	int busy;
+	FloatInspectorInterposerBuffer *buffers[];
+	
+} FloatInspectorInterposerThread;
+
+#pragma mark Wrapped Functions
+
+/* Every wrapped function, the index is the position in this list.  */
+#define FloatInspectorInterposerFunctions(UNARY, BINARY) \
+	UNARY(exp, double, DoubleFunction) \
+	UNARY(exp2, double, DoubleFunction) \
+	UNARY(expm1, double, DoubleFunction) \
+	UNARY(log, double, DoubleFunction) \
+	UNARY(log2, double, DoubleFunction) \
+	UNARY(log10, double, DoubleFunction) \
+	UNARY(log1p, double, DoubleFunction) \
+	BINARY(pow, double, DoubleFunction) \
+	UNARY(sin, double, DoubleFunction) \
+	UNARY(cos, double, DoubleFunction) \
+	UNARY(tan, double, DoubleFunction) \
+	UNARY(atan, double, DoubleFunction) \
+	BINARY(atan2, double, DoubleFunction) \
+	UNARY(tanh, double, DoubleFunction) \
+	UNARY(expf, float, FloatFunction) \
+	UNARY(logf, float, FloatFunction) \
+	BINARY(powf, float, FloatFunction) \
+	UNARY(sinf, float, FloatFunction) \
+	UNARY(cosf, float, FloatFunction) \
+	UNARY(tanhf, float, FloatFunction)
+
+#define FloatInspectorInterposerEnum(name, type, precision) \
+	FloatInspectorInterposer_##name,
+
+enum {
+	FloatInspectorInterposerFunctions(FloatInspectorInterposerEnum, 
+									  FloatInspectorInterposerEnum)
+	kFloatInspectorInterposerNumberOfFunctions
+};
+
+#define FloatInspectorInterposerUnaryEntry(fname, type, prec) \
+	{ .name = #fname, .precision = prec, .nArguments = 1 },
+#define FloatInspectorInterposerBinaryEntry(fname, type, prec) \
+	{ .name = #fname, .precision = prec, .nArguments = 2 },
+
+static FloatInspectorInterposerFunction 
+FloatInspectorInterposerTable[kFloatInspectorInterposerNumberOfFunctions] = {
+	FloatInspectorInterposerFunctions(FloatInspectorInterposerUnaryEntry, 
+									  FloatInspectorInterposerBinaryEntry)
+};
+
+#pragma mark Globals
+
+static pthread_mutex_t FloatInspectorInterposerLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t FloatInspectorInterposerOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t FloatInspectorInterposerKey;
+
+/* All thread records, so buffers of still running threads are flushed at 
+ * exit as well.  */
+static FloatInspectorInterposerThread *FloatInspectorInterposerThreads = NULL;
+
+static __thread FloatInspectorInterposerThread *FloatInspectorInterposerCurrent = NULL;
+
+/* Current record of threads whose record was flushed at thread exit. Calls
+ * from later TLS destructors are not recorded instead of allocating a 
+ * record nobody would release.  */
+static FloatInspectorInterposerThread FloatInspectorInterposerExited;
+
+/* Set while the report is written, calls are no longer recorded.  */
+static int FloatInspectorInterposerFinished = 0;
+
+/* Set at initialization if the report can run a barrier on every thread of
+ * the process, the calls then only need compiler barriers.  */
+static int FloatInspectorInterposerAsymmetric = 0;
+
+#pragma mark Private Function Prototypes
+
+static void *FloatInspectorInterposerResolve(const char *name);
+
+static void FloatInspectorInterposerInitialize(void);
+
+static void FloatInspectorInterposerBarrier(void);
+
+static FloatInspectorInterposerThread *FloatInspectorInterposerEnter(void);
+
+static FloatInspectorInterposerBuffer *
+FloatInspectorInterposerBufferForFunction(FloatInspectorInterposerThread *thread,
+										  unsigned int function);
+
+static void FloatInspectorInterposerFlush(unsigned int function,
+										  FloatInspectorInterposerBuffer *buffer);
+
+static void FloatInspectorInterposerThreadExit(void *context);
+
+static void FloatInspectorInterposerReport(void) __attribute__((destructor));
+
+#pragma mark Private Functions Implementations
+
+static void *
+FloatInspectorInterposerResolve(const char *name) {
+	
+	void *symbol = dlsym(RTLD_NEXT, name);
+	
+	if (symbol == NULL) {
+		
+		fprintf(stderr, "FloatInspector: cannot resolve %s: %s\n", name, dlerror());
+		abort();
+	}
+	
+	return symbol;
+}
+
+static void 
+FloatInspectorInterposerInitialize(void) {
+	
+	pthread_key_create(&FloatInspectorInterposerKey, 
+					   FloatInspectorInterposerThreadExit);
+	
+#if defined(__linux__) && defined(SYS_membarrier)
+	FloatInspectorInterposerAsymmetric = 
+		syscall(SYS_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0) == 0;
+#endif
+}
+
+/* Full barrier on the calling thread and, if asymmetric, on every other 
+ * running thread of the process.  */
+static void 
+FloatInspectorInterposerBarrier(void) {
+	
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	
+#if defined(__linux__) && defined(SYS_membarrier)
+	if (FloatInspectorInterposerAsymmetric) {
+		
+		syscall(SYS_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0);
+	}
+#endif
+}
+
+/* Returns the calling thread's record marked busy or NULL if recording is
+ * not possible (out of memory, thread or process exiting). Busy is stored
+ * before finished is loaded and the report does the opposite, so either the
+ * thread sees the report started or the report waits for the thread. The 
+ * fence between them is the report's membarrier where available, which 
+ * leaves a compiler barrier on this path.  */
+static FloatInspectorInterposerThread *
+FloatInspectorInterposerEnter(void) {
+	
+	FloatInspectorInterposerThread *thread = FloatInspectorInterposerCurrent;
+	
+	if (__builtin_expect((thread == NULL) || (thread == &FloatInspectorInterposerExited), 0)) {
+		
+		if ((thread != NULL) || 
+			__atomic_load_n(&FloatInspectorInterposerFinished, __ATOMIC_ACQUIRE)) {
+			
+			return NULL;
+		}
+		
+		pthread_once(&FloatInspectorInterposerOnce, FloatInspectorInterposerInitialize);
+		
+		thread = calloc(1, sizeof(FloatInspectorInterposerThread) + 
+						kFloatInspectorInterposerNumberOfFunctions * 
+						sizeof(FloatInspectorInterposerBuffer *));
+		
+		if (thread == NULL) {
+			
+			return NULL;
+		}
+		
+		pthread_mutex_lock(&FloatInspectorInterposerLock);
+		thread->next = FloatInspectorInterposerThreads;
+		FloatInspectorInterposerThreads = thread;
+		pthread_mutex_unlock(&FloatInspectorInterposerLock);
+		
+		pthread_setspecific(FloatInspectorInterposerKey, thread);
+		FloatInspectorInterposerCurrent = thread;
+	}
+	
+	__atomic_store_n(&thread->busy, 1, __ATOMIC_RELAXED);
+	
+	if (FloatInspectorInterposerAsymmetric) {
+		
+		__atomic_signal_fence(__ATOMIC_SEQ_CST);
+	}
+	else {
+		
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	}
+	
+	if (__builtin_expect(__atomic_load_n(&FloatInspectorInterposerFinished, 
+										 __ATOMIC_RELAXED), 0)) {
+		
+		__atomic_store_n(&thread->busy, 0, __ATOMIC_RELAXED);
+		return NULL;
+	}
+	
+	return thread;
+}
+
+static FloatInspectorInterposerBuffer *
+FloatInspectorInterposerBufferForFunction(FloatInspectorInterposerThread *thread,
+										  unsigned int function) {
+	
+	FloatInspectorInterposerBuffer *buffer = thread->buffers[function];
+	
+	if (__builtin_expect(buffer == NULL, 0)) {
+		
+		/* Only functions a thread actually calls get a buffer.  */
+		buffer = calloc(1, sizeof(FloatInspectorInterposerBuffer));
+		thread->buffers[function] = buffer;
+	}
+	
+	return buffer;
+}
+
+/* Classifies the buffered values of a function, the caller holds the 
+ * global lock.  */
+static void 
+FloatInspectorInterposerFlush(unsigned int function,
+							  FloatInspectorInterposerBuffer *buffer) {
+	
+	FloatInspectorInterposerFunction *f = &FloatInspectorInterposerTable[function];
+	const unsigned int n = buffer->n;
+	
+	if (n == 0) {
+		
+		return;
+	}
+	
+	if (f->result == NULL) {
+		
+		const enum PrecisionType type = f->precision == FloatFunction ? Float : Double;
+		
+		f->result = FloatInspectorStatisticsCreate(type);
+		int complete = f->result != NULL;
+		
+		for (unsigned int i = 0; i < f->nArguments; i++) {
+			
+			f->arguments[i] = FloatInspectorStatisticsCreate(type);
+			complete = complete && (f->arguments[i] != NULL);
+		}
+		
+		if (!complete) {
+			
+			for (unsigned int i = 0; i < f->nArguments; i++) {
+				
+				if (f->arguments[i] != NULL) {
+					
+					FloatInspectorStatisticsFree(f->arguments[i]);
+					f->arguments[i] = NULL;
+				}
+			}
+			
+			if (f->result != NULL) {
+				
+				FloatInspectorStatisticsFree(f->result);
+				f->result = NULL;
+			}
+		}
+	}
+	
+	f->nCalls += n;
+	
+	/* Out of memory, the values are only counted and the next flush tries
+	 * again.  */
+	if (f->result == NULL) {
+		
+		f->nDropped += n;
+		buffer->n = 0;
+		return;
+	}
+	
+	if (f->precision == FloatFunction) {
+		
+		/* Float functions are recorded as doubles, which is exact.  */
+		float values[kFloatInspectorInterposerBufferLength];
+		
+		for (unsigned int a = 0; a < f->nArguments; a++) {
+			
+			for (unsigned int i = 0; i < n; i++) values[i] = (float) buffer->arguments[a][i];
+			FloatInspectorStatisticsUpdateWithFloats(f->arguments[a], values, n);
+		}
+		
+		for (unsigned int i = 0; i < n; i++) values[i] = (float) buffer->result[i];
+		FloatInspectorStatisticsUpdateWithFloats(f->result, values, n);
+	}
+	else {
+		
+		for (unsigned int a = 0; a < f->nArguments; a++) {
+			
+			FloatInspectorStatisticsUpdateWithDoubles(f->arguments[a], 
+													  buffer->arguments[a], n);
+		}
+		
+		FloatInspectorStatisticsUpdateWithDoubles(f->result, buffer->result, n);
+	}
+	
+	buffer->n = 0;
+}
+
+static void 
+FloatInspectorInterposerThreadExit(void *context) {
+	
+	FloatInspectorInterposerThread *thread = context;
+	
+	pthread_mutex_lock(&FloatInspectorInterposerLock);
+	
+	for (unsigned int i = 0; i < kFloatInspectorInterposerNumberOfFunctions; i++) {
+		
+		if (thread->buffers[i] != NULL) {
+			
+			FloatInspectorInterposerFlush(i, thread->buffers[i]);
+			free(thread->buffers[i]);
+			thread->buffers[i] = NULL;
+		}
+	}
+	
+	pthread_mutex_unlock(&FloatInspectorInterposerLock);
+	
+	/* The record itself stays on the thread list and is never released: 
+	 * the report walks the list without the lock, and a few hundred bytes 
+	 * per thread are cheaper than making it wait for exiting threads.  */
+	FloatInspectorInterposerCurrent = &FloatInspectorInterposerExited;
+}
+
+static void 
+FloatInspectorInterposerReport(void) {
+	
+	pthread_once(&FloatInspectorInterposerOnce, FloatInspectorInterposerInitialize);
+	
+	__atomic_store_n(&FloatInspectorInterposerFinished, 1, __ATOMIC_RELAXED);
+	FloatInspectorInterposerBarrier();
+	
+	/* Threads registered later see finished and do not record. The lock is
+	 * not held while waiting, a busy thread may need it to flush a full 
+	 * buffer.  */
+	pthread_mutex_lock(&FloatInspectorInterposerLock);
+	FloatInspectorInterposerThread *threads = FloatInspectorInterposerThreads;
+	pthread_mutex_unlock(&FloatInspectorInterposerLock);
+	
+	for (FloatInspectorInterposerThread *thread = threads;
+		 thread != NULL;
+		 thread = thread->next) {
+		
+		while (__atomic_load_n(&thread->busy, __ATOMIC_RELAXED)) {
+			
+			sched_yield();
+		}
+	}
+	
+	/* Makes the values appended before busy was cleared visible here.  */
+	FloatInspectorInterposerBarrier();
+	
+	pthread_mutex_lock(&FloatInspectorInterposerLock);
+	
+	for (FloatInspectorInterposerThread *thread = threads;
+		 thread != NULL;
+		 thread = thread->next) {
+		
+		for (unsigned int i = 0; i < kFloatInspectorInterposerNumberOfFunctions; i++) {
+			
+			if (thread->buffers[i] != NULL) {
+				
+				FloatInspectorInterposerFlush(i, thread->buffers[i]);
+			}
+		}
+	}
+	
+	const char *path = getenv("FLOATINSPECTOR_LIBM_REPORT");
+	FILE *stream = path != NULL ? fopen(path, "w") : NULL;
+	
+	if (stream == NULL) {
+		
+		stream = stderr;
+	}
+	
+	for (unsigned int i = 0; i < kFloatInspectorInterposerNumberOfFunctions; i++) {
+		
+		FloatInspectorInterposerFunction *f = &FloatInspectorInterposerTable[i];
+		
+		if (f->nCalls == 0) {
+			
+			continue;
+		}
+		
+		fprintf(stream, "=== %s: %llu calls ===\n\n", f->name, f->nCalls);
+		
+		if (f->nDropped != 0) {
+			
+			fprintf(stream, "%llu calls not classified, out of memory\n\n", f->nDropped);
+		}
+		
+		if (f->result == NULL) {
+			
+			continue;
+		}
+		
+		for (unsigned int a = 0; a < f->nArguments; a++) {
+			
+			fprintf(stream, "--- %s argument %u ---\n", f->name, a + 1);
+			FloatInspectorStatisticsPrint(f->arguments[a], stream);
+		}
+		
+		fprintf(stream, "--- %s result ---\n", f->name);
+		FloatInspectorStatisticsPrint(f->result, stream);
+	}
+	
+	if (stream != stderr) {
+		
+		fclose(stream);
+	}
+	
+	pthread_mutex_unlock(&FloatInspectorInterposerLock);
+}
+
+/* Appends one call to the calling thread's buffer.  */
+static inline void 
+FloatInspectorInterposerRecord(unsigned int function, 
+							   double x, double y, double result) {
+	
+	FloatInspectorInterposerThread *thread = FloatInspectorInterposerEnter();
+	
+	if (__builtin_expect(thread == NULL, 0)) {
+		
+		return;
+	}
+	
+	FloatInspectorInterposerBuffer *buffer = 
+		FloatInspectorInterposerBufferForFunction(thread, function);
+	
+	if (__builtin_expect(buffer != NULL, 1)) {
+		
+		const unsigned int n = buffer->n;
+		
+		buffer->arguments[0][n] = x;
+		buffer->arguments[1][n] = y;
+		buffer->result[n] = result;
+		buffer->n = n + 1;
+		
+		if (__builtin_expect(n + 1 == kFloatInspectorInterposerBufferLength, 0)) {
+			
+			pthread_mutex_lock(&FloatInspectorInterposerLock);
+			FloatInspectorInterposerFlush(function, buffer);
+			pthread_mutex_unlock(&FloatInspectorInterposerLock);
+		}
+	}
+	
+	/* The report's second barrier publishes the buffer.  */
+	if (FloatInspectorInterposerAsymmetric) {
+		
+		__atomic_signal_fence(__ATOMIC_SEQ_CST);
+		__atomic_store_n(&thread->busy, 0, __ATOMIC_RELAXED);
+	}
+	else {
+		
+		__atomic_store_n(&thread->busy, 0, __ATOMIC_RELEASE);
+	}
+}
+
+#pragma mark Public Functions Implementations
+
+#define FloatInspectorInterposerUnary(fname, type, precision) \
+	type fname(type x) { \
+		static type (*real)(type) = NULL; \
+		if (__builtin_expect(real == NULL, 0)) { \
+			*(void **) &real = FloatInspectorInterposerResolve(#fname); \
+		} \
+		const type result = real(x); \
+		FloatInspectorInterposerRecord(FloatInspectorInterposer_##fname, x, 0., result); \
+		return result; \
+	}
+
+#define FloatInspectorInterposerBinary(fname, type, precision) \
+	type fname(type x, type y) { \
+		static type (*real)(type, type) = NULL; \
+		if (__builtin_expect(real == NULL, 0)) { \
+			*(void **) &real = FloatInspectorInterposerResolve(#fname); \
+		} \
+		const type result = real(x, y); \
+		FloatInspectorInterposerRecord(FloatInspectorInterposer_##fname, x, y, result); \
+		return result; \
+	}
+
+FloatInspectorInterposerFunctions(FloatInspectorInterposerUnary, 
+								  FloatInspectorInterposerBinary)
@@ -0,0 +1,98 @@
+//
+//  FloatInspectorLibmTest.c
+//  FloatInspector
+//  
+//  Copyright 2011 Stefan Reinhold <stefan@sreinhold.com>. All rights reserved.
+//  
+//  Redistribution and use in source and binary forms, with or without modification, are
+//  permitted provided that the following conditions are met:
+//  
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//  
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list
+//  of conditions and the following disclaimer in the documentation and/or other materials
+//  provided with the distribution.
+//  
+//  THIS SOFTWARE IS PROVIDED BY STEFAN REINHOLD ``AS IS'' AND ANY EXPRESS OR IMPLIED
+//  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STEFAN REINHOLD OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+//  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+//  ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//  
+//  The views and conclusions contained in the software and documentation are those of the
+//  authors and should not be interpreted as representing official policies, either expressed
+//  or implied, of Stefan Reinhold.
+//  
+
+
+//  Small program to try the libm interposer against, e.g.
+//  
+//      LD_PRELOAD=libFloatInspectorLibm.so ./FloatInspectorLibmTest
+//  
+//  It feeds exp, log, pow and sin a mix of ordinary, denormalized and 
+//  extreme arguments, from two threads.
+//  
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <float.h>
+#include <math.h>
+#include <pthread.h>
+
+
+int main(int, char **);
+
+static void *FloatInspectorLibmTestWork(void *);
+
+/* Volatile, so the compiler cannot fold the calls away.  */
+static volatile double sink;
+
+static void *
+FloatInspectorLibmTestWork(void *context) {
+	
+	const int offset = *(const int *) context;
+	double sum = 0.;
+	
+	for (int i = 0; i < 100000; i++) {
+		
+		const double x = (double) (i + offset) / 1000.;
+		
+		sum += exp(-x);
+		sum += log(x + DBL_MIN);
+		sum += pow(x, 1.5);
+		sum += sin(x);
+		
+		/* Denormalized and huge arguments.  */
+		sum += exp(DBL_MIN / (i + 2));
+		sum += log(DBL_MIN / (i + 2));
+		sum += pow(DBL_MAX / (i + 1), 2.);
+		sum += (double) expf((float) -x * 100.f);
+	}
+	
+	sink = sum;
+	
+	return NULL;
+}
+
+int
+main(int argc, char **argv) {
+	
+#pragma unused(argc, argv)
+	
+	pthread_t thread;
+	int offsets[2] = { 0, 100000 };
+	
+	pthread_create(&thread, NULL, FloatInspectorLibmTestWork, &offsets[1]);
+	FloatInspectorLibmTestWork(&offsets[0]);
+	pthread_join(thread, NULL);
+	
+	printf("%e\n", sink);
+	
+	return EXIT_SUCCESS;
+}
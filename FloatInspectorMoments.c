@@ -0,0 +1,418 @@
+//
+//  FloatInspectorMoments.c
+//  FloatInspector
+//  
+//  Copyright 2011 Stefan Reinhold <stefan@sreinhold.com>. All rights reserved.
+//  
+//  Redistribution and use in source and binary forms, with or without modification, are
+//  permitted provided that the following conditions are met:
+//  
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//  
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list
+//  of conditions and the following disclaimer in the documentation and/or other materials
+//  provided with the distribution.
+//  
+//  THIS SOFTWARE IS PROVIDED BY STEFAN REINHOLD ``AS IS'' AND ANY EXPRESS OR IMPLIED
+//  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STEFAN REINHOLD OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+//  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+//  ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//  
+//  The views and conclusions contained in the software and documentation are those of the
+//  authors and should not be interpreted as representing official policies, either expressed
+//  or implied, of Stefan Reinhold.
+//  
+
+
+
+
+
+#include "FloatInspectorMoments.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#pragma mark Constants
+
+/* Values reduced at once, small enough to stay in L1 for the second pass 
+ * over the deviations.  */
+#define kFloatInspectorMomentsBlock	512
+/* Doubles per vector, 128 bit vectors are available on every SIMD 
+ * target.  */
+#define kFloatInspectorMomentsLanes	2
+
+#pragma mark Data Types
+
+/* Generic vectors, lowered to SSE2, NEON or plain scalar code.  */
+typedef double FloatInspectorMomentsVector 
+	__attribute__((vector_size(kFloatInspectorMomentsLanes * sizeof(double))));
+typedef int64_t FloatInspectorMomentsMask 
+	__attribute__((vector_size(kFloatInspectorMomentsLanes * sizeof(int64_t))));
+
+/* Partial moments of a block, one per lane.  */
+typedef struct {
+	
+	FloatInspectorMomentsVector counts;
+	FloatInspectorMomentsVector sums;
+	FloatInspectorMomentsVector minima;
+	FloatInspectorMomentsVector maxima;
+	
+} FloatInspectorMomentsPartials;
+
+/* Moments of a single block.  */
+typedef struct {
+	
+	uint64_t n;
+	double minimum;
+	double maximum;
+	double sum;
+	double m2;
+	
+} FloatInspectorMomentsBlock;
+
+#pragma mark Private Functions Implementations
+
+static inline void 
+FloatInspectorMomentsAddSum(FloatInspectorMomentsRef moments, double x) {
+	
+	const double t = moments->sum + x;
+	
+	if (fabs(moments->sum) >= fabs(x)) {
+		
+		moments->compensation += (moments->sum - t) + x;
+	}
+	else {
+		
+		moments->compensation += (x - t) + moments->sum;
+	}
+	
+	moments->sum = t;
+}
+
+/* Combines the moments with the ones of n further values.  */
+static void 
+FloatInspectorMomentsCombine(FloatInspectorMomentsRef moments,
+							 uint64_t n,
+							 double minimum,
+							 double maximum,
+							 double mean,
+							 double m2) {
+	
+	if (n == 0) {
+		
+		return;
+	}
+	
+	const double nA = (double) moments->n;
+	const double nB = (double) n;
+	const double delta = mean - moments->mean;
+	
+	moments->n += n;
+	moments->mean += delta * (nB / (nA + nB));
+	moments->m2 += m2 + delta * delta * (nA * nB / (nA + nB));
+	
+	moments->minimum = minimum < moments->minimum ? minimum : moments->minimum;
+	moments->maximum = maximum > moments->maximum ? maximum : moments->maximum;
+}
+
+/* All ones in the lanes of finite values.  */
+static inline FloatInspectorMomentsMask 
+FloatInspectorMomentsFinite(FloatInspectorMomentsVector x) {
+	
+	const FloatInspectorMomentsMask magnitude = (FloatInspectorMomentsMask) { 0 } + INT64_MAX;
+	
+	return (FloatInspectorMomentsVector) ((FloatInspectorMomentsMask) x & magnitude) <= 
+		(FloatInspectorMomentsVector) { 0. } + DBL_MAX;
+}
+
+static inline FloatInspectorMomentsVector 
+FloatInspectorMomentsSelect(FloatInspectorMomentsMask mask,
+							FloatInspectorMomentsVector a,
+							FloatInspectorMomentsVector b) {
+	
+	return (FloatInspectorMomentsVector) 
+		(((FloatInspectorMomentsMask) a & mask) | ((FloatInspectorMomentsMask) b & ~mask));
+}
+
+/* Non-finite values are replaced by neutral elements with masks instead of
+ * branches.  */
+static inline void 
+FloatInspectorMomentsAccumulate(FloatInspectorMomentsPartials *partials,
+								FloatInspectorMomentsVector x) {
+	
+	const FloatInspectorMomentsMask finite = FloatInspectorMomentsFinite(x);
+	
+	/* NaNs fail both comparisons anyway, the mask only rules out 
+	 * infinities.  */
+	const FloatInspectorMomentsMask lower = (x < partials->minima) & finite;
+	const FloatInspectorMomentsMask higher = (x > partials->maxima) & finite;
+	
+	partials->counts += FloatInspectorMomentsSelect(finite, 
+													(FloatInspectorMomentsVector) { 0. } + 1., 
+													(FloatInspectorMomentsVector) { 0. });
+	partials->sums += FloatInspectorMomentsSelect(finite, x, (FloatInspectorMomentsVector) { 0. });
+	partials->minima = FloatInspectorMomentsSelect(lower, x, partials->minima);
+	partials->maxima = FloatInspectorMomentsSelect(higher, x, partials->maxima);
+}
+
+/* Reduces a block of at most kFloatInspectorMomentsBlock values in two 
+ * independent sets of vectors.  */
+static FloatInspectorMomentsBlock 
+FloatInspectorMomentsReduce(const double *restrict values, size_t n) {
+	
+	const FloatInspectorMomentsVector infinity = (FloatInspectorMomentsVector) { 0. } + INFINITY;
+	const size_t nGroupValues = kFloatInspectorMomentsLanes * 2;
+	const size_t nGroups = n / nGroupValues;
+	
+	FloatInspectorMomentsPartials even = { { 0. }, { 0. }, infinity, -infinity };
+	FloatInspectorMomentsPartials odd = even;
+	
+	for (size_t group = 0; group < nGroups; group++) {
+		
+		FloatInspectorMomentsVector x0, x1;
+		memcpy(&x0, &values[group * nGroupValues], sizeof(x0));
+		memcpy(&x1, &values[group * nGroupValues + kFloatInspectorMomentsLanes], sizeof(x1));
+		
+		FloatInspectorMomentsAccumulate(&even, x0);
+		FloatInspectorMomentsAccumulate(&odd, x1);
+	}
+	
+	/* Only now spill the partials to memory.  */
+	double partials[2][4][kFloatInspectorMomentsLanes];
+	memcpy(partials[0], &even, sizeof(even));
+	memcpy(partials[1], &odd, sizeof(odd));
+	
+	FloatInspectorMomentsBlock block = { 0, INFINITY, -INFINITY, 0., 0. };
+	double count = 0.;
+	
+	for (unsigned int k = 0; k < 2; k++) {
+		for (unsigned int lane = 0; lane < kFloatInspectorMomentsLanes; lane++) {
+			
+			count += partials[k][0][lane];
+			block.sum += partials[k][1][lane];
+			block.minimum = fmin(block.minimum, partials[k][2][lane]);
+			block.maximum = fmax(block.maximum, partials[k][3][lane]);
+		}
+	}
+	
+	for (size_t i = nGroups * nGroupValues; i < n; i++) {
+		
+		if (fabs(values[i]) <= DBL_MAX) {
+			
+			count += 1.;
+			block.sum += values[i];
+			block.minimum = fmin(block.minimum, values[i]);
+			block.maximum = fmax(block.maximum, values[i]);
+		}
+	}
+	
+	block.n = (uint64_t) count;
+	
+	if (block.n == 0) {
+		
+		return block;
+	}
+	
+	/* Second pass over the cached block. Deviations from the block mean do 
+	 * not suffer from the cancellation of the textbook formula.  */
+	const double mean = block.sum / count;
+	FloatInspectorMomentsVector m2 = { 0. };
+	
+	for (size_t i = 0; i < nGroups * 2; i++) {
+		
+		FloatInspectorMomentsVector x;
+		memcpy(&x, &values[i * kFloatInspectorMomentsLanes], sizeof(x));
+		
+		const FloatInspectorMomentsVector deviation = 
+			FloatInspectorMomentsSelect(FloatInspectorMomentsFinite(x), 
+										x - mean, 
+										(FloatInspectorMomentsVector) { 0. });
+		
+		m2 += deviation * deviation;
+	}
+	
+	double m2s[kFloatInspectorMomentsLanes];
+	memcpy(m2s, &m2, sizeof(m2));
+	
+	for (unsigned int lane = 0; lane < kFloatInspectorMomentsLanes; lane++) {
+		
+		block.m2 += m2s[lane];
+	}
+	
+	for (size_t i = nGroups * nGroupValues; i < n; i++) {
+		
+		if (fabs(values[i]) <= DBL_MAX) {
+			
+			block.m2 += (values[i] - mean) * (values[i] - mean);
+		}
+	}
+	
+	return block;
+}
+
+static void 
+FloatInspectorMomentsFold(FloatInspectorMomentsRef moments,
+						  const FloatInspectorMomentsBlock *block) {
+	
+	if (block->n == 0) {
+		
+		return;
+	}
+	
+	FloatInspectorMomentsAddSum(moments, block->sum);
+	FloatInspectorMomentsCombine(moments, block->n, block->minimum, block->maximum,
+								 block->sum / (double) block->n, block->m2);
+}
+
+#pragma mark Public Functions Implementations
+
+FloatInspectorMomentsRef 
+FloatInspectorMomentsCreate(void) {
+	
+	FloatInspectorMomentsRef moments = malloc(sizeof(_FloatInspectorMoments));
+	
+	if (moments == NULL) {
+		
+		return NULL;
+	}
+	
+	FloatInspectorMomentsReset(moments);
+	
+	return moments;
+}
+
+FloatInspectorMomentsRef 
+FloatInspectorMomentsCopy(const FloatInspectorMomentsRef moments) {
+	
+	FloatInspectorMomentsRef copy = malloc(sizeof(_FloatInspectorMoments));
+	
+	if (copy == NULL) {
+		
+		return NULL;
+	}
+	
+	*copy = *moments;
+	
+	return copy;
+}
+
+void 
+FloatInspectorMomentsReset(FloatInspectorMomentsRef moments) {
+	
+	_FloatInspectorMoments _moments = {
+		
+		.n				= 0,
+		.nOutOfRange	= 0,
+		.minimum		= INFINITY,
+		.maximum		= -INFINITY,
+		.sum			= 0.,
+		.compensation	= 0.,
+		.mean			= 0.,
+		.m2				= 0.
+	};
+	
+	*moments = _moments;
+}
+
+void 
+FloatInspectorMomentsMerge(FloatInspectorMomentsRef dst,
+						   const FloatInspectorMomentsRef src) {
+	
+	dst->nOutOfRange += src->nOutOfRange;
+	
+	if (src->n == 0) {
+		
+		return;
+	}
+	
+	FloatInspectorMomentsAddSum(dst, src->sum);
+	FloatInspectorMomentsAddSum(dst, src->compensation);
+	FloatInspectorMomentsCombine(dst, src->n, src->minimum, src->maximum,
+								 src->mean, src->m2);
+}
+
+void 
+FloatInspectorMomentsFree(FloatInspectorMomentsRef moments) {
+	
+	free(moments);
+}
+
+void 
+FloatInspectorMomentsAddFloats(FloatInspectorMomentsRef moments,
+							   const float *restrict values,
+							   size_t n) {
+	
+	double widened[kFloatInspectorMomentsBlock];
+	
+	for (size_t block = 0; block < n; block += kFloatInspectorMomentsBlock) {
+		
+		const size_t nBlock = n - block < kFloatInspectorMomentsBlock ? 
+			n - block : kFloatInspectorMomentsBlock;
+		
+		for (size_t i = 0; i < nBlock; i++) {
+			
+			widened[i] = (double) values[block + i];
+		}
+		
+		const FloatInspectorMomentsBlock reduced = 
+			FloatInspectorMomentsReduce(widened, nBlock);
+		FloatInspectorMomentsFold(moments, &reduced);
+	}
+}
+
+void 
+FloatInspectorMomentsAddDoubles(FloatInspectorMomentsRef moments,
+								const double *restrict values,
+								size_t n) {
+	
+	for (size_t block = 0; block < n; block += kFloatInspectorMomentsBlock) {
+		
+		const size_t nBlock = n - block < kFloatInspectorMomentsBlock ? 
+			n - block : kFloatInspectorMomentsBlock;
+		
+		const FloatInspectorMomentsBlock reduced = 
+			FloatInspectorMomentsReduce(&values[block], nBlock);
+		FloatInspectorMomentsFold(moments, &reduced);
+	}
+}
+
+void 
+FloatInspectorMomentsAddLongDouble(FloatInspectorMomentsRef moments,
+								   long double value) {
+	
+	if (fabsl(value) <= (long double) DBL_MAX) {
+		
+		const double rounded = (double) value;
+		FloatInspectorMomentsAddDoubles(moments, &rounded, 1);
+	}
+	else if (isfinite(value)) {
+		
+		moments->nOutOfRange++;
+	}
+}
+
+double 
+FloatInspectorMomentsSum(const FloatInspectorMomentsRef moments) {
+	
+	return moments->sum + moments->compensation;
+}
+
+double 
+FloatInspectorMomentsMean(const FloatInspectorMomentsRef moments) {
+	
+	return moments->n != 0 ? moments->mean : NAN;
+}
+
+double 
+FloatInspectorMomentsVariance(const FloatInspectorMomentsRef moments) {
+	
+	return moments->n != 0 ? moments->m2 / (double) moments->n : NAN;
+}
@@ -0,0 +1,109 @@
+//
+//  FloatInspectorMoments.h
+//  FloatInspector
+//  
+//  Copyright 2011 Stefan Reinhold <stefan@sreinhold.com>. All rights reserved.
+//  
+//  Redistribution and use in source and binary forms, with or without modification, are
+//  permitted provided that the following conditions are met:
+//  
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//  
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list
+//  of conditions and the following disclaimer in the documentation and/or other materials
+//  provided with the distribution.
+//  
+//  THIS SOFTWARE IS PROVIDED BY STEFAN REINHOLD ``AS IS'' AND ANY EXPRESS OR IMPLIED
+//  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STEFAN REINHOLD OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+//  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+//  ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//  
+//  The views and conclusions contained in the software and documentation are those of the
+//  authors and should not be interpreted as representing official policies, either expressed
+//  or implied, of Stefan Reinhold.
+//  
+
+
+
+
+#ifndef FloatInspector_FloatInspectorMoments_h
+#define FloatInspector_FloatInspectorMoments_h
+
+#include <inttypes.h>
+#include <stddef.h>
+
+#pragma mark Data Types
+
+/* Running moments of the finite values, NaNs and infinities are skipped. 
+ * Values are added in blocks: each block is reduced on its own in several
+ * independent lanes and folded into the running moments with the parallel
+ * update of Chan et al., which is also used to merge two objects. The sum
+ * is kept with Neumaier compensation.  */
+typedef struct {
+	
+	/* Number of finite values.  */
+	uint64_t n;
+	
+	/* Finite values beyond the double range, e.g. huge long doubles. They 
+	 * are only counted here, not in n or any other moment.  */
+	uint64_t nOutOfRange;
+	
+	/* Extrema, +INFINITY resp. -INFINITY while n is 0.  */
+	double minimum;
+	double maximum;
+	
+	/* Compensated sum, the result is sum + compensation.  */
+	double sum;
+	double compensation;
+	
+	/* Mean and sum of squared deviations from it.  */
+	double mean;
+	double m2;
+	
+} _FloatInspectorMoments;
+typedef _FloatInspectorMoments* FloatInspectorMomentsRef;
+
+#pragma mark Public Functions
+
+/* Returns empty moments or NULL if memory is exhausted.  */
+FloatInspectorMomentsRef FloatInspectorMomentsCreate(void);
+
+FloatInspectorMomentsRef 
+FloatInspectorMomentsCopy(const FloatInspectorMomentsRef moments);
+
+void FloatInspectorMomentsReset(FloatInspectorMomentsRef moments);
+
+/* Folds src into dst.  */
+void FloatInspectorMomentsMerge(FloatInspectorMomentsRef dst,
+								const FloatInspectorMomentsRef src);
+
+void FloatInspectorMomentsFree(FloatInspectorMomentsRef moments);
+
+/* Adds n values, floats are widened to double.  */
+void FloatInspectorMomentsAddFloats(FloatInspectorMomentsRef moments,
+									const float *restrict values,
+									size_t n);
+
+void FloatInspectorMomentsAddDoubles(FloatInspectorMomentsRef moments,
+									 const double *restrict values,
+									 size_t n);
+
+/* Adds a long double rounded to double, or counts it in nOutOfRange if it
+ * is finite but beyond the double range.  */
+void FloatInspectorMomentsAddLongDouble(FloatInspectorMomentsRef moments,
+										long double value);
+
+/* Compensated sum, 0 if no finite value was added.  */
+double FloatInspectorMomentsSum(const FloatInspectorMomentsRef moments);
+
+/* Mean resp. population variance, NAN if no finite value was added.  */
+double FloatInspectorMomentsMean(const FloatInspectorMomentsRef moments);
+double FloatInspectorMomentsVariance(const FloatInspectorMomentsRef moments);
+
+#endif
@@ -0,0 +1,630 @@
+//
+//  FloatInspectorPerf.c
+//  FloatInspector
+//  
+//  Copyright 2011 Stefan Reinhold <stefan@sreinhold.com>. All rights reserved.
+//  
+//  Redistribution and use in source and binary forms, with or without modification, are
+//  permitted provided that the following conditions are met:
+//  
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//  
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list
+//  of conditions and the following disclaimer in the documentation and/or other materials
+//  provided with the distribution.
+//  
+//  THIS SOFTWARE IS PROVIDED BY STEFAN REINHOLD ``AS IS'' AND ANY EXPRESS OR IMPLIED
+//  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STEFAN REINHOLD OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+//  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+//  ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//  
+//  The views and conclusions contained in the software and documentation are those of the
+//  authors and should not be interpreted as representing official policies, either expressed
+//  or implied, of Stefan Reinhold.
+//  
+
+
+
+#define _GNU_SOURCE
+
+#include "FloatInspectorPerf.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+#pragma mark Data Types
+
+typedef struct _FloatInspectorPerfThread {
+	
+	/* Guards the entries against reports and resets, except nCalls which 
+	 * only the thread writes, with relaxed atomics.  */
+	pthread_mutex_t lock;
+	FloatInspectorPerfEntry entries[BFloat16 + 1][kFloatInspectorPerfNumberOfPaths];
+	
+	/* Counter group, the leader is -1 if it could not be opened. Each 
+	 * counter's position in a group read or -1.  */
+	int leader;
+	int fds[kFloatInspectorPerfNumberOfCounters];
+	int slots[kFloatInspectorPerfNumberOfCounters];
+	unsigned int counters;
+	int tried;
+	
+	int worker;
+	unsigned int depth;
+	
+	struct _FloatInspectorPerfThread *next;
+	
+} FloatInspectorPerfThread;
+
+#pragma mark Constants
+
+#define kFloatInspectorPerfNumberOfTypes	(BFloat16 + 1)
+
+static const char *kFloatInspectorPerfTypeNames[kFloatInspectorPerfNumberOfTypes] = {
+	"float", "double", "long double", "half", "bfloat16"
+};
+
+static const char *kFloatInspectorPerfPathNames[kFloatInspectorPerfNumberOfPaths] = {
+	"scalar", "bulk", "threaded"
+};
+
+#if defined(__linux__)
+static const uint64_t kFloatInspectorPerfEvents[kFloatInspectorPerfNumberOfCounters] = {
+	PERF_COUNT_HW_CPU_CYCLES,
+	PERF_COUNT_HW_INSTRUCTIONS,
+	PERF_COUNT_HW_CACHE_MISSES,
+	PERF_COUNT_HW_BRANCH_MISSES
+};
+#endif
+
+#pragma mark Globals
+
+int FloatInspectorPerfEnabled = 0;
+
+/* Hardware counters were asked for.  */
+static int FloatInspectorPerfHardware = 0;
+
+static pthread_mutex_t FloatInspectorPerfLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t FloatInspectorPerfOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t FloatInspectorPerfKey;
+
+/* Threads that recorded anything, and the totals of those that exited.  */
+static FloatInspectorPerfThread *FloatInspectorPerfThreads = NULL;
+static FloatInspectorPerfEntry 
+FloatInspectorPerfRetired[kFloatInspectorPerfNumberOfTypes][kFloatInspectorPerfNumberOfPaths];
+
+static __thread FloatInspectorPerfThread *FloatInspectorPerfCurrent = NULL;
+
+#pragma mark Private Function Prototypes
+
+static void FloatInspectorPerfInitialize(void);
+
+static FloatInspectorPerfThread *FloatInspectorPerfCurrentThread(void);
+
+static void FloatInspectorPerfOpenCounters(FloatInspectorPerfThread *thread);
+
+static int FloatInspectorPerfReadCounters(FloatInspectorPerfThread *thread,
+										  unsigned long long *counts,
+										  double *enabled,
+										  double *running);
+
+static void FloatInspectorPerfThreadExit(void *context);
+
+static void FloatInspectorPerfAdd(FloatInspectorPerfEntry *dst,
+								  const FloatInspectorPerfEntry *src);
+
+static double FloatInspectorPerfNow(void);
+
+#pragma mark Private Functions Implementations
+
+static void 
+FloatInspectorPerfInitialize(void) {
+	
+	pthread_key_create(&FloatInspectorPerfKey, FloatInspectorPerfThreadExit);
+}
+
+/* Returns the calling thread's record or NULL if out of memory.  */
+static FloatInspectorPerfThread *
+FloatInspectorPerfCurrentThread(void) {
+	
+	FloatInspectorPerfThread *thread = FloatInspectorPerfCurrent;
+	
+	if (__builtin_expect(thread == NULL, 0)) {
+		
+		pthread_once(&FloatInspectorPerfOnce, FloatInspectorPerfInitialize);
+		
+		thread = calloc(1, sizeof(FloatInspectorPerfThread));
+		
+		if (thread == NULL) {
+			
+			return NULL;
+		}
+		
+		pthread_mutex_init(&thread->lock, NULL);
+		thread->leader = -1;
+		
+		for (unsigned int c = 0; c < kFloatInspectorPerfNumberOfCounters; c++) {
+			
+			thread->fds[c] = thread->slots[c] = -1;
+		}
+		
+		pthread_mutex_lock(&FloatInspectorPerfLock);
+		thread->next = FloatInspectorPerfThreads;
+		FloatInspectorPerfThreads = thread;
+		pthread_mutex_unlock(&FloatInspectorPerfLock);
+		
+		pthread_setspecific(FloatInspectorPerfKey, thread);
+		FloatInspectorPerfCurrent = thread;
+	}
+	
+	return thread;
+}
+
+/* Opens the counters of the calling thread as one group led by the cycle
+ * counter, so they are scheduled together and read with one call. User 
+ * space only, which most perf_event_paranoid settings allow. Counters the
+ * processor or a virtual machine lacks are left out.  */
+static void 
+FloatInspectorPerfOpenCounters(FloatInspectorPerfThread *thread) {
+	
+	thread->tried = 1;
+	
+#if defined(__linux__)
+	unsigned int nOpen = 0;
+	
+	for (unsigned int c = 0; c < kFloatInspectorPerfNumberOfCounters; c++) {
+		
+		struct perf_event_attr attr;
+		
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.config = kFloatInspectorPerfEvents[c];
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_GROUP | 
+			PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+		
+		const int fd = (int) syscall(SYS_perf_event_open, &attr, 0, -1, thread->leader, 
+									 PERF_FLAG_FD_CLOEXEC);
+		
+		if (fd == -1) {
+			
+			if (c == CyclesCounter) {
+				
+				return;
+			}
+			
+			continue;
+		}
+		
+		if (thread->leader == -1) {
+			
+			thread->leader = fd;
+		}
+		
+		thread->fds[c] = fd;
+		thread->slots[c] = (int) nOpen++;
+		thread->counters |= 1u << c;
+	}
+#endif
+}
+
+/* Reads the group, returns 0 on success.  */
+static int 
+FloatInspectorPerfReadCounters(FloatInspectorPerfThread *thread,
+							   unsigned long long *counts,
+							   double *enabled,
+							   double *running) {
+	
+	uint64_t values[3 + kFloatInspectorPerfNumberOfCounters];
+	const ssize_t size = read(thread->leader, values, sizeof(values));
+	
+	if ((size < (ssize_t) (3 * sizeof(uint64_t))) || 
+		(size < (ssize_t) ((3 + values[0]) * sizeof(uint64_t)))) {
+		
+		return -1;
+	}
+	
+	*enabled = (double) values[1];
+	*running = (double) values[2];
+	
+	for (unsigned int c = 0; c < kFloatInspectorPerfNumberOfCounters; c++) {
+		
+		counts[c] = thread->slots[c] >= 0 ? values[3 + thread->slots[c]] : 0;
+	}
+	
+	return 0;
+}
+
+static void 
+FloatInspectorPerfThreadExit(void *context) {
+	
+	FloatInspectorPerfThread *thread = context;
+	
+	pthread_mutex_lock(&FloatInspectorPerfLock);
+	
+	for (FloatInspectorPerfThread **link = &FloatInspectorPerfThreads; 
+		 *link != NULL; 
+		 link = &(*link)->next) {
+		
+		if (*link == thread) {
+			
+			*link = thread->next;
+			break;
+		}
+	}
+	
+	for (unsigned int t = 0; t < kFloatInspectorPerfNumberOfTypes; t++) {
+		for (unsigned int p = 0; p < kFloatInspectorPerfNumberOfPaths; p++) {
+			
+			FloatInspectorPerfAdd(&FloatInspectorPerfRetired[t][p], &thread->entries[t][p]);
+		}
+	}
+	
+	pthread_mutex_unlock(&FloatInspectorPerfLock);
+	
+	for (unsigned int c = 0; c < kFloatInspectorPerfNumberOfCounters; c++) {
+		
+		if (thread->fds[c] != -1) close(thread->fds[c]);
+	}
+	
+	pthread_mutex_destroy(&thread->lock);
+	free(thread);
+	FloatInspectorPerfCurrent = NULL;
+}
+
+static void 
+FloatInspectorPerfAdd(FloatInspectorPerfEntry *dst, const FloatInspectorPerfEntry *src) {
+	
+	dst->nCalls			+= __atomic_load_n(&src->nCalls, __ATOMIC_RELAXED);
+	dst->nPhases		+= src->nPhases;
+	dst->nValues		+= src->nValues;
+	dst->seconds		+= src->seconds;
+	dst->nCounted		+= src->nCounted;
+	dst->nCountedValues	+= src->nCountedValues;
+	dst->counters		|= src->counters;
+	
+	for (unsigned int c = 0; c < kFloatInspectorPerfNumberOfCounters; c++) {
+		
+		dst->counts[c] += src->counts[c];
+	}
+}
+
+static double 
+FloatInspectorPerfNow(void) {
+	
+	struct timespec now;
+	
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	
+	return (double) now.tv_sec + 1e-9 * (double) now.tv_nsec;
+}
+
+#pragma mark Public Functions Implementations
+
+int 
+FloatInspectorPerfEnable(int hardware) {
+	
+	FloatInspectorPerfThread *thread = FloatInspectorPerfCurrentThread();
+	
+	__atomic_store_n(&FloatInspectorPerfHardware, hardware != 0, __ATOMIC_RELAXED);
+	__atomic_store_n(&FloatInspectorPerfEnabled, 1, __ATOMIC_RELEASE);
+	
+	if ((thread == NULL) || !hardware) {
+		
+		return 0;
+	}
+	
+	if (!thread->tried) {
+		
+		FloatInspectorPerfOpenCounters(thread);
+	}
+	
+	return thread->leader != -1;
+}
+
+void 
+FloatInspectorPerfDisable(void) {
+	
+	__atomic_store_n(&FloatInspectorPerfEnabled, 0, __ATOMIC_RELEASE);
+}
+
+int 
+FloatInspectorPerfIsEnabled(void) {
+	
+	return __atomic_load_n(&FloatInspectorPerfEnabled, __ATOMIC_ACQUIRE);
+}
+
+void 
+FloatInspectorPerfReset(void) {
+	
+	pthread_mutex_lock(&FloatInspectorPerfLock);
+	
+	memset(FloatInspectorPerfRetired, 0, sizeof(FloatInspectorPerfRetired));
+	
+	for (FloatInspectorPerfThread *thread = FloatInspectorPerfThreads; 
+		 thread != NULL; 
+		 thread = thread->next) {
+		
+		pthread_mutex_lock(&thread->lock);
+		
+		for (unsigned int t = 0; t < kFloatInspectorPerfNumberOfTypes; t++) {
+			for (unsigned int p = 0; p < kFloatInspectorPerfNumberOfPaths; p++) {
+				
+				FloatInspectorPerfEntry *entry = &thread->entries[t][p];
+				
+				__atomic_store_n(&entry->nCalls, 0, __ATOMIC_RELAXED);
+				entry->nPhases = entry->nValues = 0;
+				entry->seconds = 0.;
+				entry->nCounted = entry->nCountedValues = 0;
+				entry->counters = 0;
+				memset(entry->counts, 0, sizeof(entry->counts));
+			}
+		}
+		
+		pthread_mutex_unlock(&thread->lock);
+	}
+	
+	pthread_mutex_unlock(&FloatInspectorPerfLock);
+}
+
+void 
+FloatInspectorPerfMarkWorkerThread(void) {
+	
+	FloatInspectorPerfThread *thread = FloatInspectorPerfCurrentThread();
+	
+	if (thread != NULL) {
+		
+		thread->worker = 1;
+	}
+}
+
+/* Counters are read before the clock and after it at the end, so the 
+ * phase's time does not include the reads.  */
+void 
+FloatInspectorPerfBegin(FloatInspectorPerfPhase *phase,
+						enum PrecisionType type,
+						FloatInspectorPerfPath path) {
+	
+	phase->measured = phase->nested = 0;
+	
+	if (!__atomic_load_n(&FloatInspectorPerfEnabled, __ATOMIC_RELAXED)) {
+		
+		return;
+	}
+	
+	FloatInspectorPerfThread *thread = FloatInspectorPerfCurrentThread();
+	
+	if (thread == NULL) {
+		
+		return;
+	}
+	
+	if ((path == BulkPath) && thread->worker) {
+		
+		path = ThreadedPath;
+	}
+	
+	if (path != ScalarPath) {
+		
+		FloatInspectorPerfEntry *entry = &thread->entries[type][path];
+		
+		__atomic_store_n(&entry->nCalls, 
+						 __atomic_load_n(&entry->nCalls, __ATOMIC_RELAXED) + 1, 
+						 __ATOMIC_RELAXED);
+	}
+	
+	if (thread->depth++ != 0) {
+		
+		phase->nested = 1;
+		return;
+	}
+	
+	if (__atomic_load_n(&FloatInspectorPerfHardware, __ATOMIC_RELAXED) && !thread->tried) {
+		
+		FloatInspectorPerfOpenCounters(thread);
+	}
+	
+	phase->type = type;
+	phase->path = path;
+	phase->measured = 1;
+	phase->counted = __atomic_load_n(&FloatInspectorPerfHardware, __ATOMIC_RELAXED) && 
+		(thread->leader != -1) &&
+		(FloatInspectorPerfReadCounters(thread, phase->counts, 
+										&phase->enabled, &phase->running) == 0);
+	phase->start = FloatInspectorPerfNow();
+}
+
+void 
+FloatInspectorPerfEnd(FloatInspectorPerfPhase *phase, size_t nValues) {
+	
+	FloatInspectorPerfThread *thread = FloatInspectorPerfCurrent;
+	
+	if ((thread == NULL) || !(phase->measured || phase->nested)) {
+		
+		return;
+	}
+	
+	thread->depth--;
+	
+	if (phase->nested) {
+		
+		return;
+	}
+	
+	const double seconds = FloatInspectorPerfNow() - phase->start;
+	unsigned long long counts[kFloatInspectorPerfNumberOfCounters];
+	double enabled, running;
+	
+	const int counted = phase->counted && 
+		(FloatInspectorPerfReadCounters(thread, counts, &enabled, &running) == 0);
+	
+	/* Scaled by the share of the phase the group was actually counting.  */
+	const double scale = counted && (running > phase->running) ? 
+		(enabled - phase->enabled) / (running - phase->running) : 1.;
+	FloatInspectorPerfEntry *entry = &thread->entries[phase->type][phase->path];
+	
+	pthread_mutex_lock(&thread->lock);
+	
+	entry->nPhases++;
+	entry->nValues += nValues;
+	entry->seconds += seconds;
+	
+	if (counted) {
+		
+		entry->nCounted++;
+		entry->nCountedValues += nValues;
+		entry->counters |= thread->counters;
+		
+		for (unsigned int c = 0; c < kFloatInspectorPerfNumberOfCounters; c++) {
+			
+			entry->counts[c] += 
+				(unsigned long long) ((double) (counts[c] - phase->counts[c]) * scale + .5);
+		}
+	}
+	
+	pthread_mutex_unlock(&thread->lock);
+}
+
+void 
+FloatInspectorPerfCountScalar(enum PrecisionType type) {
+	
+	FloatInspectorPerfThread *thread = FloatInspectorPerfCurrentThread();
+	
+	if (thread != NULL) {
+		
+		FloatInspectorPerfEntry *entry = &thread->entries[type][ScalarPath];
+		
+		__atomic_store_n(&entry->nCalls, 
+						 __atomic_load_n(&entry->nCalls, __ATOMIC_RELAXED) + 1, 
+						 __ATOMIC_RELAXED);
+	}
+}
+
+void 
+FloatInspectorPerfTotals(enum PrecisionType type,
+						 FloatInspectorPerfPath path,
+						 FloatInspectorPerfEntry *entry) {
+	
+	memset(entry, 0, sizeof(FloatInspectorPerfEntry));
+	
+	pthread_mutex_lock(&FloatInspectorPerfLock);
+	
+	FloatInspectorPerfAdd(entry, &FloatInspectorPerfRetired[type][path]);
+	
+	for (FloatInspectorPerfThread *thread = FloatInspectorPerfThreads; 
+		 thread != NULL; 
+		 thread = thread->next) {
+		
+		pthread_mutex_lock(&thread->lock);
+		FloatInspectorPerfAdd(entry, &thread->entries[type][path]);
+		pthread_mutex_unlock(&thread->lock);
+	}
+	
+	pthread_mutex_unlock(&FloatInspectorPerfLock);
+}
+
+void 
+FloatInspectorPerfPrint(FILE *restrict stream) {
+	
+	for (unsigned int t = 0; t < kFloatInspectorPerfNumberOfTypes; t++) {
+		
+		FloatInspectorPerfPrintType((enum PrecisionType) t, stream);
+	}
+}
+
+void 
+FloatInspectorPerfPrintType(enum PrecisionType type, FILE *restrict stream) {
+	
+	FloatInspectorPerfEntry entries[kFloatInspectorPerfNumberOfPaths];
+	int used = 0;
+	
+	for (unsigned int p = 0; p < kFloatInspectorPerfNumberOfPaths; p++) {
+		
+		FloatInspectorPerfTotals(type, (FloatInspectorPerfPath) p, &entries[p]);
+		used |= entries[p].nCalls != 0;
+	}
+	
+	if (!used) {
+		
+		return;
+	}
+	
+	fprintf(stream, "--- Performance (%s) ---\n\n", kFloatInspectorPerfTypeNames[type]);
+	
+	for (unsigned int p = 0; p < kFloatInspectorPerfNumberOfPaths; p++) {
+		
+		const FloatInspectorPerfEntry *entry = &entries[p];
+		
+		if (entry->nCalls == 0) {
+			
+			continue;
+		}
+		
+		fprintf(stream, "%s path: %llu calls", kFloatInspectorPerfPathNames[p], entry->nCalls);
+		
+		if (entry->nPhases == 0) {
+			
+			fprintf(stream, ", not measured.\n");
+			continue;
+		}
+		
+		fprintf(stream, ", %llu values in %llu phases, %.6f s (%.2f ns per value)",
+				entry->nValues, entry->nPhases, entry->seconds,
+				entry->nValues != 0 ? 1e9 * entry->seconds / (double) entry->nValues : 0.);
+		
+		if (entry->nCountedValues == 0) {
+			
+			fprintf(stream, ", no hardware counters.\n");
+			continue;
+		}
+		
+		const double n = (double) entry->nCountedValues;
+		
+		fprintf(stream, ",\n");
+		
+		for (unsigned int c = 0; c < kFloatInspectorPerfNumberOfCounters; c++) {
+			
+			static const char *names[kFloatInspectorPerfNumberOfCounters] = {
+				"cycles", "instructions", "LLC misses", "branch misses"
+			};
+			
+			if (entry->counters & (1u << c)) {
+				
+				fprintf(stream, "%.3f %s", (double) entry->counts[c] / n, names[c]);
+			}
+			else {
+				
+				fprintf(stream, "no %s", names[c]);
+			}
+			
+			fprintf(stream, c + 1 < kFloatInspectorPerfNumberOfCounters ? ", " : " per value");
+		}
+		
+		if ((entry->counters & 3u) == 3u) {
+			
+			fprintf(stream, ", %.2f instructions per cycle", 
+					(double) entry->counts[InstructionsCounter] / 
+					(double) entry->counts[CyclesCounter]);
+		}
+		
+		fprintf(stream, ".\n");
+	}
+	
+	fprintf(stream, "\n");
+}
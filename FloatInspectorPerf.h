@@ -0,0 +1,154 @@
+//
+//  FloatInspectorPerf.h
+//  FloatInspector
+//  
+//  Copyright 2011 Stefan Reinhold <stefan@sreinhold.com>. All rights reserved.
+//  
+//  Redistribution and use in source and binary forms, with or without modification, are
+//  permitted provided that the following conditions are met:
+//  
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//  
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list
+//  of conditions and the following disclaimer in the documentation and/or other materials
+//  provided with the distribution.
+//  
+//  THIS SOFTWARE IS PROVIDED BY STEFAN REINHOLD ``AS IS'' AND ANY EXPRESS OR IMPLIED
+//  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STEFAN REINHOLD OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+//  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+//  ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//  
+//  The views and conclusions contained in the software and documentation are those of the
+//  authors and should not be interpreted as representing official policies, either expressed
+//  or implied, of Stefan Reinhold.
+//  
+
+
+
+#ifndef FloatInspector_FloatInspectorPerf_h
+#define FloatInspector_FloatInspectorPerf_h
+
+#include "FloatInspector.h"
+
+#pragma mark Data Types
+
+/* Optional instrumentation of the update paths. While enabled, every bulk
+ * update is a phase that is timed and, where the kernel lets a thread 
+ * count its own hardware events (perf_event_open on Linux), measured in 
+ * cycles, instructions, last level cache misses and branch misses. Phases
+ * are attributed to the format and the path they ran on, counts are kept
+ * per thread and summed for reports. Per value updates are too short to 
+ * be bracketed by counter reads, they are only counted, unless the caller
+ * brackets a loop of them with a phase of its own. Phases nest, only the
+ * outermost phase of a thread is measured.  */
+typedef enum {
+	/* Per value updates.  */
+	ScalarPath = 0,
+	/* Array updates on the calling thread, the vector kernels of the 
+	 * moments and the exponent histogram run inside them.  */
+	BulkPath = 1,
+	/* Array updates on worker threads (watcher, crawl, tool).  */
+	ThreadedPath = 2
+} FloatInspectorPerfPath;
+
+typedef enum {
+	CyclesCounter = 0,
+	InstructionsCounter = 1,
+	CacheMissesCounter = 2,
+	BranchMissesCounter = 3
+} FloatInspectorPerfCounter;
+
+#define kFloatInspectorPerfNumberOfPaths	3
+#define kFloatInspectorPerfNumberOfCounters	4
+
+/* Totals of one format and path.  */
+typedef struct {
+	
+	/* Update calls, measured or not.  */
+	unsigned long long nCalls;
+	/* Measured phases, the values they covered and their wall time.  */
+	unsigned long long nPhases;
+	unsigned long long nValues;
+	double seconds;
+	/* Phases measured with hardware counters, the values they covered and
+	 * the counts, scaled up where the kernel multiplexed the counters. 
+	 * counters has bit 1 << FloatInspectorPerfCounter set for the counters 
+	 * that could be opened.  */
+	unsigned long long nCounted;
+	unsigned long long nCountedValues;
+	unsigned int counters;
+	unsigned long long counts[kFloatInspectorPerfNumberOfCounters];
+	
+} FloatInspectorPerfEntry;
+
+/* A phase in progress, lives on the stack of the measuring thread.  */
+typedef struct {
+	
+	enum PrecisionType type;
+	FloatInspectorPerfPath path;
+	/* Outermost phase of its thread, or one nested in it.  */
+	int measured;
+	int nested;
+	int counted;
+	double start;
+	unsigned long long counts[kFloatInspectorPerfNumberOfCounters];
+	double enabled;
+	double running;
+	
+} FloatInspectorPerfPhase;
+
+#pragma mark Globals
+
+/* Read by the update paths, use FloatInspectorPerfIsEnabled.  */
+extern int FloatInspectorPerfEnabled;
+
+#pragma mark Public Functions
+
+/* Starts recording, with hardware counters if requested and available. 
+ * Returns 1 if the calling thread could open them and 0 if phases are 
+ * only timed.  */
+int FloatInspectorPerfEnable(int hardware);
+
+/* Stops recording, the totals are kept.  */
+void FloatInspectorPerfDisable(void);
+
+int FloatInspectorPerfIsEnabled(void);
+
+/* Clears the totals of all threads.  */
+void FloatInspectorPerfReset(void);
+
+/* Array updates of the calling thread count as ThreadedPath from now on.
+ * Called by the worker threads of the library, and by those of callers 
+ * that want them reported apart.  */
+void FloatInspectorPerfMarkWorkerThread(void);
+
+/* Brackets a phase on the calling thread. BulkPath phases of worker 
+ * threads are recorded as ThreadedPath.  */
+void FloatInspectorPerfBegin(FloatInspectorPerfPhase *phase,
+							 enum PrecisionType type,
+							 FloatInspectorPerfPath path);
+
+void FloatInspectorPerfEnd(FloatInspectorPerfPhase *phase, size_t nValues);
+
+/* Counts a per value update, called by the scalar paths.  */
+void FloatInspectorPerfCountScalar(enum PrecisionType type);
+
+/* Totals of a format and path over all threads, including exited ones.  */
+void FloatInspectorPerfTotals(enum PrecisionType type,
+							  FloatInspectorPerfPath path,
+							  FloatInspectorPerfEntry *entry);
+
+/* Prints the totals of every format and path that was used.  */
+void FloatInspectorPerfPrint(FILE *restrict stream);
+
+/* Prints the totals of one format, FloatInspectorStatisticsPrint appends 
+ * them while recording is enabled.  */
+void FloatInspectorPerfPrintType(enum PrecisionType type, FILE *restrict stream);
+
+#endif
@@ -0,0 +1,662 @@
+//
+//  FloatInspectorQuantiles.c
+//  FloatInspector
+//  
+//  Copyright 2011 Stefan Reinhold <stefan@sreinhold.com>. All rights reserved.
+//  
+//  Redistribution and use in source and binary forms, with or without modification, are
+//  permitted provided that the following conditions are met:
+//  
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//  
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list
+//  of conditions and the following disclaimer in the documentation and/or other materials
+//  provided with the distribution.
+//  
+//  THIS SOFTWARE IS PROVIDED BY STEFAN REINHOLD ``AS IS'' AND ANY EXPRESS OR IMPLIED
+//  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STEFAN REINHOLD OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+//  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+//  ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//  
+//  The views and conclusions contained in the software and documentation are those of the
+//  authors and should not be interpreted as representing official policies, either expressed
+//  or implied, of Stefan Reinhold.
+//  
+
+
+
+
+#include "FloatInspectorQuantiles.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#pragma mark Constants
+
+/* Enough levels for 2^60 values at the smallest k.  */
+#define kFloatInspectorQuantilesMaxLevels	60
+/* Lower bound of a level's capacity, keeps compactions of the lowest 
+ * levels from degenerating to single items.  */
+#define kFloatInspectorQuantilesMinWidth	8
+/* Partitions sorted by insertion sort.  */
+#define kFloatInspectorQuantilesSmallSort	16
+/* Values collected by level 0 at least, large enough for radix sorting.  */
+#define kFloatInspectorQuantilesMinBuffer	2048
+
+#pragma mark Data Types
+
+struct _FloatInspectorQuantiles {
+	
+	unsigned int k;
+	unsigned int nLevels;
+	uint64_t n;
+	
+	/* Exact extremes, the compactors may drop them.  */
+	double minimum;
+	double maximum;
+	
+	/* State of the coin deciding which half of a level survives.  */
+	uint64_t random;
+	
+	/* Level h holds items of weight 2^h. Level 0 is unsorted, all others 
+	 * are kept sorted so compactions only have to sort level 0.  */
+	double *levels[kFloatInspectorQuantilesMaxLevels];
+	uint32_t sizes[kFloatInspectorQuantilesMaxLevels];
+	uint32_t allocated[kFloatInspectorQuantilesMaxLevels];
+	
+	/* Capacity of a level by its distance from the top level.  */
+	uint32_t capacities[kFloatInspectorQuantilesMaxLevels];
+	
+	/* Radix sort buffers for level 0.  */
+	uint64_t *keys;
+	uint64_t *sortedKeys;
+};
+
+/* A retained item and its weight, used to answer queries.  */
+typedef struct {
+	
+	double value;
+	uint64_t weight;
+	
+} FloatInspectorQuantilesItem;
+
+#pragma mark Private Functions Implementations
+
+static inline uint32_t 
+FloatInspectorQuantilesCapacity(const FloatInspectorQuantilesRef sketch,
+								unsigned int level) {
+	
+	return sketch->capacities[sketch->nLevels - 1 - level];
+}
+
+/* Level 0 collects a large batch before it is compacted. Compacting less 
+ * often only lowers the error, and the batch can be radix sorted.  */
+static inline uint32_t 
+FloatInspectorQuantilesBufferSize(const FloatInspectorQuantilesRef sketch) {
+	
+	return sketch->k > kFloatInspectorQuantilesMinBuffer ? 
+		sketch->k : kFloatInspectorQuantilesMinBuffer;
+}
+
+static int 
+FloatInspectorQuantilesReserve(FloatInspectorQuantilesRef sketch,
+							   unsigned int level,
+							   size_t size) {
+	
+	if (size <= sketch->allocated[level]) {
+		
+		return 0;
+	}
+	
+	size_t allocated = 2 * (size_t) sketch->allocated[level];
+	
+	if (allocated < size) {
+		
+		allocated = size;
+	}
+	
+	if (allocated > UINT32_MAX) {
+		
+		return -1;
+	}
+	
+	double *items = realloc(sketch->levels[level], allocated * sizeof(double));
+	
+	if (items == NULL) {
+		
+		return -1;
+	}
+	
+	sketch->levels[level] = items;
+	sketch->allocated[level] = (uint32_t) allocated;
+	
+	return 0;
+}
+
+/* Quicksort without the indirection of qsort, levels are sorted on every 
+ * compaction.  */
+static void 
+FloatInspectorQuantilesSort(double *values, size_t n) {
+	
+	while (n > kFloatInspectorQuantilesSmallSort) {
+		
+		/* Median of three pivot.  */
+		double a = values[0], b = values[n / 2], c = values[n - 1];
+		const double pivot = a < b ? (b < c ? b : (a < c ? c : a)) : (a < c ? a : (b < c ? c : b));
+		
+		size_t i = 0;
+		size_t j = n - 1;
+		
+		for (;;) {
+			
+			while (values[i] < pivot) i++;
+			while (values[j] > pivot) j--;
+			
+			if (i >= j) {
+				
+				break;
+			}
+			
+			const double value = values[i];
+			values[i] = values[j];
+			values[j] = value;
+			i++;
+			j--;
+		}
+		
+		/* Recurse into the smaller part, loop over the larger one.  */
+		if (j + 1 < n - j - 1) {
+			
+			FloatInspectorQuantilesSort(values, j + 1);
+			values += j + 1;
+			n -= j + 1;
+		}
+		else {
+			
+			FloatInspectorQuantilesSort(values + j + 1, n - j - 1);
+			n = j + 1;
+		}
+	}
+	
+	for (size_t i = 1; i < n; i++) {
+		
+		const double value = values[i];
+		size_t j = i;
+		
+		while ((j > 0) && (values[j - 1] > value)) {
+			
+			values[j] = values[j - 1];
+			j--;
+		}
+		
+		values[j] = value;
+	}
+}
+
+/* LSD radix sort on order preserving integer keys, bytes that are equal 
+ * for all values (e.g. the exponent of values of similar magnitude) are 
+ * skipped.  */
+static void 
+FloatInspectorQuantilesRadixSort(FloatInspectorQuantilesRef sketch,
+								 double *values,
+								 size_t n) {
+	
+	uint32_t counts[8][256];
+	uint64_t *keys = sketch->keys;
+	uint64_t *sortedKeys = sketch->sortedKeys;
+	
+	memset(counts, 0, sizeof(counts));
+	
+	for (size_t i = 0; i < n; i++) {
+		
+		uint64_t bits;
+		memcpy(&bits, &values[i], sizeof(bits));
+		
+		/* Flip all bits of negative values, only the sign of positive ones.  */
+		keys[i] = bits ^ ((uint64_t) ((int64_t) bits >> 63) | (UINT64_C(1) << 63));
+		
+		for (unsigned int digit = 0; digit < 8; digit++) {
+			
+			counts[digit][(keys[i] >> (8 * digit)) & 0xff]++;
+		}
+	}
+	
+	for (unsigned int digit = 0; digit < 8; digit++) {
+		
+		if (counts[digit][keys[0] >> (8 * digit) & 0xff] == n) {
+			
+			continue;
+		}
+		
+		uint32_t offset = 0;
+		
+		for (unsigned int bucket = 0; bucket < 256; bucket++) {
+			
+			const uint32_t count = counts[digit][bucket];
+			counts[digit][bucket] = offset;
+			offset += count;
+		}
+		
+		for (size_t i = 0; i < n; i++) {
+			
+			sortedKeys[counts[digit][(keys[i] >> (8 * digit)) & 0xff]++] = keys[i];
+		}
+		
+		uint64_t *swap = keys;
+		keys = sortedKeys;
+		sortedKeys = swap;
+	}
+	
+	for (size_t i = 0; i < n; i++) {
+		
+		const uint64_t bits = keys[i] ^ 
+			((uint64_t) ((int64_t) ~keys[i] >> 63) | (UINT64_C(1) << 63));
+		memcpy(&values[i], &bits, sizeof(bits));
+	}
+}
+
+/* Merges the sorted values into the sorted level, from the back so no 
+ * scratch space is needed.  */
+static int 
+FloatInspectorQuantilesMergeInto(FloatInspectorQuantilesRef sketch,
+								 unsigned int level,
+								 const double *values,
+								 size_t n) {
+	
+	const size_t size = sketch->sizes[level];
+	
+	if (FloatInspectorQuantilesReserve(sketch, level, size + n) != 0) {
+		
+		return -1;
+	}
+	
+	double *items = sketch->levels[level];
+	size_t i = size;
+	size_t j = n;
+	size_t k = size + n;
+	
+	while (j > 0) {
+		
+		if ((i > 0) && (items[i - 1] > values[j - 1])) {
+			
+			items[--k] = items[--i];
+		}
+		else {
+			
+			items[--k] = values[--j];
+		}
+	}
+	
+	sketch->sizes[level] = (uint32_t) (size + n);
+	
+	return 0;
+}
+
+/* Halves every level that reached its capacity, promoting every other item
+ * of the sorted level to the next one.  */
+static int 
+FloatInspectorQuantilesCompress(FloatInspectorQuantilesRef sketch) {
+	
+	for (unsigned int h = 0; h < sketch->nLevels; h++) {
+		
+		const uint32_t capacity = h == 0 ? 
+			FloatInspectorQuantilesBufferSize(sketch) : 
+			FloatInspectorQuantilesCapacity(sketch, h);
+		
+		if (sketch->sizes[h] < capacity) {
+			
+			continue;
+		}
+		
+		if (h + 1 == sketch->nLevels) {
+			
+			if (sketch->nLevels == kFloatInspectorQuantilesMaxLevels) {
+				
+				return -1;
+			}
+			
+			sketch->sizes[sketch->nLevels++] = 0;
+		}
+		
+		const uint32_t size = sketch->sizes[h];
+		const uint32_t odd = size & 1;
+		const uint32_t nPromoted = (size - odd) / 2;
+		
+		double *items = sketch->levels[h];
+		
+		if ((h == 0) && (size <= FloatInspectorQuantilesBufferSize(sketch))) {
+			
+			FloatInspectorQuantilesRadixSort(sketch, items, size);
+		}
+		else if (h == 0) {
+			
+			/* Merges may overfill level 0.  */
+			FloatInspectorQuantilesSort(items, size);
+		}
+		
+		/* The odd item stays, it keeps its weight.  */
+		const double last = items[size - 1];
+		
+		sketch->random ^= sketch->random << 13;
+		sketch->random ^= sketch->random >> 7;
+		sketch->random ^= sketch->random << 17;
+		
+		/* Gather the survivors at the front, they stay sorted.  */
+		for (uint32_t i = 0, j = (uint32_t) (sketch->random & 1); i < nPromoted; i++, j += 2) {
+			
+			items[i] = items[j];
+		}
+		
+		if (FloatInspectorQuantilesMergeInto(sketch, h + 1, items, nPromoted) != 0) {
+			
+			return -1;
+		}
+		
+		/* The reserve may have moved level h + 1 only.  */
+		items[0] = last;
+		sketch->sizes[h] = odd;
+	}
+	
+	return 0;
+}
+
+static int 
+FloatInspectorQuantilesCompareItems(const void *a, const void *b) {
+	
+	const double x = ((const FloatInspectorQuantilesItem *) a)->value;
+	const double y = ((const FloatInspectorQuantilesItem *) b)->value;
+	
+	return (x > y) - (x < y);
+}
+
+#pragma mark Public Functions Implementations
+
+FloatInspectorQuantilesRef 
+FloatInspectorQuantilesCreate(unsigned int k) {
+	
+	if ((k < kFloatInspectorQuantilesMinWidth) || (k > (1u << 24))) {
+		
+		return NULL;
+	}
+	
+	FloatInspectorQuantilesRef sketch = calloc(1, sizeof(struct _FloatInspectorQuantiles));
+	
+	if (sketch == NULL) {
+		
+		return NULL;
+	}
+	
+	sketch->k = k;
+	sketch->keys = malloc(FloatInspectorQuantilesBufferSize(sketch) * sizeof(uint64_t));
+	sketch->sortedKeys = malloc(FloatInspectorQuantilesBufferSize(sketch) * sizeof(uint64_t));
+	
+	if ((sketch->keys == NULL) || (sketch->sortedKeys == NULL)) {
+		
+		FloatInspectorQuantilesFree(sketch);
+		return NULL;
+	}
+	
+	/* The top level holds k items, every level below 2/3 of the one above.  */
+	double capacity = k;
+	
+	for (unsigned int i = 0; i < kFloatInspectorQuantilesMaxLevels; i++) {
+		
+		sketch->capacities[i] = capacity > kFloatInspectorQuantilesMinWidth ? 
+			(uint32_t) ceil(capacity) : kFloatInspectorQuantilesMinWidth;
+		capacity *= 2. / 3.;
+	}
+	
+	FloatInspectorQuantilesReset(sketch);
+	
+	return sketch;
+}
+
+FloatInspectorQuantilesRef 
+FloatInspectorQuantilesCopy(const FloatInspectorQuantilesRef sketch) {
+	
+	FloatInspectorQuantilesRef copy = FloatInspectorQuantilesCreate(sketch->k);
+	
+	if (copy == NULL) {
+		
+		return NULL;
+	}
+	
+	copy->nLevels = sketch->nLevels;
+	copy->n = sketch->n;
+	copy->minimum = sketch->minimum;
+	copy->maximum = sketch->maximum;
+	copy->random = sketch->random;
+	
+	for (unsigned int h = 0; h < sketch->nLevels; h++) {
+		
+		if (FloatInspectorQuantilesReserve(copy, h, sketch->sizes[h]) != 0) {
+			
+			FloatInspectorQuantilesFree(copy);
+			return NULL;
+		}
+		
+		/* Empty levels may have no buffer yet.  */
+		if (sketch->sizes[h] != 0) {
+			
+			memcpy(copy->levels[h], sketch->levels[h], sketch->sizes[h] * sizeof(double));
+		}
+		
+		copy->sizes[h] = sketch->sizes[h];
+	}
+	
+	return copy;
+}
+
+void 
+FloatInspectorQuantilesReset(FloatInspectorQuantilesRef sketch) {
+	
+	sketch->nLevels = 1;
+	sketch->n = 0;
+	sketch->minimum = INFINITY;
+	sketch->maximum = -INFINITY;
+	sketch->random = 0x2545f4914f6cdd1dULL;
+	
+	memset(sketch->sizes, 0, sizeof(sketch->sizes));
+}
+
+int 
+FloatInspectorQuantilesMerge(FloatInspectorQuantilesRef dst,
+							 const FloatInspectorQuantilesRef src) {
+	
+	if (dst->k != src->k) {
+		
+		return -1;
+	}
+	
+	for (unsigned int h = 0; h < src->nLevels; h++) {
+		
+		if (h == dst->nLevels) {
+			
+			dst->sizes[dst->nLevels++] = 0;
+		}
+		
+		if (h > 0) {
+			
+			if (FloatInspectorQuantilesMergeInto(dst, h, src->levels[h], src->sizes[h]) != 0) {
+				
+				return -1;
+			}
+			
+			continue;
+		}
+		
+		if (FloatInspectorQuantilesReserve(dst, h, 
+										   (size_t) dst->sizes[h] + src->sizes[h]) != 0) {
+			
+			return -1;
+		}
+		
+		if (src->sizes[h] != 0) {
+			
+			memcpy(dst->levels[h] + dst->sizes[h], src->levels[h], 
+				   src->sizes[h] * sizeof(double));
+			dst->sizes[h] += src->sizes[h];
+		}
+	}
+	
+	dst->n += src->n;
+	dst->minimum = src->minimum < dst->minimum ? src->minimum : dst->minimum;
+	dst->maximum = src->maximum > dst->maximum ? src->maximum : dst->maximum;
+	
+	return FloatInspectorQuantilesCompress(dst);
+}
+
+void 
+FloatInspectorQuantilesFree(FloatInspectorQuantilesRef sketch) {
+	
+	if (sketch == NULL) {
+		
+		return;
+	}
+	
+	for (unsigned int h = 0; h < kFloatInspectorQuantilesMaxLevels; h++) {
+		
+		free(sketch->levels[h]);
+	}
+	
+	free(sketch->keys);
+	free(sketch->sortedKeys);
+	free(sketch);
+}
+
+int 
+FloatInspectorQuantilesAdd(FloatInspectorQuantilesRef sketch,
+						   const double *restrict values,
+						   size_t n) {
+	
+	while (n > 0) {
+		
+		const uint32_t capacity = FloatInspectorQuantilesBufferSize(sketch);
+		
+		if (sketch->sizes[0] >= capacity) {
+			
+			if (FloatInspectorQuantilesCompress(sketch) != 0) {
+				
+				return -1;
+			}
+			
+			continue;
+		}
+		
+		const size_t nChunk = n < capacity - sketch->sizes[0] ? n : capacity - sketch->sizes[0];
+		
+		if (FloatInspectorQuantilesReserve(sketch, 0, capacity) != 0) {
+			
+			return -1;
+		}
+		
+		double *restrict items = sketch->levels[0] + sketch->sizes[0];
+		double minimum = sketch->minimum;
+		double maximum = sketch->maximum;
+		
+		for (size_t i = 0; i < nChunk; i++) {
+			
+			items[i] = values[i];
+			minimum = values[i] < minimum ? values[i] : minimum;
+			maximum = values[i] > maximum ? values[i] : maximum;
+		}
+		
+		sketch->minimum = minimum;
+		sketch->maximum = maximum;
+		sketch->sizes[0] += (uint32_t) nChunk;
+		sketch->n += nChunk;
+		values += nChunk;
+		n -= nChunk;
+	}
+	
+	return 0;
+}
+
+uint64_t 
+FloatInspectorQuantilesCount(const FloatInspectorQuantilesRef sketch) {
+	
+	return sketch->n;
+}
+
+unsigned int 
+FloatInspectorQuantilesK(const FloatInspectorQuantilesRef sketch) {
+	
+	return sketch->k;
+}
+
+double 
+FloatInspectorQuantilesGet(const FloatInspectorQuantilesRef sketch,
+						   double rank) {
+	
+	if (sketch->n == 0) {
+		
+		return NAN;
+	}
+	
+	if (rank <= 0.) {
+		
+		return sketch->minimum;
+	}
+	
+	if (rank >= 1.) {
+		
+		return sketch->maximum;
+	}
+	
+	size_t nItems = 0;
+	
+	for (unsigned int h = 0; h < sketch->nLevels; h++) {
+		
+		nItems += sketch->sizes[h];
+	}
+	
+	FloatInspectorQuantilesItem *items = malloc(nItems * sizeof(FloatInspectorQuantilesItem) + 1);
+	
+	if (items == NULL) {
+		
+		return NAN;
+	}
+	
+	uint64_t total = 0;
+	size_t i = 0;
+	
+	for (unsigned int h = 0; h < sketch->nLevels; h++) {
+		
+		for (uint32_t j = 0; j < sketch->sizes[h]; j++, i++) {
+			
+			items[i].value = sketch->levels[h][j];
+			items[i].weight = (uint64_t) 1 << h;
+		}
+		
+		total += (uint64_t) sketch->sizes[h] << h;
+	}
+	
+	qsort(items, nItems, sizeof(FloatInspectorQuantilesItem), 
+		  FloatInspectorQuantilesCompareItems);
+	
+	const double target = rank * (double) total;
+	double value = sketch->maximum;
+	uint64_t cumulative = 0;
+	
+	for (i = 0; i < nItems; i++) {
+		
+		cumulative += items[i].weight;
+		
+		if ((double) cumulative >= target) {
+			
+			value = items[i].value;
+			break;
+		}
+	}
+	
+	free(items);
+	
+	return value;
+}
@@ -0,0 +1,89 @@
+//
+//  FloatInspectorQuantiles.h
+//  FloatInspector
+//  
+//  Copyright 2011 Stefan Reinhold <stefan@sreinhold.com>. All rights reserved.
+//  
+//  Redistribution and use in source and binary forms, with or without modification, are
+//  permitted provided that the following conditions are met:
+//  
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//  
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list
+//  of conditions and the following disclaimer in the documentation and/or other materials
+//  provided with the distribution.
+//  
+//  THIS SOFTWARE IS PROVIDED BY STEFAN REINHOLD ``AS IS'' AND ANY EXPRESS OR IMPLIED
+//  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STEFAN REINHOLD OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+//  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+//  ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//  
+//  The views and conclusions contained in the software and documentation are those of the
+//  authors and should not be interpreted as representing official policies, either expressed
+//  or implied, of Stefan Reinhold.
+//  
+
+
+
+#ifndef FloatInspector_FloatInspectorQuantiles_h
+#define FloatInspector_FloatInspectorQuantiles_h
+
+#include <inttypes.h>
+#include <stddef.h>
+
+#pragma mark Data Types
+
+/* KLL quantile sketch over doubles. The compacted levels keep about 3 * k 
+ * values no matter how many were added, the rank error is roughly 1.7 / k.
+ * Level 0 collects batches of max(k, 2048) raw values, and the levels above
+ * it are sized to take in half a batch at once, so a sketch of the default
+ * k takes about 100 KiB. Sketches of the same k can be merged, so per 
+ * thread sketches can be combined later.  */
+typedef struct _FloatInspectorQuantiles *FloatInspectorQuantilesRef;
+
+#pragma mark Constants
+
+/* About 1% rank error.  */
+#define kFloatInspectorQuantilesDefaultK	200
+
+#pragma mark Public Functions
+
+/* Returns an empty sketch or NULL if k is less than 8 or memory is 
+ * exhausted.  */
+FloatInspectorQuantilesRef FloatInspectorQuantilesCreate(unsigned int k);
+
+FloatInspectorQuantilesRef 
+FloatInspectorQuantilesCopy(const FloatInspectorQuantilesRef sketch);
+
+void FloatInspectorQuantilesReset(FloatInspectorQuantilesRef sketch);
+
+/* Folds src into dst. Returns 0 on success and -1 if k differs or memory is
+ * exhausted.  */
+int FloatInspectorQuantilesMerge(FloatInspectorQuantilesRef dst,
+								 const FloatInspectorQuantilesRef src);
+
+void FloatInspectorQuantilesFree(FloatInspectorQuantilesRef sketch);
+
+/* Adds n values, none of them may be NaN. Returns 0 on success and -1 if 
+ * memory is exhausted.  */
+int FloatInspectorQuantilesAdd(FloatInspectorQuantilesRef sketch,
+							   const double *restrict values,
+							   size_t n);
+
+/* Number of values added so far.  */
+uint64_t FloatInspectorQuantilesCount(const FloatInspectorQuantilesRef sketch);
+
+unsigned int FloatInspectorQuantilesK(const FloatInspectorQuantilesRef sketch);
+
+/* Returns the value of the given rank in [0, 1], NAN if the sketch is 
+ * empty. Ranks 0 and 1 return the exact minimum and maximum.  */
+double FloatInspectorQuantilesGet(const FloatInspectorQuantilesRef sketch,
+								  double rank);
+
+#endif
@@ -0,0 +1,702 @@
+//
+//  FloatInspectorSnapshot.c
+//  FloatInspector
+//  
+//  Copyright 2011 Stefan Reinhold <stefan@sreinhold.com>. All rights reserved.
+//  
+//  Redistribution and use in source and binary forms, with or without modification, are
+//  permitted provided that the following conditions are met:
+//  
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//  
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list
+//  of conditions and the following disclaimer in the documentation and/or other materials
+//  provided with the distribution.
+//  
+//  THIS SOFTWARE IS PROVIDED BY STEFAN REINHOLD ``AS IS'' AND ANY EXPRESS OR IMPLIED
+//  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STEFAN REINHOLD OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+//  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+//  ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//  
+//  The views and conclusions contained in the software and documentation are those of the
+//  authors and should not be interpreted as representing official policies, either expressed
+//  or implied, of Stefan Reinhold.
+//  
+
+
+
+#include "FloatInspectorSnapshot.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+
+#pragma mark Data Types
+
+struct _FloatInspectorMonitor {
+	
+	/* Active and idle buffer, producers only touch buffers[active].  */
+	FloatInspectorStatisticsRef buffers[2];
+	unsigned int active;
+	/* Number of producers currently inside a buffer.  */
+	unsigned int nWriters[2];
+	
+	/* Everything drained from the buffers so far.  */
+	FloatInspectorStatisticsRef total;
+	pthread_mutex_t snapshotLock;
+};
+
+#pragma mark Constants
+
+/* Cells compared at once when searching for changes.  */
+#define kFloatInspectorDiffBlockCells 16
+
+/* Magic and version of the delta encoding.  */
+static const uint8_t kFloatInspectorDiffMagic[4] = { 'F', 'I', 'D', 2 };
+
+/* Largest floating point format accepted by the decoder.  */
+#define kFloatInspectorDiffMaxBits 128
+
+#pragma mark Private Function Prototypes
+
+static uint64_t *
+FloatInspectorStatisticsHistogram(const FloatInspectorStatisticsRef stats,
+								  FloatInspectorHistogram histogram);
+
+static size_t 
+FloatInspectorStatisticsHistogramCells(const FloatInspectorStatisticsRef stats,
+									   FloatInspectorHistogram histogram);
+
+static size_t FloatInspectorVarIntEncode(uint8_t *buffer, uint64_t value);
+
+static int FloatInspectorVarIntDecode(const uint8_t **cursor, 
+									  const uint8_t *end,
+									  uint64_t *value);
+
+static int FloatInspectorVarIntDecode32(const uint8_t **cursor, 
+										const uint8_t *end,
+										uint32_t *value);
+
+static int FloatInspectorAddDelta(uint64_t *value, uint64_t delta);
+
+#pragma mark Private Functions Implementations
+
+static uint64_t *
+FloatInspectorStatisticsHistogram(const FloatInspectorStatisticsRef stats,
+								  FloatInspectorHistogram histogram) {
+	
+	switch (histogram) {
+		case NormalizedPositiveHistogram:
+			return stats->nNonZeroBitsNormalizedPositive;
+			
+		case DenormalizedPositiveHistogram:
+			return stats->nNonZeroBitsDenormalizedPositive;
+			
+		case NormalizedNegativeHistogram:
+			return stats->nNonZeroBitsNormalizedNegative;
+			
+		case DenormalizedNegativeHistogram:
+			return stats->nNonZeroBitsDenormalizedNegative;
+	}
+	
+	return NULL;
+}
+
+static size_t 
+FloatInspectorStatisticsHistogramCells(const FloatInspectorStatisticsRef stats,
+									   FloatInspectorHistogram histogram) {
+	
+	if ((histogram == NormalizedPositiveHistogram) || 
+		(histogram == NormalizedNegativeHistogram)) {
+		
+		return FloatInspectorStatisticsNormalizedCells(stats);
+	}
+	
+	return FloatInspectorStatisticsDenormalizedCells(stats);
+}
+
+/* LEB128 style unsigned varint, at most 10 bytes for 64 bit values. The 
+ * decoder rejects longer encodings and those of values beyond 64 bits.  */
+static size_t 
+FloatInspectorVarIntEncode(uint8_t *buffer, uint64_t value) {
+	
+	size_t n = 0;
+	
+	while (value >= 0x80) {
+		
+		buffer[n++] = (uint8_t) (value | 0x80);
+		value >>= 7;
+	}
+	buffer[n++] = (uint8_t) value;
+	
+	return n;
+}
+
+static int 
+FloatInspectorVarIntDecode(const uint8_t **cursor, 
+						   const uint8_t *end,
+						   uint64_t *value) {
+	
+	uint64_t result = 0;
+	
+	for (unsigned int shift = 0; shift < 70; shift += 7) {
+		
+		if (*cursor >= end) {
+			
+			return -1;
+		}
+		
+		const uint8_t byte = *(*cursor)++;
+		
+		/* The tenth byte carries the top bit, anything above it does not 
+		 * fit and would be dropped by the shift.  */
+		if ((shift == 63) && ((byte & 0x7e) != 0)) {
+			
+			return -1;
+		}
+		
+		result |= (uint64_t) (byte & 0x7f) << shift;
+		
+		if ((byte & 0x80) == 0) {
+			
+			*value = result;
+			return 0;
+		}
+	}
+	
+	return -1;
+}
+
+/* Format fields and counts, which have to fit 32 bits.  */
+static int 
+FloatInspectorVarIntDecode32(const uint8_t **cursor, 
+							 const uint8_t *end,
+							 uint32_t *value) {
+	
+	uint64_t wide;
+	
+	if ((FloatInspectorVarIntDecode(cursor, end, &wide) != 0) || (wide > UINT32_MAX)) {
+		
+		return -1;
+	}
+	
+	*value = (uint32_t) wide;
+	
+	return 0;
+}
+
+/* Deltas are two's complement, zig-zag them so small decrements stay 
+ * short.  */
+static inline uint64_t 
+FloatInspectorZigZag(uint64_t delta) {
+	
+	return (delta << 1) ^ (uint64_t) -(int64_t) (delta >> 63);
+}
+
+static inline uint64_t 
+FloatInspectorUnZigZag(uint64_t value) {
+	
+	return (value >> 1) ^ (uint64_t) -(int64_t) (value & 1);
+}
+
+/* Adds a two's complement delta to value. Returns -1 and leaves value 
+ * alone if the result is negative or does not fit 64 bits.  */
+static int 
+FloatInspectorAddDelta(uint64_t *value, uint64_t delta) {
+	
+	uint64_t result;
+	
+	if ((int64_t) delta >= 0) {
+		
+		if (__builtin_add_overflow(*value, delta, &result)) {
+			
+			return -1;
+		}
+	}
+	else if (__builtin_sub_overflow(*value, -delta, &result)) {
+		
+		return -1;
+	}
+	
+	*value = result;
+	
+	return 0;
+}
+
+#pragma mark Public Functions Implementations
+
+FloatInspectorMonitorRef 
+FloatInspectorMonitorCreate(enum PrecisionType type) {
+	
+	FloatInspectorMonitorRef monitor = calloc(1, sizeof(struct _FloatInspectorMonitor));
+	
+	if (monitor == NULL) {
+		
+		return NULL;
+	}
+	
+	monitor->buffers[0] = FloatInspectorStatisticsCreate(type);
+	monitor->buffers[1] = FloatInspectorStatisticsCreate(type);
+	monitor->total = FloatInspectorStatisticsCreate(type);
+	pthread_mutex_init(&monitor->snapshotLock, NULL);
+	
+	if ((monitor->buffers[0] == NULL) || 
+		(monitor->buffers[1] == NULL) || 
+		(monitor->total == NULL)) {
+		
+		FloatInspectorMonitorFree(monitor);
+		return NULL;
+	}
+	
+	return monitor;
+}
+
+void 
+FloatInspectorMonitorFree(FloatInspectorMonitorRef monitor) {
+	
+	for (unsigned int i = 0; i < 2; i++) {
+		
+		if (monitor->buffers[i] != NULL) {
+			
+			FloatInspectorStatisticsFree(monitor->buffers[i]);
+		}
+	}
+	
+	if (monitor->total != NULL) {
+		
+		FloatInspectorStatisticsFree(monitor->total);
+	}
+	
+	pthread_mutex_destroy(&monitor->snapshotLock);
+	free(monitor);
+}
+
+FloatInspectorStatisticsRef 
+FloatInspectorMonitorBeginUpdate(FloatInspectorMonitorRef monitor) {
+	
+	for (;;) {
+		
+		const unsigned int idx = __atomic_load_n(&monitor->active, __ATOMIC_SEQ_CST);
+		
+		__atomic_add_fetch(&monitor->nWriters[idx], 1, __ATOMIC_SEQ_CST);
+		
+		/* A snapshot may have swapped the buffers between reading the index
+		 * and announcing ourselves, in that case it might already be draining
+		 * the buffer.  */
+		if (__atomic_load_n(&monitor->active, __ATOMIC_SEQ_CST) == idx) {
+			
+			return monitor->buffers[idx];
+		}
+		
+		__atomic_sub_fetch(&monitor->nWriters[idx], 1, __ATOMIC_SEQ_CST);
+	}
+}
+
+void 
+FloatInspectorMonitorEndUpdate(FloatInspectorMonitorRef monitor,
+							   FloatInspectorStatisticsRef stats) {
+	
+	const unsigned int idx = stats == monitor->buffers[0] ? 0 : 1;
+	
+	__atomic_sub_fetch(&monitor->nWriters[idx], 1, __ATOMIC_RELEASE);
+}
+
+void 
+FloatInspectorMonitorUpdateWithFloat(FloatInspectorMonitorRef monitor,
+									 float f) {
+	
+	FloatInspectorStatisticsRef stats = FloatInspectorMonitorBeginUpdate(monitor);
+	FloatInspectorStatisticsUpdateWithFloat(stats, f);
+	FloatInspectorMonitorEndUpdate(monitor, stats);
+}
+
+void 
+FloatInspectorMonitorUpdateWithDouble(FloatInspectorMonitorRef monitor,
+									  double f) {
+	
+	FloatInspectorStatisticsRef stats = FloatInspectorMonitorBeginUpdate(monitor);
+	FloatInspectorStatisticsUpdateWithDouble(stats, f);
+	FloatInspectorMonitorEndUpdate(monitor, stats);
+}
+
+void 
+FloatInspectorMonitorUpdateWithLongDouble(FloatInspectorMonitorRef monitor,
+										  long double f) {
+	
+	FloatInspectorStatisticsRef stats = FloatInspectorMonitorBeginUpdate(monitor);
+	FloatInspectorStatisticsUpdateWithLongDouble(stats, f);
+	FloatInspectorMonitorEndUpdate(monitor, stats);
+}
+
+FloatInspectorStatisticsRef 
+FloatInspectorMonitorTakeSnapshot(FloatInspectorMonitorRef monitor) {
+	
+	pthread_mutex_lock(&monitor->snapshotLock);
+	
+	/* Redirect producers to the idle buffer and wait for the ones still 
+	 * writing into the old buffer. Only the snapshot side ever waits.  */
+	const unsigned int old = __atomic_load_n(&monitor->active, __ATOMIC_SEQ_CST);
+	__atomic_store_n(&monitor->active, 1 - old, __ATOMIC_SEQ_CST);
+	
+	while (__atomic_load_n(&monitor->nWriters[old], __ATOMIC_ACQUIRE) != 0) {
+		
+		sched_yield();
+	}
+	
+	/* A buffer that cannot be added is kept, producers fill it again 
+	 * after the next swap.  */
+	FloatInspectorStatisticsRef snapshot = NULL;
+	
+	if (FloatInspectorStatisticsMerge(monitor->total, monitor->buffers[old]) == 0) {
+		
+		FloatInspectorStatisticsReset(monitor->buffers[old]);
+		snapshot = FloatInspectorStatisticsCopy(monitor->total);
+	}
+	
+	pthread_mutex_unlock(&monitor->snapshotLock);
+	
+	return snapshot;
+}
+
+FloatInspectorStatisticsDiffRef 
+FloatInspectorStatisticsDiffCreate(const FloatInspectorStatisticsRef older,
+								   const FloatInspectorStatisticsRef newer) {
+	
+	if ((older->type != newer->type) ||
+		(older->nExponentBits != newer->nExponentBits) ||
+		(older->nMantissaBits != newer->nMantissaBits)) {
+		
+		return NULL;
+	}
+	
+	FloatInspectorStatisticsDiffRef diff = calloc(1, sizeof(_FloatInspectorStatisticsDiff));
+	
+	if (diff == NULL) {
+		
+		return NULL;
+	}
+	
+	diff->type = newer->type;
+	diff->nBits = newer->nBits;
+	diff->nExponentBits = newer->nExponentBits;
+	diff->nMantissaBits = newer->nMantissaBits;
+	
+	diff->nEntries		= newer->nEntries - older->nEntries;
+	diff->nDenormalized	= newer->nDenormalized - older->nDenormalized;
+	diff->nNormalized	= newer->nNormalized - older->nNormalized;
+	diff->nNegative		= newer->nNegative - older->nNegative;
+	diff->nPositive		= newer->nPositive - older->nPositive;
+	diff->nNaN			= newer->nNaN - older->nNaN;
+	diff->nInf			= newer->nInf - older->nInf;
+	
+	unsigned int capacity = 0;
+	
+	for (FloatInspectorHistogram h = NormalizedPositiveHistogram; 
+		 h <= DenormalizedNegativeHistogram; 
+		 h++) {
+		
+		const uint64_t *a = FloatInspectorStatisticsHistogram(older, h);
+		const uint64_t *b = FloatInspectorStatisticsHistogram(newer, h);
+		const size_t nCells = FloatInspectorStatisticsHistogramCells(newer, h);
+		
+		for (size_t block = 0; block < nCells; block += kFloatInspectorDiffBlockCells) {
+			
+			const size_t blockEnd = block + kFloatInspectorDiffBlockCells < nCells ?
+				block + kFloatInspectorDiffBlockCells : nCells;
+			
+			/* Most blocks are unchanged between two monitoring intervals, skip
+			 * them without looking at single cells.  */
+			if (memcmp(&a[block], &b[block], 
+					   (blockEnd - block) * sizeof(uint64_t)) == 0) {
+				
+				continue;
+			}
+			
+			for (size_t i = block; i < blockEnd; i++) {
+				
+				if (a[i] == b[i]) {
+					
+					continue;
+				}
+				
+				if (diff->nChanges == capacity) {
+					
+					capacity = capacity == 0 ? 64 : capacity * 2;
+					FloatInspectorStatisticsCellChange *changes = 
+						realloc(diff->changes, 
+								capacity * sizeof(FloatInspectorStatisticsCellChange));
+					
+					if (changes == NULL) {
+						
+						FloatInspectorStatisticsDiffFree(diff);
+						return NULL;
+					}
+					diff->changes = changes;
+				}
+				
+				diff->changes[diff->nChanges].histogram = h;
+				diff->changes[diff->nChanges].index = (unsigned int) i;
+				diff->changes[diff->nChanges].delta = b[i] - a[i];
+				diff->nChanges++;
+			}
+		}
+	}
+	
+	return diff;
+}
+
+void 
+FloatInspectorStatisticsDiffFree(FloatInspectorStatisticsDiffRef diff) {
+	
+	free(diff->changes);
+	free(diff);
+}
+
+int 
+FloatInspectorStatisticsDiffApply(FloatInspectorStatisticsRef stats,
+								  const FloatInspectorStatisticsDiffRef diff) {
+	
+	if ((stats->type != diff->type) ||
+		(stats->nExponentBits != diff->nExponentBits) ||
+		(stats->nMantissaBits != diff->nMantissaBits)) {
+		
+		return -1;
+	}
+	
+	/* Counters and cells are checked on a copy of the counters and in a 
+	 * first pass over the cells, so a diff that does not fit is not half 
+	 * applied.  */
+	uint64_t counters[7] = {
+		stats->nEntries, stats->nDenormalized, stats->nNormalized, 
+		stats->nNegative, stats->nPositive, stats->nNaN, stats->nInf
+	};
+	const uint64_t deltas[7] = {
+		diff->nEntries, diff->nDenormalized, diff->nNormalized, 
+		diff->nNegative, diff->nPositive, diff->nNaN, diff->nInf
+	};
+	
+	for (unsigned int i = 0; i < 7; i++) {
+		
+		if (FloatInspectorAddDelta(&counters[i], deltas[i]) != 0) {
+			
+			return -1;
+		}
+	}
+	
+	for (unsigned int i = 0; i < diff->nChanges; i++) {
+		
+		const FloatInspectorStatisticsCellChange change = diff->changes[i];
+		uint64_t cell = FloatInspectorStatisticsHistogram(stats, change.histogram)[change.index];
+		
+		if (FloatInspectorAddDelta(&cell, change.delta) != 0) {
+			
+			return -1;
+		}
+	}
+	
+	stats->nEntries			= counters[0];
+	stats->nDenormalized	= counters[1];
+	stats->nNormalized		= counters[2];
+	stats->nNegative		= counters[3];
+	stats->nPositive		= counters[4];
+	stats->nNaN				= counters[5];
+	stats->nInf				= counters[6];
+	
+	for (unsigned int i = 0; i < diff->nChanges; i++) {
+		
+		const FloatInspectorStatisticsCellChange change = diff->changes[i];
+		
+		FloatInspectorStatisticsHistogram(stats, change.histogram)[change.index] += 
+			change.delta;
+	}
+	
+	return 0;
+}
+
+size_t 
+FloatInspectorStatisticsDiffEncodedSize(const FloatInspectorStatisticsDiffRef diff) {
+	
+	/* Header, 3 format fields, 7 counters, 4 cell counts and 2 varints per
+	 * change, each varint at most 10 bytes.  */
+	return sizeof(kFloatInspectorDiffMagic) + 1 + 
+		10 * (3 + 7 + 4) + 
+		20 * (size_t) diff->nChanges;
+}
+
+size_t 
+FloatInspectorStatisticsDiffEncode(const FloatInspectorStatisticsDiffRef diff,
+								   uint8_t *buffer,
+								   size_t size) {
+	
+	if (size < FloatInspectorStatisticsDiffEncodedSize(diff)) {
+		
+		return 0;
+	}
+	
+	size_t n = 0;
+	
+	memcpy(buffer, kFloatInspectorDiffMagic, sizeof(kFloatInspectorDiffMagic));
+	n += sizeof(kFloatInspectorDiffMagic);
+	
+	buffer[n++] = (uint8_t) diff->type;
+	n += FloatInspectorVarIntEncode(&buffer[n], diff->nBits);
+	n += FloatInspectorVarIntEncode(&buffer[n], diff->nExponentBits);
+	n += FloatInspectorVarIntEncode(&buffer[n], diff->nMantissaBits);
+	
+	const uint64_t counters[7] = {
+		diff->nEntries, diff->nDenormalized, diff->nNormalized, 
+		diff->nNegative, diff->nPositive, diff->nNaN, diff->nInf
+	};
+	
+	for (unsigned int i = 0; i < 7; i++) {
+		
+		n += FloatInspectorVarIntEncode(&buffer[n], FloatInspectorZigZag(counters[i]));
+	}
+	
+	/* Changes are sorted by histogram and index, so each histogram is a 
+	 * count followed by (index gap, delta) pairs.  */
+	unsigned int c = 0;
+	
+	for (FloatInspectorHistogram h = NormalizedPositiveHistogram; 
+		 h <= DenormalizedNegativeHistogram; 
+		 h++) {
+		
+		unsigned int end = c;
+		while ((end < diff->nChanges) && (diff->changes[end].histogram == h)) end++;
+		
+		n += FloatInspectorVarIntEncode(&buffer[n], end - c);
+		
+		unsigned int next = 0;
+		for (; c < end; c++) {
+			
+			n += FloatInspectorVarIntEncode(&buffer[n], diff->changes[c].index - next);
+			n += FloatInspectorVarIntEncode(&buffer[n], 
+											FloatInspectorZigZag(diff->changes[c].delta));
+			next = diff->changes[c].index + 1;
+		}
+	}
+	
+	return n;
+}
+
+FloatInspectorStatisticsDiffRef 
+FloatInspectorStatisticsDiffDecode(const uint8_t *buffer, size_t size) {
+	
+	const uint8_t *cursor = buffer;
+	const uint8_t *end = buffer + size;
+	
+	if ((size < sizeof(kFloatInspectorDiffMagic) + 1) ||
+		(memcmp(buffer, kFloatInspectorDiffMagic, sizeof(kFloatInspectorDiffMagic)) != 0)) {
+		
+		return NULL;
+	}
+	cursor += sizeof(kFloatInspectorDiffMagic);
+	
+	FloatInspectorStatisticsDiffRef diff = calloc(1, sizeof(_FloatInspectorStatisticsDiff));
+	
+	if (diff == NULL) {
+		
+		return NULL;
+	}
+	
+	const uint8_t type = *cursor++;
+	uint64_t counters[7];
+	int failed = (type > BFloat16);
+	
+	diff->type = (enum PrecisionType) type;
+	failed = failed || FloatInspectorVarIntDecode32(&cursor, end, &diff->nBits);
+	failed = failed || FloatInspectorVarIntDecode32(&cursor, end, &diff->nExponentBits);
+	failed = failed || FloatInspectorVarIntDecode32(&cursor, end, &diff->nMantissaBits);
+	failed = failed || (diff->nBits > kFloatInspectorDiffMaxBits) ||
+		(diff->nExponentBits + diff->nMantissaBits >= diff->nBits);
+	
+	for (unsigned int i = 0; (i < 7) && !failed; i++) {
+		
+		failed = FloatInspectorVarIntDecode(&cursor, end, &counters[i]);
+		counters[i] = FloatInspectorUnZigZag(counters[i]);
+	}
+	
+	if (failed) {
+		
+		FloatInspectorStatisticsDiffFree(diff);
+		return NULL;
+	}
+	
+	diff->nEntries		= counters[0];
+	diff->nDenormalized	= counters[1];
+	diff->nNormalized	= counters[2];
+	diff->nNegative		= counters[3];
+	diff->nPositive		= counters[4];
+	diff->nNaN			= counters[5];
+	diff->nInf			= counters[6];
+	
+	const size_t nNormalized = 
+		(size_t) (diff->nExponentBits + 1) * (diff->nMantissaBits + 1);
+	const size_t nDenormalized = (size_t) diff->nMantissaBits + 1;
+	
+	for (FloatInspectorHistogram h = NormalizedPositiveHistogram; 
+		 h <= DenormalizedNegativeHistogram; 
+		 h++) {
+		
+		const size_t nCells = 
+			((h == NormalizedPositiveHistogram) || (h == NormalizedNegativeHistogram)) ?
+			nNormalized : nDenormalized;
+		uint32_t count;
+		
+		if (FloatInspectorVarIntDecode32(&cursor, end, &count) || (count > nCells)) {
+			
+			FloatInspectorStatisticsDiffFree(diff);
+			return NULL;
+		}
+		
+		if (count > 0) {
+			
+			FloatInspectorStatisticsCellChange *changes = 
+				realloc(diff->changes, 
+						(diff->nChanges + count) * sizeof(FloatInspectorStatisticsCellChange));
+			
+			if (changes == NULL) {
+				
+				FloatInspectorStatisticsDiffFree(diff);
+				return NULL;
+			}
+			diff->changes = changes;
+		}
+		
+		size_t next = 0;
+		for (uint32_t i = 0; i < count; i++) {
+			
+			uint32_t gap;
+			uint64_t delta;
+			
+			if (FloatInspectorVarIntDecode32(&cursor, end, &gap) || 
+				FloatInspectorVarIntDecode(&cursor, end, &delta) ||
+				(next + gap >= nCells)) {
+				
+				FloatInspectorStatisticsDiffFree(diff);
+				return NULL;
+			}
+			
+			FloatInspectorStatisticsCellChange *change = &diff->changes[diff->nChanges++];
+			change->histogram = h;
+			change->index = (unsigned int) (next + gap);
+			change->delta = FloatInspectorUnZigZag(delta);
+			next = change->index + 1;
+		}
+	}
+	
+	if (cursor != end) {
+		
+		FloatInspectorStatisticsDiffFree(diff);
+		return NULL;
+	}
+	
+	return diff;
+}
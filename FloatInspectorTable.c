@@ -0,0 +1,853 @@
+//
+//  FloatInspectorTable.c
+//  FloatInspector
+//  
+//  Copyright 2011 Stefan Reinhold <stefan@sreinhold.com>. All rights reserved.
+//  
+//  Redistribution and use in source and binary forms, with or without modification, are
+//  permitted provided that the following conditions are met:
+//  
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//  
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list
+//  of conditions and the following disclaimer in the documentation and/or other materials
+//  provided with the distribution.
+//  
+//  THIS SOFTWARE IS PROVIDED BY STEFAN REINHOLD ``AS IS'' AND ANY EXPRESS OR IMPLIED
+//  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STEFAN REINHOLD OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+//  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+//  ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//  
+//  The views and conclusions contained in the software and documentation are those of the
+//  authors and should not be interpreted as representing official policies, either expressed
+//  or implied, of Stefan Reinhold.
+//  
+
+
+
+
+#include "FloatInspectorTable.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#pragma mark Data Types
+
+/* Header of a group's block, followed by the moments if kept and the key.
+ * The histograms live in a separate arena.  */
+typedef struct {
+	
+	_FloatInspectorStatistics stats;
+	uint64_t hash;
+	size_t keyLength;
+	char *key;
+	
+} FloatInspectorTableEntry;
+
+/* Index entry, the upper half of the hash saves most key comparisons.  */
+typedef struct {
+	
+	uint32_t tag;
+	/* Group id plus one, 0 marks an empty slot.  */
+	uint32_t group;
+	
+} FloatInspectorTableSlot;
+
+typedef struct _FloatInspectorTableSlab {
+	
+	struct _FloatInspectorTableSlab *next;
+	size_t size;
+	size_t used;
+	
+} FloatInspectorTableSlab;
+
+struct _FloatInspectorTable {
+	
+	enum PrecisionType type;
+	unsigned int nBits;
+	unsigned int nExponentBits;
+	unsigned int nMantissaBits;
+	int moments;
+	size_t nNormalizedCells;
+	size_t nDenormalizedCells;
+	
+	FloatInspectorTableEntry **groups;
+	unsigned int nGroups;
+	unsigned int capacity;
+	
+	/* Power of two, at most half full.  */
+	FloatInspectorTableSlot *slots;
+	size_t nSlots;
+	
+	/* Headers, moments and keys are packed densely, apart from the 
+	 * histograms, so the headers touched by a batch share cache lines and
+	 * pages.  */
+	FloatInspectorTableSlab *headers;
+	FloatInspectorTableSlab *cells;
+	
+	/* Partitioning of a batch: per group its count, then its offset in the
+	 * scratch buffer.  */
+	uint32_t *offsets;
+	uint32_t *resolved;
+	void *scratch;
+	/* Pairs partitioned at once.  */
+	size_t blockSize;
+};
+
+#pragma mark Constants
+
+/* Pairs partitioned at once, between the minimum and maximum the block 
+ * grows with the number of groups, so runs get long enough to pay for the
+ * scatter.  */
+#define kFloatInspectorTableMinimumBlock	((size_t) 1 << 14)
+#define kFloatInspectorTableMaximumBlock	((size_t) 1 << 20)
+#define kFloatInspectorTableValuesPerGroup	((size_t) 64)
+/* Average run length from which the bulk path pays.  */
+#define kFloatInspectorTableMinimumRun	4
+/* Groups from which partitioning a block pays over pair by pair updates. 
+ * On a 2.1 GHz Xeon with doubles in random group order the partition was 
+ * ahead from 2 groups up, 14 against 18 ns per pair up to 8 groups, 19 
+ * against 21 at 1000 and 25 against 36 at 5000.  */
+#define kFloatInspectorTablePartitionGroups	2
+/* Bytes of a slab, larger groups get a slab of their own.  */
+#define kFloatInspectorTableSlab	((size_t) 1 << 18)
+#define kFloatInspectorTableAlign	((size_t) 16)
+
+#pragma mark Private Function Prototypes
+
+static size_t FloatInspectorTableAlign(size_t size);
+
+static void *FloatInspectorTableAllocate(FloatInspectorTableSlab **slabs, size_t size);
+
+static long FloatInspectorTableLookup(const FloatInspectorTableRef table,
+									  const void *key,
+									  size_t length,
+									  uint64_t hash);
+
+static int FloatInspectorTableGrowIndex(FloatInspectorTableRef table);
+
+static int FloatInspectorTableReserveScratch(FloatInspectorTableRef table);
+
+static void FloatInspectorTableUpdateRun(FloatInspectorTableRef table,
+										 uint32_t group,
+										 const void *restrict values,
+										 size_t n);
+
+static void FloatInspectorTableUpdateBlock(FloatInspectorTableRef table,
+										   const uint32_t *restrict groups,
+										   const void *restrict values,
+										   size_t n);
+
+static int FloatInspectorTableUpdate(FloatInspectorTableRef table,
+									 const uint32_t *restrict groups,
+									 const void *restrict values,
+									 size_t n);
+
+static int FloatInspectorTableUpdateKeyed(FloatInspectorTableRef table,
+										  const char *const *keys,
+										  const void *restrict values,
+										  size_t n);
+
+#pragma mark Private Functions Implementations
+
+static size_t 
+FloatInspectorTableAlign(size_t size) {
+	
+	return (size + kFloatInspectorTableAlign - 1) & ~(kFloatInspectorTableAlign - 1);
+}
+
+/* Bump allocation from the newest slab, blocks are only released with the
+ * table.  */
+static void *
+FloatInspectorTableAllocate(FloatInspectorTableSlab **slabs, size_t size) {
+	
+	const size_t header = FloatInspectorTableAlign(sizeof(FloatInspectorTableSlab));
+	FloatInspectorTableSlab *slab = *slabs;
+	
+	size = FloatInspectorTableAlign(size);
+	
+	if ((slab == NULL) || (slab->size - slab->used < size)) {
+		
+		const size_t slabSize = header + size > kFloatInspectorTableSlab ? 
+			header + size : kFloatInspectorTableSlab;
+		
+		slab = malloc(slabSize);
+		
+		if (slab == NULL) {
+			
+			return NULL;
+		}
+		
+		slab->size = slabSize;
+		slab->used = header;
+		slab->next = *slabs;
+		*slabs = slab;
+	}
+	
+	void *block = (uint8_t *) slab + slab->used;
+	
+	slab->used += size;
+	
+	return block;
+}
+
+/* Returns the group of key or -1 - the empty slot it would go to.  */
+static long 
+FloatInspectorTableLookup(const FloatInspectorTableRef table,
+						  const void *key,
+						  size_t length,
+						  uint64_t hash) {
+	
+	const size_t mask = table->nSlots - 1;
+	const uint32_t tag = (uint32_t) (hash >> 32);
+	
+	for (size_t i = (size_t) hash & mask;; i = (i + 1) & mask) {
+		
+		const FloatInspectorTableSlot slot = table->slots[i];
+		
+		if (slot.group == 0) {
+			
+			return -1 - (long) i;
+		}
+		
+		const FloatInspectorTableEntry *group = table->groups[slot.group - 1];
+		
+		if ((slot.tag == tag) && (group->keyLength == length) && 
+			(memcmp(group->key, key, length) == 0)) {
+			
+			return (long) slot.group - 1;
+		}
+	}
+}
+
+static int 
+FloatInspectorTableGrowIndex(FloatInspectorTableRef table) {
+	
+	const size_t nSlots = table->nSlots == 0 ? 64 : 2 * table->nSlots;
+	FloatInspectorTableSlot *slots = calloc(nSlots, sizeof(FloatInspectorTableSlot));
+	
+	if (slots == NULL) {
+		
+		return -1;
+	}
+	
+	for (unsigned int g = 0; g < table->nGroups; g++) {
+		
+		const uint64_t hash = table->groups[g]->hash;
+		size_t i = (size_t) hash & (nSlots - 1);
+		
+		while (slots[i].group != 0) {
+			
+			i = (i + 1) & (nSlots - 1);
+		}
+		
+		slots[i].tag = (uint32_t) (hash >> 32);
+		slots[i].group = g + 1;
+	}
+	
+	free(table->slots);
+	table->slots = slots;
+	table->nSlots = nSlots;
+	
+	return 0;
+}
+
+static int 
+FloatInspectorTableReserveScratch(FloatInspectorTableRef table) {
+	
+	size_t blockSize = kFloatInspectorTableMinimumBlock;
+	
+	while ((blockSize < kFloatInspectorTableMaximumBlock) && 
+		   (blockSize < kFloatInspectorTableValuesPerGroup * table->nGroups)) {
+		
+		blockSize *= 2;
+	}
+	
+	if (blockSize <= table->blockSize) {
+		
+		return 0;
+	}
+	
+	free(table->resolved);
+	free(table->scratch);
+	
+	table->resolved = malloc(blockSize * sizeof(uint32_t));
+	table->scratch = malloc(blockSize * sizeof(double));
+	table->blockSize = blockSize;
+	
+	if ((table->resolved == NULL) || (table->scratch == NULL)) {
+		
+		free(table->resolved);
+		free(table->scratch);
+		table->resolved = NULL;
+		table->scratch = NULL;
+		table->blockSize = 0;
+		
+		return -1;
+	}
+	
+	return 0;
+}
+
+static void 
+FloatInspectorTableUpdateRun(FloatInspectorTableRef table,
+							 uint32_t group,
+							 const void *restrict values,
+							 size_t n) {
+	
+	FloatInspectorStatisticsRef stats = &table->groups[group]->stats;
+	
+	if (table->type == Float) {
+		
+		FloatInspectorStatisticsUpdateWithFloats(stats, values, n);
+	}
+	else {
+		
+		FloatInspectorStatisticsUpdateWithDoubles(stats, values, n);
+	}
+}
+
+/* Picks the cheapest way through at most one block of pairs. Pairs that 
+ * arrive in long runs of one group go to the bulk path in place. Otherwise,
+ * if the table has enough groups and the block is large against their 
+ * number, the pairs are counting sorted by group and every group gets one
+ * bulk update, which keeps its histograms in the cache for the whole run.
+ * Anything else is added pair by pair, a partition would cost more than it
+ * saves.  */
+static void 
+FloatInspectorTableUpdateBlock(FloatInspectorTableRef table,
+							   const uint32_t *restrict groups,
+							   const void *restrict values,
+							   size_t n) {
+	
+	const size_t size = table->type == Float ? sizeof(float) : sizeof(double);
+	size_t nSegments = n != 0;
+	
+	for (size_t i = 1; i < n; i++) {
+		
+		nSegments += groups[i] != groups[i - 1];
+	}
+	
+	if (kFloatInspectorTableMinimumRun * nSegments <= n) {
+		
+		for (size_t i = 0; i < n;) {
+			
+			size_t j = i + 1;
+			
+			while ((j < n) && (groups[j] == groups[i])) {
+				
+				j++;
+			}
+			
+			FloatInspectorTableUpdateRun(table, groups[i], (const uint8_t *) values + i * size, 
+										 j - i);
+			i = j;
+		}
+		
+		return;
+	}
+	
+	if ((table->nGroups < kFloatInspectorTablePartitionGroups) ||
+		(n < kFloatInspectorTableMinimumRun * (size_t) table->nGroups)) {
+		
+		for (size_t i = 0; i < n; i++) {
+			
+			FloatInspectorStatisticsRef stats = &table->groups[groups[i]]->stats;
+			
+			if (table->type == Float) {
+				
+				FloatInspectorStatisticsUpdateWithFloat(stats, ((const float *) values)[i]);
+			}
+			else {
+				
+				FloatInspectorStatisticsUpdateWithDouble(stats, ((const double *) values)[i]);
+			}
+		}
+		
+		return;
+	}
+	
+	uint32_t *restrict offsets = table->offsets;
+	const uint32_t nGroups = table->nGroups;
+	
+	memset(offsets, 0, nGroups * sizeof(uint32_t));
+	
+	for (size_t i = 0; i < n; i++) {
+		
+		offsets[groups[i]]++;
+	}
+	
+	/* Counts become start offsets, which the scatter moves to the ends.  */
+	uint32_t offset = 0;
+	
+	for (uint32_t g = 0; g < nGroups; g++) {
+		
+		const uint32_t count = offsets[g];
+		
+		offsets[g] = offset;
+		offset += count;
+	}
+	
+	if (table->type == Float) {
+		
+		float *restrict out = table->scratch;
+		const float *restrict in = values;
+		
+		for (size_t i = 0; i < n; i++) {
+			
+			out[offsets[groups[i]]++] = in[i];
+		}
+	}
+	else {
+		
+		double *restrict out = table->scratch;
+		const double *restrict in = values;
+		
+		for (size_t i = 0; i < n; i++) {
+			
+			out[offsets[groups[i]]++] = in[i];
+		}
+	}
+	
+	uint32_t start = 0;
+	
+	for (uint32_t g = 0; g < nGroups; g++) {
+		
+		if (offsets[g] != start) {
+			
+			FloatInspectorTableUpdateRun(table, g, 
+										 (const uint8_t *) table->scratch + start * size, 
+										 offsets[g] - start);
+			start = offsets[g];
+		}
+	}
+}
+
+static int 
+FloatInspectorTableUpdate(FloatInspectorTableRef table,
+						  const uint32_t *restrict groups,
+						  const void *restrict values,
+						  size_t n) {
+	
+	for (size_t i = 0; i < n; i++) {
+		
+		if (groups[i] >= table->nGroups) {
+			
+			return -1;
+		}
+	}
+	
+	if ((n != 0) && (FloatInspectorTableReserveScratch(table) != 0)) {
+		
+		return -1;
+	}
+	
+	const size_t size = table->type == Float ? sizeof(float) : sizeof(double);
+	
+	for (size_t first = 0; first < n; first += table->blockSize) {
+		
+		FloatInspectorTableUpdateBlock(table, groups + first, 
+									   (const uint8_t *) values + first * size,
+									   n - first < table->blockSize ? 
+									   n - first : table->blockSize);
+	}
+	
+	return 0;
+}
+
+/* Keys are resolved a block at a time, a key repeated by pointer is looked
+ * up once.  */
+static int 
+FloatInspectorTableUpdateKeyed(FloatInspectorTableRef table,
+							   const char *const *keys,
+							   const void *restrict values,
+							   size_t n) {
+	
+	if ((n != 0) && (FloatInspectorTableReserveScratch(table) != 0)) {
+		
+		return -1;
+	}
+	
+	const size_t size = table->type == Float ? sizeof(float) : sizeof(double);
+	const char *lastKey = NULL;
+	long lastGroup = -1;
+	
+	for (size_t first = 0; first < n; first += table->blockSize) {
+		
+		const size_t count = n - first < table->blockSize ? 
+			n - first : table->blockSize;
+		
+		for (size_t i = 0; i < count; i++) {
+			
+			const char *key = keys[first + i];
+			
+			if (key != lastKey) {
+				
+				lastGroup = FloatInspectorTableGroup(table, key, strlen(key));
+				lastKey = key;
+				
+				if (lastGroup < 0) {
+					
+					return -1;
+				}
+			}
+			
+			table->resolved[i] = (uint32_t) lastGroup;
+		}
+		
+		FloatInspectorTableUpdateBlock(table, table->resolved, 
+									   (const uint8_t *) values + first * size, count);
+	}
+	
+	return 0;
+}
+
+#pragma mark Public Functions Implementations
+
+FloatInspectorTableRef 
+FloatInspectorTableCreate(enum PrecisionType type, int moments) {
+	
+	if ((type != Float) && (type != Double)) {
+		
+		return NULL;
+	}
+	
+	FloatInspectorTableRef table = calloc(1, sizeof(struct _FloatInspectorTable));
+	FloatInspectorStatisticsRef format = FloatInspectorStatisticsCreate(type);
+	
+	if ((table == NULL) || (format == NULL)) {
+		
+		free(table);
+		if (format != NULL) FloatInspectorStatisticsFree(format);
+		
+		return NULL;
+	}
+	
+	table->type = type;
+	table->nBits = format->nBits;
+	table->nExponentBits = format->nExponentBits;
+	table->nMantissaBits = format->nMantissaBits;
+	table->moments = moments != 0;
+	table->nNormalizedCells = FloatInspectorStatisticsNormalizedCells(format);
+	table->nDenormalizedCells = FloatInspectorStatisticsDenormalizedCells(format);
+	
+	FloatInspectorStatisticsFree(format);
+	
+	return table;
+}
+
+void 
+FloatInspectorTableFree(FloatInspectorTableRef table) {
+	
+	for (unsigned int i = 0; i < 2; i++) {
+		
+		FloatInspectorTableSlab *slab = i == 0 ? table->headers : table->cells;
+		
+		while (slab != NULL) {
+			
+			FloatInspectorTableSlab *next = slab->next;
+			
+			free(slab);
+			slab = next;
+		}
+	}
+	
+	free(table->groups);
+	free(table->slots);
+	free(table->offsets);
+	free(table->resolved);
+	free(table->scratch);
+	free(table);
+}
+
+void 
+FloatInspectorTableReset(FloatInspectorTableRef table) {
+	
+	for (unsigned int g = 0; g < table->nGroups; g++) {
+		
+		FloatInspectorStatisticsReset(&table->groups[g]->stats);
+	}
+}
+
+int 
+FloatInspectorTableMerge(FloatInspectorTableRef dst, const FloatInspectorTableRef src) {
+	
+	if ((dst->type != src->type) || (dst->moments != src->moments)) {
+		
+		return -1;
+	}
+	
+	for (unsigned int g = 0; g < src->nGroups; g++) {
+		
+		const FloatInspectorTableEntry *group = src->groups[g];
+		const long target = FloatInspectorTableGroup(dst, group->key, group->keyLength);
+		
+		if (target < 0) {
+			
+			return -1;
+		}
+		
+		if (FloatInspectorStatisticsMerge(&dst->groups[target]->stats, 
+										  (const FloatInspectorStatisticsRef) &group->stats) != 0) {
+			
+			return -1;
+		}
+	}
+	
+	return 0;
+}
+
+long 
+FloatInspectorTableGroup(FloatInspectorTableRef table, const void *key, size_t length) {
+	
+	const uint64_t hash = FloatInspectorTableHash(key, length);
+	
+	if (table->nSlots != 0) {
+		
+		const long group = FloatInspectorTableLookup(table, key, length, hash);
+		
+		if (group >= 0) {
+			
+			return group;
+		}
+	}
+	
+	if ((table->nGroups == UINT32_MAX - 1) ||
+		((2 * ((size_t) table->nGroups + 1) > table->nSlots) && 
+		 (FloatInspectorTableGrowIndex(table) != 0))) {
+		
+		return -1;
+	}
+	
+	if (table->nGroups == table->capacity) {
+		
+		const unsigned int capacity = table->capacity == 0 ? 64 : 2 * table->capacity;
+		FloatInspectorTableEntry **groups = realloc(table->groups, 
+													capacity * sizeof(FloatInspectorTableEntry *));
+		
+		if (groups != NULL) table->groups = groups;
+		
+		uint32_t *offsets = realloc(table->offsets, capacity * sizeof(uint32_t));
+		
+		if (offsets != NULL) table->offsets = offsets;
+		
+		if ((groups == NULL) || (offsets == NULL)) {
+			
+			return -1;
+		}
+		
+		table->capacity = capacity;
+	}
+	
+	/* One block for header, moments and key, one for the four histograms.  */
+	const size_t nNormalizedBytes = table->nNormalizedCells * sizeof(uint64_t);
+	const size_t nDenormalizedBytes = table->nDenormalizedCells * sizeof(uint64_t);
+	const size_t header = FloatInspectorTableAlign(sizeof(FloatInspectorTableEntry));
+	const size_t moments = table->moments ? 
+		FloatInspectorTableAlign(sizeof(_FloatInspectorMoments)) : 0;
+	const size_t histograms = 2 * (nNormalizedBytes + nDenormalizedBytes);
+	uint8_t *block = FloatInspectorTableAllocate(&table->headers, header + moments + length + 1);
+	uint8_t *cells = block != NULL ? 
+		FloatInspectorTableAllocate(&table->cells, histograms) : NULL;
+	
+	if (cells == NULL) {
+		
+		return -1;
+	}
+	
+	FloatInspectorTableEntry *group = (FloatInspectorTableEntry *) block;
+	
+	memset(group, 0, sizeof(FloatInspectorTableEntry));
+	memset(cells, 0, histograms);
+	
+	group->stats.type = table->type;
+	group->stats.nBits = table->nBits;
+	group->stats.nExponentBits = table->nExponentBits;
+	group->stats.nMantissaBits = table->nMantissaBits;
+	group->stats.nNonZeroBitsNormalizedPositive = (uint64_t *) cells;
+	group->stats.nNonZeroBitsNormalizedNegative = (uint64_t *) (cells + nNormalizedBytes);
+	group->stats.nNonZeroBitsDenormalizedPositive = 
+		(uint64_t *) (cells + 2 * nNormalizedBytes);
+	group->stats.nNonZeroBitsDenormalizedNegative = 
+		(uint64_t *) (cells + 2 * nNormalizedBytes + nDenormalizedBytes);
+	
+	if (table->moments) {
+		
+		group->stats.moments = (FloatInspectorMomentsRef) (block + header);
+		FloatInspectorMomentsReset(group->stats.moments);
+	}
+	
+	group->hash = hash;
+	group->keyLength = length;
+	group->key = (char *) block + header + moments;
+	memcpy(group->key, key, length);
+	group->key[length] = '\0';
+	
+	/* The slot may have moved if the index grew.  */
+	const long slot = -1 - FloatInspectorTableLookup(table, key, length, hash);
+	
+	table->slots[slot].tag = (uint32_t) (hash >> 32);
+	table->slots[slot].group = table->nGroups + 1;
+	table->groups[table->nGroups] = group;
+	
+	return (long) table->nGroups++;
+}
+
+long 
+FloatInspectorTableFind(const FloatInspectorTableRef table, 
+						const void *key, 
+						size_t length) {
+	
+	if (table->nSlots == 0) {
+		
+		return -1;
+	}
+	
+	const long group = FloatInspectorTableLookup(table, key, length, 
+												 FloatInspectorTableHash(key, length));
+	
+	return group >= 0 ? group : -1;
+}
+
+unsigned int 
+FloatInspectorTableNumberOfGroups(const FloatInspectorTableRef table) {
+	
+	return table->nGroups;
+}
+
+const char *
+FloatInspectorTableKey(const FloatInspectorTableRef table, 
+					   unsigned int group, 
+					   size_t *length) {
+	
+	if (length != NULL) {
+		
+		*length = table->groups[group]->keyLength;
+	}
+	
+	return table->groups[group]->key;
+}
+
+FloatInspectorStatisticsRef 
+FloatInspectorTableStatistics(const FloatInspectorTableRef table,
+							  unsigned int group) {
+	
+	return &table->groups[group]->stats;
+}
+
+int 
+FloatInspectorTableUpdateWithFloats(FloatInspectorTableRef table,
+									const uint32_t *restrict groups,
+									const float *restrict values,
+									size_t n) {
+	
+	return table->type == Float ? FloatInspectorTableUpdate(table, groups, values, n) : -1;
+}
+
+int 
+FloatInspectorTableUpdateWithDoubles(FloatInspectorTableRef table,
+									 const uint32_t *restrict groups,
+									 const double *restrict values,
+									 size_t n) {
+	
+	return table->type == Double ? FloatInspectorTableUpdate(table, groups, values, n) : -1;
+}
+
+int 
+FloatInspectorTableUpdateWithKeyedFloats(FloatInspectorTableRef table,
+										 const char *const *keys,
+										 const float *restrict values,
+										 size_t n) {
+	
+	return table->type == Float ? FloatInspectorTableUpdateKeyed(table, keys, values, n) : -1;
+}
+
+int 
+FloatInspectorTableUpdateWithKeyedDoubles(FloatInspectorTableRef table,
+										  const char *const *keys,
+										  const double *restrict values,
+										  size_t n) {
+	
+	return table->type == Double ? FloatInspectorTableUpdateKeyed(table, keys, values, n) : -1;
+}
+
+/* Word at a time multiply and fold, good enough for an index that keeps 
+ * the full key.  */
+uint64_t 
+FloatInspectorTableHash(const void *bytes, size_t length) {
+	
+	const uint8_t *key = bytes;
+	uint64_t hash = 0x9e3779b97f4a7c15ULL ^ length;
+	uint64_t word;
+	
+	for (; length >= 8; key += 8, length -= 8) {
+		
+		memcpy(&word, key, 8);
+		hash = (hash ^ word) * 0xff51afd7ed558ccdULL;
+		hash ^= hash >> 32;
+	}
+	
+	word = 0;
+	memcpy(&word, key, length);
+	hash = (hash ^ word) * 0xc4ceb9fe1a85ec53ULL;
+	hash ^= hash >> 29;
+	hash *= 0xff51afd7ed558ccdULL;
+	
+	return hash ^ (hash >> 32);
+}
+
+size_t 
+FloatInspectorTableMemorySize(const FloatInspectorTableRef table) {
+	
+	size_t size = sizeof(struct _FloatInspectorTable) + 
+		table->capacity * (sizeof(FloatInspectorTableEntry *) + sizeof(uint32_t)) +
+		table->nSlots * sizeof(FloatInspectorTableSlot);
+	
+	for (const FloatInspectorTableSlab *slab = table->headers; slab != NULL; slab = slab->next) {
+		
+		size += slab->size;
+	}
+	
+	for (const FloatInspectorTableSlab *slab = table->cells; slab != NULL; slab = slab->next) {
+		
+		size += slab->size;
+	}
+	
+	if (table->scratch != NULL) {
+		
+		size += table->blockSize * (sizeof(uint32_t) + sizeof(double));
+	}
+	
+	return size;
+}
+
+void 
+FloatInspectorTablePrint(const FloatInspectorTableRef table, FILE *restrict stream) {
+	
+	for (unsigned int g = 0; g < table->nGroups; g++) {
+		
+		const FloatInspectorTableEntry *group = table->groups[g];
+		const _FloatInspectorStatistics *stats = &group->stats;
+		
+		fprintf(stream, "%.*s: %" PRIu64 " values, %" PRIu64 " negative, %" PRIu64 " denormalized, "
+				"%" PRIu64 " NaN, %" PRIu64 " Inf",
+				(int) group->keyLength, group->key, stats->nEntries, stats->nNegative,
+				stats->nDenormalized, stats->nNaN, stats->nInf);
+		
+		if ((stats->moments != NULL) && (stats->moments->n != 0)) {
+			
+			fprintf(stream, ", minimum %g, maximum %g, mean %g, variance %g",
+					stats->moments->minimum, stats->moments->maximum,
+					FloatInspectorMomentsMean(stats->moments),
+					FloatInspectorMomentsVariance(stats->moments));
+		}
+		
+		fprintf(stream, "\n");
+	}
+}
@@ -0,0 +1,125 @@
+//
+//  FloatInspectorTable.h
+//  FloatInspector
+//  
+//  Copyright 2011 Stefan Reinhold <stefan@sreinhold.com>. All rights reserved.
+//  
+//  Redistribution and use in source and binary forms, with or without modification, are
+//  permitted provided that the following conditions are met:
+//  
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//  
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list
+//  of conditions and the following disclaimer in the documentation and/or other materials
+//  provided with the distribution.
+//  
+//  THIS SOFTWARE IS PROVIDED BY STEFAN REINHOLD ``AS IS'' AND ANY EXPRESS OR IMPLIED
+//  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STEFAN REINHOLD OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+//  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+//  ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//  
+//  The views and conclusions contained in the software and documentation are those of the
+//  authors and should not be interpreted as representing official policies, either expressed
+//  or implied, of Stefan Reinhold.
+//  
+
+
+
+#ifndef FloatInspector_FloatInspectorTable_h
+#define FloatInspector_FloatInspectorTable_h
+
+#include "FloatInspector.h"
+
+#pragma mark Data Types
+
+/* Statistics of many series, one group per key. Keys are byte strings 
+ * found through an open addressing index. Each group is a single block 
+ * (counters, histograms, optional moments and the key) carved from large
+ * slabs, so thousands of groups cost a handful of allocations and no 
+ * pointer chasing between them. Groups carry no sketches.  */
+typedef struct _FloatInspectorTable *FloatInspectorTableRef;
+
+#pragma mark Public Functions
+
+/* Returns an empty table of float or double groups, with running moments
+ * per group if moments is nonzero, or NULL for another type or if out of
+ * memory.  */
+FloatInspectorTableRef FloatInspectorTableCreate(enum PrecisionType type, int moments);
+
+void FloatInspectorTableFree(FloatInspectorTableRef table);
+
+/* Clears the statistics of all groups, keys and ids are kept.  */
+void FloatInspectorTableReset(FloatInspectorTableRef table);
+
+/* Adds the groups of src to the groups of dst with the same key, creating
+ * them as needed. Returns 0 on success and -1 if the tables differ in type
+ * or moments, memory is exhausted or the counters of a group would overflow,
+ * the groups merged so far are kept then.  */
+int FloatInspectorTableMerge(FloatInspectorTableRef dst, const FloatInspectorTableRef src);
+
+/* Id of the group of key, which is added if new. Ids are dense in order of
+ * first appearance and never change. Returns -1 if out of memory.  */
+long FloatInspectorTableGroup(FloatInspectorTableRef table, const void *key, size_t length);
+
+/* Id of the group of key or -1 if there is none.  */
+long FloatInspectorTableFind(const FloatInspectorTableRef table, 
+							 const void *key, 
+							 size_t length);
+
+unsigned int FloatInspectorTableNumberOfGroups(const FloatInspectorTableRef table);
+
+/* Key of a group, NUL terminated for convenience.  */
+const char *FloatInspectorTableKey(const FloatInspectorTableRef table, 
+								   unsigned int group, 
+								   size_t *length);
+
+/* Statistics of a group, owned by the table. They may be read, merged into
+ * other objects and updated, but not freed or given sketches.  */
+FloatInspectorStatisticsRef FloatInspectorTableStatistics(const FloatInspectorTableRef table,
+														  unsigned int group);
+
+/* Adds n (group, value) pairs. The pairs are partitioned by group, every 
+ * group of a batch gets one run for the bulk path. Returns 0 on success and
+ * -1 if the values do not match the type of the table or a group does not 
+ * exist, in which case nothing of the batch is added.  */
+int FloatInspectorTableUpdateWithFloats(FloatInspectorTableRef table,
+										const uint32_t *restrict groups,
+										const float *restrict values,
+										size_t n);
+
+int FloatInspectorTableUpdateWithDoubles(FloatInspectorTableRef table,
+										 const uint32_t *restrict groups,
+										 const double *restrict values,
+										 size_t n);
+
+/* Same for pairs of NUL terminated keys and values, groups are added as 
+ * needed. Returns -1 if the values do not match the type of the table or 
+ * memory is exhausted.  */
+int FloatInspectorTableUpdateWithKeyedFloats(FloatInspectorTableRef table,
+											 const char *const *keys,
+											 const float *restrict values,
+											 size_t n);
+
+int FloatInspectorTableUpdateWithKeyedDoubles(FloatInspectorTableRef table,
+											  const char *const *keys,
+											  const double *restrict values,
+											  size_t n);
+
+/* Hash of a key as used by the index, for other indexes of byte strings.
+ * Not seeded, so not meant for keys an attacker picks to collide.  */
+uint64_t FloatInspectorTableHash(const void *key, size_t length);
+
+/* Bytes held by the table: slabs, index, group list and the partition 
+ * buffers, one count per group and a group id and value per pair.  */
+size_t FloatInspectorTableMemorySize(const FloatInspectorTableRef table);
+
+/* One line per group: key, counters and moments if kept.  */
+void FloatInspectorTablePrint(const FloatInspectorTableRef table, FILE *restrict stream);
+
+#endif
@@ -0,0 +1,1028 @@
+//
+//  FloatInspectorTensors.c
+//  FloatInspector
+//  
+//  Copyright 2011 Stefan Reinhold <stefan@sreinhold.com>. All rights reserved.
+//  
+//  Redistribution and use in source and binary forms, with or without modification, are
+//  permitted provided that the following conditions are met:
+//  
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//  
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list
+//  of conditions and the following disclaimer in the documentation and/or other materials
+//  provided with the distribution.
+//  
+//  THIS SOFTWARE IS PROVIDED BY STEFAN REINHOLD ``AS IS'' AND ANY EXPRESS OR IMPLIED
+//  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STEFAN REINHOLD OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+//  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+//  ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//  
+//  The views and conclusions contained in the software and documentation are those of the
+//  authors and should not be interpreted as representing official policies, either expressed
+//  or implied, of Stefan Reinhold.
+//  
+
+
+
+#include "FloatInspectorTensors.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <float.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#pragma mark Constants
+
+/* Elements copied at once if they cannot be read in place.  */
+#define kFloatInspectorTensorChunk	1024
+/* Nesting of header values skipped before a header is considered 
+ * malformed.  */
+#define kFloatInspectorTensorMaxDepth	64
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define kFloatInspectorTensorBigEndianHost	1
+#else
+#define kFloatInspectorTensorBigEndianHost	0
+#endif
+
+#pragma mark Data Types
+
+/* Cursor over a header inside the mapping.  */
+typedef struct {
+	
+	const char *p;
+	const char *end;
+	
+} FloatInspectorTensorParser;
+
+typedef struct {
+	
+	const char *dtype;
+	size_t size;
+	int supported;
+	enum PrecisionType type;
+	
+} FloatInspectorTensorSafetensorsType;
+
+#pragma mark Globals
+
+static const char kFloatInspectorTensorNumPyMagic[] = "\x93NUMPY";
+
+/* Element types of safetensors, the unsupported ones are listed to check 
+ * their offsets.  */
+static const FloatInspectorTensorSafetensorsType kFloatInspectorTensorSafetensorsTypes[] = {
+	
+	{"F16", 2, 1, Half},
+	{"BF16", 2, 1, BFloat16},
+	{"F32", 4, 1, Float},
+	{"F64", 8, 1, Double},
+	{"F8_E4M3", 1, 0, Float},
+	{"F8_E5M2", 1, 0, Float},
+	{"BOOL", 1, 0, Float},
+	{"I8", 1, 0, Float},
+	{"U8", 1, 0, Float},
+	{"I16", 2, 0, Float},
+	{"U16", 2, 0, Float},
+	{"I32", 4, 0, Float},
+	{"U32", 4, 0, Float},
+	{"I64", 8, 0, Float},
+	{"U64", 8, 0, Float}
+};
+
+#define kFloatInspectorTensorNumberOfSafetensorsTypes \
+	(sizeof(kFloatInspectorTensorSafetensorsTypes) / sizeof(FloatInspectorTensorSafetensorsType))
+
+#pragma mark Private Function Prototypes
+
+static void 
+FloatInspectorTensorFileFree(FloatInspectorTensorFileRef file);
+
+static FloatInspectorTensor *
+FloatInspectorTensorFileAppend(FloatInspectorTensorFileRef file);
+
+static void FloatInspectorTensorSkipSpace(FloatInspectorTensorParser *parser);
+
+static int FloatInspectorTensorExpect(FloatInspectorTensorParser *parser, char c);
+
+static int FloatInspectorTensorParseString(FloatInspectorTensorParser *parser,
+										   char **string);
+
+static int FloatInspectorTensorParseUnsigned(FloatInspectorTensorParser *parser,
+											 uint64_t *value);
+
+static int FloatInspectorTensorParseShape(FloatInspectorTensorParser *parser,
+										  FloatInspectorTensor *tensor,
+										  char open,
+										  char close);
+
+static int FloatInspectorTensorSkipValue(FloatInspectorTensorParser *parser,
+										 unsigned int depth);
+
+static int FloatInspectorTensorSetElements(FloatInspectorTensor *tensor);
+
+static int FloatInspectorTensorParseNumPy(FloatInspectorTensorFileRef file,
+										  const char *path);
+
+static int FloatInspectorTensorParseSafetensors(FloatInspectorTensorFileRef file);
+
+static inline void 
+FloatInspectorTensorUpdateInPlace(FloatInspectorStatisticsRef stats,
+								  enum PrecisionType type,
+								  const void *values,
+								  size_t n);
+
+#pragma mark Private Functions Implementations
+
+static void 
+FloatInspectorTensorFileFree(FloatInspectorTensorFileRef file) {
+	
+	for (unsigned int i = 0; i < file->nTensors; i++) {
+		
+		free(file->tensors[i].name);
+	}
+	
+	free(file->tensors);
+	
+	if (file->map != NULL) {
+		
+		munmap(file->map, file->size);
+	}
+	
+	free(file);
+}
+
+static FloatInspectorTensor *
+FloatInspectorTensorFileAppend(FloatInspectorTensorFileRef file) {
+	
+	/* Grow to powers of two.  */
+	if ((file->nTensors & (file->nTensors - 1)) == 0) {
+		
+		const unsigned int capacity = file->nTensors == 0 ? 1 : 2 * file->nTensors;
+		FloatInspectorTensor *tensors = realloc(file->tensors, 
+												capacity * sizeof(FloatInspectorTensor));
+		
+		if (tensors == NULL) {
+			
+			return NULL;
+		}
+		
+		file->tensors = tensors;
+	}
+	
+	FloatInspectorTensor *tensor = &file->tensors[file->nTensors++];
+	memset(tensor, 0, sizeof(FloatInspectorTensor));
+	
+	return tensor;
+}
+
+static void 
+FloatInspectorTensorSkipSpace(FloatInspectorTensorParser *parser) {
+	
+	while ((parser->p < parser->end) && 
+		   ((*parser->p == ' ') || (*parser->p == '\t') || 
+			(*parser->p == '\n') || (*parser->p == '\r'))) {
+		
+		parser->p++;
+	}
+}
+
+static int 
+FloatInspectorTensorExpect(FloatInspectorTensorParser *parser, char c) {
+	
+	FloatInspectorTensorSkipSpace(parser);
+	
+	if ((parser->p == parser->end) || (*parser->p != c)) {
+		
+		return -1;
+	}
+	
+	parser->p++;
+	
+	return 0;
+}
+
+/* Parses a JSON or Python string literal, the latter may be single quoted.
+ * Escapes are decoded (\u as UTF-8) if string is not NULL, the result is 
+ * owned by the caller.  */
+static int 
+FloatInspectorTensorParseString(FloatInspectorTensorParser *parser,
+								char **string) {
+	
+	FloatInspectorTensorSkipSpace(parser);
+	
+	if ((parser->p == parser->end) || ((*parser->p != '"') && (*parser->p != '\''))) {
+		
+		return -1;
+	}
+	
+	const char quote = *parser->p++;
+	const char *begin = parser->p;
+	
+	while ((parser->p < parser->end) && (*parser->p != quote)) {
+		
+		parser->p += (*parser->p == '\\') ? 2 : 1;
+	}
+	
+	if (parser->p >= parser->end) {
+		
+		return -1;
+	}
+	
+	const char *end = parser->p++;
+	
+	if (string == NULL) {
+		
+		return 0;
+	}
+	
+	/* Decoding never grows the string.  */
+	char *s = malloc((size_t) (end - begin) + 1);
+	size_t length = 0;
+	
+	if (s == NULL) {
+		
+		return -1;
+	}
+	
+	for (const char *q = begin; q < end; q++) {
+		
+		if (*q != '\\') {
+			
+			s[length++] = *q;
+			continue;
+		}
+		
+		switch (*++q) {
+			case 'b': s[length++] = '\b'; break;
+			case 'f': s[length++] = '\f'; break;
+			case 'n': s[length++] = '\n'; break;
+			case 'r': s[length++] = '\r'; break;
+			case 't': s[length++] = '\t'; break;
+				
+			case 'u': {
+				
+				unsigned int code = 0;
+				
+				for (int i = 0; i < 4; i++) {
+					
+					const char h = (q + 1 < end) ? *++q : 'x';
+					
+					if ((h >= '0') && (h <= '9')) code = 16 * code + (unsigned int) (h - '0');
+					else if ((h >= 'a') && (h <= 'f')) code = 16 * code + (unsigned int) (h - 'a' + 10);
+					else if ((h >= 'A') && (h <= 'F')) code = 16 * code + (unsigned int) (h - 'A' + 10);
+					else {
+						
+						free(s);
+						return -1;
+					}
+				}
+				
+				/* Surrogates are kept as they are, names are only printed.  */
+				if (code < 0x80) {
+					
+					s[length++] = (char) code;
+				}
+				else if (code < 0x800) {
+					
+					s[length++] = (char) (0xc0 | (code >> 6));
+					s[length++] = (char) (0x80 | (code & 0x3f));
+				}
+				else {
+					
+					s[length++] = (char) (0xe0 | (code >> 12));
+					s[length++] = (char) (0x80 | ((code >> 6) & 0x3f));
+					s[length++] = (char) (0x80 | (code & 0x3f));
+				}
+				break;
+			}
+				
+			default:
+				s[length++] = *q;
+				break;
+		}
+	}
+	
+	s[length] = '\0';
+	*string = s;
+	
+	return 0;
+}
+
+static int 
+FloatInspectorTensorParseUnsigned(FloatInspectorTensorParser *parser,
+								  uint64_t *value) {
+	
+	FloatInspectorTensorSkipSpace(parser);
+	
+	const char *begin = parser->p;
+	uint64_t v = 0;
+	
+	while ((parser->p < parser->end) && (*parser->p >= '0') && (*parser->p <= '9')) {
+		
+		if (__builtin_mul_overflow(v, 10, &v) || 
+			__builtin_add_overflow(v, (uint64_t) (*parser->p - '0'), &v)) {
+			
+			return -1;
+		}
+		
+		parser->p++;
+	}
+	
+	/* Python 2 wrote long integers with a suffix.  */
+	if ((parser->p < parser->end) && (*parser->p == 'L')) {
+		
+		parser->p++;
+	}
+	
+	*value = v;
+	
+	return parser->p == begin ? -1 : 0;
+}
+
+/* Parses a tuple or list of dimensions, a trailing comma is allowed.  */
+static int 
+FloatInspectorTensorParseShape(FloatInspectorTensorParser *parser,
+							   FloatInspectorTensor *tensor,
+							   char open,
+							   char close) {
+	
+	if (FloatInspectorTensorExpect(parser, open) != 0) {
+		
+		return -1;
+	}
+	
+	tensor->nDimensions = 0;
+	
+	for (;;) {
+		
+		FloatInspectorTensorSkipSpace(parser);
+		
+		if ((parser->p < parser->end) && (*parser->p == close)) {
+			
+			parser->p++;
+			return 0;
+		}
+		
+		if ((tensor->nDimensions == kFloatInspectorTensorMaxDimensions) ||
+			(FloatInspectorTensorParseUnsigned(parser, 
+											   &tensor->shape[tensor->nDimensions]) != 0)) {
+			
+			return -1;
+		}
+		
+		tensor->nDimensions++;
+		
+		FloatInspectorTensorSkipSpace(parser);
+		
+		if ((parser->p < parser->end) && (*parser->p == ',')) {
+			
+			parser->p++;
+		}
+		else if ((parser->p == parser->end) || (*parser->p != close)) {
+			
+			return -1;
+		}
+	}
+}
+
+/* Skips a JSON value or Python literal. Only the structure is checked, 
+ * scalars are any run of word characters.  */
+static int 
+FloatInspectorTensorSkipValue(FloatInspectorTensorParser *parser,
+							  unsigned int depth) {
+	
+	FloatInspectorTensorSkipSpace(parser);
+	
+	if ((parser->p == parser->end) || (depth > kFloatInspectorTensorMaxDepth)) {
+		
+		return -1;
+	}
+	
+	const char c = *parser->p;
+	
+	if ((c == '"') || (c == '\'')) {
+		
+		return FloatInspectorTensorParseString(parser, NULL);
+	}
+	
+	if ((c == '{') || (c == '[') || (c == '(')) {
+		
+		const char close = c == '{' ? '}' : (c == '[' ? ']' : ')');
+		
+		parser->p++;
+		
+		for (;;) {
+			
+			FloatInspectorTensorSkipSpace(parser);
+			
+			if (parser->p == parser->end) {
+				
+				return -1;
+			}
+			
+			if (*parser->p == close) {
+				
+				parser->p++;
+				return 0;
+			}
+			
+			if (FloatInspectorTensorSkipValue(parser, depth + 1) != 0) {
+				
+				return -1;
+			}
+			
+			FloatInspectorTensorSkipSpace(parser);
+			
+			if ((parser->p < parser->end) && ((*parser->p == ',') || (*parser->p == ':'))) {
+				
+				parser->p++;
+			}
+		}
+	}
+	
+	const char *begin = parser->p;
+	
+	while ((parser->p < parser->end) && 
+		   (((*parser->p >= '0') && (*parser->p <= '9')) || 
+			((*parser->p >= 'a') && (*parser->p <= 'z')) ||
+			((*parser->p >= 'A') && (*parser->p <= 'Z')) ||
+			(*parser->p == '-') || (*parser->p == '+') || (*parser->p == '.'))) {
+		
+		parser->p++;
+	}
+	
+	return parser->p == begin ? -1 : 0;
+}
+
+/* Derives the number of elements from the shape, a scalar has rank 0.  */
+static int 
+FloatInspectorTensorSetElements(FloatInspectorTensor *tensor) {
+	
+	size_t n = 1;
+	
+	for (unsigned int i = 0; i < tensor->nDimensions; i++) {
+		
+		if ((tensor->shape[i] > SIZE_MAX) || 
+			__builtin_mul_overflow(n, (size_t) tensor->shape[i], &n)) {
+			
+			return -1;
+		}
+	}
+	
+	tensor->nElements = n;
+	
+	return 0;
+}
+
+/* Version 1 headers have a 16 bit length, versions 2 and 3 a 32 bit one.  */
+static int 
+FloatInspectorTensorParseNumPy(FloatInspectorTensorFileRef file,
+							   const char *path) {
+	
+	const uint8_t *bytes = file->map;
+	const size_t prefix = bytes[6] == 1 ? 10 : 12;
+	
+	if (file->size < prefix) {
+		
+		return -1;
+	}
+	
+	size_t length = (size_t) bytes[8] | ((size_t) bytes[9] << 8);
+	
+	if (prefix == 12) {
+		
+		length |= ((size_t) bytes[10] << 16) | ((size_t) bytes[11] << 24);
+	}
+	
+	if (length > file->size - prefix) {
+		
+		return -1;
+	}
+	
+	FloatInspectorTensor *tensor = FloatInspectorTensorFileAppend(file);
+	
+	if (tensor == NULL) {
+		
+		return -1;
+	}
+	
+	const char *base = strrchr(path, '/');
+	tensor->name = strdup(base == NULL ? path : base + 1);
+	
+	if (tensor->name == NULL) {
+		
+		return -1;
+	}
+	
+	FloatInspectorTensorParser parser = {
+		(const char *) bytes + prefix,
+		(const char *) bytes + prefix + length
+	};
+	int hasShape = 0;
+	
+	if (FloatInspectorTensorExpect(&parser, '{') != 0) {
+		
+		return -1;
+	}
+	
+	for (;;) {
+		
+		FloatInspectorTensorSkipSpace(&parser);
+		
+		if ((parser.p < parser.end) && (*parser.p == '}')) {
+			
+			break;
+		}
+		
+		char *key;
+		int failed;
+		
+		if (FloatInspectorTensorParseString(&parser, &key) != 0) {
+			
+			return -1;
+		}
+		
+		if (FloatInspectorTensorExpect(&parser, ':') != 0) {
+			
+			failed = -1;
+		}
+		else if (strcmp(key, "shape") == 0) {
+			
+			failed = FloatInspectorTensorParseShape(&parser, tensor, '(', ')');
+			hasShape = 1;
+		}
+		else if (strcmp(key, "descr") == 0) {
+			
+			char *descr = NULL;
+			
+			FloatInspectorTensorSkipSpace(&parser);
+			
+			/* Structured types are lists of fields, they stay 
+			 * unsupported.  */
+			if ((parser.p < parser.end) && (*parser.p == '[')) {
+				
+				failed = FloatInspectorTensorSkipValue(&parser, 0);
+				strcpy(tensor->dtype, "structured");
+			}
+			else if ((failed = FloatInspectorTensorParseString(&parser, &descr)) == 0) {
+				
+				strncpy(tensor->dtype, descr, sizeof(tensor->dtype) - 1);
+				free(descr);
+			}
+		}
+		else {
+			
+			/* The storage order does not matter to statistics.  */
+			failed = FloatInspectorTensorSkipValue(&parser, 0);
+		}
+		
+		free(key);
+		
+		if (failed) {
+			
+			return -1;
+		}
+		
+		FloatInspectorTensorSkipSpace(&parser);
+		
+		if ((parser.p < parser.end) && (*parser.p == ',')) {
+			
+			parser.p++;
+		}
+	}
+	
+	if (!hasShape || (tensor->dtype[0] == '\0') || 
+		(FloatInspectorTensorSetElements(tensor) != 0)) {
+		
+		return -1;
+	}
+	
+	/* Descriptors are a byte order, a kind and the size in bytes.  */
+	const char order = tensor->dtype[0];
+	char *sizeEnd;
+	const unsigned long size = strtoul(tensor->dtype + 2, &sizeEnd, 10);
+	
+	if ((strchr("<>=|", order) == NULL) || (tensor->dtype[1] == '\0') || 
+		(sizeEnd == tensor->dtype + 2) || (*sizeEnd != '\0')) {
+		
+		return 0;
+	}
+	
+	tensor->elementSize = size;
+	tensor->swapped = kFloatInspectorTensorBigEndianHost ? (order == '<') : (order == '>');
+	tensor->data = bytes + prefix + length;
+	
+	if ((tensor->elementSize != 0) && 
+		(tensor->nElements > (file->size - prefix - length) / tensor->elementSize)) {
+		
+		return -1;
+	}
+	
+	if (tensor->dtype[1] == 'f') {
+		
+		tensor->supported = 1;
+		
+		switch (size) {
+			case 2:
+				tensor->type = Half;
+				break;
+				
+			case sizeof(float):
+				tensor->type = Float;
+				break;
+				
+			case sizeof(double):
+				tensor->type = Double;
+				break;
+				
+			default:
+				/* Only the host's own extended format can be read, which 
+				 * NumPy stores padded to the size of long double.  */
+				tensor->type = LongDouble;
+				tensor->supported = (size == sizeof(long double)) && !tensor->swapped && 
+					(LDBL_MANT_DIG > DBL_MANT_DIG);
+				break;
+		}
+	}
+	
+	return 0;
+}
+
+/* An eight byte little endian header length, a JSON object of tensors and
+ * the payload, to which the tensors' offsets are relative.  */
+static int 
+FloatInspectorTensorParseSafetensors(FloatInspectorTensorFileRef file) {
+	
+	const uint8_t *bytes = file->map;
+	uint64_t length = 0;
+	
+	for (int i = 7; i >= 0; i--) {
+		
+		length = (length << 8) | bytes[i];
+	}
+	
+	if (length > file->size - 8) {
+		
+		return -1;
+	}
+	
+	const uint8_t *payload = bytes + 8 + length;
+	const size_t nPayloadBytes = file->size - 8 - (size_t) length;
+	
+	FloatInspectorTensorParser parser = {
+		(const char *) bytes + 8,
+		(const char *) payload
+	};
+	
+	if (FloatInspectorTensorExpect(&parser, '{') != 0) {
+		
+		return -1;
+	}
+	
+	for (;;) {
+		
+		FloatInspectorTensorSkipSpace(&parser);
+		
+		if ((parser.p < parser.end) && (*parser.p == '}')) {
+			
+			return 0;
+		}
+		
+		char *name;
+		
+		if ((FloatInspectorTensorParseString(&parser, &name) != 0)) {
+			
+			return -1;
+		}
+		
+		if ((FloatInspectorTensorExpect(&parser, ':') != 0) || 
+			(strcmp(name, "__metadata__") == 0)) {
+			
+			free(name);
+			
+			if (FloatInspectorTensorSkipValue(&parser, 0) != 0) {
+				
+				return -1;
+			}
+		}
+		else {
+			
+			FloatInspectorTensor *tensor = FloatInspectorTensorFileAppend(file);
+			uint64_t begin = 0;
+			uint64_t end = 0;
+			int hasShape = 0;
+			int hasOffsets = 0;
+			
+			if (tensor == NULL) {
+				
+				free(name);
+				return -1;
+			}
+			
+			tensor->name = name;
+			
+			if (FloatInspectorTensorExpect(&parser, '{') != 0) {
+				
+				return -1;
+			}
+			
+			for (;;) {
+				
+				FloatInspectorTensorSkipSpace(&parser);
+				
+				if ((parser.p < parser.end) && (*parser.p == '}')) {
+					
+					parser.p++;
+					break;
+				}
+				
+				char *key;
+				int failed;
+				
+				if (FloatInspectorTensorParseString(&parser, &key) != 0) {
+					
+					return -1;
+				}
+				
+				if (FloatInspectorTensorExpect(&parser, ':') != 0) {
+					
+					failed = -1;
+				}
+				else if (strcmp(key, "dtype") == 0) {
+					
+					char *dtype = NULL;
+					
+					if ((failed = FloatInspectorTensorParseString(&parser, &dtype)) == 0) {
+						
+						strncpy(tensor->dtype, dtype, sizeof(tensor->dtype) - 1);
+						free(dtype);
+					}
+				}
+				else if (strcmp(key, "shape") == 0) {
+					
+					failed = FloatInspectorTensorParseShape(&parser, tensor, '[', ']');
+					hasShape = 1;
+				}
+				else if (strcmp(key, "data_offsets") == 0) {
+					
+					failed = (FloatInspectorTensorExpect(&parser, '[') != 0) || 
+						(FloatInspectorTensorParseUnsigned(&parser, &begin) != 0) ||
+						(FloatInspectorTensorExpect(&parser, ',') != 0) ||
+						(FloatInspectorTensorParseUnsigned(&parser, &end) != 0) ||
+						(FloatInspectorTensorExpect(&parser, ']') != 0);
+					hasOffsets = 1;
+				}
+				else {
+					
+					failed = FloatInspectorTensorSkipValue(&parser, 0);
+				}
+				
+				free(key);
+				
+				if (failed) {
+					
+					return -1;
+				}
+				
+				FloatInspectorTensorSkipSpace(&parser);
+				
+				if ((parser.p < parser.end) && (*parser.p == ',')) {
+					
+					parser.p++;
+				}
+			}
+			
+			if (!hasShape || !hasOffsets || (begin > end) || (end > nPayloadBytes) ||
+				(FloatInspectorTensorSetElements(tensor) != 0)) {
+				
+				return -1;
+			}
+			
+			for (size_t i = 0; i < kFloatInspectorTensorNumberOfSafetensorsTypes; i++) {
+				
+				if (strcmp(tensor->dtype, kFloatInspectorTensorSafetensorsTypes[i].dtype) == 0) {
+					
+					tensor->elementSize = kFloatInspectorTensorSafetensorsTypes[i].size;
+					tensor->supported = kFloatInspectorTensorSafetensorsTypes[i].supported;
+					tensor->type = kFloatInspectorTensorSafetensorsTypes[i].type;
+				}
+			}
+			
+			/* The payload is little endian.  */
+			tensor->swapped = kFloatInspectorTensorBigEndianHost;
+			tensor->data = payload + begin;
+			
+			if ((tensor->elementSize != 0) && 
+				((end - begin) / tensor->elementSize != tensor->nElements ||
+				 (end - begin) % tensor->elementSize != 0)) {
+				
+				return -1;
+			}
+		}
+		
+		FloatInspectorTensorSkipSpace(&parser);
+		
+		if ((parser.p < parser.end) && (*parser.p == ',')) {
+			
+			parser.p++;
+		}
+		else if ((parser.p == parser.end) || (*parser.p != '}')) {
+			
+			return -1;
+		}
+	}
+}
+
+static inline void 
+FloatInspectorTensorUpdateInPlace(FloatInspectorStatisticsRef stats,
+								  enum PrecisionType type,
+								  const void *values,
+								  size_t n) {
+	
+	switch (type) {
+		case Float:
+			FloatInspectorStatisticsUpdateWithFloats(stats, values, n);
+			break;
+			
+		case Double:
+			FloatInspectorStatisticsUpdateWithDoubles(stats, values, n);
+			break;
+			
+		case LongDouble:
+			FloatInspectorStatisticsUpdateWithLongDoubles(stats, values, n);
+			break;
+			
+		case Half:
+			FloatInspectorStatisticsUpdateWithHalfs(stats, values, n);
+			break;
+			
+		case BFloat16:
+			FloatInspectorStatisticsUpdateWithBFloat16s(stats, values, n);
+			break;
+	}
+}
+
+#pragma mark Public Functions Implementations
+
+FloatInspectorTensorFileRef 
+FloatInspectorTensorFileOpen(const char *path) {
+	
+	const int fd = open(path, O_RDONLY);
+	
+	if (fd < 0) {
+		
+		return NULL;
+	}
+	
+	struct stat st;
+	FloatInspectorTensorFileRef file = NULL;
+	int error = EINVAL;
+	
+	if (fstat(fd, &st) != 0) {
+		
+		error = errno;
+	}
+	else if ((st.st_size >= 10) && ((uint64_t) st.st_size <= SIZE_MAX) &&
+			 ((file = calloc(1, sizeof(_FloatInspectorTensorFile))) == NULL)) {
+		
+		error = ENOMEM;
+	}
+	else if (file != NULL) {
+		
+		file->size = (size_t) st.st_size;
+		file->map = mmap(NULL, file->size, PROT_READ, MAP_PRIVATE, fd, 0);
+		
+		if (file->map == MAP_FAILED) {
+			
+			error = errno;
+			file->map = NULL;
+		}
+		else {
+			
+			/* Tensors are streamed front to back, one chunk per thread.  */
+			madvise(file->map, file->size, MADV_SEQUENTIAL);
+			
+			int failed;
+			
+			errno = 0;
+			
+			if (memcmp(file->map, kFloatInspectorTensorNumPyMagic, 6) == 0) {
+				
+				file->format = NumPyTensorFile;
+				failed = FloatInspectorTensorParseNumPy(file, path);
+			}
+			else {
+				
+				file->format = SafetensorsTensorFile;
+				failed = FloatInspectorTensorParseSafetensors(file);
+			}
+			
+			/* Allocations are the only other way parsing fails.  */
+			error = failed ? (errno == ENOMEM ? ENOMEM : EINVAL) : 0;
+		}
+	}
+	
+	close(fd);
+	
+	if (error != 0) {
+		
+		if (file != NULL) {
+			
+			FloatInspectorTensorFileFree(file);
+		}
+		
+		errno = error;
+		return NULL;
+	}
+	
+	return file;
+}
+
+void 
+FloatInspectorTensorFileClose(FloatInspectorTensorFileRef file) {
+	
+	if (file == NULL) {
+		
+		return;
+	}
+	
+	FloatInspectorTensorFileFree(file);
+}
+
+void 
+FloatInspectorTensorUpdateStatistics(const FloatInspectorTensor *tensor,
+									 FloatInspectorStatisticsRef stats,
+									 size_t first,
+									 size_t n) {
+	
+	assert(tensor->supported && (stats->type == tensor->type));
+	assert((first <= tensor->nElements) && (n <= tensor->nElements - first));
+	
+	const size_t size = tensor->elementSize;
+	const uint8_t *values = (const uint8_t *) tensor->data + first * size;
+	
+	/* Elements are naturally aligned in either format in practice, the 
+	 * formats just do not promise it.  */
+	if (!tensor->swapped && (((uintptr_t) values % size) == 0)) {
+		
+		FloatInspectorTensorUpdateInPlace(stats, tensor->type, values, n);
+		return;
+	}
+	
+	union {
+		
+		uint16_t words16[kFloatInspectorTensorChunk];
+		uint32_t words32[kFloatInspectorTensorChunk];
+		uint64_t words64[kFloatInspectorTensorChunk];
+		long double longDoubles[kFloatInspectorTensorChunk];
+		
+	} buffer;
+	
+	for (size_t done = 0; done < n; done += kFloatInspectorTensorChunk) {
+		
+		const size_t nChunk = n - done < kFloatInspectorTensorChunk ? 
+			n - done : kFloatInspectorTensorChunk;
+		
+		memcpy(&buffer, values + done * size, nChunk * size);
+		
+		if (tensor->swapped) {
+			
+			switch (size) {
+				case 2:
+					for (size_t i = 0; i < nChunk; i++) {
+						
+						buffer.words16[i] = __builtin_bswap16(buffer.words16[i]);
+					}
+					break;
+					
+				case 4:
+					for (size_t i = 0; i < nChunk; i++) {
+						
+						buffer.words32[i] = __builtin_bswap32(buffer.words32[i]);
+					}
+					break;
+					
+				case 8:
+					for (size_t i = 0; i < nChunk; i++) {
+						
+						buffer.words64[i] = __builtin_bswap64(buffer.words64[i]);
+					}
+					break;
+			}
+		}
+		
+		FloatInspectorTensorUpdateInPlace(stats, tensor->type, &buffer, nChunk);
+	}
+}
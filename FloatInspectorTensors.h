@@ -0,0 +1,105 @@
+//
+//  FloatInspectorTensors.h
+//  FloatInspector
+//  
+//  Copyright 2011 Stefan Reinhold <stefan@sreinhold.com>. All rights reserved.
+//  
+//  Redistribution and use in source and binary forms, with or without modification, are
+//  permitted provided that the following conditions are met:
+//  
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//  
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list
+//  of conditions and the following disclaimer in the documentation and/or other materials
+//  provided with the distribution.
+//  
+//  THIS SOFTWARE IS PROVIDED BY STEFAN REINHOLD ``AS IS'' AND ANY EXPRESS OR IMPLIED
+//  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STEFAN REINHOLD OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+//  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+//  ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//  
+//  The views and conclusions contained in the software and documentation are those of the
+//  authors and should not be interpreted as representing official policies, either expressed
+//  or implied, of Stefan Reinhold.
+//  
+
+
+
+#ifndef FloatInspector_FloatInspectorTensors_h
+#define FloatInspector_FloatInspectorTensors_h
+
+#include "FloatInspector.h"
+
+#pragma mark Constants
+
+/* Maximal rank of a tensor, the one of NumPy.  */
+#define kFloatInspectorTensorMaxDimensions	32
+
+#pragma mark Data Types
+
+typedef enum {
+	NumPyTensorFile,
+	SafetensorsTensorFile
+} FloatInspectorTensorFileFormat;
+
+/* One tensor of a mapped file. Data points into the mapping and stays 
+ * valid until the file is closed.  */
+typedef struct {
+	
+	char *name;
+	/* Element type as stored in the file, e.g. "<f4" or "BF16".  */
+	char dtype[16];
+	
+	/* Whether the elements map to a precision type, only supported tensors
+	 * can be fed to statistics.  */
+	int supported;
+	enum PrecisionType type;
+	/* Elements are stored in the opposite byte order of the host.  */
+	int swapped;
+	
+	const void *data;
+	size_t elementSize;
+	size_t nElements;
+	
+	unsigned int nDimensions;
+	uint64_t shape[kFloatInspectorTensorMaxDimensions];
+	
+} FloatInspectorTensor;
+
+typedef struct {
+	
+	FloatInspectorTensorFileFormat format;
+	
+	void *map;
+	size_t size;
+	
+	unsigned int nTensors;
+	FloatInspectorTensor *tensors;
+	
+} _FloatInspectorTensorFile;
+typedef _FloatInspectorTensorFile* FloatInspectorTensorFileRef;
+
+#pragma mark Public Functions
+
+/* Maps a .npy or .safetensors file read only and parses its header, the 
+ * format is told by the content. Returns NULL and sets errno on failure, 
+ * EINVAL if the header is malformed or a tensor exceeds the file.  */
+FloatInspectorTensorFileRef FloatInspectorTensorFileOpen(const char *path);
+
+void FloatInspectorTensorFileClose(FloatInspectorTensorFileRef file);
+
+/* Feeds n elements starting at first to the bulk path of the tensor's 
+ * precision type. Swapped or misaligned elements are copied in chunks, 
+ * which may run concurrently for disjoint statistics.  */
+void FloatInspectorTensorUpdateStatistics(const FloatInspectorTensor *tensor,
+										  FloatInspectorStatisticsRef stats,
+										  size_t first,
+										  size_t n);
+
+#endif
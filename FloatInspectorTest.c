@@ -31,14 +31,78 @@
 
 
 #include "FloatInspector.h"
+#include "FloatInspectorAggregator.h"
+#include "FloatInspectorCrawl.h"
+#include "FloatInspectorPerf.h"
+#include "FloatInspectorSnapshot.h"
+#include "FloatInspectorTable.h"
+#include "FloatInspectorText.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <float.h>
+#include <math.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
 
 
 int main(int, char **);
 
+static void FloatInspectorTestCountFile(const FloatInspectorCrawlFile *file, void *context);
+
+static void *FloatInspectorTestServe(void *aggregator);
+
+static void *FloatInspectorTestProfile(void *stats);
+
+static const char *FloatInspectorTestInconsistent(void);
+
+/* Checks that failed, any of them fails the test.  */
+static unsigned int FloatInspectorTestFailures = 0;
+
+/* Verdict of a failed check, which is counted.  */
+static const char *
+FloatInspectorTestInconsistent(void) {
+	
+	FloatInspectorTestFailures++;
+	
+	return "INCONSISTENT";
+}
+
+/* Counts completed, resumed and failed files.  */
+static void 
+FloatInspectorTestCountFile(const FloatInspectorCrawlFile *file, void *context) {
+	
+	unsigned int *counts = context;
+	
+	counts[0]++;
+	counts[1] += file->resumed != 0;
+	counts[2] += file->error != 0;
+}
+
+static void *
+FloatInspectorTestServe(void *aggregator) {
+	
+	FloatInspectorAggregatorRun(aggregator);
+	
+	return NULL;
+}
+
+/* Array updates of a worker thread, reported on the threaded path.  */
+static void *
+FloatInspectorTestProfile(void *stats) {
+	
+	const float values[] = {1.f, -2.5f, 1e-40f, 3e38f};
+	
+	FloatInspectorPerfMarkWorkerThread();
+	FloatInspectorStatisticsUpdateWithFloats(stats, values, 4);
+	
+	return NULL;
+}
+
 int
 main(int argc, char **argv) {
 	
@@ -139,10 +203,936 @@ main(int argc, char **argv) {
 	FloatInspectorStatisticsPrint(statsD, stdout);
 	FloatInspectorStatisticsPrint(statsLD, stdout);
 	
+	/* The bulk paths have to agree with the per value path.  */
+	{
+		FloatInspectorStatisticsRef bulkF = FloatInspectorStatisticsCreateFloat();
+		FloatInspectorStatisticsRef bulkD = FloatInspectorStatisticsCreateDouble();
+		
+		FloatInspectorStatisticsUpdateWithFloats(bulkF, fvals, 
+												 sizeof(fvals) / sizeof(float));
+		FloatInspectorStatisticsUpdateWithDoubles(bulkD, dvals, 
+												  sizeof(dvals) / sizeof(double));
+		
+		FloatInspectorStatisticsDiffRef diffF = 
+			FloatInspectorStatisticsDiffCreate(statsF, bulkF);
+		FloatInspectorStatisticsDiffRef diffD = 
+			FloatInspectorStatisticsDiffCreate(statsD, bulkD);
+		
+		printf("Bulk float path:\t\t\t\t\t%s\n"
+			   "Bulk double path:\t\t\t\t\t%s\n\n",
+			   diffF->nChanges == 0 && diffF->nEntries == 0 ? "consistent" : FloatInspectorTestInconsistent(),
+			   diffD->nChanges == 0 && diffD->nEntries == 0 ? "consistent" : FloatInspectorTestInconsistent());
+		
+		FloatInspectorStatisticsDiffFree(diffF);
+		FloatInspectorStatisticsDiffFree(diffD);
+		FloatInspectorStatisticsFree(bulkF);
+		FloatInspectorStatisticsFree(bulkD);
+	}
+	
+	/* Snapshots, diffs and their delta encoding.  */
+	{
+		FloatInspectorMonitorRef monitor = FloatInspectorMonitorCreate(Double);
+		
+		for (int i = 0; i < sizeof(dvals) / sizeof(double); i++) {
+			
+			FloatInspectorMonitorUpdateWithDouble(monitor, dvals[i]);
+		}
+		
+		FloatInspectorStatisticsRef first = FloatInspectorMonitorTakeSnapshot(monitor);
+		
+		FloatInspectorMonitorUpdateWithDouble(monitor, 2.);
+		FloatInspectorMonitorUpdateWithDouble(monitor, -DBL_MIN / 4);
+		
+		FloatInspectorStatisticsRef second = FloatInspectorMonitorTakeSnapshot(monitor);
+		
+		FloatInspectorStatisticsDiffRef diff = 
+			FloatInspectorStatisticsDiffCreate(first, second);
+		
+		uint8_t *buffer = malloc(FloatInspectorStatisticsDiffEncodedSize(diff));
+		const size_t nBytes = 
+			FloatInspectorStatisticsDiffEncode(diff, buffer, 
+											   FloatInspectorStatisticsDiffEncodedSize(diff));
+		
+		FloatInspectorStatisticsDiffRef decoded = 
+			FloatInspectorStatisticsDiffDecode(buffer, nBytes);
+		
+		FloatInspectorStatisticsDiffApply(first, decoded);
+		
+		/* A counter of 2^64 does not fit its varint and has to be rejected 
+		 * rather than truncated.  */
+		const uint8_t oversized[] = {
+			'F', 'I', 'D', 2, Double, 64, 11, 52, 
+			0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x02, 
+			0, 0, 0, 0, 0, 0, 
+			0, 0, 0, 0
+		};
+		FloatInspectorStatisticsDiffRef rejected = 
+			FloatInspectorStatisticsDiffDecode(oversized, sizeof(oversized));
+		
+		/* Counters go past 2^32, but a diff that would wrap them is refused
+		 * as a whole.  */
+		FloatInspectorStatisticsRef large = FloatInspectorStatisticsCopy(second);
+		
+		large->nEntries = UINT32_MAX;
+		
+		int counted = FloatInspectorStatisticsDiffApply(large, decoded) == 0 && 
+			large->nEntries == (uint64_t) UINT32_MAX + 2;
+		const uint64_t nDenormalized = large->nDenormalized;
+		
+		large->nEntries = UINT64_MAX;
+		counted &= FloatInspectorStatisticsDiffApply(large, decoded) != 0 && 
+			large->nEntries == UINT64_MAX && large->nDenormalized == nDenormalized;
+		
+		printf("Snapshot diff:\t\t\t\t\t\t%u changed cells, %zu bytes encoded, %s\n\n",
+			   diff->nChanges, 
+			   nBytes,
+			   first->nEntries == second->nEntries &&
+			   first->nDenormalized == second->nDenormalized && 
+			   rejected == NULL && counted ? "consistent" : FloatInspectorTestInconsistent());
+		
+		if (rejected != NULL) FloatInspectorStatisticsDiffFree(rejected);
+		FloatInspectorStatisticsFree(large);
+		
+		free(buffer);
+		FloatInspectorStatisticsDiffFree(decoded);
+		FloatInspectorStatisticsDiffFree(diff);
+		FloatInspectorStatisticsFree(first);
+		FloatInspectorStatisticsFree(second);
+		FloatInspectorMonitorFree(monitor);
+	}
+	
+	/* Distinct values of two halves, estimated separately and merged.  */
+	{
+		const size_t nValues = 100000;
+		double *values = malloc(nValues * sizeof(double));
+		
+		for (size_t i = 0; i < nValues; i++) {
+			
+			/* 50000 distinct values, each one twice.  */
+			values[i] = (double) (i % (nValues / 2)) / 7.;
+		}
+		
+		FloatInspectorStatisticsRef left = FloatInspectorStatisticsCreateDouble();
+		FloatInspectorStatisticsRef right = FloatInspectorStatisticsCreateDouble();
+		
+		FloatInspectorStatisticsEnableCardinality(left, kFloatInspectorCardinalityDefaultPrecision);
+		FloatInspectorStatisticsEnableCardinality(right, kFloatInspectorCardinalityDefaultPrecision);
+		
+		FloatInspectorStatisticsUpdateWithDoubles(left, values, nValues / 2);
+		FloatInspectorStatisticsUpdateWithDoubles(right, values + nValues / 2, nValues / 2);
+		FloatInspectorStatisticsMerge(left, right);
+		
+		const double estimate = FloatInspectorStatisticsCardinality(left);
+		
+		printf("Distinct values:\t\t\t\t\t%.0f of %zu estimated, %s\n\n",
+			   estimate,
+			   nValues / 2,
+			   fabs(estimate - (double) (nValues / 2)) < .05 * (double) (nValues / 2) ? 
+			   "consistent" : FloatInspectorTestInconsistent());
+		
+		free(values);
+		FloatInspectorStatisticsFree(left);
+		FloatInspectorStatisticsFree(right);
+	}
+	
+	/* Fill values among distinct ones, counted on two shards.  */
+	{
+		const size_t nValues = 100000;
+		float *values = malloc(nValues * sizeof(float));
+		
+		for (size_t i = 0; i < nValues; i++) {
+			
+			values[i] = i % 10 == 0 ? -9999.f : (i % 20 == 1 ? 0.f : (float) i / 3.f);
+		}
+		
+		FloatInspectorStatisticsRef left = FloatInspectorStatisticsCreateFloat();
+		FloatInspectorStatisticsRef right = FloatInspectorStatisticsCreateFloat();
+		
+		FloatInspectorStatisticsEnableHeavyHitters(left, kFloatInspectorHeavyHittersDefaultCapacity);
+		FloatInspectorStatisticsEnableHeavyHitters(right, kFloatInspectorHeavyHittersDefaultCapacity);
+		
+		FloatInspectorStatisticsUpdateWithFloats(left, values, nValues / 2);
+		FloatInspectorStatisticsUpdateWithFloats(right, values + nValues / 2, nValues / 2);
+		FloatInspectorStatisticsMerge(left, right);
+		
+		FloatInspectorHeavyHitter hitters[2];
+		FloatInspectorHeavyHittersGet(left->heavyHitters, hitters, 2);
+		
+		float first, second;
+		memcpy(&first, hitters[0].bits, sizeof(first));
+		memcpy(&second, hitters[1].bits, sizeof(second));
+		
+		printf("Most frequent values:\t\t\t\t%g, %g, %s\n\n",
+			   first,
+			   second,
+			   first == -9999.f && second == 0.f &&
+			   hitters[0].count - hitters[0].error <= nValues / 10 &&
+			   hitters[0].count >= nValues / 10 ? "consistent" : FloatInspectorTestInconsistent());
+		
+		free(values);
+		FloatInspectorStatisticsFree(left);
+		FloatInspectorStatisticsFree(right);
+	}
+	
+	/* Quantiles of two shards, the magnitudes are 0.001 ... 100.  */
+	{
+		const size_t nValues = 100000;
+		double *values = malloc(nValues * sizeof(double));
+		
+		for (size_t i = 0; i < nValues; i++) {
+			
+			/* Shuffled, every other value negative, plus non-finite ones
+			 * that have to be ignored.  */
+			const size_t j = (i * 7919) % nValues;
+			values[i] = (double) (j + 1) / (j % 2 ? 1000. : -1000.);
+		}
+		values[17] = NAN;
+		values[4711] = -INFINITY;
+		
+		FloatInspectorStatisticsRef left = FloatInspectorStatisticsCreateDouble();
+		FloatInspectorStatisticsRef right = FloatInspectorStatisticsCreateDouble();
+		
+		FloatInspectorStatisticsEnableQuantiles(left, kFloatInspectorQuantilesDefaultK);
+		FloatInspectorStatisticsEnableQuantiles(right, kFloatInspectorQuantilesDefaultK);
+		
+		FloatInspectorStatisticsUpdateWithDoubles(left, values, nValues / 2);
+		FloatInspectorStatisticsUpdateWithDoubles(right, values + nValues / 2, nValues / 2);
+		FloatInspectorStatisticsMerge(left, right);
+		
+		const double median = FloatInspectorStatisticsMagnitudeQuantile(left, .5);
+		const double p99 = FloatInspectorStatisticsMagnitudeQuantile(left, .99);
+		
+		int consistent = fabs(median - 50.) < 2. && fabs(p99 - 99.) < 2. &&
+			FloatInspectorStatisticsMagnitudeQuantile(left, 1.) == 100. &&
+			FloatInspectorQuantilesCount(left->magnitudes) == nValues - 2;
+		
+		/* A sketch of another k is refused without touching the target, a 
+		 * sketch only one side has never covers values of the other one.  */
+		FloatInspectorStatisticsRef other = FloatInspectorStatisticsCreateDouble();
+		FloatInspectorStatisticsRef plain = FloatInspectorStatisticsCreateDouble();
+		
+		FloatInspectorStatisticsEnableQuantiles(other, 2 * kFloatInspectorQuantilesDefaultK);
+		FloatInspectorStatisticsUpdateWithDoubles(other, values, 10);
+		FloatInspectorStatisticsUpdateWithDoubles(plain, values, 10);
+		
+		consistent &= FloatInspectorStatisticsMerge(left, other) == -1 &&
+			left->nEntries == nValues &&
+			FloatInspectorQuantilesCount(left->magnitudes) == nValues - 2;
+		
+		consistent &= FloatInspectorStatisticsMerge(plain, right) == 0 &&
+			plain->magnitudes == NULL && plain->nEntries == 10 + nValues / 2;
+		
+		consistent &= FloatInspectorStatisticsMerge(left, plain) == 0 &&
+			left->magnitudes == NULL && left->nEntries == nValues + nValues / 2 + 10;
+		
+		/* Long doubles beyond the double range are clamped, not infinite.  */
+		FloatInspectorStatisticsRef longDoubles = FloatInspectorStatisticsCreateLongDouble();
+		FloatInspectorStatisticsEnableQuantiles(longDoubles, kFloatInspectorQuantilesDefaultK);
+		FloatInspectorStatisticsUpdateWithLongDouble(longDoubles, -LDBL_MAX);
+		FloatInspectorStatisticsUpdateWithLongDouble(longDoubles, 1.L);
+		
+		consistent &= FloatInspectorStatisticsMagnitudeQuantile(longDoubles, 1.) == 
+			(LDBL_MAX > DBL_MAX ? DBL_MAX : (double) LDBL_MAX);
+		
+		printf("Magnitude quantiles:\t\t\t\tp50 %.0f, p99 %.0f, exponent p50 %.0f, %s\n\n",
+			   median,
+			   p99,
+			   FloatInspectorStatisticsExponentQuantile(left, .5),
+			   consistent ? "consistent" : FloatInspectorTestInconsistent());
+		
+		free(values);
+		FloatInspectorStatisticsFree(left);
+		FloatInspectorStatisticsFree(right);
+		FloatInspectorStatisticsFree(other);
+		FloatInspectorStatisticsFree(plain);
+		FloatInspectorStatisticsFree(longDoubles);
+	}
+	
+	/* Exponents of two shards, every binade of double once with alternating
+	 * signs, both zeros and a NaN.  */
+	{
+		const int minimum = DBL_MIN_EXP - DBL_MANT_DIG;
+		const int maximum = DBL_MAX_EXP - 1;
+		const size_t nValues = (size_t) (maximum - minimum + 1);
+		double *values = malloc((nValues + 3) * sizeof(double));
+		
+		for (size_t i = 0; i < nValues; i++) {
+			
+			values[i] = ldexp(i % 2 ? -1. : 1., minimum + (int) i);
+		}
+		values[nValues] = 0.;
+		values[nValues + 1] = -0.;
+		values[nValues + 2] = NAN;
+		
+		FloatInspectorStatisticsRef left = FloatInspectorStatisticsCreateDouble();
+		FloatInspectorStatisticsRef right = FloatInspectorStatisticsCreateDouble();
+		FloatInspectorStatisticsRef longDoubles = FloatInspectorStatisticsCreateLongDouble();
+		
+		FloatInspectorStatisticsEnableExponents(left);
+		FloatInspectorStatisticsEnableExponents(right);
+		FloatInspectorStatisticsEnableExponents(longDoubles);
+		
+		FloatInspectorStatisticsUpdateWithDoubles(left, values, nValues / 2);
+		FloatInspectorStatisticsUpdateWithDoubles(right, values + nValues / 2, nValues - nValues / 2 + 3);
+		FloatInspectorStatisticsMerge(left, right);
+		
+		int consistent = FloatInspectorExponentsZeros(left->exponents, 0) == 1 &&
+			FloatInspectorExponentsZeros(left->exponents, 1) == 1 &&
+			FloatInspectorExponentsTotal(left->exponents) == nValues + 2 &&
+			FloatInspectorStatisticsExponentQuantile(left, 0.) == -INFINITY &&
+			FloatInspectorStatisticsExponentQuantile(left, 1.) == maximum;
+		
+		for (size_t i = 0; i < nValues; i++) {
+			
+			consistent &= FloatInspectorExponentsCount(left->exponents, i % 2, minimum + (int) i) == 1;
+		}
+		
+		/* The same through the long double path, where all of them are 
+		 * normalized.  */
+		for (size_t i = 0; i < nValues + 3; i++) {
+			
+			FloatInspectorStatisticsUpdateWithLongDouble(longDoubles, values[i]);
+		}
+		
+		consistent &= FloatInspectorExponentsTotal(longDoubles->exponents) == nValues + 2 &&
+			FloatInspectorExponentsCount(longDoubles->exponents, 0, minimum) == 1 &&
+			FloatInspectorExponentsCount(longDoubles->exponents, 1, maximum) == 1;
+		
+		printf("Exponent histogram:\t\t\t\t%d ... %d, %s\n\n",
+			   minimum,
+			   maximum,
+			   consistent ? "consistent" : FloatInspectorTestInconsistent());
+		
+		free(values);
+		FloatInspectorStatisticsFree(left);
+		FloatInspectorStatisticsFree(right);
+		FloatInspectorStatisticsFree(longDoubles);
+	}
+	
+	/* Moments of two shards of badly conditioned values 1e8 + 0.001 ... 
+	 * 1e8 + 1, the textbook variance formula loses all digits here.  */
+	{
+		const size_t nValues = 100000;
+		float *floats = malloc(nValues * sizeof(float));
+		double *values = malloc(nValues * sizeof(double));
+		
+		for (size_t i = 0; i < nValues; i++) {
+			
+			values[i] = 1e8 + (double) ((i * 7919) % 1000 + 1) / 1000.;
+			floats[i] = (float) i;
+		}
+		values[42] = NAN;
+		values[4711] = INFINITY;
+		
+		FloatInspectorStatisticsRef left = FloatInspectorStatisticsCreateDouble();
+		FloatInspectorStatisticsRef right = FloatInspectorStatisticsCreateDouble();
+		FloatInspectorStatisticsRef singles = FloatInspectorStatisticsCreateFloat();
+		
+		FloatInspectorStatisticsEnableMoments(left);
+		FloatInspectorStatisticsEnableMoments(right);
+		FloatInspectorStatisticsEnableMoments(singles);
+		
+		FloatInspectorStatisticsUpdateWithDoubles(left, values, nValues / 3);
+		FloatInspectorStatisticsUpdateWithDoubles(right, values + nValues / 3, nValues - nValues / 3);
+		FloatInspectorStatisticsMerge(left, right);
+		FloatInspectorStatisticsUpdateWithFloats(singles, floats, nValues);
+		
+		/* Every residue 1 ... 1000 occurs equally often, minus two values.  */
+		const double variance = FloatInspectorMomentsVariance(left->moments);
+		
+		/* Long doubles beyond the double range are counted, not dropped, and
+		 * survive a merge.  */
+		const int wide = LDBL_MAX > DBL_MAX;
+		FloatInspectorStatisticsRef longDoubles = FloatInspectorStatisticsCreateLongDouble();
+		FloatInspectorStatisticsRef longTotal = FloatInspectorStatisticsCreateLongDouble();
+		FloatInspectorStatisticsEnableMoments(longDoubles);
+		FloatInspectorStatisticsEnableMoments(longTotal);
+		
+		FloatInspectorStatisticsUpdateWithLongDouble(longDoubles, LDBL_MAX);
+		FloatInspectorStatisticsUpdateWithLongDouble(longDoubles, -LDBL_MAX);
+		FloatInspectorStatisticsUpdateWithLongDouble(longDoubles, 2.L);
+		FloatInspectorStatisticsUpdateWithLongDouble(longDoubles, INFINITY);
+		FloatInspectorStatisticsMerge(longTotal, longDoubles);
+		
+		printf("Moments:\t\t\t\t\tmean %.4f, variance %.5f, %s\n\n",
+			   FloatInspectorMomentsMean(left->moments),
+			   variance,
+			   left->moments->n == nValues - 2 &&
+			   left->moments->minimum == 1e8 + .001 && 
+			   left->moments->maximum == 1e8 + 1. &&
+			   fabs(FloatInspectorMomentsMean(left->moments) - (1e8 + .5005)) < 1e-5 &&
+			   fabs(variance - (1000. * 1000. - 1.) / 12e6) < 1e-4 &&
+			   FloatInspectorMomentsSum(singles->moments) == (double) nValues * (nValues - 1) / 2. &&
+			   fabs(FloatInspectorMomentsVariance(singles->moments) / 
+					(((double) nValues * nValues - 1.) / 12.) - 1.) < 1e-12 &&
+			   longTotal->moments->n == (wide ? 1 : 3) &&
+			   longTotal->moments->nOutOfRange == (wide ? 2 : 0) ? 
+			   "consistent" : FloatInspectorTestInconsistent());
+		
+		free(floats);
+		free(values);
+		FloatInspectorStatisticsFree(left);
+		FloatInspectorStatisticsFree(right);
+		FloatInspectorStatisticsFree(singles);
+		FloatInspectorStatisticsFree(longDoubles);
+		FloatInspectorStatisticsFree(longTotal);
+	}
+	
+	/* Every half pattern once, the 16 bit path has to agree with the format's
+	 * definition and the conversions have to be exact.  */
+	{
+		uint16_t *halfs = malloc(65536 * sizeof(uint16_t));
+		
+		for (uint32_t i = 0; i < 65536; i++) {
+			
+			halfs[i] = (uint16_t) i;
+		}
+		
+		FloatInspectorStatisticsRef half = FloatInspectorStatisticsCreateHalf();
+		FloatInspectorStatisticsRef brain = FloatInspectorStatisticsCreateBFloat16();
+		
+		FloatInspectorStatisticsEnableExponents(half);
+		FloatInspectorStatisticsEnableMoments(half);
+		
+		FloatInspectorStatisticsUpdateWithHalfs(half, halfs, 65536);
+		FloatInspectorStatisticsUpdateWithBFloat16s(brain, halfs, 65536);
+		
+		printf("Half patterns:\t\t\t\t%" PRIu64 " NaN, %" PRIu64 " Inf, %" PRIu64 " denormalized, "
+			   "%" PRIu64 " normalized, %s\n\n",
+			   half->nNaN, half->nInf, half->nDenormalized, half->nNormalized,
+			   half->nEntries == 65536 &&
+			   half->nNaN == 2046 && half->nInf == 2 &&
+			   half->nDenormalized == 2048 && half->nNormalized == 61440 &&
+			   brain->nNaN == 2 * 127 && brain->nInf == 2 &&
+			   FloatInspectorExponentsMinimum(half->exponents) == -24 &&
+			   FloatInspectorExponentsMaximum(half->exponents) == 15 &&
+			   half->moments->n == 65536 - 2046 - 2 &&
+			   half->moments->maximum == 65504.f &&
+			   FloatInspectorMomentsSum(half->moments) == 0. &&
+			   FloatInspectorHalfToFloat(0x3c00) == 1.f &&
+			   FloatInspectorHalfToFloat(0xc000) == -2.f &&
+			   FloatInspectorHalfToFloat(0x0001) == 0x1p-24f &&
+			   isinf(FloatInspectorHalfToFloat(0xfc00)) &&
+			   isnan(FloatInspectorHalfToFloat(0x7e00)) &&
+			   FloatInspectorBFloat16ToFloat(0x3f80) == 1.f ?
+			   "consistent" : FloatInspectorTestInconsistent());
+		
+		free(halfs);
+		FloatInspectorStatisticsFree(half);
+		FloatInspectorStatisticsFree(brain);
+	}
+	
+	/* CSV fed in pieces of 7 bytes: a byte order mark, quoted delimiters and
+	 * newlines, CRLF, blank, empty, invalid and missing fields.  */
+	{
+		const char csv[] =
+			"\xef\xbb\xbf" "id,value,\"note, quoted\"\r\n"
+			"1,0.1,\"a,\nb\"\r\n"
+			"2, -2.5e-3 ,x\n"
+			"\n"
+			"3,,y\n"
+			"4,abc,z\n"
+			"5,\"1e308\",\n"
+			"6,0x1p-1074,w\n"
+			"7";
+		
+		FloatInspectorTextRef text = FloatInspectorTextCreate(',', 1, NULL, 0, NULL);
+		
+		for (size_t i = 0; i < sizeof(csv) - 1; i += 7) {
+			
+			FloatInspectorTextUpdate(text, csv + i,
+									 sizeof(csv) - 1 - i < 7 ? sizeof(csv) - 1 - i : 7);
+		}
+		
+		FloatInspectorTextFinish(text);
+		
+		const FloatInspectorStatisticsRef ids = FloatInspectorTextColumnStatistics(text, 0);
+		const FloatInspectorStatisticsRef values = FloatInspectorTextColumnStatistics(text, 1);
+		double parsed;
+		
+		printf("Text columns:\t\t\t\t%u columns, %llu records, %s\n\n",
+			   FloatInspectorTextNumberOfColumns(text),
+			   FloatInspectorTextNumberOfRecords(text),
+			   FloatInspectorTextNumberOfColumns(text) == 3 &&
+			   FloatInspectorTextNumberOfRecords(text) == 7 &&
+			   strcmp(FloatInspectorTextColumnName(text, 2), "note, quoted") == 0 &&
+			   ids->nEntries == 7 && ids->nNormalized == 7 &&
+			   values->nEntries == 4 && values->nNegative == 1 && values->nDenormalized == 1 &&
+			   FloatInspectorTextColumnMissing(text, 1) == 2 &&
+			   FloatInspectorTextColumnInvalid(text, 1) == 1 &&
+			   FloatInspectorTextColumnMissing(text, 2) == 2 &&
+			   FloatInspectorTextColumnInvalid(text, 2) == 5 &&
+			   FloatInspectorTextParseDouble("2.2250738585072011e-308",
+											 "2.2250738585072011e-308" + 23, &parsed) == 0 &&
+			   parsed == strtod("2.2250738585072011e-308", NULL) &&
+			   FloatInspectorTextParseDouble("1.5x", "1.5x" + 4, &parsed) != 0 ?
+			   "consistent" : FloatInspectorTestInconsistent());
+		
+		FloatInspectorTextFree(text);
+	}
+	
+	/* A small tree crawled with tiny buffers, then again from the checkpoint
+	 * and once more with blocking reads, all three have to see every value
+	 * once. The trailing odd bytes of a file are no value.  */
+	{
+		char root[] = "/tmp/FloatInspectorTest.XXXXXX";
+		char path[64], checkpoint[64];
+		float *floats = calloc(5001, sizeof(float));
+		
+		for (unsigned int i = 0; i < 5000; i++) {
+			
+			floats[i] = i % 1000 == 999 ? INFINITY : .25f * (float) i - 300.f;
+		}
+		
+		mkdtemp(root);
+		snprintf(path, sizeof(path), "%s/sub", root);
+		mkdir(path, 0755);
+		snprintf(checkpoint, sizeof(checkpoint), "%s.checkpoint", root);
+		
+		for (unsigned int i = 0; i < 3; i++) {
+			
+			snprintf(path, sizeof(path), i == 0 ? "%s/a" : "%s/sub/%c", root, 'a' + i);
+			
+			FILE *file = fopen(path, "wb");
+			fwrite(floats + 2000 * i, 1, i == 2 ? 1000 * sizeof(float) + 3 : 
+				   2000 * sizeof(float), file);
+			fclose(file);
+		}
+		
+		snprintf(path, sizeof(path), "%s/empty", root);
+		fclose(fopen(path, "wb"));
+		
+		FloatInspectorStatisticsRef expected = FloatInspectorStatisticsCreateFloat();
+		FloatInspectorCrawlOptions options = kFloatInspectorCrawlDefaultOptions;
+		unsigned int counts[3][3] = {{0}};
+		unsigned long long nBytes[3];
+		int consistent = 1;
+		
+		FloatInspectorStatisticsUpdateWithFloats(expected, floats, 5000);
+		options.bufferSize = 4096;
+		options.nBuffers = 3;
+		options.nOpenFiles = 2;
+		
+		for (unsigned int run = 0; run < 3; run++) {
+			
+			options.asynchronous = run < 2;
+			
+			FloatInspectorCrawlRef crawl = FloatInspectorCrawlCreate(expected, options);
+			
+			FloatInspectorCrawlAddPath(crawl, root);
+			
+			if (run < 2) {
+				
+				FloatInspectorCrawlSetCheckpoint(crawl, checkpoint);
+			}
+			
+			consistent &= FloatInspectorCrawlRun(crawl, FloatInspectorTestCountFile, 
+												 counts[run]) == 0;
+			
+			const FloatInspectorStatisticsRef stats = FloatInspectorCrawlStatistics(crawl);
+			
+			consistent &= stats->nEntries == expected->nEntries &&
+				stats->nInf == expected->nInf && stats->nNegative == expected->nNegative &&
+				memcmp(stats->nNonZeroBitsNormalizedPositive, 
+					   expected->nNonZeroBitsNormalizedPositive,
+					   FloatInspectorStatisticsNormalizedCells(stats) * sizeof(uint64_t)) == 0;
+			nBytes[run] = FloatInspectorCrawlNumberOfBytes(crawl);
+			
+			FloatInspectorCrawlFree(crawl);
+		}
+		
+		printf("Crawl:\t\t\t\t\t\t%u files, %u resumed, %llu bytes, %s\n\n",
+			   counts[0][0], counts[1][1], nBytes[0],
+			   consistent && 
+			   counts[0][0] == 4 && counts[0][1] == 0 && counts[0][2] == 0 &&
+			   counts[1][0] == 4 && counts[1][1] == 4 && nBytes[1] == 0 &&
+			   counts[2][0] == 4 && counts[2][1] == 0 && 
+			   nBytes[0] == 5000 * sizeof(float) && nBytes[2] == nBytes[0] ?
+			   "consistent" : FloatInspectorTestInconsistent());
+		
+		for (unsigned int i = 0; i < 3; i++) {
+			
+			snprintf(path, sizeof(path), i == 0 ? "%s/a" : "%s/sub/%c", root, 'a' + i);
+			unlink(path);
+		}
+		
+		snprintf(path, sizeof(path), "%s/empty", root);
+		unlink(path);
+		snprintf(path, sizeof(path), "%s/sub", root);
+		rmdir(path);
+		rmdir(root);
+		unlink(checkpoint);
+		free(floats);
+		FloatInspectorStatisticsFree(expected);
+	}
+	
+	/* Interleaved pairs of three series against one statistics object per
+	 * series, added by id and by key in two halves that are merged, then 
+	 * many small series.  */
+	{
+		static const char *names[] = {"alpha", "beta", "a somewhat longer series name"};
+		const size_t nPairs = 50000;
+		double *values = malloc(nPairs * sizeof(double));
+		uint32_t *ids = malloc(nPairs * sizeof(uint32_t));
+		const char **keys = malloc(nPairs * sizeof(const char *));
+		FloatInspectorTableRef byId = FloatInspectorTableCreate(Double, 1);
+		FloatInspectorTableRef left = FloatInspectorTableCreate(Double, 1);
+		FloatInspectorTableRef right = FloatInspectorTableCreate(Double, 1);
+		FloatInspectorTableRef many = FloatInspectorTableCreate(Float, 0);
+		FloatInspectorStatisticsRef expected[3];
+		int consistent = 1;
+		
+		for (unsigned int k = 0; k < 3; k++) {
+			
+			expected[k] = FloatInspectorStatisticsCreateDouble();
+			FloatInspectorStatisticsEnableMoments(expected[k]);
+			consistent &= FloatInspectorTableGroup(byId, names[k], strlen(names[k])) == k;
+		}
+		
+		for (size_t i = 0; i < nPairs; i++) {
+			
+			const unsigned int k = (unsigned int) ((i * 7 + i / 3) % 3);
+			
+			ids[i] = k;
+			keys[i] = names[k];
+			values[i] = (i % 11 == 0 ? -1. : 1.) * (double) i / 7.;
+			FloatInspectorStatisticsUpdateWithDouble(expected[k], values[i]);
+		}
+		
+		consistent &= FloatInspectorTableUpdateWithDoubles(byId, ids, values, nPairs) == 0;
+		consistent &= FloatInspectorTableUpdateWithKeyedDoubles(left, keys, values, 
+																nPairs / 2) == 0;
+		consistent &= FloatInspectorTableUpdateWithKeyedDoubles(right, keys + nPairs / 2, 
+																values + nPairs / 2, 
+																nPairs - nPairs / 2) == 0;
+		consistent &= FloatInspectorTableMerge(left, right) == 0;
+		
+		for (unsigned int k = 0; k < 3; k++) {
+			
+			const long merged = FloatInspectorTableFind(left, names[k], strlen(names[k]));
+			
+			for (unsigned int j = 0; j < 2; j++) {
+				
+				const FloatInspectorStatisticsRef stats = 
+					FloatInspectorTableStatistics(j == 0 ? byId : left, 
+												  j == 0 ? k : (unsigned int) merged);
+				
+				consistent &= merged >= 0 &&
+					stats->nEntries == expected[k]->nEntries &&
+					stats->nNegative == expected[k]->nNegative &&
+					memcmp(stats->nNonZeroBitsNormalizedPositive, 
+						   expected[k]->nNonZeroBitsNormalizedPositive,
+						   FloatInspectorStatisticsNormalizedCells(stats) * 
+						   sizeof(uint64_t)) == 0 &&
+					memcmp(stats->nNonZeroBitsNormalizedNegative, 
+						   expected[k]->nNonZeroBitsNormalizedNegative,
+						   FloatInspectorStatisticsNormalizedCells(stats) * 
+						   sizeof(uint64_t)) == 0 &&
+					stats->moments->n == expected[k]->moments->n &&
+					stats->moments->maximum == expected[k]->moments->maximum &&
+					fabs(FloatInspectorMomentsMean(stats->moments) / 
+						 FloatInspectorMomentsMean(expected[k]->moments) - 1.) < 1e-12;
+			}
+		}
+		
+		/* Mismatched values and unknown groups are refused.  */
+		ids[nPairs / 2] = 3;
+		consistent &= FloatInspectorTableUpdateWithDoubles(byId, ids, values, nPairs) != 0 &&
+			FloatInspectorTableUpdateWithFloats(byId, ids, NULL, 0) != 0 &&
+			FloatInspectorTableStatistics(byId, 0)->nEntries == expected[0]->nEntries;
+		
+		char key[32];
+		const float one = 1.f;
+		const unsigned int nSeries = 10000;
+		
+		for (unsigned int i = 0; i < nSeries; i++) {
+			
+			const char *pointer = key;
+			
+			snprintf(key, sizeof(key), "sensor %u", i);
+			FloatInspectorTableUpdateWithKeyedFloats(many, &pointer, &one, 1);
+		}
+		
+		snprintf(key, sizeof(key), "sensor %u", nSeries - 1);
+		
+		const long last = FloatInspectorTableFind(many, key, strlen(key));
+		
+		consistent &= FloatInspectorTableNumberOfGroups(many) == nSeries &&
+			last == nSeries - 1 && 
+			strcmp(FloatInspectorTableKey(many, (unsigned int) last, NULL), key) == 0 &&
+			FloatInspectorTableStatistics(many, (unsigned int) last)->nEntries == 1 &&
+			FloatInspectorTableFind(many, "sensor", 6) == -1;
+		
+		printf("Keyed table:\t\t\t\t%u groups, %zu bytes per group, %s\n\n",
+			   FloatInspectorTableNumberOfGroups(many),
+			   FloatInspectorTableMemorySize(many) / nSeries,
+			   consistent ? "consistent" : FloatInspectorTestInconsistent());
+		
+		for (unsigned int k = 0; k < 3; k++) {
+			
+			FloatInspectorStatisticsFree(expected[k]);
+		}
+		
+		FloatInspectorTableFree(byId);
+		FloatInspectorTableFree(left);
+		FloatInspectorTableFree(right);
+		FloatInspectorTableFree(many);
+		free(values);
+		free(ids);
+		free(keys);
+	}
+	
+	/* Short-lived clients submitting three times each, one frame written 
+	 * in two parts by hand and a broken one, queried until the daemon has
+	 * read every connection.  */
+	{
+		char root[] = "/tmp/FloatInspectorTest.XXXXXX";
+		char path[64];
+		
+		mkdtemp(root);
+		snprintf(path, sizeof(path), "%s/socket", root);
+		
+		FloatInspectorAggregatorRef aggregator = 
+			FloatInspectorAggregatorCreate(path, kFloatInspectorAggregatorDefaultOptions);
+		FloatInspectorStatisticsRef expected = FloatInspectorStatisticsCreateDouble();
+		FloatInspectorStatisticsRef empty = FloatInspectorStatisticsCreateDouble();
+		const unsigned int nClients = 40;
+		pthread_t thread;
+		int consistent = aggregator != NULL;
+		
+		if (consistent) {
+			
+			pthread_create(&thread, NULL, FloatInspectorTestServe, aggregator);
+		}
+		
+		for (unsigned int c = 0; consistent && (c < nClients); c++) {
+			
+			FloatInspectorClientRef client = 
+				FloatInspectorClientCreate(path, kFloatInspectorClientDefaultOptions);
+			FloatInspectorStatisticsRef stats = FloatInspectorStatisticsCreateDouble();
+			
+			for (unsigned int round = 0; round < 3; round++) {
+				
+				for (unsigned int i = 0; i < 50; i++) {
+					
+					const double value = (c % 3 == 0 ? -1. : 1.) * (c * 150. + round * 50. + i) / 3.;
+					
+					FloatInspectorStatisticsUpdateWithDouble(stats, value);
+					FloatInspectorStatisticsUpdateWithDouble(expected, value);
+				}
+				
+				consistent &= FloatInspectorClientSubmit(client, "series", stats) == 0;
+				
+				if (round == 0) {
+					
+					/* One aggregate per client as well, enough to grow the index.  */
+					char name[32];
+					
+					snprintf(name, sizeof(name), "client %u", c);
+					consistent &= FloatInspectorClientSubmit(client, name, stats) == 0;
+				}
+			}
+			
+			/* Unchanged statistics send nothing, another format is refused.  */
+			consistent &= FloatInspectorClientSubmit(client, "series", stats) == 0 &&
+				FloatInspectorClientSubmit(client, "series", statsF) == -1;
+			
+			FloatInspectorStatisticsFree(stats);
+			FloatInspectorClientFree(client);
+		}
+		
+		/* Delta frame of one value, in two writes, then an unknown kind.  */
+		struct sockaddr_un address;
+		const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		
+		memset(&address, 0, sizeof(address));
+		address.sun_family = AF_UNIX;
+		strcpy(address.sun_path, path);
+		
+		if (consistent && 
+			(connect(fd, (const struct sockaddr *) &address, sizeof(address)) == 0)) {
+			
+			FloatInspectorStatisticsRef one = FloatInspectorStatisticsCreateDouble();
+			
+			FloatInspectorStatisticsUpdateWithDouble(one, 1e300);
+			FloatInspectorStatisticsUpdateWithDouble(expected, 1e300);
+			
+			FloatInspectorStatisticsDiffRef diff = FloatInspectorStatisticsDiffCreate(empty, one);
+			uint8_t frame[512] = {0, 0, 0, 0, 1, 6, 's', 'e', 'r', 'i', 'e', 's'};
+			const size_t size = 12 + FloatInspectorStatisticsDiffEncode(diff, frame + 12, 
+																		 sizeof(frame) - 12);
+			const uint8_t broken[] = {2, 0, 0, 0, 9, 0};
+			
+			frame[0] = (uint8_t) (size - 4);
+			consistent &= write(fd, frame, 7) == 7;
+			usleep(20000);
+			consistent &= write(fd, frame + 7, size - 7) == (ssize_t) (size - 7) &&
+				write(fd, broken, sizeof(broken)) == sizeof(broken);
+			
+			FloatInspectorStatisticsDiffFree(diff);
+			FloatInspectorStatisticsFree(one);
+		}
+		else {
+			
+			consistent = 0;
+		}
+		
+		close(fd);
+		
+		FloatInspectorClientRef client = 
+			FloatInspectorClientCreate(path, kFloatInspectorClientDefaultOptions);
+		FloatInspectorStatisticsRef stats = NULL;
+		
+		for (unsigned int attempt = 0; consistent && (attempt < 200); attempt++) {
+			
+			if (stats != NULL) FloatInspectorStatisticsFree(stats);
+			stats = FloatInspectorClientQuery(client, "series", 1.);
+			
+			if ((stats != NULL) && (stats->nEntries == expected->nEntries)) {
+				
+				break;
+			}
+			
+			usleep(10000);
+		}
+		
+		consistent &= stats != NULL && 
+			stats->nEntries == expected->nEntries &&
+			stats->nNegative == expected->nNegative &&
+			stats->nNormalized == expected->nNormalized &&
+			memcmp(stats->nNonZeroBitsNormalizedPositive, 
+				   expected->nNonZeroBitsNormalizedPositive,
+				   FloatInspectorStatisticsNormalizedCells(stats) * sizeof(uint64_t)) == 0 &&
+			memcmp(stats->nNonZeroBitsNormalizedNegative, 
+				   expected->nNonZeroBitsNormalizedNegative,
+				   FloatInspectorStatisticsNormalizedCells(stats) * sizeof(uint64_t)) == 0 &&
+			FloatInspectorClientQuery(client, "missing", 1.) == NULL;
+		
+		if (aggregator != NULL) {
+			
+			FloatInspectorStatisticsRef copy = 
+				FloatInspectorAggregatorCopyStatistics(aggregator, "series");
+			
+			consistent &= copy != NULL && copy->nEntries == expected->nEntries;
+			
+			if (copy != NULL) FloatInspectorStatisticsFree(copy);
+			
+			for (unsigned int c = 0; c < nClients; c++) {
+				
+				char name[32];
+				
+				snprintf(name, sizeof(name), "client %u", c);
+				copy = FloatInspectorAggregatorCopyStatistics(aggregator, name);
+				consistent &= copy != NULL && copy->nEntries == 50;
+				
+				if (copy != NULL) FloatInspectorStatisticsFree(copy);
+			}
+			
+			consistent &= FloatInspectorAggregatorCopyStatistics(aggregator, "client") == NULL;
+			
+			FloatInspectorAggregatorStop(aggregator);
+			pthread_join(thread, NULL);
+			FloatInspectorAggregatorFree(aggregator);
+		}
+		
+		printf("Aggregator:\t\t\t\t\t%u clients, %" PRIu64 " values, %s\n\n",
+			   nClients, stats != NULL ? stats->nEntries : 0,
+			   consistent && access(path, F_OK) != 0 ? "consistent" : FloatInspectorTestInconsistent());
+		
+		if (stats != NULL) FloatInspectorStatisticsFree(stats);
+		
+		FloatInspectorClientFree(client);
+		FloatInspectorStatisticsFree(expected);
+		FloatInspectorStatisticsFree(empty);
+		rmdir(root);
+	}
+	
+	/* Performance counters  */
+	{
+		const unsigned int nValues = 4096;
+		FloatInspectorStatisticsRef floats = FloatInspectorStatisticsCreate(Float);
+		FloatInspectorStatisticsRef doubles = FloatInspectorStatisticsCreate(Double);
+		float *values = malloc(nValues * sizeof(float));
+		double *dvalues = malloc(nValues * sizeof(double));
+		
+		for (unsigned int i = 0; i < nValues; i++) {
+			
+			values[i] = ldexpf((float) (i + 1), (int) (i % 300) - 150);
+			dvalues[i] = -ldexp((double) (i + 1), (int) (i % 2000) - 1000);
+		}
+		
+		FloatInspectorPerfReset();
+		const int hardware = FloatInspectorPerfEnable(1);
+		
+		for (unsigned int i = 0; i < 100; i++) {
+			
+			FloatInspectorStatisticsUpdateWithFloat(floats, values[i]);
+		}
+		
+		FloatInspectorStatisticsUpdateWithFloats(floats, values, nValues);
+		
+		/* Nested bulk phases are counted but measured by the outer one.  */
+		FloatInspectorPerfPhase phase;
+		
+		FloatInspectorPerfBegin(&phase, Double, ScalarPath);
+		
+		for (unsigned int i = 0; i < nValues; i += nValues / 8) {
+			
+			FloatInspectorStatisticsUpdateWithDoubles(doubles, dvalues + i, nValues / 8);
+		}
+		
+		FloatInspectorPerfEnd(&phase, nValues);
+		
+		pthread_t thread;
+		
+		pthread_create(&thread, NULL, FloatInspectorTestProfile, floats);
+		pthread_join(thread, NULL);
+		
+		FloatInspectorPerfDisable();
+		FloatInspectorStatisticsUpdateWithFloats(floats, values, nValues);
+		
+		FloatInspectorPerfEntry scalar, bulk, threaded, outer, nested;
+		
+		FloatInspectorPerfTotals(Float, ScalarPath, &scalar);
+		FloatInspectorPerfTotals(Float, BulkPath, &bulk);
+		FloatInspectorPerfTotals(Float, ThreadedPath, &threaded);
+		FloatInspectorPerfTotals(Double, ScalarPath, &outer);
+		FloatInspectorPerfTotals(Double, BulkPath, &nested);
+		
+		int consistent = scalar.nCalls == 100 && scalar.nPhases == 0 &&
+			bulk.nCalls == 1 && bulk.nPhases == 1 && bulk.nValues == nValues &&
+			bulk.seconds > 0. &&
+			threaded.nCalls == 1 && threaded.nPhases == 1 && threaded.nValues == 4 &&
+			outer.nCalls == 0 && outer.nPhases == 1 && outer.nValues == nValues &&
+			nested.nCalls == 8 && nested.nPhases == 0 && nested.nValues == 0 &&
+			bulk.nCounted == (hardware ? 1u : 0u) &&
+			(!hardware || (bulk.counts[CyclesCounter] > 0)) &&
+			floats->nEntries == 100 + 2 * nValues + 4 && doubles->nEntries == nValues;
+		
+		FloatInspectorPerfReset();
+		FloatInspectorPerfTotals(Float, BulkPath, &bulk);
+		
+		consistent &= bulk.nCalls == 0 && bulk.nPhases == 0 && bulk.seconds == 0.;
+		
+		printf("Performance:\t\t\t\t%s counters, %s\n\n",
+			   hardware ? "hardware" : "no hardware",
+			   consistent ? "consistent" : FloatInspectorTestInconsistent());
+		
+		free(values);
+		free(dvalues);
+		FloatInspectorStatisticsFree(floats);
+		FloatInspectorStatisticsFree(doubles);
+	}
+	
 	FloatInspectorStatisticsFree(statsF);
 	FloatInspectorStatisticsFree(statsD);
 	FloatInspectorStatisticsFree(statsLD);
 	
+	if (FloatInspectorTestFailures != 0) {
+		
+		fprintf(stderr, "%u checks INCONSISTENT\n", FloatInspectorTestFailures);
+		return EXIT_FAILURE;
+	}
 	
 	return EXIT_SUCCESS;
 }
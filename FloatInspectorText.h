@@ -0,0 +1,100 @@
+//
+//  FloatInspectorText.h
+//  FloatInspector
+//  
+//  Copyright 2011 Stefan Reinhold <stefan@sreinhold.com>. All rights reserved.
+//  
+//  Redistribution and use in source and binary forms, with or without modification, are
+//  permitted provided that the following conditions are met:
+//  
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//  
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list
+//  of conditions and the following disclaimer in the documentation and/or other materials
+//  provided with the distribution.
+//  
+//  THIS SOFTWARE IS PROVIDED BY STEFAN REINHOLD ``AS IS'' AND ANY EXPRESS OR IMPLIED
+//  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STEFAN REINHOLD OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+//  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+//  ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//  
+//  The views and conclusions contained in the software and documentation are those of the
+//  authors and should not be interpreted as representing official policies, either expressed
+//  or implied, of Stefan Reinhold.
+//  
+
+
+
+#ifndef FloatInspector_FloatInspectorText_h
+#define FloatInspector_FloatInspectorText_h
+
+#include "FloatInspector.h"
+
+#pragma mark Data Types
+
+/* Per column double statistics of delimiter separated text (CSV, TSV). 
+ * Records end at newlines outside of double quotes, fields are trimmed of 
+ * blanks and one pair of enclosing quotes. Text is fed in arbitrary pieces,
+ * an incomplete last record is kept until the next update.  */
+typedef struct _FloatInspectorText *FloatInspectorTextRef;
+
+#pragma mark Public Functions
+
+/* Selects columns (zero based) or all columns if columns is NULL. Statistics
+ * of a column are copies of prototype, so sketches attached to it apply to
+ * every column; prototype may be NULL. The first record is taken as column
+ * names if header is set. Returns NULL if out of memory.  */
+FloatInspectorTextRef 
+FloatInspectorTextCreate(char delimiter,
+						 int header,
+						 const unsigned int *columns,
+						 unsigned int nColumns,
+						 const FloatInspectorStatisticsRef prototype);
+
+void FloatInspectorTextFree(FloatInspectorTextRef text);
+
+/* Parses all complete records of the given text. Returns 0 on success and
+ * -1 if out of memory.  */
+int FloatInspectorTextUpdate(FloatInspectorTextRef text,
+							 const char *data,
+							 size_t size);
+
+/* Parses the pending last record, if any, and flushes all columns.  */
+int FloatInspectorTextFinish(FloatInspectorTextRef text);
+
+/* Number of columns selected resp. seen so far if all are selected.  */
+unsigned int FloatInspectorTextNumberOfColumns(const FloatInspectorTextRef text);
+
+/* Number of records parsed, the header excluded.  */
+unsigned long long FloatInspectorTextNumberOfRecords(const FloatInspectorTextRef text);
+
+/* Column by index into the selection resp. by position if all are selected.
+ * The statistics stay owned by the text object, the name is NULL without a
+ * header. Empty fields are counted as missing, fields that are not a 
+ * number as invalid.  */
+FloatInspectorStatisticsRef 
+FloatInspectorTextColumnStatistics(const FloatInspectorTextRef text,
+								   unsigned int column);
+
+const char *FloatInspectorTextColumnName(const FloatInspectorTextRef text,
+										 unsigned int column);
+
+unsigned long long FloatInspectorTextColumnMissing(const FloatInspectorTextRef text,
+												   unsigned int column);
+
+unsigned long long FloatInspectorTextColumnInvalid(const FloatInspectorTextRef text,
+												   unsigned int column);
+
+/* Parses [begin, end) exactly like strtod in the C locale. Returns 0 on 
+ * success and -1 if the range is not a number as a whole.  */
+int FloatInspectorTextParseDouble(const char *begin, 
+								  const char *end, 
+								  double *value);
+
+#endif
@@ -0,0 +1,1018 @@
+//
+//  FloatInspectorTool.c
+//  FloatInspector
+//  
+//  Copyright 2011 Stefan Reinhold <stefan@sreinhold.com>. All rights reserved.
+//  
+//  Redistribution and use in source and binary forms, with or without modification, are
+//  permitted provided that the following conditions are met:
+//  
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//  
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list
+//  of conditions and the following disclaimer in the documentation and/or other materials
+//  provided with the distribution.
+//  
+//  THIS SOFTWARE IS PROVIDED BY STEFAN REINHOLD ``AS IS'' AND ANY EXPRESS OR IMPLIED
+//  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STEFAN REINHOLD OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+//  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+//  ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//  
+//  The views and conclusions contained in the software and documentation are those of the
+//  authors and should not be interpreted as representing official policies, either expressed
+//  or implied, of Stefan Reinhold.
+//  
+
+
+
+//  Statistics of the floating point tensors of .npy and .safetensors files
+//  and of the numeric columns of text files (.csv, .tsv, .txt or - for 
+//  standard input). Files are mapped, tensors are split into chunks that 
+//  all threads take from one queue and fed to the bulk path of their type,
+//  each text file is one item of the queue. Prints one line per tensor or 
+//  column and the combined statistics per type; tensors of types without a
+//  bulk path are listed as skipped.
+//  
+//  With -r the arguments are directories of raw shards of one format, 
+//  crawled with many reads in flight (see FloatInspectorCrawl.h). One line
+//  is printed per file as it completes.
+//  
+//  Usage: FloatInspectorTool [-j threads] [-v] [-a] [-p] [-d delimiter] 
+//                            [-c columns] [-H] file...
+//         FloatInspectorTool -r -t type [-j threads] [-v] [-a] [-p] [-o offset] 
+//                            [-k checkpoint] [-s] path...
+//  
+//    -v  print the full statistics of every tensor, column or file
+//    -a  attach all sketches, not only the moments
+//    -p  report time and hardware counters per format and update path
+//    -d  field delimiter of text files, default tab for .tsv, else comma
+//    -c  comma separated list of text columns (1 based), default all
+//    -H  the first record of text files holds the column names
+//    -r  crawl raw shards
+//    -t  format of the shards: f2, bf16, f4, f8 or f16 (long double)
+//    -o  bytes to skip at the start of every shard
+//    -k  checkpoint to resume an interrupted crawl from
+//    -s  blocking reads instead of io_uring
+//  
+
+
+#include "FloatInspector.h"
+#include "FloatInspectorCrawl.h"
+#include "FloatInspectorPerf.h"
+#include "FloatInspectorTensors.h"
+#include "FloatInspectorText.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#pragma mark Data Types
+
+/* A tensor and the statistics its chunks are merged into.  */
+typedef struct {
+	
+	const char *path;
+	const FloatInspectorTensor *tensor;
+	
+	FloatInspectorStatisticsRef stats;
+	pthread_mutex_t lock;
+	/* errno of a chunk that could not be classified or merged, the 
+	 * statistics are incomplete.  */
+	int failed;
+	
+} FloatInspectorToolTensor;
+
+/* A text file, parsed by a single thread.  */
+typedef struct {
+	
+	const char *path;
+	FloatInspectorTextRef text;
+	size_t nBytes;
+	/* errno of a failed read, 0 on success.  */
+	int error;
+	
+} FloatInspectorToolText;
+
+/* A chunk of a tensor or a whole text file.  */
+typedef struct {
+	
+	FloatInspectorToolTensor *tensor;
+	FloatInspectorToolText *text;
+	size_t first;
+	size_t n;
+	
+} FloatInspectorToolJob;
+
+#pragma mark Constants
+
+/* Elements per job, large enough to amortize the merge, small enough to 
+ * balance a few big tensors over all threads.  */
+#define kFloatInspectorToolJob	((size_t) 1 << 22)
+/* Bytes read at once from standard input.  */
+#define kFloatInspectorToolReadSize	((size_t) 1 << 20)
+
+#pragma mark Globals
+
+static int FloatInspectorToolAllSketches = 0;
+static int FloatInspectorToolProfile = 0;
+
+static FloatInspectorToolJob *FloatInspectorToolJobs = NULL;
+static size_t FloatInspectorToolNumberOfJobs = 0;
+static size_t FloatInspectorToolNextJob = 0;
+
+#pragma mark Private Function Prototypes
+
+int main(int, char **);
+
+static FloatInspectorStatisticsRef 
+FloatInspectorToolCreateStatistics(enum PrecisionType type);
+
+static void FloatInspectorToolOutOfMemory(FloatInspectorTensorFileRef *files,
+										  FloatInspectorToolText *texts,
+										  int nFiles,
+										  FloatInspectorToolTensor *tensors,
+										  size_t nTensors);
+
+static int FloatInspectorToolIsText(const char *path);
+
+static void FloatInspectorToolParseText(FloatInspectorToolText *text);
+
+static void *FloatInspectorToolWorker(void *context);
+
+static void FloatInspectorToolPrintLine(const char *name,
+										const char *dtype,
+										const char *shape,
+										unsigned long long nValues,
+										const FloatInspectorStatisticsRef stats,
+										const char *suffix,
+										int verbose);
+
+static void FloatInspectorToolPrintTensor(const FloatInspectorToolTensor *tensor,
+										  int verbose);
+
+static void FloatInspectorToolPrintText(const FloatInspectorToolText *text,
+										int verbose);
+
+static void FloatInspectorToolPrintFile(const FloatInspectorCrawlFile *file,
+										void *context);
+
+static int FloatInspectorToolCrawl(char **paths,
+								   int nPaths,
+								   const char *format,
+								   FloatInspectorCrawlOptions options,
+								   const char *checkpoint,
+								   int verbose);
+
+#pragma mark Private Functions Implementations
+
+/* Returns NULL if memory is exhausted.  */
+static FloatInspectorStatisticsRef 
+FloatInspectorToolCreateStatistics(enum PrecisionType type) {
+	
+	FloatInspectorStatisticsRef stats = FloatInspectorStatisticsCreate(type);
+	
+	if (stats == NULL) {
+		
+		return NULL;
+	}
+	
+	FloatInspectorStatisticsEnableMoments(stats);
+	
+	if (FloatInspectorToolAllSketches) {
+		
+		FloatInspectorStatisticsEnableCardinality(stats, 
+												  kFloatInspectorCardinalityDefaultPrecision);
+		FloatInspectorStatisticsEnableHeavyHitters(stats, 
+												   kFloatInspectorHeavyHittersDefaultCapacity);
+		FloatInspectorStatisticsEnableQuantiles(stats, kFloatInspectorQuantilesDefaultK);
+		FloatInspectorStatisticsEnableExponents(stats);
+	}
+	
+	return stats;
+}
+
+/* Reports the lack of memory and releases the inputs and statistics main 
+ * holds, the caller frees the arrays themselves.  */
+static void 
+FloatInspectorToolOutOfMemory(FloatInspectorTensorFileRef *files,
+							  FloatInspectorToolText *texts,
+							  int nFiles,
+							  FloatInspectorToolTensor *tensors,
+							  size_t nTensors) {
+	
+	fprintf(stderr, "%s\n", strerror(ENOMEM));
+	
+	for (size_t i = 0; i < nTensors; i++) {
+		
+		if (tensors[i].stats != NULL) {
+			
+			FloatInspectorStatisticsFree(tensors[i].stats);
+			pthread_mutex_destroy(&tensors[i].lock);
+		}
+	}
+	
+	for (int i = 0; i < nFiles; i++) {
+		
+		if (texts[i].text != NULL) {
+			
+			FloatInspectorTextFree(texts[i].text);
+		}
+		
+		FloatInspectorTensorFileClose(files[i]);
+	}
+}
+
+static int 
+FloatInspectorToolIsText(const char *path) {
+	
+	const char *extension = strrchr(path, '.');
+	
+	return (strcmp(path, "-") == 0) || 
+		((extension != NULL) && 
+		 ((strcmp(extension, ".csv") == 0) || (strcmp(extension, ".tsv") == 0) ||
+		  (strcmp(extension, ".txt") == 0)));
+}
+
+/* Files are mapped, standard input is read in pieces.  */
+static void 
+FloatInspectorToolParseText(FloatInspectorToolText *text) {
+	
+	if (strcmp(text->path, "-") == 0) {
+		
+		char *buffer = malloc(kFloatInspectorToolReadSize);
+		ssize_t n;
+		
+		if (buffer == NULL) {
+			
+			text->error = ENOMEM;
+			return;
+		}
+		
+		while ((n = read(STDIN_FILENO, buffer, kFloatInspectorToolReadSize)) != 0) {
+			
+			if (n < 0) {
+				
+				if (errno == EINTR) continue;
+				
+				text->error = errno;
+				break;
+			}
+			
+			if (FloatInspectorTextUpdate(text->text, buffer, (size_t) n) != 0) {
+				
+				text->error = ENOMEM;
+				break;
+			}
+			
+			text->nBytes += (size_t) n;
+		}
+		
+		free(buffer);
+	}
+	else {
+		
+		const int fd = open(text->path, O_RDONLY);
+		struct stat st;
+		
+		if ((fd < 0) || (fstat(fd, &st) != 0)) {
+			
+			text->error = errno;
+			
+			if (fd >= 0) close(fd);
+			return;
+		}
+		
+		text->nBytes = (size_t) st.st_size;
+		
+		if (text->nBytes > 0) {
+			
+			void *map = mmap(NULL, text->nBytes, PROT_READ, MAP_PRIVATE, fd, 0);
+			
+			if (map == MAP_FAILED) {
+				
+				text->error = errno;
+			}
+			else {
+				
+				madvise(map, text->nBytes, MADV_SEQUENTIAL);
+				
+				if (FloatInspectorTextUpdate(text->text, map, text->nBytes) != 0) {
+					
+					text->error = ENOMEM;
+				}
+				
+				munmap(map, text->nBytes);
+			}
+		}
+		
+		close(fd);
+	}
+	
+	if ((FloatInspectorTextFinish(text->text) != 0) && (text->error == 0)) {
+		
+		text->error = ENOMEM;
+	}
+}
+
+/* Chunks are classified into per thread statistics, one per type, and 
+ * merged into their tensor's statistics afterwards.  */
+static void *
+FloatInspectorToolWorker(void *context) {
+	
+	(void) context;
+	
+	FloatInspectorStatisticsRef scratch[BFloat16 + 1] = {NULL};
+	
+	FloatInspectorPerfMarkWorkerThread();
+	
+	for (;;) {
+		
+		const size_t i = __atomic_fetch_add(&FloatInspectorToolNextJob, 1, __ATOMIC_RELAXED);
+		
+		if (i >= FloatInspectorToolNumberOfJobs) {
+			
+			break;
+		}
+		
+		const FloatInspectorToolJob *job = &FloatInspectorToolJobs[i];
+		
+		if (job->text != NULL) {
+			
+			FloatInspectorToolParseText(job->text);
+			continue;
+		}
+		
+		const enum PrecisionType type = job->tensor->tensor->type;
+		
+		if (scratch[type] == NULL) {
+			
+			scratch[type] = FloatInspectorToolCreateStatistics(type);
+		}
+		
+		if (scratch[type] == NULL) {
+			
+			pthread_mutex_lock(&job->tensor->lock);
+			job->tensor->failed = ENOMEM;
+			pthread_mutex_unlock(&job->tensor->lock);
+			continue;
+		}
+		
+		FloatInspectorTensorUpdateStatistics(job->tensor->tensor, scratch[type], 
+											 job->first, job->n);
+		
+		pthread_mutex_lock(&job->tensor->lock);
+		
+		if (FloatInspectorStatisticsMerge(job->tensor->stats, scratch[type]) != 0) {
+			
+			job->tensor->failed = EOVERFLOW;
+		}
+		
+		pthread_mutex_unlock(&job->tensor->lock);
+		
+		FloatInspectorStatisticsReset(scratch[type]);
+	}
+	
+	for (unsigned int i = 0; i <= BFloat16; i++) {
+		
+		if (scratch[i] != NULL) {
+			
+			FloatInspectorStatisticsFree(scratch[i]);
+		}
+	}
+	
+	return NULL;
+}
+
+static void 
+FloatInspectorToolPrintLine(const char *name,
+							const char *dtype,
+							const char *shape,
+							unsigned long long nValues,
+							const FloatInspectorStatisticsRef stats,
+							const char *suffix,
+							int verbose) {
+	
+	if (stats == NULL) {
+		
+		printf("  %-38s %-10s %-20s skipped\n", name, dtype, shape);
+		return;
+	}
+	
+	if (stats->moments == NULL) {
+		
+		printf("  %-38s %-10s %-20s %12llu values, %" PRIu64 " NaN, %" PRIu64 " Inf%s\n",
+			   name, dtype, shape, nValues, stats->nNaN, stats->nInf, suffix);
+	}
+	else {
+		
+		printf("  %-38s %-10s %-20s %12llu values, %" PRIu64 " NaN, %" PRIu64 " Inf, "
+			   "minimum %g, maximum %g, mean %g%s\n",
+			   name, dtype, shape, nValues, stats->nNaN, stats->nInf,
+			   stats->moments->n == 0 ? NAN : stats->moments->minimum,
+			   stats->moments->n == 0 ? NAN : stats->moments->maximum,
+			   FloatInspectorMomentsMean(stats->moments), suffix);
+	}
+	
+	if (verbose) {
+		
+		printf("\n");
+		FloatInspectorStatisticsPrint(stats, stdout);
+		printf("\n");
+	}
+}
+
+static void 
+FloatInspectorToolPrintTensor(const FloatInspectorToolTensor *tensor,
+							  int verbose) {
+	
+	const FloatInspectorTensor *t = tensor->tensor;
+	char shape[128];
+	size_t length = 0;
+	
+	shape[length++] = '[';
+	
+	for (unsigned int i = 0; (i < t->nDimensions) && (length < sizeof(shape) - 24); i++) {
+		
+		length += (size_t) snprintf(shape + length, sizeof(shape) - length, 
+									i == 0 ? "%llu" : ", %llu", 
+									(unsigned long long) t->shape[i]);
+	}
+	
+	snprintf(shape + length, sizeof(shape) - length, "]");
+	
+	FloatInspectorToolPrintLine(t->name, t->dtype, shape, t->nElements, 
+								tensor->stats, "", verbose);
+}
+
+static void 
+FloatInspectorToolPrintText(const FloatInspectorToolText *text,
+							int verbose) {
+	
+	if (text->error != 0) {
+		
+		printf("  %s\n", strerror(text->error));
+		return;
+	}
+	
+	char shape[32];
+	
+	snprintf(shape, sizeof(shape), "[%llu]", 
+			 FloatInspectorTextNumberOfRecords(text->text));
+	
+	for (unsigned int i = 0; i < FloatInspectorTextNumberOfColumns(text->text); i++) {
+		
+		const FloatInspectorStatisticsRef stats = 
+			FloatInspectorTextColumnStatistics(text->text, i);
+		const unsigned long long nMissing = FloatInspectorTextColumnMissing(text->text, i);
+		const unsigned long long nInvalid = FloatInspectorTextColumnInvalid(text->text, i);
+		const char *name = FloatInspectorTextColumnName(text->text, i);
+		char column[32], suffix[64];
+		
+		snprintf(column, sizeof(column), "column %u", i + 1);
+		snprintf(suffix, sizeof(suffix), ", %llu missing, %llu invalid", nMissing, nInvalid);
+		
+		FloatInspectorToolPrintLine(name != NULL ? name : column, "text", shape, 
+									stats->moments->n + stats->nNaN + stats->nInf,
+									stats, suffix, verbose);
+	}
+}
+
+/* Files restored from the checkpoint carry no moments.  */
+static void 
+FloatInspectorToolPrintFile(const FloatInspectorCrawlFile *file,
+							void *context) {
+	
+	const int verbose = *(const int *) context;
+	char shape[32];
+	
+	if (file->error != 0) {
+		
+		printf("  %-38s %s\n", file->path, strerror(file->error));
+		return;
+	}
+	
+	snprintf(shape, sizeof(shape), "[%" PRIu64 "]", file->stats->nEntries);
+	
+	FloatInspectorToolPrintLine(file->path, "raw", shape, file->stats->nEntries,
+								file->stats, file->resumed ? ", from checkpoint" : "",
+								verbose && !file->resumed);
+}
+
+static int 
+FloatInspectorToolCrawl(char **paths,
+						int nPaths,
+						const char *format,
+						FloatInspectorCrawlOptions options,
+						const char *checkpoint,
+						int verbose) {
+	
+	static const char *formats[] = {"f4", "f8", "f16", "f2", "bf16"};
+	unsigned int type = 0;
+	
+	while ((type <= BFloat16) && ((format == NULL) || (strcmp(format, formats[type]) != 0))) {
+		
+		type++;
+	}
+	
+	if (type > BFloat16) {
+		
+		fprintf(stderr, "unknown format %s\n", format != NULL ? format : "(none)");
+		return EXIT_FAILURE;
+	}
+	
+	FloatInspectorStatisticsRef prototype = FloatInspectorToolCreateStatistics(type);
+	FloatInspectorCrawlRef crawl = 
+		prototype != NULL ? FloatInspectorCrawlCreate(prototype, options) : NULL;
+	int status = EXIT_SUCCESS;
+	
+	if (prototype != NULL) {
+		
+		FloatInspectorStatisticsFree(prototype);
+	}
+	
+	if (crawl == NULL) {
+		
+		fprintf(stderr, "%s\n", strerror(ENOMEM));
+		return EXIT_FAILURE;
+	}
+	
+	for (int i = 0; i < nPaths; i++) {
+		
+		if (FloatInspectorCrawlAddPath(crawl, paths[i]) != 0) {
+			
+			fprintf(stderr, "%s: %s\n", paths[i], strerror(errno));
+			status = EXIT_FAILURE;
+		}
+	}
+	
+	FloatInspectorCrawlSetCheckpoint(crawl, checkpoint);
+	
+	struct timespec start, end;
+	
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	
+	if (FloatInspectorCrawlRun(crawl, FloatInspectorToolPrintFile, &verbose) != 0) {
+		
+		fprintf(stderr, "crawl incomplete: %s\n", strerror(errno));
+		status = EXIT_FAILURE;
+	}
+	
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	FloatInspectorPerfDisable();
+	
+	printf("\nAll files\n");
+	FloatInspectorStatisticsPrint(FloatInspectorCrawlStatistics(crawl), stdout);
+	
+	const double seconds = (double) (end.tv_sec - start.tv_sec) + 
+		1e-9 * (double) (end.tv_nsec - start.tv_nsec);
+	const unsigned long long nBytes = FloatInspectorCrawlNumberOfBytes(crawl);
+	
+	printf("\n%zu files, %llu bytes read in %.3f s (%.1f MB/s, %s, %u workers)\n",
+		   FloatInspectorCrawlNumberOfFiles(crawl), nBytes, seconds,
+		   seconds > 0. ? 1e-6 * (double) nBytes / seconds : 0.,
+		   FloatInspectorCrawlIsAsynchronous(crawl) ? "io_uring" : "pread",
+		   options.nWorkers);
+	
+	if (FloatInspectorToolProfile) {
+		
+		printf("\n");
+		FloatInspectorPerfPrint(stdout);
+	}
+	
+	FloatInspectorCrawlFree(crawl);
+	
+	return status;
+}
+
+#pragma mark Main
+
+int
+main(int argc, char **argv) {
+	
+	static const char usage[] = 
+		"usage: %s [-j threads] [-v] [-a] [-p] [-d delimiter] [-c columns] [-H] file...\n"
+		"       %s -r -t type [-j threads] [-v] [-a] [-p] [-o offset] [-k checkpoint] [-s] "
+		"path...\n";
+	
+	long nThreads = sysconf(_SC_NPROCESSORS_ONLN);
+	int verbose = 0;
+	int header = 0;
+	char delimiter = '\0';
+	unsigned int *columns = NULL;
+	unsigned int nColumns = 0;
+	int crawl = 0;
+	const char *format = NULL;
+	const char *checkpoint = NULL;
+	FloatInspectorCrawlOptions options = kFloatInspectorCrawlDefaultOptions;
+	int opt;
+	
+	while ((opt = getopt(argc, argv, "j:vapd:c:Hrt:o:k:s")) != -1) {
+		
+		switch (opt) {
+			case 'j':
+				nThreads = atol(optarg);
+				break;
+				
+			case 'v':
+				verbose = 1;
+				break;
+				
+			case 'a':
+				FloatInspectorToolAllSketches = 1;
+				break;
+				
+			case 'p':
+				FloatInspectorToolProfile = 1;
+				break;
+				
+			case 'd':
+				delimiter = strcmp(optarg, "\\t") == 0 ? '\t' : optarg[0];
+				break;
+				
+			case 'c':
+				for (char *field = strtok(optarg, ","); field != NULL; field = strtok(NULL, ",")) {
+					
+					const long column = atol(field);
+					
+					if (column < 1) {
+						
+						fprintf(stderr, usage, argv[0], argv[0]);
+						return EXIT_FAILURE;
+					}
+					
+					unsigned int *grown = realloc(columns, (nColumns + 1) * sizeof(unsigned int));
+					
+					if (grown == NULL) {
+						
+						fprintf(stderr, "%s\n", strerror(ENOMEM));
+						free(columns);
+						return EXIT_FAILURE;
+					}
+					
+					columns = grown;
+					columns[nColumns++] = (unsigned int) column - 1;
+				}
+				break;
+				
+			case 'H':
+				header = 1;
+				break;
+				
+			case 'r':
+				crawl = 1;
+				break;
+				
+			case 't':
+				format = optarg;
+				break;
+				
+			case 'o':
+				options.offset = (size_t) strtoull(optarg, NULL, 0);
+				break;
+				
+			case 'k':
+				checkpoint = optarg;
+				break;
+				
+			case 's':
+				options.asynchronous = 0;
+				break;
+				
+			default:
+				fprintf(stderr, usage, argv[0], argv[0]);
+				return EXIT_FAILURE;
+		}
+	}
+	
+	if ((optind == argc) || (delimiter == '\n') || (delimiter == '"')) {
+		
+		fprintf(stderr, usage, argv[0], argv[0]);
+		return EXIT_FAILURE;
+	}
+	
+	if (nThreads < 1) nThreads = 1;
+	
+	if (FloatInspectorToolProfile && !FloatInspectorPerfEnable(1)) {
+		
+		fprintf(stderr, "hardware counters unavailable, phases are only timed\n");
+	}
+	
+	if (crawl) {
+		
+		options.nWorkers = (unsigned int) nThreads;
+		free(columns);
+		
+		return FloatInspectorToolCrawl(argv + optind, argc - optind, format, options, 
+									   checkpoint, verbose);
+	}
+	
+	const int nFiles = argc - optind;
+	FloatInspectorTensorFileRef *files = calloc((size_t) nFiles, 
+												sizeof(FloatInspectorTensorFileRef));
+	FloatInspectorToolText *texts = calloc((size_t) nFiles, sizeof(FloatInspectorToolText));
+	FloatInspectorStatisticsRef prototype = FloatInspectorToolCreateStatistics(Double);
+	pthread_t *threads = malloc((size_t) nThreads * sizeof(pthread_t));
+	size_t nTensors = 0;
+	int status = EXIT_SUCCESS;
+	
+	if ((files == NULL) || (texts == NULL) || (prototype == NULL) || (threads == NULL)) {
+		
+		fprintf(stderr, "%s\n", strerror(ENOMEM));
+		
+		if (prototype != NULL) {
+			
+			FloatInspectorStatisticsFree(prototype);
+		}
+		
+		free(threads);
+		free(texts);
+		free(files);
+		free(columns);
+		return EXIT_FAILURE;
+	}
+	
+	FloatInspectorToolNumberOfJobs = 0;
+	
+	for (int i = 0; i < nFiles; i++) {
+		
+		const char *path = argv[optind + i];
+		
+		if (FloatInspectorToolIsText(path)) {
+			
+			const char *extension = strrchr(path, '.');
+			
+			texts[i].path = path;
+			texts[i].text = FloatInspectorTextCreate(delimiter != '\0' ? delimiter : 
+													 (extension != NULL) && 
+													 (strcmp(extension, ".tsv") == 0) ? '\t' : ',',
+													 header, columns, nColumns, prototype);
+			
+			if (texts[i].text == NULL) {
+				
+				fprintf(stderr, "%s: %s\n", path, strerror(ENOMEM));
+				status = EXIT_FAILURE;
+				continue;
+			}
+			
+			FloatInspectorToolNumberOfJobs++;
+			continue;
+		}
+		
+		files[i] = FloatInspectorTensorFileOpen(path);
+		
+		if (files[i] == NULL) {
+			
+			fprintf(stderr, "%s: %s\n", path, strerror(errno));
+			status = EXIT_FAILURE;
+			continue;
+		}
+		
+		nTensors += files[i]->nTensors;
+	}
+	
+	/* Every file's tensors go into one queue, so small files do not leave
+	 * threads idle.  */
+	FloatInspectorToolTensor *tensors = calloc(nTensors + 1, sizeof(FloatInspectorToolTensor));
+	size_t nValues = 0;
+	
+	nTensors = 0;
+	
+	if (tensors == NULL) {
+		
+		FloatInspectorToolOutOfMemory(files, texts, nFiles, NULL, 0);
+		FloatInspectorStatisticsFree(prototype);
+		free(threads);
+		free(texts);
+		free(files);
+		free(columns);
+		return EXIT_FAILURE;
+	}
+	
+	for (int i = 0; i < nFiles; i++) {
+		
+		for (unsigned int j = 0; (files[i] != NULL) && (j < files[i]->nTensors); j++) {
+			
+			FloatInspectorToolTensor *tensor = &tensors[nTensors++];
+			
+			tensor->path = argv[optind + i];
+			tensor->tensor = &files[i]->tensors[j];
+			
+			if (!tensor->tensor->supported) {
+				
+				continue;
+			}
+			
+			tensor->stats = FloatInspectorToolCreateStatistics(tensor->tensor->type);
+			
+			if (tensor->stats == NULL) {
+				
+				FloatInspectorToolOutOfMemory(files, texts, nFiles, tensors, nTensors);
+				FloatInspectorStatisticsFree(prototype);
+				free(threads);
+				free(tensors);
+				free(texts);
+				free(files);
+				free(columns);
+				return EXIT_FAILURE;
+			}
+			
+			pthread_mutex_init(&tensor->lock, NULL);
+			
+			FloatInspectorToolNumberOfJobs += 
+				(tensor->tensor->nElements + kFloatInspectorToolJob - 1) / kFloatInspectorToolJob;
+			nValues += tensor->tensor->nElements;
+		}
+	}
+	
+	FloatInspectorToolJobs = calloc(FloatInspectorToolNumberOfJobs + 1, 
+									sizeof(FloatInspectorToolJob));
+	size_t nJobs = 0;
+	
+	if (FloatInspectorToolJobs == NULL) {
+		
+		FloatInspectorToolOutOfMemory(files, texts, nFiles, tensors, nTensors);
+		FloatInspectorStatisticsFree(prototype);
+		free(threads);
+		free(tensors);
+		free(texts);
+		free(files);
+		free(columns);
+		return EXIT_FAILURE;
+	}
+	
+	/* Text files cannot be split, they are started first.  */
+	for (int i = 0; i < nFiles; i++) {
+		
+		if (texts[i].text != NULL) {
+			
+			FloatInspectorToolJobs[nJobs++].text = &texts[i];
+		}
+	}
+	
+	for (size_t i = 0; i < nTensors; i++) {
+		
+		for (size_t first = 0; 
+			 (tensors[i].stats != NULL) && (first < tensors[i].tensor->nElements); 
+			 first += kFloatInspectorToolJob) {
+			
+			FloatInspectorToolJob *job = &FloatInspectorToolJobs[nJobs++];
+			
+			job->tensor = &tensors[i];
+			job->first = first;
+			job->n = tensors[i].tensor->nElements - first < kFloatInspectorToolJob ?
+				tensors[i].tensor->nElements - first : kFloatInspectorToolJob;
+		}
+	}
+	
+	FloatInspectorToolNumberOfJobs = nJobs;
+	
+	struct timespec start, end;
+	
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	
+	for (long i = 0; i < nThreads; i++) {
+		
+		pthread_create(&threads[i], NULL, FloatInspectorToolWorker, NULL);
+	}
+	
+	for (long i = 0; i < nThreads; i++) {
+		
+		pthread_join(threads[i], NULL);
+	}
+	
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	FloatInspectorPerfDisable();
+	
+	/* Formats cannot be merged, the total is kept per type.  */
+	FloatInspectorStatisticsRef totals[BFloat16 + 1] = {NULL};
+	size_t nBytes = 0;
+	size_t tensor = 0;
+	
+	for (int i = 0; i < nFiles; i++) {
+		
+		if ((files[i] == NULL) && (texts[i].text == NULL)) {
+			
+			continue;
+		}
+		
+		printf("%s%s\n", i == 0 ? "" : "\n", argv[optind + i]);
+		
+		if (texts[i].text != NULL) {
+			
+			FloatInspectorToolPrintText(&texts[i], verbose);
+			
+			if (texts[i].error != 0) {
+				
+				status = EXIT_FAILURE;
+			}
+			
+			for (unsigned int j = 0; j < FloatInspectorTextNumberOfColumns(texts[i].text); j++) {
+				
+				const FloatInspectorStatisticsRef stats = 
+					FloatInspectorTextColumnStatistics(texts[i].text, j);
+				
+				nValues += stats->moments->n + stats->nNaN + stats->nInf;
+				
+				if (totals[Double] == NULL) {
+					
+					totals[Double] = FloatInspectorStatisticsCopy(stats);
+				}
+				else if (FloatInspectorStatisticsMerge(totals[Double], stats) != 0) {
+					
+					fprintf(stderr, "%s: %s\n", argv[optind + i], strerror(EOVERFLOW));
+					status = EXIT_FAILURE;
+				}
+			}
+			
+			nBytes += texts[i].nBytes;
+			FloatInspectorTextFree(texts[i].text);
+			continue;
+		}
+		
+		for (unsigned int j = 0; j < files[i]->nTensors; j++, tensor++) {
+			
+			FloatInspectorToolPrintTensor(&tensors[tensor], verbose);
+			
+			if (tensors[tensor].stats == NULL) {
+				
+				continue;
+			}
+			
+			const enum PrecisionType type = tensors[tensor].tensor->type;
+			
+			if (totals[type] == NULL) {
+				
+				totals[type] = FloatInspectorStatisticsCopy(tensors[tensor].stats);
+			}
+			else if (FloatInspectorStatisticsMerge(totals[type], tensors[tensor].stats) != 0) {
+				
+				tensors[tensor].failed = EOVERFLOW;
+			}
+			
+			if (tensors[tensor].failed != 0) {
+				
+				fprintf(stderr, "%s: %s: %s\n", argv[optind + i], 
+						tensors[tensor].tensor->name, strerror(tensors[tensor].failed));
+				status = EXIT_FAILURE;
+			}
+			
+			FloatInspectorStatisticsFree(tensors[tensor].stats);
+			pthread_mutex_destroy(&tensors[tensor].lock);
+		}
+		
+		nBytes += files[i]->size;
+	}
+	
+	for (unsigned int i = 0; i <= BFloat16; i++) {
+		
+		if (totals[i] != NULL) {
+			
+			printf("\nAll tensors and columns of this type\n");
+			FloatInspectorStatisticsPrint(totals[i], stdout);
+			FloatInspectorStatisticsFree(totals[i]);
+		}
+	}
+	
+	const double seconds = (double) (end.tv_sec - start.tv_sec) + 
+		1e-9 * (double) (end.tv_nsec - start.tv_nsec);
+	
+	printf("\n%zu values, %zu bytes in %.3f s (%.1f M values/s, %.1f MB/s, %ld threads)\n",
+		   nValues, nBytes, seconds, 
+		   seconds > 0. ? 1e-6 * (double) nValues / seconds : 0., 
+		   seconds > 0. ? 1e-6 * (double) nBytes / seconds : 0., nThreads);
+	
+	if (FloatInspectorToolProfile) {
+		
+		printf("\n");
+		FloatInspectorPerfPrint(stdout);
+	}
+	
+	for (int i = 0; i < nFiles; i++) {
+		
+		FloatInspectorTensorFileClose(files[i]);
+	}
+	
+	FloatInspectorStatisticsFree(prototype);
+	free(threads);
+	free(FloatInspectorToolJobs);
+	free(tensors);
+	free(texts);
+	free(files);
+	free(columns);
+	
+	return status;
+}
@@ -0,0 +1,888 @@
+//
+//  FloatInspectorVerify.c
+//  FloatInspector
+//  
+//  Copyright 2011 Stefan Reinhold <stefan@sreinhold.com>. All rights reserved.
+//  
+//  Redistribution and use in source and binary forms, with or without modification, are
+//  permitted provided that the following conditions are met:
+//  
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//  
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list
+//  of conditions and the following disclaimer in the documentation and/or other materials
+//  provided with the distribution.
+//  
+//  THIS SOFTWARE IS PROVIDED BY STEFAN REINHOLD ``AS IS'' AND ANY EXPRESS OR IMPLIED
+//  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STEFAN REINHOLD OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+//  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+//  ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//  
+//  The views and conclusions contained in the software and documentation are those of the
+//  authors and should not be interpreted as representing official policies, either expressed
+//  or implied, of Stefan Reinhold.
+//  
+
+
+//  Verification harness for the classification paths. Every float bit 
+//  pattern and large random and structured samples of doubles and long 
+//  doubles are decoded by a deliberately naive reference decoder and 
+//  compared field by field with the fast classification, the generic 
+//  decoder and the histogram cells the bulk update paths increment.
+//  Random decimal text is parsed by the text ingestion parser and compared
+//  bit for bit with strtod.
+//  
+//  Usage: FloatInspectorVerify [-t threads] [-d doubles] [-l long doubles]
+//                              [-p parsed strings] [-g generic stride] 
+//                              [-s seed]
+//  
+//  Exits with EXIT_FAILURE if any mismatch was found.
+//  
+
+
+#include "FloatInspector.h"
+#include "FloatInspectorSnapshot.h"
+#include "FloatInspectorText.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#pragma mark Data Types
+
+typedef enum {
+	FloatSweepPhase,
+	DoubleRandomPhase,
+	DoubleStructuredPhase,
+	LongDoubleRandomPhase,
+	TextParsePhase
+} FloatInspectorVerifyPhase;
+
+typedef struct {
+	
+	FloatInspectorVerifyPhase phase;
+	unsigned long long nJobs;
+	unsigned long long nextJob;
+	
+	/* Values checked over the whole run.  */
+	unsigned long long nValues;
+	
+	/* Statistics of the bulk paths and the ones derived from the reference
+	 * decoder, merged from all threads.  */
+	FloatInspectorStatisticsRef actual;
+	FloatInspectorStatisticsRef expected;
+	
+	/* Worker results that could not be merged, each one fails the phase.  */
+	unsigned int nFailedMerges;
+	
+} FloatInspectorVerifyState;
+
+#pragma mark Constants
+
+/* Float bit patterns per job of the sweep.  */
+#define kFloatInspectorVerifyFloatJob	((uint64_t) 1 << 20)
+/* Random samples per job.  */
+#define kFloatInspectorVerifySampleJob	((uint64_t) 1 << 16)
+/* Mismatches reported in detail.  */
+#define kFloatInspectorVerifyMaxReports	16
+
+#pragma mark Globals
+
+static unsigned long long FloatInspectorVerifyDoubleSamples = (unsigned long long) 1 << 27;
+static unsigned long long FloatInspectorVerifyLongDoubleSamples = (unsigned long long) 1 << 22;
+static unsigned long long FloatInspectorVerifyTextSamples = (unsigned long long) 1 << 23;
+static unsigned long long FloatInspectorVerifyGenericStride = 256;
+static uint64_t FloatInspectorVerifySeed = 0x464c4f4154494e53ULL;
+
+static pthread_mutex_t FloatInspectorVerifyLock = PTHREAD_MUTEX_INITIALIZER;
+static FloatInspectorVerifyState FloatInspectorVerifyCurrent;
+static unsigned long long FloatInspectorVerifyMismatches = 0;
+
+/* Reference results of the float sweep. Classification only depends on 
+ * the mantissa, the exponent and whether the mantissa is zero, so the 
+ * reference decoder is run once per distinct mantissa and exponent and the
+ * results are looked up per bit pattern.  */
+static uint8_t *FloatInspectorVerifyFloatMantissa = NULL;
+static uint8_t FloatInspectorVerifyFloatExponent[256];
+static uint8_t FloatInspectorVerifyFloatType[256][2];
+static uint8_t FloatInspectorVerifyFloatSign[2];
+
+/* Layout of long double as reported by the generic decoder.  */
+static unsigned int FloatInspectorVerifyLongDoubleExponentBits;
+static unsigned int FloatInspectorVerifyLongDoubleMantissaBits;
+
+#pragma mark Private Function Prototypes
+
+int main(int, char **);
+
+static uint64_t FloatInspectorVerifyRandom(uint64_t *state);
+
+static FloatInspectorMetaInformation 
+FloatInspectorVerifyReference(const uint8_t *bytes,
+							  unsigned int nExp,
+							  unsigned int nMant,
+							  int explicitIntegerBit,
+							  uint8_t *exponent,
+							  uint8_t *mantissa);
+
+static void FloatInspectorVerifyCount(FloatInspectorStatisticsRef stats,
+									  FloatInspectorMetaInformation meta);
+
+static void FloatInspectorVerifyCompare(const char *what,
+										const uint8_t *bytes,
+										size_t nBytes,
+										FloatInspectorMetaInformation actual,
+										FloatInspectorMetaInformation expected);
+
+static void FloatInspectorVerifyCompareText(const char *text,
+											int parsed,
+											double actual,
+											double expected);
+
+static void FloatInspectorVerifyPrepareFloatTables(void);
+
+static void *FloatInspectorVerifyWorker(void *context);
+
+static int FloatInspectorVerifyRun(FloatInspectorVerifyPhase phase,
+								   const char *name,
+								   enum PrecisionType type,
+								   unsigned long long nJobs,
+								   unsigned int nThreads);
+
+#pragma mark Private Functions Implementations
+
+/* splitmix64.  */
+static uint64_t 
+FloatInspectorVerifyRandom(uint64_t *state) {
+	
+	uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	
+	return z ^ (z >> 31);
+}
+
+/* Decodes a little endian float of the given layout one bit at a time, 
+ * sharing no code with the library.  */
+static FloatInspectorMetaInformation 
+FloatInspectorVerifyReference(const uint8_t *bytes,
+							  unsigned int nExp,
+							  unsigned int nMant,
+							  int explicitIntegerBit,
+							  uint8_t *exponent,
+							  uint8_t *mantissa) {
+	
+	FloatInspectorMetaInformation meta;
+	
+	meta.exponent = exponent;
+	meta.nExponentBits = nExp;
+	meta.nExponentBytes = (nExp + 7) / 8;
+	meta.nNonZeroExponentBits = 0;
+	
+	meta.mantissa = mantissa;
+	meta.nMantissaBits = nMant;
+	meta.nMantissaBytes = (nMant + 7) / 8;
+	meta.nNonZeroMantissaBits = 0;
+	
+	memset(exponent, 0, meta.nExponentBytes);
+	memset(mantissa, 0, meta.nMantissaBytes);
+	
+	unsigned int nExponentOnes = 0;
+	unsigned int nFractionOnes = 0;
+	
+	for (unsigned int i = 0; i < nMant; i++) {
+		
+		if ((bytes[i / 8] >> (i % 8)) & 1) {
+			
+			mantissa[i / 8] |= (uint8_t) (1 << (i % 8));
+			
+			if (meta.nNonZeroMantissaBits == 0) {
+				
+				meta.nNonZeroMantissaBits = nMant - i;
+			}
+			
+			if (!explicitIntegerBit || (i != nMant - 1)) {
+				
+				nFractionOnes++;
+			}
+		}
+	}
+	
+	for (unsigned int j = 0; j < nExp; j++) {
+		
+		const unsigned int i = nMant + j;
+		
+		if ((bytes[i / 8] >> (i % 8)) & 1) {
+			
+			exponent[j / 8] |= (uint8_t) (1 << (j % 8));
+			meta.nNonZeroExponentBits = j + 1;
+			nExponentOnes++;
+		}
+	}
+	
+	const unsigned int s = nMant + nExp;
+	meta.sign = (bytes[s / 8] >> (s % 8)) & 1 ? Negative : Positive;
+	
+	if (nExponentOnes == 0) {
+		
+		meta.type = Denormalized;
+	}
+	else if (nExponentOnes == nExp) {
+		
+		meta.type = nFractionOnes == 0 ? Infinity : NaN;
+	}
+	else {
+		
+		meta.type = Normalized;
+	}
+	
+	return meta;
+}
+
+/* Updates stats the way the histogram definition says, independent of the 
+ * library's update code.  */
+static void 
+FloatInspectorVerifyCount(FloatInspectorStatisticsRef stats,
+						  FloatInspectorMetaInformation meta) {
+	
+	const int negative = meta.sign == Negative;
+	const size_t cell = (size_t) meta.nNonZeroMantissaBits * (meta.nExponentBits + 1) + 
+		meta.nNonZeroExponentBits;
+	
+	stats->nEntries++;
+	
+	if (meta.type == NaN) {
+		
+		stats->nNaN++;
+		return;
+	}
+	
+	if (negative) {
+		
+		stats->nNegative++;
+	}
+	else {
+		
+		stats->nPositive++;
+	}
+	
+	if (meta.type == Normalized) {
+		
+		stats->nNormalized++;
+		(negative ? 
+		 stats->nNonZeroBitsNormalizedNegative : 
+		 stats->nNonZeroBitsNormalizedPositive)[cell]++;
+	}
+	else if (meta.type == Denormalized) {
+		
+		stats->nDenormalized++;
+		(negative ? 
+		 stats->nNonZeroBitsDenormalizedNegative : 
+		 stats->nNonZeroBitsDenormalizedPositive)[meta.nNonZeroMantissaBits]++;
+	}
+	else {
+		
+		stats->nInf++;
+	}
+}
+
+/* Compares every field, exponent and mantissa bytes only if both sides 
+ * provide them.  */
+static void 
+FloatInspectorVerifyCompare(const char *what,
+							const uint8_t *bytes,
+							size_t nBytes,
+							FloatInspectorMetaInformation actual,
+							FloatInspectorMetaInformation expected) {
+	
+	int equal = 
+		(actual.nExponentBits == expected.nExponentBits) &&
+		(actual.nExponentBytes == expected.nExponentBytes) &&
+		(actual.nNonZeroExponentBits == expected.nNonZeroExponentBits) &&
+		(actual.nMantissaBits == expected.nMantissaBits) &&
+		(actual.nMantissaBytes == expected.nMantissaBytes) &&
+		(actual.nNonZeroMantissaBits == expected.nNonZeroMantissaBits) &&
+		(actual.sign == expected.sign) &&
+		(actual.type == expected.type);
+	
+	if (equal && (actual.exponent != NULL) && (expected.exponent != NULL)) {
+		
+		equal = memcmp(actual.exponent, expected.exponent, expected.nExponentBytes) == 0;
+	}
+	
+	if (equal && (actual.mantissa != NULL) && (expected.mantissa != NULL)) {
+		
+		equal = memcmp(actual.mantissa, expected.mantissa, expected.nMantissaBytes) == 0;
+	}
+	
+	if (equal) {
+		
+		return;
+	}
+	
+	pthread_mutex_lock(&FloatInspectorVerifyLock);
+	
+	if (FloatInspectorVerifyMismatches++ < kFloatInspectorVerifyMaxReports) {
+		
+		fprintf(stderr, "MISMATCH %s, bits 0x", what);
+		for (size_t i = nBytes; i > 0; i--) fprintf(stderr, "%.2x", bytes[i - 1]);
+		fprintf(stderr, 
+				"\n  actual:   exp %u/%u mant %u/%u sign %d type %d\n"
+				"  expected: exp %u/%u mant %u/%u sign %d type %d\n",
+				actual.nNonZeroExponentBits, actual.nExponentBits,
+				actual.nNonZeroMantissaBits, actual.nMantissaBits,
+				(int) actual.sign, (int) actual.type,
+				expected.nNonZeroExponentBits, expected.nExponentBits,
+				expected.nNonZeroMantissaBits, expected.nMantissaBits,
+				(int) expected.sign, (int) expected.type);
+	}
+	
+	pthread_mutex_unlock(&FloatInspectorVerifyLock);
+}
+
+static void 
+FloatInspectorVerifyCompareText(const char *text,
+								int parsed,
+								double actual,
+								double expected) {
+	
+	if ((parsed == 0) && (memcmp(&actual, &expected, sizeof(double)) == 0)) {
+		
+		return;
+	}
+	
+	pthread_mutex_lock(&FloatInspectorVerifyLock);
+	
+	if (FloatInspectorVerifyMismatches++ < kFloatInspectorVerifyMaxReports) {
+		
+		fprintf(stderr, "MISMATCH text \"%s\"\n  actual:   %s%a\n  expected: %a\n",
+				text, parsed == 0 ? "" : "rejected ", actual, expected);
+	}
+	
+	pthread_mutex_unlock(&FloatInspectorVerifyLock);
+}
+
+static void 
+FloatInspectorVerifyPrepareFloatTables(void) {
+	
+	uint8_t exponent[16], mantissa[16];
+	
+	FloatInspectorVerifyFloatMantissa = malloc((size_t) 1 << 23);
+	
+	for (uint32_t m = 0; m < (UINT32_C(1) << 23); m++) {
+		
+		const uint32_t bits = (UINT32_C(1) << 23) | m;
+		FloatInspectorVerifyFloatMantissa[m] = (uint8_t)
+			FloatInspectorVerifyReference((const uint8_t *) &bits, 8, 23, 0,
+										  exponent, mantissa).nNonZeroMantissaBits;
+	}
+	
+	for (uint32_t e = 0; e < 256; e++) {
+		
+		for (uint32_t z = 0; z < 2; z++) {
+			
+			const uint32_t bits = (e << 23) | z;
+			const FloatInspectorMetaInformation ref = 
+				FloatInspectorVerifyReference((const uint8_t *) &bits, 8, 23, 0,
+											  exponent, mantissa);
+			
+			FloatInspectorVerifyFloatExponent[e] = (uint8_t) ref.nNonZeroExponentBits;
+			FloatInspectorVerifyFloatType[e][z] = (uint8_t) ref.type;
+		}
+	}
+	
+	for (uint32_t s = 0; s < 2; s++) {
+		
+		const uint32_t bits = s << 31;
+		FloatInspectorVerifyFloatSign[s] = (uint8_t) 
+			FloatInspectorVerifyReference((const uint8_t *) &bits, 8, 23, 0,
+										  exponent, mantissa).sign;
+	}
+}
+
+static void *
+FloatInspectorVerifyWorker(void *context) {
+	
+	(void) context;
+	
+	FloatInspectorVerifyState *state = &FloatInspectorVerifyCurrent;
+	FloatInspectorStatisticsRef actual = FloatInspectorStatisticsCopy(state->actual);
+	FloatInspectorStatisticsRef expected = FloatInspectorStatisticsCopy(state->expected);
+	
+	const size_t capacity = kFloatInspectorVerifyFloatJob > kFloatInspectorVerifySampleJob ?
+		kFloatInspectorVerifyFloatJob : kFloatInspectorVerifySampleJob;
+	void *values = malloc(capacity * sizeof(long double));
+	
+	uint8_t refExponent[16], refMantissa[16];
+	unsigned long long nValues = 0;
+	
+	for (;;) {
+		
+		const unsigned long long job = 
+			__atomic_fetch_add(&state->nextJob, 1, __ATOMIC_RELAXED);
+		
+		if (job >= state->nJobs) {
+			
+			break;
+		}
+		
+		uint64_t random = FloatInspectorVerifySeed ^ (job * 0x2545f4914f6cdd1dULL) ^ 
+			((uint64_t) state->phase << 56);
+		
+		switch (state->phase) {
+			case FloatSweepPhase: {
+				
+				float *f = values;
+				const uint64_t first = job * kFloatInspectorVerifyFloatJob;
+				
+				for (uint64_t i = 0; i < kFloatInspectorVerifyFloatJob; i++) {
+					
+					const uint32_t bits = (uint32_t) (first + i);
+					const uint32_t m = bits & ((UINT32_C(1) << 23) - 1);
+					const uint32_t e = (bits >> 23) & 0xff;
+					
+					memcpy(&f[i], &bits, sizeof(bits));
+					
+					FloatInspectorMetaInformation ref;
+					
+					ref.exponent = NULL;
+					ref.nExponentBits = 8;
+					ref.nExponentBytes = 1;
+					ref.nNonZeroExponentBits = FloatInspectorVerifyFloatExponent[e];
+					ref.mantissa = NULL;
+					ref.nMantissaBits = 23;
+					ref.nMantissaBytes = 3;
+					ref.nNonZeroMantissaBits = FloatInspectorVerifyFloatMantissa[m];
+					ref.sign = FloatInspectorVerifyFloatSign[bits >> 31];
+					ref.type = FloatInspectorVerifyFloatType[e][m != 0];
+					
+					FloatInspectorVerifyCompare("float classify", 
+												(const uint8_t *) &bits, sizeof(bits),
+												FloatInspectorMetaInformationClassifyFloat(f[i]), 
+												ref);
+					FloatInspectorVerifyCount(expected, ref);
+					
+					if ((first + i) % FloatInspectorVerifyGenericStride == 0) {
+						
+						/* Compare the bytes against the full reference decoder.  */
+						FloatInspectorMetaInformation meta = 
+							FloatInspectorMetaInformationCreateWithFloat(f[i]);
+						FloatInspectorVerifyCompare("float generic", 
+													(const uint8_t *) &bits, sizeof(bits),
+													meta, 
+													FloatInspectorVerifyReference((const uint8_t *) &bits, 
+																				  8, 23, 0,
+																				  refExponent, 
+																				  refMantissa));
+						FloatInspectorMetaInformationFree(meta);
+					}
+				}
+				
+				FloatInspectorStatisticsUpdateWithFloats(actual, f, 
+														 kFloatInspectorVerifyFloatJob);
+				nValues += kFloatInspectorVerifyFloatJob;
+				break;
+			}
+				
+			case DoubleRandomPhase:
+			case DoubleStructuredPhase: {
+				
+				double *d = values;
+				size_t n = 0;
+				
+				if (state->phase == DoubleRandomPhase) {
+					
+					for (; n < kFloatInspectorVerifySampleJob; n++) {
+						
+						uint64_t bits = FloatInspectorVerifyRandom(&random);
+						const uint64_t choice = FloatInspectorVerifyRandom(&random);
+						
+						/* Bias towards the rare exponents.  */
+						if ((choice & 7) == 0) bits &= ~(0x7ffULL << 52);
+						if ((choice & 7) == 1) bits |= 0x7ffULL << 52;
+						if ((choice & 0x38) == 0) bits &= ~((1ULL << ((choice >> 8) % 53)) - 1);
+						
+						memcpy(&d[n], &bits, sizeof(bits));
+					}
+				}
+				else {
+					
+					/* One job per biased exponent: both signs with empty, full, 
+					 * single bit and low bit run mantissas.  */
+					for (uint64_t sign = 0; sign < 2; sign++) {
+						
+						const uint64_t head = (sign << 63) | ((uint64_t) job << 52);
+						uint64_t patterns[2 + 52 + 53];
+						unsigned int nPatterns = 0;
+						
+						patterns[nPatterns++] = 0;
+						patterns[nPatterns++] = (1ULL << 52) - 1;
+						for (unsigned int k = 0; k < 52; k++) patterns[nPatterns++] = 1ULL << k;
+						for (unsigned int k = 0; k <= 52; k++) patterns[nPatterns++] = ((1ULL << k) - 1) << (52 - k);
+						
+						for (unsigned int p = 0; p < nPatterns; p++) {
+							
+							const uint64_t bits = head | patterns[p];
+							memcpy(&d[n++], &bits, sizeof(bits));
+						}
+					}
+				}
+				
+				for (size_t i = 0; i < n; i++) {
+					
+					uint64_t bits;
+					memcpy(&bits, &d[i], sizeof(bits));
+					
+					const FloatInspectorMetaInformation ref = 
+						FloatInspectorVerifyReference((const uint8_t *) &bits, 11, 52, 0,
+													  refExponent, refMantissa);
+					
+					FloatInspectorVerifyCompare("double classify", 
+												(const uint8_t *) &bits, sizeof(bits),
+												FloatInspectorMetaInformationClassifyDouble(d[i]), 
+												ref);
+					FloatInspectorVerifyCount(expected, ref);
+					
+					if ((state->phase == DoubleStructuredPhase) || 
+						(i % FloatInspectorVerifyGenericStride == 0)) {
+						
+						FloatInspectorMetaInformation meta = 
+							FloatInspectorMetaInformationCreateWithDouble(d[i]);
+						FloatInspectorVerifyCompare("double generic", 
+													(const uint8_t *) &bits, sizeof(bits),
+													meta, ref);
+						FloatInspectorMetaInformationFree(meta);
+					}
+				}
+				
+				FloatInspectorStatisticsUpdateWithDoubles(actual, d, n);
+				nValues += n;
+				break;
+			}
+				
+			case LongDoubleRandomPhase: {
+				
+				long double *ld = values;
+				const unsigned int nExp = FloatInspectorVerifyLongDoubleExponentBits;
+				const unsigned int nMant = FloatInspectorVerifyLongDoubleMantissaBits;
+				const unsigned int nBits = 1 + nExp + nMant;
+				
+				for (size_t i = 0; i < kFloatInspectorVerifySampleJob; i++) {
+					
+					uint8_t bytes[sizeof(long double)];
+					const uint64_t choice = FloatInspectorVerifyRandom(&random);
+					
+					memset(bytes, 0, sizeof(bytes));
+					for (size_t b = 0; b < sizeof(bytes); b += 8) {
+						
+						const uint64_t r = FloatInspectorVerifyRandom(&random);
+						memcpy(&bytes[b], &r, sizeof(bytes) - b < 8 ? sizeof(bytes) - b : 8);
+					}
+					
+					/* Clear padding, bias the exponent towards its extremes.  */
+					for (unsigned int bit = nBits; bit < 8 * sizeof(bytes); bit++) {
+						
+						bytes[bit / 8] &= (uint8_t) ~(1 << (bit % 8));
+					}
+					for (unsigned int bit = nMant; bit < nMant + nExp; bit++) {
+						
+						if ((choice & 7) == 0) bytes[bit / 8] &= (uint8_t) ~(1 << (bit % 8));
+						if ((choice & 7) == 1) bytes[bit / 8] |= (uint8_t) (1 << (bit % 8));
+					}
+					
+					memcpy(&ld[i], bytes, sizeof(bytes));
+					
+					const FloatInspectorMetaInformation ref = 
+						FloatInspectorVerifyReference(bytes, nExp, nMant, LDBL_MANT_DIG == 64,
+													  refExponent, refMantissa);
+					FloatInspectorVerifyCount(expected, ref);
+					
+					if (i % 16 == 0) {
+						
+						FloatInspectorMetaInformation meta = 
+							FloatInspectorMetaInformationCreateWithLongDouble(ld[i]);
+						FloatInspectorVerifyCompare("long double generic", 
+													bytes, (nBits + 7) / 8, meta, ref);
+						FloatInspectorMetaInformationFree(meta);
+					}
+				}
+				
+				FloatInspectorStatisticsUpdateWithLongDoubles(actual, ld, 
+															  kFloatInspectorVerifySampleJob);
+				nValues += kFloatInspectorVerifySampleJob;
+				break;
+			}
+				
+			case TextParsePhase: {
+				
+				double *d = values;
+				char text[96];
+				
+				for (size_t i = 0; i < kFloatInspectorVerifySampleJob; i++) {
+					
+					const uint64_t bits = FloatInspectorVerifyRandom(&random);
+					const uint64_t choice = FloatInspectorVerifyRandom(&random);
+					double f;
+					int length;
+					
+					memcpy(&f, &bits, sizeof(f));
+					
+					switch (choice % 5) {
+						case 0:
+							/* Shortest round trip and shorter, infinities and
+							 * NaNs included.  */
+							length = snprintf(text, sizeof(text), "%.*g", 
+											  (int) ((choice >> 8) % 17) + 1, f);
+							break;
+							
+						case 1: {
+							
+							/* Exact midpoint of two doubles, the hard cases 
+							 * of rounding.  */
+							const uint64_t low = bits & (UINT64_MAX >> 2);
+							const uint64_t high = low + 1;
+							double next;
+							
+							memcpy(&f, &low, sizeof(f));
+							memcpy(&next, &high, sizeof(next));
+							length = snprintf(text, sizeof(text), "%.*Le", 
+											  (int) ((choice >> 8) % 40) + 1,
+											  ((long double) f + (long double) next) / 2);
+							break;
+						}
+							
+						case 2: {
+							
+							/* Denormals.  */
+							const uint64_t denormal = bits >> 12;
+							
+							memcpy(&f, &denormal, sizeof(f));
+							length = snprintf(text, sizeof(text), "%.*e", 
+											  (int) ((choice >> 8) % 20), f);
+							break;
+						}
+							
+						default: {
+							
+							/* Digit strings with up to 30 digits, a fraction
+							 * and an exponent.  */
+							const unsigned int nDigits = (unsigned int) ((choice >> 8) % 30) + 1;
+							uint64_t digits = bits;
+							
+							length = (choice >> 16) & 1 ? snprintf(text, sizeof(text), "-") : 0;
+							
+							for (unsigned int k = 0; k < nDigits; k++) {
+								
+								if (k % 16 == 15) digits = FloatInspectorVerifyRandom(&random);
+								if (k == (unsigned int) ((choice >> 24) % 32)) text[length++] = '.';
+								
+								text[length++] = (char) ('0' + digits % 10);
+								digits /= 10;
+							}
+							
+							if ((choice >> 17) & 1) {
+								
+								length += snprintf(text + length, sizeof(text) - (size_t) length, 
+												   "e%d", (int) ((choice >> 32) % 700) - 350);
+							}
+							
+							text[length] = '\0';
+							break;
+						}
+					}
+					
+					const double reference = strtod(text, NULL);
+					uint64_t referenceBits;
+					
+					const int parsed = FloatInspectorTextParseDouble(text, text + length, &d[i]);
+					FloatInspectorVerifyCompareText(text, parsed, d[i], reference);
+					
+					memcpy(&referenceBits, &reference, sizeof(referenceBits));
+					FloatInspectorVerifyCount(expected, 
+											  FloatInspectorVerifyReference((const uint8_t *) &referenceBits, 
+																			11, 52, 0,
+																			refExponent, refMantissa));
+				}
+				
+				FloatInspectorStatisticsUpdateWithDoubles(actual, d, 
+														  kFloatInspectorVerifySampleJob);
+				nValues += kFloatInspectorVerifySampleJob;
+				break;
+			}
+		}
+	}
+	
+	pthread_mutex_lock(&FloatInspectorVerifyLock);
+	if ((FloatInspectorStatisticsMerge(state->actual, actual) != 0) ||
+		(FloatInspectorStatisticsMerge(state->expected, expected) != 0)) {
+		
+		state->nFailedMerges++;
+	}
+	
+	state->nValues += nValues;
+	pthread_mutex_unlock(&FloatInspectorVerifyLock);
+	
+	free(values);
+	FloatInspectorStatisticsFree(actual);
+	FloatInspectorStatisticsFree(expected);
+	
+	return NULL;
+}
+
+/* Runs one phase on all threads and compares the merged histograms.
+ * Returns the number of mismatching cells and counters.  */
+static int 
+FloatInspectorVerifyRun(FloatInspectorVerifyPhase phase,
+						const char *name,
+						enum PrecisionType type,
+						unsigned long long nJobs,
+						unsigned int nThreads) {
+	
+	FloatInspectorVerifyState *state = &FloatInspectorVerifyCurrent;
+	struct timespec start, end;
+	
+	state->phase = phase;
+	state->nJobs = nJobs;
+	state->nextJob = 0;
+	state->nValues = 0;
+	state->nFailedMerges = 0;
+	state->actual = FloatInspectorStatisticsCreate(type);
+	state->expected = FloatInspectorStatisticsCreate(type);
+	
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	
+	pthread_t *threads = malloc(nThreads * sizeof(pthread_t));
+	
+	for (unsigned int i = 0; i < nThreads; i++) {
+		
+		pthread_create(&threads[i], NULL, FloatInspectorVerifyWorker, NULL);
+	}
+	
+	for (unsigned int i = 0; i < nThreads; i++) {
+		
+		pthread_join(threads[i], NULL);
+	}
+	
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	
+	FloatInspectorStatisticsDiffRef diff = 
+		FloatInspectorStatisticsDiffCreate(state->expected, state->actual);
+	
+	const int nDifferences = (int) diff->nChanges + (int) state->nFailedMerges +
+		(diff->nEntries != 0) + (diff->nDenormalized != 0) + (diff->nNormalized != 0) +
+		(diff->nNegative != 0) + (diff->nPositive != 0) + (diff->nNaN != 0) + 
+		(diff->nInf != 0);
+	
+	printf("%-24s %12llu values %8.2f s  %s\n",
+		   name,
+		   state->nValues,
+		   (double) (end.tv_sec - start.tv_sec) + 1e-9 * (double) (end.tv_nsec - start.tv_nsec),
+		   nDifferences == 0 ? "histograms match" : "HISTOGRAMS DIFFER");
+	
+	FloatInspectorStatisticsDiffFree(diff);
+	FloatInspectorStatisticsFree(state->actual);
+	FloatInspectorStatisticsFree(state->expected);
+	free(threads);
+	
+	return nDifferences;
+}
+
+#pragma mark Main
+
+int
+main(int argc, char **argv) {
+	
+	long nThreads = sysconf(_SC_NPROCESSORS_ONLN);
+	int opt;
+	
+	while ((opt = getopt(argc, argv, "t:d:l:p:g:s:")) != -1) {
+		
+		switch (opt) {
+			case 't':
+				nThreads = atol(optarg);
+				break;
+				
+			case 'd':
+				FloatInspectorVerifyDoubleSamples = strtoull(optarg, NULL, 0);
+				break;
+				
+			case 'l':
+				FloatInspectorVerifyLongDoubleSamples = strtoull(optarg, NULL, 0);
+				break;
+				
+			case 'p':
+				FloatInspectorVerifyTextSamples = strtoull(optarg, NULL, 0);
+				break;
+				
+			case 'g':
+				FloatInspectorVerifyGenericStride = strtoull(optarg, NULL, 0);
+				break;
+				
+			case 's':
+				FloatInspectorVerifySeed = strtoull(optarg, NULL, 0);
+				break;
+				
+			default:
+				fprintf(stderr, 
+						"usage: %s [-t threads] [-d doubles] [-l long doubles] "
+						"[-p parsed strings] [-g generic stride] [-s seed]\n", argv[0]);
+				return EXIT_FAILURE;
+		}
+	}
+	
+	if (nThreads < 1) nThreads = 1;
+	if (FloatInspectorVerifyGenericStride < 1) FloatInspectorVerifyGenericStride = 1;
+	
+	const FloatInspectorMetaInformation layout = 
+		FloatInspectorMetaInformationCreateWithLongDouble(1.l);
+	FloatInspectorVerifyLongDoubleExponentBits = layout.nExponentBits;
+	FloatInspectorVerifyLongDoubleMantissaBits = layout.nMantissaBits;
+	FloatInspectorMetaInformationFree(layout);
+	
+	printf("Verifying with %ld threads, generic decoder every %llu values\n\n", 
+		   nThreads, FloatInspectorVerifyGenericStride);
+	
+	FloatInspectorVerifyPrepareFloatTables();
+	
+	int nDifferences = 0;
+	
+	nDifferences += FloatInspectorVerifyRun(FloatSweepPhase, "float (all patterns)", Float,
+											((uint64_t) 1 << 32) / kFloatInspectorVerifyFloatJob,
+											(unsigned int) nThreads);
+	nDifferences += FloatInspectorVerifyRun(DoubleStructuredPhase, "double (structured)", Double,
+											2048, (unsigned int) nThreads);
+	nDifferences += FloatInspectorVerifyRun(DoubleRandomPhase, "double (random)", Double,
+											(FloatInspectorVerifyDoubleSamples + 
+											 kFloatInspectorVerifySampleJob - 1) / 
+											kFloatInspectorVerifySampleJob,
+											(unsigned int) nThreads);
+	nDifferences += FloatInspectorVerifyRun(LongDoubleRandomPhase, "long double (random)", 
+											LongDouble,
+											(FloatInspectorVerifyLongDoubleSamples + 
+											 kFloatInspectorVerifySampleJob - 1) / 
+											kFloatInspectorVerifySampleJob,
+											(unsigned int) nThreads);
+	nDifferences += FloatInspectorVerifyRun(TextParsePhase, "text (against strtod)", Double,
+											(FloatInspectorVerifyTextSamples + 
+											 kFloatInspectorVerifySampleJob - 1) / 
+											kFloatInspectorVerifySampleJob,
+											(unsigned int) nThreads);
+	
+	free(FloatInspectorVerifyFloatMantissa);
+	
+	printf("\n%llu mismatching values, %d mismatching histogram cells or counters\n",
+		   FloatInspectorVerifyMismatches, nDifferences);
+	
+	return (FloatInspectorVerifyMismatches == 0) && (nDifferences == 0) ? 
+		EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,590 @@
+//
+//  FloatInspectorWatcher.c
+//  FloatInspector
+//  
+//  Copyright 2011 Stefan Reinhold <stefan@sreinhold.com>. All rights reserved.
+//  
+//  Redistribution and use in source and binary forms, with or without modification, are
+//  permitted provided that the following conditions are met:
+//  
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//  
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list
+//  of conditions and the following disclaimer in the documentation and/or other materials
+//  provided with the distribution.
+//  
+//  THIS SOFTWARE IS PROVIDED BY STEFAN REINHOLD ``AS IS'' AND ANY EXPRESS OR IMPLIED
+//  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STEFAN REINHOLD OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+//  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+//  ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//  
+//  The views and conclusions contained in the software and documentation are those of the
+//  authors and should not be interpreted as representing official policies, either expressed
+//  or implied, of Stefan Reinhold.
+//  
+
+
+
+#define _GNU_SOURCE
+
+#include "FloatInspectorWatcher.h"
+#include "FloatInspectorPerf.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+
+#pragma mark Data Types
+
+typedef struct {
+	
+	char *name;
+	const void *base;
+	size_t n;
+	enum PrecisionType type;
+	
+	/* Slot is in use, cleared by unregister to cancel a running scan.  */
+	int registered;
+	/* The watcher thread is currently reading the region.  */
+	int scanning;
+	/* Monotonic time of the next scan.  */
+	double nextScan;
+	
+	/* Ring of the last window scans, allocated on demand.  */
+	unsigned int nScans;
+	FloatInspectorStatisticsRef *scans;
+	
+} FloatInspectorWatcherRegion;
+
+struct _FloatInspectorWatcher {
+	
+	FloatInspectorWatcherOptions options;
+	
+	pthread_mutex_t lock;
+	/* Signalled on stop requests, new regions and finished scans.  */
+	pthread_cond_t cond;
+	pthread_t thread;
+	int running;
+	int stopRequested;
+	
+	/* Regions are never moved, so the thread may keep a pointer while 
+	 * scanning. Ids are indices and never reused.  */
+	FloatInspectorWatcherRegion **regions;
+	unsigned int nRegions;
+	unsigned int capacity;
+	
+	/* Scan buffers of the watcher thread, one per type, swapped into the 
+	 * rings when a scan is complete.  */
+	FloatInspectorStatisticsRef scratch[BFloat16 + 1];
+};
+
+#pragma mark Constants
+
+const FloatInspectorWatcherOptions kFloatInspectorWatcherDefaultOptions = {
+	.scanInterval	= 1.,
+	.cpuBudget		= .05,
+	.core			= -1,
+	.window			= 8
+};
+
+/* Elements classified between two checks of the CPU budget.  */
+#define kFloatInspectorWatcherChunk ((size_t) 1 << 16)
+
+#pragma mark Private Function Prototypes
+
+static double FloatInspectorWatcherClock(clockid_t clock);
+
+static void FloatInspectorWatcherSleep(double seconds);
+
+static void FloatInspectorWatcherLowerPriority(FloatInspectorWatcherRef watcher);
+
+static int FloatInspectorWatcherScan(FloatInspectorWatcherRef watcher,
+									 FloatInspectorWatcherRegion *region,
+									 const void *base,
+									 size_t n,
+									 FloatInspectorStatisticsRef stats);
+
+static void *FloatInspectorWatcherMain(void *context);
+
+#pragma mark Private Functions Implementations
+
+static double 
+FloatInspectorWatcherClock(clockid_t clock) {
+	
+	struct timespec ts;
+	clock_gettime(clock, &ts);
+	
+	return (double) ts.tv_sec + 1e-9 * (double) ts.tv_nsec;
+}
+
+static void 
+FloatInspectorWatcherSleep(double seconds) {
+	
+	struct timespec ts = {
+		.tv_sec = (time_t) seconds,
+		.tv_nsec = (long) ((seconds - (double) (time_t) seconds) * 1e9)
+	};
+	
+	while ((nanosleep(&ts, &ts) != 0) && (errno == EINTR));
+}
+
+/* Best effort, failures leave the thread at normal priority.  */
+static void 
+FloatInspectorWatcherLowerPriority(FloatInspectorWatcherRef watcher) {
+	
+#if defined(__linux__)
+	
+	struct sched_param param = { .sched_priority = 0 };
+	pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+	
+	if (watcher->options.core >= 0) {
+		
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(watcher->options.core, &set);
+		pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+	}
+	
+#elif defined(__APPLE__)
+	
+	/* Darwin has no hard affinity, the core option is ignored.  */
+	pthread_set_qos_class_self_np(QOS_CLASS_BACKGROUND, 0);
+	
+#endif
+}
+
+/* Classifies the region chunk by chunk, sleeping whenever the thread's CPU
+ * time exceeds its budget share of the wall time since the scan started.
+ * Returns -1 if the scan was cancelled.  */
+static int 
+FloatInspectorWatcherScan(FloatInspectorWatcherRef watcher,
+						  FloatInspectorWatcherRegion *region,
+						  const void *base,
+						  size_t n,
+						  FloatInspectorStatisticsRef stats) {
+	
+	const double budget = watcher->options.cpuBudget;
+	const double wallStart = FloatInspectorWatcherClock(CLOCK_MONOTONIC);
+	const double cpuStart = FloatInspectorWatcherClock(CLOCK_THREAD_CPUTIME_ID);
+	
+	for (size_t offset = 0; offset < n; offset += kFloatInspectorWatcherChunk) {
+		
+		const size_t count = n - offset < kFloatInspectorWatcherChunk ? 
+			n - offset : kFloatInspectorWatcherChunk;
+		
+		switch (stats->type) {
+			case Float:
+				FloatInspectorStatisticsUpdateWithFloats(stats, 
+														 (const float *) base + offset, 
+														 count);
+				break;
+				
+			case Double:
+				FloatInspectorStatisticsUpdateWithDoubles(stats, 
+														  (const double *) base + offset, 
+														  count);
+				break;
+				
+			case LongDouble:
+				FloatInspectorStatisticsUpdateWithLongDoubles(stats, 
+															  (const long double *) base + offset, 
+															  count);
+				break;
+				
+			case Half:
+				FloatInspectorStatisticsUpdateWithHalfs(stats, 
+														(const uint16_t *) base + offset, 
+														count);
+				break;
+				
+			case BFloat16:
+				FloatInspectorStatisticsUpdateWithBFloat16s(stats, 
+															(const uint16_t *) base + offset, 
+															count);
+				break;
+		}
+		
+		if (!__atomic_load_n(&region->registered, __ATOMIC_ACQUIRE) ||
+			__atomic_load_n(&watcher->stopRequested, __ATOMIC_ACQUIRE)) {
+			
+			return -1;
+		}
+		
+		const double cpu = FloatInspectorWatcherClock(CLOCK_THREAD_CPUTIME_ID) - cpuStart;
+		const double wall = FloatInspectorWatcherClock(CLOCK_MONOTONIC) - wallStart;
+		
+		if (cpu > budget * wall) {
+			
+			FloatInspectorWatcherSleep(cpu / budget - wall);
+		}
+	}
+	
+	return 0;
+}
+
+static void *
+FloatInspectorWatcherMain(void *context) {
+	
+	FloatInspectorWatcherRef watcher = context;
+	
+	FloatInspectorWatcherLowerPriority(watcher);
+	FloatInspectorPerfMarkWorkerThread();
+	
+	pthread_mutex_lock(&watcher->lock);
+	
+	while (!watcher->stopRequested) {
+		
+		/* Pick the region that is due first.  */
+		FloatInspectorWatcherRegion *region = NULL;
+		
+		for (unsigned int i = 0; i < watcher->nRegions; i++) {
+			
+			if (watcher->regions[i]->registered &&
+				((region == NULL) || (watcher->regions[i]->nextScan < region->nextScan))) {
+				
+				region = watcher->regions[i];
+			}
+		}
+		
+		const double now = FloatInspectorWatcherClock(CLOCK_MONOTONIC);
+		
+		if ((region == NULL) || (region->nextScan > now)) {
+			
+			const double wait = region == NULL ? 
+				watcher->options.scanInterval : region->nextScan - now;
+			struct timespec deadline;
+			
+			/* Condition variables time out on the realtime clock.  */
+			clock_gettime(CLOCK_REALTIME, &deadline);
+			deadline.tv_sec += (time_t) wait;
+			deadline.tv_nsec += (long) ((wait - (double) (time_t) wait) * 1e9);
+			if (deadline.tv_nsec >= 1000000000L) {
+				
+				deadline.tv_sec++;
+				deadline.tv_nsec -= 1000000000L;
+			}
+			
+			pthread_cond_timedwait(&watcher->cond, &watcher->lock, &deadline);
+			continue;
+		}
+		
+		const enum PrecisionType type = region->type;
+		const void *base = region->base;
+		const size_t n = region->n;
+		
+		if (watcher->scratch[type] == NULL) {
+			
+			watcher->scratch[type] = FloatInspectorStatisticsCreate(type);
+		}
+		
+		FloatInspectorStatisticsRef stats = watcher->scratch[type];
+		
+		if (stats == NULL) {
+			
+			region->nextScan = now + watcher->options.scanInterval;
+			continue;
+		}
+		
+		region->scanning = 1;
+		pthread_mutex_unlock(&watcher->lock);
+		
+		FloatInspectorStatisticsReset(stats);
+		const int cancelled = 
+			FloatInspectorWatcherScan(watcher, region, base, n, stats);
+		
+		pthread_mutex_lock(&watcher->lock);
+		
+		region->scanning = 0;
+		region->nextScan = now + watcher->options.scanInterval;
+		
+		if (!cancelled) {
+			
+			/* Swap the finished scan into the ring, the replaced entry becomes
+			 * the next scratch buffer.  */
+			const unsigned int slot = region->nScans % watcher->options.window;
+			
+			watcher->scratch[type] = region->scans[slot];
+			region->scans[slot] = stats;
+			region->nScans++;
+		}
+		
+		pthread_cond_broadcast(&watcher->cond);
+	}
+	
+	pthread_mutex_unlock(&watcher->lock);
+	
+	return NULL;
+}
+
+#pragma mark Public Functions Implementations
+
+FloatInspectorWatcherRef 
+FloatInspectorWatcherCreate(FloatInspectorWatcherOptions options) {
+	
+	if ((options.cpuBudget <= 0.) || (options.cpuBudget > 1.) ||
+		(options.scanInterval < 0.) || (options.window == 0)) {
+		
+		return NULL;
+	}
+	
+	FloatInspectorWatcherRef watcher = calloc(1, sizeof(struct _FloatInspectorWatcher));
+	
+	if (watcher == NULL) {
+		
+		return NULL;
+	}
+	
+	watcher->options = options;
+	pthread_mutex_init(&watcher->lock, NULL);
+	pthread_cond_init(&watcher->cond, NULL);
+	
+	return watcher;
+}
+
+void 
+FloatInspectorWatcherFree(FloatInspectorWatcherRef watcher) {
+	
+	FloatInspectorWatcherStop(watcher);
+	
+	for (unsigned int i = 0; i < watcher->nRegions; i++) {
+		
+		FloatInspectorWatcherRegion *region = watcher->regions[i];
+		
+		for (unsigned int j = 0; (region->scans != NULL) && (j < watcher->options.window); j++) {
+			
+			if (region->scans[j] != NULL) {
+				
+				FloatInspectorStatisticsFree(region->scans[j]);
+			}
+		}
+		
+		free(region->scans);
+		free(region->name);
+		free(region);
+	}
+	
+	for (unsigned int i = 0; i <= BFloat16; i++) {
+		
+		if (watcher->scratch[i] != NULL) {
+			
+			FloatInspectorStatisticsFree(watcher->scratch[i]);
+		}
+	}
+	
+	pthread_cond_destroy(&watcher->cond);
+	pthread_mutex_destroy(&watcher->lock);
+	free(watcher->regions);
+	free(watcher);
+}
+
+int 
+FloatInspectorWatcherStart(FloatInspectorWatcherRef watcher) {
+	
+	pthread_mutex_lock(&watcher->lock);
+	
+	int result = 0;
+	
+	if (!watcher->running) {
+		
+		watcher->stopRequested = 0;
+		result = pthread_create(&watcher->thread, NULL, 
+								FloatInspectorWatcherMain, watcher) == 0 ? 0 : -1;
+		watcher->running = result == 0;
+	}
+	
+	pthread_mutex_unlock(&watcher->lock);
+	
+	return result;
+}
+
+void 
+FloatInspectorWatcherStop(FloatInspectorWatcherRef watcher) {
+	
+	pthread_mutex_lock(&watcher->lock);
+	
+	if (!watcher->running) {
+		
+		pthread_mutex_unlock(&watcher->lock);
+		return;
+	}
+	
+	__atomic_store_n(&watcher->stopRequested, 1, __ATOMIC_RELEASE);
+	pthread_cond_broadcast(&watcher->cond);
+	pthread_mutex_unlock(&watcher->lock);
+	
+	pthread_join(watcher->thread, NULL);
+	
+	pthread_mutex_lock(&watcher->lock);
+	watcher->running = 0;
+	pthread_mutex_unlock(&watcher->lock);
+}
+
+int 
+FloatInspectorWatcherRegister(FloatInspectorWatcherRef watcher,
+							  const char *name,
+							  const void *base,
+							  size_t n,
+							  enum PrecisionType type) {
+	
+	/* The scratch buffers are indexed by type.  */
+	if ((unsigned int) type > BFloat16) {
+		
+		errno = EINVAL;
+		return -1;
+	}
+	
+	FloatInspectorWatcherRegion *region = calloc(1, sizeof(FloatInspectorWatcherRegion));
+	FloatInspectorStatisticsRef *scans = 
+		calloc(watcher->options.window, sizeof(FloatInspectorStatisticsRef));
+	char *nameCopy = strdup(name != NULL ? name : "");
+	
+	if ((region == NULL) || (scans == NULL) || (nameCopy == NULL)) {
+		
+		free(region);
+		free(scans);
+		free(nameCopy);
+		return -1;
+	}
+	
+	pthread_mutex_lock(&watcher->lock);
+	
+	if (watcher->nRegions == watcher->capacity) {
+		
+		const unsigned int capacity = watcher->capacity == 0 ? 8 : 2 * watcher->capacity;
+		FloatInspectorWatcherRegion **regions = 
+			realloc(watcher->regions, capacity * sizeof(FloatInspectorWatcherRegion *));
+		
+		if (regions == NULL) {
+			
+			pthread_mutex_unlock(&watcher->lock);
+			free(region);
+			free(scans);
+			free(nameCopy);
+			return -1;
+		}
+		
+		watcher->regions = regions;
+		watcher->capacity = capacity;
+	}
+	
+	const int idx = (int) watcher->nRegions++;
+	watcher->regions[idx] = region;
+	
+	region->name = nameCopy;
+	region->base = base;
+	region->n = n;
+	region->type = type;
+	region->registered = 1;
+	region->scanning = 0;
+	region->nextScan = FloatInspectorWatcherClock(CLOCK_MONOTONIC);
+	region->nScans = 0;
+	region->scans = scans;
+	
+	pthread_cond_broadcast(&watcher->cond);
+	pthread_mutex_unlock(&watcher->lock);
+	
+	return idx;
+}
+
+void 
+FloatInspectorWatcherUnregister(FloatInspectorWatcherRef watcher,
+								int region) {
+	
+	pthread_mutex_lock(&watcher->lock);
+	
+	if ((region >= 0) && ((unsigned int) region < watcher->nRegions)) {
+		
+		FloatInspectorWatcherRegion *r = watcher->regions[region];
+		
+		__atomic_store_n(&r->registered, 0, __ATOMIC_RELEASE);
+		
+		while (r->scanning) {
+			
+			pthread_cond_wait(&watcher->cond, &watcher->lock);
+		}
+		
+		/* Keep the slot so ids stay stable, but drop its statistics.  */
+		for (unsigned int i = 0; i < watcher->options.window; i++) {
+			
+			if (r->scans[i] != NULL) {
+				
+				FloatInspectorStatisticsFree(r->scans[i]);
+				r->scans[i] = NULL;
+			}
+		}
+	}
+	
+	pthread_mutex_unlock(&watcher->lock);
+}
+
+FloatInspectorStatisticsRef 
+FloatInspectorWatcherCopyStatistics(FloatInspectorWatcherRef watcher,
+									int region) {
+	
+	pthread_mutex_lock(&watcher->lock);
+	
+	if ((region < 0) || ((unsigned int) region >= watcher->nRegions) ||
+		!watcher->regions[region]->registered) {
+		
+		pthread_mutex_unlock(&watcher->lock);
+		return NULL;
+	}
+	
+	const FloatInspectorWatcherRegion *r = watcher->regions[region];
+	FloatInspectorStatisticsRef stats = FloatInspectorStatisticsCreate(r->type);
+	
+	for (unsigned int i = 0; (stats != NULL) && (i < watcher->options.window); i++) {
+		
+		if ((r->scans[i] != NULL) && 
+			(FloatInspectorStatisticsMerge(stats, r->scans[i]) != 0)) {
+			
+			FloatInspectorStatisticsFree(stats);
+			stats = NULL;
+		}
+	}
+	
+	pthread_mutex_unlock(&watcher->lock);
+	
+	return stats;
+}
+
+void 
+FloatInspectorWatcherPrint(FloatInspectorWatcherRef watcher,
+						   FILE *restrict stream) {
+	
+	pthread_mutex_lock(&watcher->lock);
+	const unsigned int nRegions = watcher->nRegions;
+	pthread_mutex_unlock(&watcher->lock);
+	
+	for (unsigned int i = 0; i < nRegions; i++) {
+		
+		FloatInspectorStatisticsRef stats = 
+			FloatInspectorWatcherCopyStatistics(watcher, (int) i);
+		
+		if (stats == NULL) {
+			
+			continue;
+		}
+		
+		pthread_mutex_lock(&watcher->lock);
+		fprintf(stream, 
+				"=== Region %u (%s): %zu elements, %u scans ===\n\n",
+				i,
+				watcher->regions[i]->name,
+				watcher->regions[i]->n,
+				watcher->regions[i]->nScans);
+		pthread_mutex_unlock(&watcher->lock);
+		
+		FloatInspectorStatisticsPrint(stats, stream);
+		FloatInspectorStatisticsFree(stats);
+	}
+}
@@ -0,0 +1,103 @@
+//
+//  FloatInspectorWatcher.h
+//  FloatInspector
+//  
+//  Copyright 2011 Stefan Reinhold <stefan@sreinhold.com>. All rights reserved.
+//  
+//  Redistribution and use in source and binary forms, with or without modification, are
+//  permitted provided that the following conditions are met:
+//  
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//  
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list
+//  of conditions and the following disclaimer in the documentation and/or other materials
+//  provided with the distribution.
+//  
+//  THIS SOFTWARE IS PROVIDED BY STEFAN REINHOLD ``AS IS'' AND ANY EXPRESS OR IMPLIED
+//  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+//  FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STEFAN REINHOLD OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+//  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+//  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+//  ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//  
+//  The views and conclusions contained in the software and documentation are those of the
+//  authors and should not be interpreted as representing official policies, either expressed
+//  or implied, of Stefan Reinhold.
+//  
+
+
+#ifndef FloatInspector_FloatInspectorWatcher_h
+#define FloatInspector_FloatInspectorWatcher_h
+
+#include "FloatInspector.h"
+
+#pragma mark Data Types
+
+/* Background thread that periodically scans registered memory regions with 
+ * the bulk classification paths and keeps rolling statistics per region.
+ * Regions are read while their owners keep writing to them, so a scan is 
+ * a sample of the region's contents, not a consistent snapshot.  */
+typedef struct _FloatInspectorWatcher *FloatInspectorWatcherRef;
+
+typedef struct {
+	
+	/* Seconds between the starts of two scans of a region.  */
+	double scanInterval;
+	/* Fraction of one core the watcher thread may use, in (0, 1].  */
+	double cpuBudget;
+	/* Core to pin the watcher thread to, -1 to leave it unpinned.  */
+	int core;
+	/* Number of most recent scans the rolling statistics cover.  */
+	unsigned int window;
+	
+} FloatInspectorWatcherOptions;
+
+#pragma mark Constants
+
+/* One scan per second, at most 5% of a core, unpinned, window of 8 scans.  */
+extern const FloatInspectorWatcherOptions kFloatInspectorWatcherDefaultOptions;
+
+#pragma mark Public Functions
+
+FloatInspectorWatcherRef 
+FloatInspectorWatcherCreate(FloatInspectorWatcherOptions options);
+
+/* Stops the watcher thread if running and releases all regions.  */
+void FloatInspectorWatcherFree(FloatInspectorWatcherRef watcher);
+
+/* Starts the low priority watcher thread. Returns 0 on success.  */
+int FloatInspectorWatcherStart(FloatInspectorWatcherRef watcher);
+
+/* Stops the watcher thread, waiting for the current scan to finish.  */
+void FloatInspectorWatcherStop(FloatInspectorWatcherRef watcher);
+
+/* Registers n elements of the given type at base. Returns the region id or 
+ * -1 on failure, with errno set to EINVAL for an unknown type. The memory 
+ * has to stay valid until the region is unregistered.  */
+int FloatInspectorWatcherRegister(FloatInspectorWatcherRef watcher,
+								  const char *name,
+								  const void *base,
+								  size_t n,
+								  enum PrecisionType type);
+
+/* Removes a region. Returns after any scan of it has finished, so its 
+ * memory may be released afterwards.  */
+void FloatInspectorWatcherUnregister(FloatInspectorWatcherRef watcher,
+									 int region);
+
+/* Returns the statistics of the last window scans of a region, owned by the
+ * caller, or NULL if the region is unknown, memory is exhausted or the scans
+ * cannot be summed up.  */
+FloatInspectorStatisticsRef 
+FloatInspectorWatcherCopyStatistics(FloatInspectorWatcherRef watcher,
+									int region);
+
+/* Prints the rolling statistics of all regions.  */
+void FloatInspectorWatcherPrint(FloatInspectorWatcherRef watcher,
+								FILE *restrict stream);
+
+#endif